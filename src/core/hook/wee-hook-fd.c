@@ -38,6 +38,8 @@
 
 struct pollfd *hook_fd_pollfd = NULL;  /* file descriptors for poll()       */
 int hook_fd_pollfd_count = 0;          /* number of file descriptors        */
+int hook_fd_timeout_max = -1;          /* max timeout for poll() (in ms),   */
+                                       /* -1 = no limit                     */
 
 
 /*
@@ -250,6 +252,11 @@ hook_fd_exec ()
 
     /* perform the poll() */
     timeout = hook_timer_get_time_to_next ();
+    if ((hook_fd_timeout_max >= 0)
+        && ((timeout < 0) || (timeout > hook_fd_timeout_max)))
+    {
+        timeout = hook_fd_timeout_max;
+    }
     if (hook_process_pending)
         timeout = 0;
     ready = poll (hook_fd_pollfd, num_fd, timeout);
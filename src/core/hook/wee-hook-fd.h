@@ -41,6 +41,8 @@ struct t_hook_fd
                                        /* with fd                           */
 };
 
+extern int hook_fd_timeout_max;
+
 extern char *hook_fd_get_description (struct t_hook *hook);
 extern void hook_fd_add_cb (struct t_hook *hook);
 extern void hook_fd_remove_cb (struct t_hook *hook);
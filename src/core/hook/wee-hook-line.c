@@ -126,11 +126,13 @@ hook_line_exec (struct t_gui_line *line)
     struct t_hook *ptr_hook, *next_hook;
     struct t_hashtable *hashtable, *hashtable2;
     char str_value[128], *str_tags;
+    int hashtable_filled;
 
     if (!weechat_hooks[HOOK_TYPE_LINE])
         return;
 
     hashtable = NULL;
+    hashtable_filled = 0;
 
     hook_exec_start ();
 
@@ -160,25 +162,34 @@ hook_line_exec (struct t_gui_line *line)
                 if (!hashtable)
                     break;
             }
-            HASHTABLE_SET_POINTER("buffer", line->data->buffer);
-            HASHTABLE_SET_STR("buffer_name", line->data->buffer->full_name);
-            HASHTABLE_SET_STR("buffer_type",
-                              gui_buffer_type_string[line->data->buffer->type]);
-            HASHTABLE_SET_INT("y", line->data->y);
-            HASHTABLE_SET_TIME("date", line->data->date);
-            HASHTABLE_SET_TIME("date_printed", line->data->date_printed);
-            HASHTABLE_SET_STR_NOT_NULL("str_time", line->data->str_time);
-            HASHTABLE_SET_INT("tags_count", line->data->tags_count);
-            str_tags = string_rebuild_split_string (
-                (const char **)line->data->tags_array, ",", 0, -1);
-            HASHTABLE_SET_STR_NOT_NULL("tags", str_tags);
-            if (str_tags)
-                free (str_tags);
-            HASHTABLE_SET_INT("displayed", line->data->displayed);
-            HASHTABLE_SET_INT("notify_level", line->data->notify_level);
-            HASHTABLE_SET_INT("highlight", line->data->highlight);
-            HASHTABLE_SET_STR_NOT_NULL("prefix", line->data->prefix);
-            HASHTABLE_SET_STR_NOT_NULL("message", line->data->message);
+            /*
+             * fill the hashtable only for the first callback and when the
+             * line was updated by a callback
+             */
+            if (!hashtable_filled)
+            {
+                HASHTABLE_SET_POINTER("buffer", line->data->buffer);
+                HASHTABLE_SET_STR("buffer_name", line->data->buffer->full_name);
+                HASHTABLE_SET_STR("buffer_type",
+                                  gui_buffer_type_string[line->data->buffer->type]);
+                HASHTABLE_SET_INT("y", line->data->y);
+                HASHTABLE_SET_TIME("date", line->data->date);
+                HASHTABLE_SET_TIME("date_printed", line->data->date_printed);
+                HASHTABLE_SET_STR_NOT_NULL("str_time", line->data->str_time);
+                HASHTABLE_SET_INT("tags_count", line->data->tags_count);
+                HASHTABLE_SET_POINTER("tags_array", line->data->tags_array);
+                str_tags = string_rebuild_split_string (
+                    (const char **)line->data->tags_array, ",", 0, -1);
+                HASHTABLE_SET_STR_NOT_NULL("tags", str_tags);
+                if (str_tags)
+                    free (str_tags);
+                HASHTABLE_SET_INT("displayed", line->data->displayed);
+                HASHTABLE_SET_INT("notify_level", line->data->notify_level);
+                HASHTABLE_SET_INT("highlight", line->data->highlight);
+                HASHTABLE_SET_STR_NOT_NULL("prefix", line->data->prefix);
+                HASHTABLE_SET_STR_NOT_NULL("message", line->data->message);
+                hashtable_filled = 1;
+            }
 
             /* run callback */
             ptr_hook->running = 1;
@@ -192,6 +203,7 @@ hook_line_exec (struct t_gui_line *line)
             {
                 gui_line_hook_update (line, hashtable, hashtable2);
                 hashtable_free (hashtable2);
+                hashtable_filled = 0;
                 if (!line->data->buffer)
                     break;
             }
@@ -113,6 +113,44 @@ hook_print (struct t_weechat_plugin *plugin, struct t_gui_buffer *buffer,
     return new_hook;
 }
 
+/*
+ * Copies a string without colors cached in a line, before it is sent to a
+ * callback: the callback may update the line, and then the cached string is
+ * freed.
+ *
+ * The buffer "str_buffer" is used for short strings, so that no memory is
+ * allocated for most lines.
+ *
+ * Note: result must be freed with function hook_print_free_copy.
+ */
+
+char *
+hook_print_copy (const char *string, char *str_buffer, int size_buffer)
+{
+    int length;
+
+    if (!string)
+        return NULL;
+
+    length = strlen (string) + 1;
+    if (length > size_buffer)
+        return strdup (string);
+
+    memcpy (str_buffer, string, length);
+    return str_buffer;
+}
+
+/*
+ * Frees a string returned by function hook_print_copy.
+ */
+
+void
+hook_print_free_copy (char *string, const char *str_buffer)
+{
+    if (string && (string != str_buffer))
+        free (string);
+}
+
 /*
  * Executes a print hook.
  */
@@ -121,7 +159,8 @@ void
 hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
 {
     struct t_hook *ptr_hook, *next_hook;
-    char *prefix_no_color, *message_no_color;
+    const char *prefix_no_color, *message_no_color;
+    char str_prefix[256], str_message[4096], *prefix_copy, *message_copy;
 
     if (!weechat_hooks[HOOK_TYPE_PRINT])
         return;
@@ -129,17 +168,6 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
     if (!line->data->message)
         return;
 
-    prefix_no_color = (line->data->prefix) ?
-        gui_color_decode (line->data->prefix, NULL) : NULL;
-
-    message_no_color = gui_color_decode (line->data->message, NULL);
-    if (!message_no_color)
-    {
-        if (prefix_no_color)
-            free (prefix_no_color);
-        return;
-    }
-
     hook_exec_start ();
 
     ptr_hook = weechat_hooks[HOOK_TYPE_PRINT];
@@ -147,19 +175,42 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
     {
         next_hook = ptr_hook->next_hook;
 
+        /*
+         * prefix and message without colors are cached in line data (and
+         * computed only once); they are read again for each hook because a
+         * callback may have updated the line
+         */
+        prefix_no_color = gui_line_get_prefix_no_color (line->data);
+        message_no_color = gui_line_get_message_no_color (line->data);
+
         if (!ptr_hook->deleted
             && !ptr_hook->running
+            && message_no_color
             && (!HOOK_PRINT(ptr_hook, buffer)
                 || (buffer == HOOK_PRINT(ptr_hook, buffer)))
             && (!HOOK_PRINT(ptr_hook, message)
                 || !HOOK_PRINT(ptr_hook, message)[0]
-                || string_strcasestr (prefix_no_color, HOOK_PRINT(ptr_hook, message))
+                || (prefix_no_color
+                    && string_strcasestr (prefix_no_color, HOOK_PRINT(ptr_hook, message)))
                 || string_strcasestr (message_no_color, HOOK_PRINT(ptr_hook, message)))
             && (!HOOK_PRINT(ptr_hook, tags_array)
                 || gui_line_match_tags (line->data,
                                         HOOK_PRINT(ptr_hook, tags_count),
                                         HOOK_PRINT(ptr_hook, tags_array))))
         {
+            /* send a copy of strings without colors (see hook_print_copy) */
+            prefix_copy = NULL;
+            message_copy = NULL;
+            if (HOOK_PRINT(ptr_hook, strip_colors))
+            {
+                prefix_copy = hook_print_copy (prefix_no_color,
+                                               str_prefix,
+                                               sizeof (str_prefix));
+                message_copy = hook_print_copy (message_no_color,
+                                                str_message,
+                                                sizeof (str_message));
+            }
+
             /* run callback */
             ptr_hook->running = 1;
             (void) (HOOK_PRINT(ptr_hook, callback))
@@ -170,19 +221,17 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
                  line->data->tags_count,
                  (const char **)line->data->tags_array,
                  (int)line->data->displayed, (int)line->data->highlight,
-                 (HOOK_PRINT(ptr_hook, strip_colors)) ? prefix_no_color : line->data->prefix,
-                 (HOOK_PRINT(ptr_hook, strip_colors)) ? message_no_color : line->data->message);
+                 (HOOK_PRINT(ptr_hook, strip_colors)) ? prefix_copy : line->data->prefix,
+                 (HOOK_PRINT(ptr_hook, strip_colors)) ? message_copy : line->data->message);
             ptr_hook->running = 0;
+
+            hook_print_free_copy (prefix_copy, str_prefix);
+            hook_print_free_copy (message_copy, str_message);
         }
 
         ptr_hook = next_hook;
     }
 
-    if (prefix_no_color)
-        free (prefix_no_color);
-    if (message_no_color)
-        free (message_no_color);
-
     hook_exec_end ();
 }
 
@@ -54,6 +54,9 @@ extern struct t_hook *hook_print (struct t_weechat_plugin *plugin,
                                   t_hook_callback_print *callback,
                                   const void *callback_pointer,
                                   void *callback_data);
+extern char *hook_print_copy (const char *string, char *str_buffer,
+                              int size_buffer);
+extern void hook_print_free_copy (char *string, const char *str_buffer);
 extern void hook_print_exec (struct t_gui_buffer *buffer,
                              struct t_gui_line *line);
 extern void hook_print_free_data (struct t_hook *hook);
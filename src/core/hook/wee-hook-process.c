@@ -32,18 +32,29 @@
 #include <errno.h>
 
 #include "../weechat.h"
+#include "../wee-config.h"
 #include "../wee-hashtable.h"
 #include "../wee-hook.h"
 #include "../wee-infolist.h"
 #include "../wee-log.h"
 #include "../wee-string.h"
+#include "../wee-thread-pool.h"
 #include "../wee-url.h"
 #include "../../gui/gui-chat.h"
 #include "../../plugins/plugin.h"
 
 
 int hook_process_pending = 0;          /* 1 if there are some process to    */
-                                       /* run (via fork)                    */
+                                       /* run (via fork or thread)          */
+
+/* URL transfer run in a thread */
+struct t_hook_process_url
+{
+    struct t_url_transfer transfer;    /* curl transfer                     */
+    int rc_init;                       /* return code of transfer init      */
+    FILE *output;                      /* stdout pipe (write side)          */
+    FILE *error;                       /* stderr pipe (write side)          */
+};
 
 
 void hook_process_run (struct t_hook *hook_process);
@@ -88,6 +99,7 @@ hook_process_hashtable (struct t_weechat_plugin *plugin,
     char *stdout_buffer, *stderr_buffer, *error;
     const char *ptr_value;
     long number;
+    int buffer_max;
 
     stdout_buffer = NULL;
     stderr_buffer = NULL;
@@ -97,11 +109,26 @@ hook_process_hashtable (struct t_weechat_plugin *plugin,
     if (!command || !command[0] || !callback)
         goto error;
 
-    stdout_buffer = malloc (HOOK_PROCESS_BUFFER_SIZE + 1);
+    buffer_max = HOOK_PROCESS_BUFFER_SIZE;
+    if (options)
+    {
+        ptr_value = hashtable_get (options, "buffer_size");
+        if (ptr_value && ptr_value[0])
+        {
+            number = strtol (ptr_value, &error, 10);
+            if (error && !error[0]
+                && (number >= 1) && (number <= HOOK_PROCESS_BUFFER_SIZE_MAX))
+            {
+                buffer_max = (int)number;
+            }
+        }
+    }
+
+    stdout_buffer = malloc (buffer_max + 1);
     if (!stdout_buffer)
         goto error;
 
-    stderr_buffer = malloc (HOOK_PROCESS_BUFFER_SIZE + 1);
+    stderr_buffer = malloc (buffer_max + 1);
     if (!stderr_buffer)
         goto error;
 
@@ -130,6 +157,7 @@ hook_process_hashtable (struct t_weechat_plugin *plugin,
     new_hook_process->child_write[HOOK_PROCESS_STDOUT] = -1;
     new_hook_process->child_write[HOOK_PROCESS_STDERR] = -1;
     new_hook_process->child_pid = 0;
+    new_hook_process->thread_job = NULL;
     new_hook_process->hook_fd[HOOK_PROCESS_STDIN] = NULL;
     new_hook_process->hook_fd[HOOK_PROCESS_STDOUT] = NULL;
     new_hook_process->hook_fd[HOOK_PROCESS_STDERR] = NULL;
@@ -140,7 +168,10 @@ hook_process_hashtable (struct t_weechat_plugin *plugin,
     new_hook_process->buffer_size[HOOK_PROCESS_STDIN] = 0;
     new_hook_process->buffer_size[HOOK_PROCESS_STDOUT] = 0;
     new_hook_process->buffer_size[HOOK_PROCESS_STDERR] = 0;
-    new_hook_process->buffer_flush = HOOK_PROCESS_BUFFER_SIZE;
+    new_hook_process->buffer_max = buffer_max;
+    new_hook_process->buffer_flush = buffer_max;
+    new_hook_process->line_mode = 0;
+    new_hook_process->backpressure = 0;
     if (options)
     {
         ptr_value = hashtable_get (options, "buffer_flush");
@@ -148,11 +179,19 @@ hook_process_hashtable (struct t_weechat_plugin *plugin,
         {
             number = strtol (ptr_value, &error, 10);
             if (error && !error[0]
-                && (number >= 1) && (number <= HOOK_PROCESS_BUFFER_SIZE))
+                && (number >= 1) && (number <= buffer_max))
             {
                 new_hook_process->buffer_flush = (int)number;
             }
         }
+        ptr_value = hashtable_get (options, "line_mode");
+        new_hook_process->line_mode = (ptr_value
+                                       && (strcmp (ptr_value, "1") == 0)) ?
+            1 : 0;
+        ptr_value = hashtable_get (options, "backpressure");
+        new_hook_process->backpressure = (ptr_value
+                                          && (strcmp (ptr_value, "1") == 0)) ?
+            1 : 0;
     }
 
     hook_add_to_list (new_hook);
@@ -376,20 +415,45 @@ hook_process_child (struct t_hook *hook_process)
 
 /*
  * Sends buffers (stdout/stderr) to callback.
+ *
+ * In line mode, while the process is running, only complete lines are sent
+ * (the incomplete line at the end of buffer is kept for next call), unless
+ * the buffer is full.
  */
 
 void
 hook_process_send_buffers (struct t_hook *hook_process, int callback_rc)
 {
-    int size;
+    int index[2] = { HOOK_PROCESS_STDOUT, HOOK_PROCESS_STDERR };
+    int size[2], length[2], i;
+    char *ptr_buffer[2], saved_char[2];
 
-    /* add '\0' at end of stdout and stderr */
-    size = HOOK_PROCESS(hook_process, buffer_size[HOOK_PROCESS_STDOUT]);
-    if (size > 0)
-        HOOK_PROCESS(hook_process, buffer[HOOK_PROCESS_STDOUT])[size] = '\0';
-    size = HOOK_PROCESS(hook_process, buffer_size[HOOK_PROCESS_STDERR]);
-    if (size > 0)
-        HOOK_PROCESS(hook_process, buffer[HOOK_PROCESS_STDERR])[size] = '\0';
+    for (i = 0; i < 2; i++)
+    {
+        ptr_buffer[i] = HOOK_PROCESS(hook_process, buffer[index[i]]);
+        size[i] = HOOK_PROCESS(hook_process, buffer_size[index[i]]);
+        length[i] = size[i];
+        if (HOOK_PROCESS(hook_process, line_mode)
+            && (callback_rc == WEECHAT_HOOK_PROCESS_RUNNING)
+            && (size[i] < HOOK_PROCESS(hook_process, buffer_max)))
+        {
+            while ((length[i] > 0) && (ptr_buffer[i][length[i] - 1] != '\n'))
+            {
+                length[i]--;
+            }
+        }
+        /* add '\0' at end of data sent */
+        saved_char[i] = ptr_buffer[i][length[i]];
+        ptr_buffer[i][length[i]] = '\0';
+    }
+
+    if ((callback_rc == WEECHAT_HOOK_PROCESS_RUNNING)
+        && (length[0] == 0) && (length[1] == 0))
+    {
+        ptr_buffer[0][0] = saved_char[0];
+        ptr_buffer[1][0] = saved_char[1];
+        return;
+    }
 
     /* send buffers to callback */
     (void) (HOOK_PROCESS(hook_process, callback))
@@ -397,63 +461,107 @@ hook_process_send_buffers (struct t_hook *hook_process, int callback_rc)
          hook_process->callback_data,
          HOOK_PROCESS(hook_process, command),
          callback_rc,
-         (HOOK_PROCESS(hook_process, buffer_size[HOOK_PROCESS_STDOUT]) > 0) ?
-         HOOK_PROCESS(hook_process, buffer[HOOK_PROCESS_STDOUT]) : NULL,
-         (HOOK_PROCESS(hook_process, buffer_size[HOOK_PROCESS_STDERR]) > 0) ?
-         HOOK_PROCESS(hook_process, buffer[HOOK_PROCESS_STDERR]) : NULL);
-
-    /* reset size for stdout and stderr */
-    HOOK_PROCESS(hook_process, buffer_size[HOOK_PROCESS_STDOUT]) = 0;
-    HOOK_PROCESS(hook_process, buffer_size[HOOK_PROCESS_STDERR]) = 0;
+         (length[0] > 0) ? ptr_buffer[0] : NULL,
+         (length[1] > 0) ? ptr_buffer[1] : NULL);
+
+    /* the hook may have been removed by the callback */
+    if (hook_process->deleted || !hook_process->hook_data)
+        return;
+
+    /* keep only data not sent (incomplete line in line mode) */
+    for (i = 0; i < 2; i++)
+    {
+        ptr_buffer[i][length[i]] = saved_char[i];
+        if ((length[i] > 0) && (length[i] < size[i]))
+        {
+            memmove (ptr_buffer[i], ptr_buffer[i] + length[i],
+                     size[i] - length[i]);
+        }
+        HOOK_PROCESS(hook_process, buffer_size[index[i]]) = size[i] - length[i];
+    }
 }
 
 /*
- * Adds some data to buffer (stdout or stderr).
+ * Sets non-blocking mode on a pipe read by WeeChat.
  */
 
 void
-hook_process_add_to_buffer (struct t_hook *hook_process, int index_buffer,
-                            const char *buffer, int size)
+hook_process_set_nonblock (int fd)
 {
-    if (HOOK_PROCESS(hook_process, buffer_size[index_buffer]) + size > HOOK_PROCESS_BUFFER_SIZE)
-        hook_process_send_buffers (hook_process, WEECHAT_HOOK_PROCESS_RUNNING);
+    int flags;
 
-    memcpy (HOOK_PROCESS(hook_process, buffer[index_buffer]) +
-            HOOK_PROCESS(hook_process, buffer_size[index_buffer]),
-            buffer, size);
-    HOOK_PROCESS(hook_process, buffer_size[index_buffer]) += size;
+    if (fd < 0)
+        return;
+
+    flags = fcntl (fd, F_GETFL);
+    if (flags >= 0)
+        fcntl (fd, F_SETFL, flags | O_NONBLOCK);
 }
 
 /*
  * Reads process output (stdout or stderr) from child process.
+ *
+ * Data is read directly in the buffer. Unless backpressure is enabled, the
+ * pipe (non-blocking) is read until it is empty, or until the size of
+ * buffer has been read: output is then sent in large batches. With
+ * backpressure, the pipe is read only once per main loop iteration, so
+ * that a process writing faster than the callback consumes the output is
+ * slowed down by the pipe.
  */
 
 void
 hook_process_child_read (struct t_hook *hook_process, int fd,
                          int index_buffer, struct t_hook **hook_fd)
 {
-    char buffer[HOOK_PROCESS_BUFFER_SIZE / 8];
-    int num_read;
+    int num_read, space, total_read;
 
     if (hook_process->deleted)
         return;
 
-    num_read = read (fd, buffer, sizeof (buffer) - 1);
-    if (num_read > 0)
+    total_read = 0;
+    while (1)
     {
-        hook_process_add_to_buffer (hook_process, index_buffer,
-                                    buffer, num_read);
-        if (HOOK_PROCESS(hook_process, buffer_size[index_buffer]) >=
-            HOOK_PROCESS(hook_process, buffer_flush))
+        space = HOOK_PROCESS(hook_process, buffer_max)
+            - HOOK_PROCESS(hook_process, buffer_size[index_buffer]);
+        if (space <= 0)
         {
             hook_process_send_buffers (hook_process,
                                        WEECHAT_HOOK_PROCESS_RUNNING);
+            if (hook_process->deleted || !hook_process->hook_data)
+                return;
+            continue;
+        }
+        num_read = read (fd,
+                         HOOK_PROCESS(hook_process, buffer[index_buffer]) +
+                         HOOK_PROCESS(hook_process, buffer_size[index_buffer]),
+                         space);
+        if (num_read > 0)
+        {
+            HOOK_PROCESS(hook_process, buffer_size[index_buffer]) += num_read;
+            total_read += num_read;
+            if (HOOK_PROCESS(hook_process, buffer_size[index_buffer]) >=
+                HOOK_PROCESS(hook_process, buffer_flush))
+            {
+                hook_process_send_buffers (hook_process,
+                                           WEECHAT_HOOK_PROCESS_RUNNING);
+                if (hook_process->deleted || !hook_process->hook_data)
+                    return;
+            }
+            if (HOOK_PROCESS(hook_process, backpressure)
+                || (total_read >= HOOK_PROCESS(hook_process, buffer_max)))
+            {
+                break;
+            }
+        }
+        else
+        {
+            if (num_read == 0)
+            {
+                unhook (*hook_fd);
+                *hook_fd = NULL;
+            }
+            break;
         }
-    }
-    else if (num_read == 0)
-    {
-        unhook (*hook_fd);
-        *hook_fd = NULL;
     }
 }
 
@@ -567,6 +675,9 @@ hook_process_child_read_until_eof (struct t_hook *hook_process)
             }
         }
 
+        if (hook_process->deleted)
+            break;
+
         count++;
     }
 }
@@ -593,6 +704,8 @@ hook_process_timer_cb (const void *pointer, void *data, int remaining_calls)
     if (remaining_calls == 0)
     {
         hook_process_send_buffers (hook_process, WEECHAT_HOOK_PROCESS_ERROR);
+        if (hook_process->deleted)
+            return WEECHAT_RC_OK;
         if (weechat_debug_core >= 1)
         {
             gui_chat_printf (NULL,
@@ -600,10 +713,27 @@ hook_process_timer_cb (const void *pointer, void *data, int remaining_calls)
                              HOOK_PROCESS(hook_process, command),
                              ((float)HOOK_PROCESS(hook_process, timeout)) / 1000);
         }
-        kill (HOOK_PROCESS(hook_process, child_pid), SIGKILL);
-        usleep (1000);
+        if (!HOOK_PROCESS(hook_process, thread_job))
+        {
+            kill (HOOK_PROCESS(hook_process, child_pid), SIGKILL);
+            usleep (1000);
+        }
         unhook (hook_process);
     }
+    else if (HOOK_PROCESS(hook_process, thread_job))
+    {
+        if (thread_pool_job_done (HOOK_PROCESS(hook_process, thread_job)))
+        {
+            /* job terminated in thread */
+            rc = HOOK_PROCESS(hook_process, thread_job)->rc;
+            hook_process_child_read_until_eof (hook_process);
+            if (!hook_process->deleted)
+            {
+                hook_process_send_buffers (hook_process, rc);
+                unhook (hook_process);
+            }
+        }
+    }
     else
     {
         if (waitpid (HOOK_PROCESS(hook_process, child_pid),
@@ -614,16 +744,22 @@ hook_process_timer_cb (const void *pointer, void *data, int remaining_calls)
                 /* child terminated normally */
                 rc = WEXITSTATUS(status);
                 hook_process_child_read_until_eof (hook_process);
-                hook_process_send_buffers (hook_process, rc);
-                unhook (hook_process);
+                if (!hook_process->deleted)
+                {
+                    hook_process_send_buffers (hook_process, rc);
+                    unhook (hook_process);
+                }
             }
             else if (WIFSIGNALED(status))
             {
                 /* child terminated by a signal */
                 hook_process_child_read_until_eof (hook_process);
-                hook_process_send_buffers (hook_process,
-                                           WEECHAT_HOOK_PROCESS_ERROR);
-                unhook (hook_process);
+                if (!hook_process->deleted)
+                {
+                    hook_process_send_buffers (hook_process,
+                                               WEECHAT_HOOK_PROCESS_ERROR);
+                    unhook (hook_process);
+                }
             }
         }
     }
@@ -632,18 +768,237 @@ hook_process_timer_cb (const void *pointer, void *data, int remaining_calls)
 }
 
 /*
- * Executes process command in child, and read data in current process,
- * with fd hook.
+ * Creates the timer used to check the end of child process (or thread), and
+ * the timeout.
+ */
+
+void
+hook_process_add_timer (struct t_hook *hook_process)
+{
+    int timeout, max_calls;
+    long interval;
+
+    timeout = HOOK_PROCESS(hook_process, timeout);
+    interval = 100;
+    max_calls = 0;
+    if (timeout > 0)
+    {
+        if (timeout <= 100)
+        {
+            interval = timeout;
+            max_calls = 1;
+        }
+        else
+        {
+            interval = 100;
+            max_calls = timeout / 100;
+            if (timeout % 100 == 0)
+                max_calls++;
+        }
+    }
+    HOOK_PROCESS(hook_process, hook_timer) = hook_timer (hook_process->plugin,
+                                                         interval, 0, max_calls,
+                                                         &hook_process_timer_cb,
+                                                         hook_process,
+                                                         NULL);
+}
+
+/*
+ * Checks if a process hook must run in a thread instead of a child process.
+ *
+ * A thread is used only for "url:", unless option "thread" is "0" (and if
+ * option weechat.network.process_threads is > 0 and if the process is not
+ * detached and has no stdin).
+ *
+ * A function ("func:") always runs in a child process: its output on
+ * stdout/stderr is sent to the callback, and it can be killed on timeout.
+ *
+ * Returns:
+ *   1: process must run in a thread
+ *   0: process must run in a child process (fork)
+ */
+
+int
+hook_process_use_thread (struct t_hook *hook_process)
+{
+    const char *ptr_thread;
+
+    if ((CONFIG_INTEGER(config_network_process_threads) <= 0)
+        || HOOK_PROCESS(hook_process, detached))
+    {
+        return 0;
+    }
+
+    ptr_thread = NULL;
+    if (HOOK_PROCESS(hook_process, options))
+    {
+        if (hashtable_has_key (HOOK_PROCESS(hook_process, options), "stdin"))
+            return 0;
+        ptr_thread = hashtable_get (HOOK_PROCESS(hook_process, options),
+                                    "thread");
+    }
+
+    if (strncmp (HOOK_PROCESS(hook_process, command), "url:", 4) == 0)
+        return (!ptr_thread || (strcmp (ptr_thread, "0") != 0)) ? 1 : 0;
+
+    return 0;
+}
+
+/*
+ * Frees an URL transfer run in a thread.
+ */
+
+void
+hook_process_url_free (void *arg)
+{
+    struct t_hook_process_url *url;
+
+    url = (struct t_hook_process_url *)arg;
+
+    weeurl_transfer_end (&url->transfer);
+    if (url->output)
+        fclose (url->output);
+    if (url->error)
+        fclose (url->error);
+    free (url);
+}
+
+/*
+ * Runs an URL transfer (function called in a worker thread).
+ *
+ * Output and errors are written in pipes, which are closed at the end of
+ * transfer.
+ */
+
+int
+hook_process_url_thread_cb (void *arg)
+{
+    struct t_hook_process_url *url;
+    int rc;
+
+    url = (struct t_hook_process_url *)arg;
+
+    rc = url->rc_init;
+    if (rc == 0)
+        rc = weeurl_transfer_perform (&url->transfer);
+    weeurl_transfer_end (&url->transfer);
+
+    fclose (url->output);
+    url->output = NULL;
+    fclose (url->error);
+    url->error = NULL;
+
+    return rc;
+}
+
+/*
+ * Executes an URL transfer in a thread of the pool.
+ *
+ * The transfer is initialized in main thread (options and proxy are read
+ * here) and the output of transfer is read with fd hooks, like for a child
+ * process.
+ *
+ * Returns:
+ *   1: OK, job added
+ *   0: error (the process can then run in a child process)
+ */
+
+int
+hook_process_run_thread (struct t_hook *hook_process)
+{
+    struct t_hook_process_url *url;
+    struct t_thread_pool_job *job;
+    const char *ptr_url;
+    int pipes[2][2], i;
+
+    url = calloc (1, sizeof (*url));
+    if (!url)
+        return 0;
+
+    for (i = 0; i < 2; i++)
+    {
+        pipes[i][0] = -1;
+        pipes[i][1] = -1;
+    }
+    if ((pipe (pipes[0]) < 0) || (pipe (pipes[1]) < 0))
+        goto error;
+    url->output = fdopen (pipes[0][1], "w");
+    if (!url->output)
+        goto error;
+    pipes[0][1] = -1;
+    url->error = fdopen (pipes[1][1], "w");
+    if (!url->error)
+        goto error;
+    pipes[1][1] = -1;
+
+    ptr_url = HOOK_PROCESS(hook_process, command) + 4;
+    while (ptr_url[0] == ' ')
+    {
+        ptr_url++;
+    }
+    url->rc_init = weeurl_transfer_init (&url->transfer, ptr_url,
+                                         HOOK_PROCESS(hook_process, options),
+                                         url->output, url->error);
+
+    job = thread_pool_job_add (&hook_process_url_thread_cb, url,
+                               &hook_process_url_free,
+                               CONFIG_INTEGER(config_network_process_threads));
+    if (!job)
+        goto error;
+
+    HOOK_PROCESS(hook_process, thread_job) = job;
+    HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDOUT]) = pipes[0][0];
+    HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDERR]) = pipes[1][0];
+    hook_process_set_nonblock (pipes[0][0]);
+    hook_process_set_nonblock (pipes[1][0]);
+
+    HOOK_PROCESS(hook_process, hook_fd[HOOK_PROCESS_STDOUT]) =
+        hook_fd (hook_process->plugin,
+                 HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDOUT]),
+                 1, 0, 0,
+                 &hook_process_child_read_stdout_cb,
+                 hook_process, NULL);
+    HOOK_PROCESS(hook_process, hook_fd[HOOK_PROCESS_STDERR]) =
+        hook_fd (hook_process->plugin,
+                 HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDERR]),
+                 1, 0, 0,
+                 &hook_process_child_read_stderr_cb,
+                 hook_process, NULL);
+
+    hook_process_add_timer (hook_process);
+
+    return 1;
+
+error:
+    for (i = 0; i < 2; i++)
+    {
+        if (pipes[i][0] >= 0)
+            close (pipes[i][0]);
+        if (pipes[i][1] >= 0)
+            close (pipes[i][1]);
+    }
+    hook_process_url_free (url);
+    return 0;
+}
+
+/*
+ * Executes process command in child (or in a thread, see function
+ * hook_process_use_thread), and read data in current process, with fd hook.
  */
 
 void
 hook_process_run (struct t_hook *hook_process)
 {
-    int pipes[3][2], timeout, max_calls, rc, i;
+    int pipes[3][2], rc, i;
     char str_error[1024];
-    long interval;
     pid_t pid;
 
+    if (hook_process_use_thread (hook_process)
+        && hook_process_run_thread (hook_process))
+    {
+        return;
+    }
+
     for (i = 0; i < 3; i++)
     {
         pipes[i][0] = -1;
@@ -724,6 +1079,8 @@ hook_process_run (struct t_hook *hook_process)
 
     if (HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDOUT]) >= 0)
     {
+        hook_process_set_nonblock (
+            HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDOUT]));
         HOOK_PROCESS(hook_process, hook_fd[HOOK_PROCESS_STDOUT]) =
             hook_fd (hook_process->plugin,
                      HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDOUT]),
@@ -734,6 +1091,8 @@ hook_process_run (struct t_hook *hook_process)
 
     if (HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDERR]) >= 0)
     {
+        hook_process_set_nonblock (
+            HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDERR]));
         HOOK_PROCESS(hook_process, hook_fd[HOOK_PROCESS_STDERR]) =
             hook_fd (hook_process->plugin,
                      HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDERR]),
@@ -742,29 +1101,7 @@ hook_process_run (struct t_hook *hook_process)
                      hook_process, NULL);
     }
 
-    timeout = HOOK_PROCESS(hook_process, timeout);
-    interval = 100;
-    max_calls = 0;
-    if (timeout > 0)
-    {
-        if (timeout <= 100)
-        {
-            interval = timeout;
-            max_calls = 1;
-        }
-        else
-        {
-            interval = 100;
-            max_calls = timeout / 100;
-            if (timeout % 100 == 0)
-                max_calls++;
-        }
-    }
-    HOOK_PROCESS(hook_process, hook_timer) = hook_timer (hook_process->plugin,
-                                                         interval, 0, max_calls,
-                                                         &hook_process_timer_cb,
-                                                         hook_process,
-                                                         NULL);
+    hook_process_add_timer (hook_process);
     return;
 
 error:
@@ -802,7 +1139,8 @@ hook_process_exec ()
 
         if (!ptr_hook->deleted
             && !ptr_hook->running
-            && (HOOK_PROCESS(ptr_hook, child_pid) == 0))
+            && (HOOK_PROCESS(ptr_hook, child_pid) == 0)
+            && !HOOK_PROCESS(ptr_hook, thread_job))
         {
             ptr_hook->running = 1;
             hook_process_run (ptr_hook);
@@ -824,14 +1162,11 @@ hook_process_exec ()
 void
 hook_process_free_data (struct t_hook *hook)
 {
+    struct t_hook_process_url *url;
+
     if (!hook || !hook->hook_data)
         return;
 
-    if (HOOK_PROCESS(hook, command))
-    {
-        free (HOOK_PROCESS(hook, command));
-        HOOK_PROCESS(hook, command) = NULL;
-    }
     if (HOOK_PROCESS(hook, options))
     {
         hashtable_free (HOOK_PROCESS(hook, options));
@@ -857,6 +1192,15 @@ hook_process_free_data (struct t_hook *hook)
         unhook (HOOK_PROCESS(hook, hook_timer));
         HOOK_PROCESS(hook, hook_timer) = NULL;
     }
+    if (HOOK_PROCESS(hook, thread_job))
+    {
+        /* abort transfer: a running job is freed by its thread */
+        url = (struct t_hook_process_url *)HOOK_PROCESS(hook, thread_job)->arg;
+        url->transfer.cancel = 1;
+        if (thread_pool_job_free (HOOK_PROCESS(hook, thread_job)))
+            hook_process_url_free (url);
+        HOOK_PROCESS(hook, thread_job) = NULL;
+    }
     if (HOOK_PROCESS(hook, child_pid) > 0)
     {
         kill (HOOK_PROCESS(hook, child_pid), SIGKILL);
@@ -908,6 +1252,11 @@ hook_process_free_data (struct t_hook *hook)
         free (HOOK_PROCESS(hook, buffer[HOOK_PROCESS_STDERR]));
         HOOK_PROCESS(hook, buffer[HOOK_PROCESS_STDERR]) = NULL;
     }
+    if (HOOK_PROCESS(hook, command))
+    {
+        free (HOOK_PROCESS(hook, command));
+        HOOK_PROCESS(hook, command) = NULL;
+    }
 
     free (hook->hook_data);
     hook->hook_data = NULL;
@@ -952,6 +1301,8 @@ hook_process_add_to_infolist (struct t_infolist_item *item,
         return 0;
     if (!infolist_new_var_integer (item, "child_pid", HOOK_PROCESS(hook, child_pid)))
         return 0;
+    if (!infolist_new_var_pointer (item, "thread_job", HOOK_PROCESS(hook, thread_job)))
+        return 0;
     if (!infolist_new_var_pointer (item, "hook_fd_stdin", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDIN])))
         return 0;
     if (!infolist_new_var_pointer (item, "hook_fd_stdout", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDOUT])))
@@ -960,6 +1311,14 @@ hook_process_add_to_infolist (struct t_infolist_item *item,
         return 0;
     if (!infolist_new_var_pointer (item, "hook_timer", HOOK_PROCESS(hook, hook_timer)))
         return 0;
+    if (!infolist_new_var_integer (item, "buffer_max", HOOK_PROCESS(hook, buffer_max)))
+        return 0;
+    if (!infolist_new_var_integer (item, "buffer_flush", HOOK_PROCESS(hook, buffer_flush)))
+        return 0;
+    if (!infolist_new_var_integer (item, "line_mode", HOOK_PROCESS(hook, line_mode)))
+        return 0;
+    if (!infolist_new_var_integer (item, "backpressure", HOOK_PROCESS(hook, backpressure)))
+        return 0;
 
     return 1;
 }
@@ -990,8 +1349,13 @@ hook_process_print_log (struct t_hook *hook)
     log_printf ("    child_read[stderr]. . : %d", HOOK_PROCESS(hook, child_read[HOOK_PROCESS_STDERR]));
     log_printf ("    child_write[stderr] . : %d", HOOK_PROCESS(hook, child_write[HOOK_PROCESS_STDERR]));
     log_printf ("    child_pid . . . . . . : %d", HOOK_PROCESS(hook, child_pid));
+    log_printf ("    thread_job. . . . . . : 0x%lx", HOOK_PROCESS(hook, thread_job));
     log_printf ("    hook_fd[stdin]. . . . : 0x%lx", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDIN]));
     log_printf ("    hook_fd[stdout] . . . : 0x%lx", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDOUT]));
     log_printf ("    hook_fd[stderr] . . . : 0x%lx", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDERR]));
     log_printf ("    hook_timer. . . . . . : 0x%lx", HOOK_PROCESS(hook, hook_timer));
+    log_printf ("    buffer_max. . . . . . : %d", HOOK_PROCESS(hook, buffer_max));
+    log_printf ("    buffer_flush. . . . . : %d", HOOK_PROCESS(hook, buffer_flush));
+    log_printf ("    line_mode . . . . . . : %d", HOOK_PROCESS(hook, line_mode));
+    log_printf ("    backpressure. . . . . : %d", HOOK_PROCESS(hook, backpressure));
 }
@@ -23,6 +23,7 @@
 struct t_weechat_plugin;
 struct t_infolist_item;
 struct t_hashtable;
+struct t_thread_pool_job;
 
 #define HOOK_PROCESS(hook, var) (((struct t_hook_process *)hook->hook_data)->var)
 
@@ -31,6 +32,7 @@ struct t_hashtable;
 #define HOOK_PROCESS_STDOUT      1
 #define HOOK_PROCESS_STDERR      2
 #define HOOK_PROCESS_BUFFER_SIZE 65536
+#define HOOK_PROCESS_BUFFER_SIZE_MAX (64 * 1024 * 1024)
 
 typedef int (t_hook_callback_process)(const void *pointer, void *data,
                                       const char *command,
@@ -47,11 +49,15 @@ struct t_hook_process
     int child_read[3];                 /* read stdin/out/err data from child*/
     int child_write[3];                /* write stdin/out/err data for child*/
     pid_t child_pid;                   /* pid of child process              */
+    struct t_thread_pool_job *thread_job; /* job (if run in a thread)       */
     struct t_hook *hook_fd[3];         /* hook fd for stdin/out/err         */
     struct t_hook *hook_timer;         /* timer to check if child has died  */
     char *buffer[3];                   /* buffers for child stdin/out/err   */
     int buffer_size[3];                /* size of child stdin/out/err       */
+    int buffer_max;                    /* allocated size of out/err buffers */
     int buffer_flush;                  /* bytes to flush output buffers     */
+    int line_mode;                     /* 1 = send only complete lines      */
+    int backpressure;                  /* 1 = read pipes once per loop      */
 };
 
 extern int hook_process_pending;
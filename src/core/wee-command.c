@@ -1887,6 +1887,12 @@ COMMAND_CALLBACK(debug)
         return WEECHAT_RC_OK;
     }
 
+    if (string_strcasecmp (argv[1], "config") == 0)
+    {
+        debug_config ();
+        return WEECHAT_RC_OK;
+    }
+
     if (string_strcasecmp (argv[1], "cursor") == 0)
     {
         if (gui_cursor_debug)
@@ -3217,16 +3223,62 @@ COMMAND_CALLBACK(help)
 
 COMMAND_CALLBACK(history)
 {
-    struct t_gui_history *ptr_history;
-    int n, n_total, n_user, displayed;
+    struct t_gui_history *ptr_history, *last_history;
+    const char *ptr_text;
+    int n, n_total, n_user, displayed, global;
 
     /* make C compiler happy */
     (void) pointer;
     (void) data;
-    (void) argv_eol;
 
     n_user = CONFIG_INTEGER(config_history_display_default);
 
+    if ((argc > 1) && (string_strcasecmp (argv[1], "search") == 0))
+    {
+        COMMAND_MIN_ARGS(3, "search");
+        global = (strcmp (argv[2], "-global") == 0) ? 1 : 0;
+        if (global)
+        {
+            COMMAND_MIN_ARGS(4, "search");
+            gui_history_global_load ();
+            last_history = last_gui_history;
+            ptr_text = argv_eol[3];
+        }
+        else
+        {
+            last_history = buffer->last_history;
+            ptr_text = argv_eol[2];
+        }
+        displayed = 0;
+        for (ptr_history = gui_history_search (last_history, ptr_text);
+             ptr_history;
+             ptr_history = gui_history_search (ptr_history->prev_history,
+                                               ptr_text))
+        {
+            if (!displayed)
+            {
+                gui_chat_printf_date_tags (buffer, 0, "no_log,cmd_history", "");
+                gui_chat_printf_date_tags (
+                    buffer, 0, "no_log,cmd_history",
+                    (global) ?
+                    _("Global command history matching \"%s\":") :
+                    _("Buffer command history matching \"%s\":"),
+                    ptr_text);
+            }
+            gui_chat_printf_date_tags (buffer, 0, "no_log,cmd_history",
+                                       "%s", ptr_history->text);
+            displayed = 1;
+        }
+        if (!displayed)
+        {
+            gui_chat_printf_date_tags (buffer, 0, "no_log,cmd_history",
+                                       _("No command found in history "
+                                         "matching \"%s\""),
+                                       ptr_text);
+        }
+        return WEECHAT_RC_OK;
+    }
+
     if (argc == 2)
     {
         if (string_strcasecmp (argv[1], "clear") == 0)
@@ -7666,7 +7718,7 @@ command_init ()
         N_("list"
            " || set <plugin> <level>"
            " || dump|hooks [<plugin>]"
-           " || buffer|certs|color|dirs|infolists|libs|memory|tags|"
+           " || buffer|certs|color|config|dirs|infolists|libs|memory|tags|"
            "term|windows"
            " || mouse|cursor [verbose]"
            " || hdata [free]"
@@ -7683,6 +7735,8 @@ command_init ()
            "   buffer: dump buffer content with hexadecimal values in log file\n"
            "    certs: display number of loaded trusted certificate authorities\n"
            "    color: display infos about current color pairs\n"
+           "   config: display infos about configuration files (with time "
+           "spent to read each file)\n"
            "   cursor: toggle debug for cursor mode\n"
            "     dirs: display directories\n"
            "    hdata: display infos about hdata (with free: remove all hdata "
@@ -7693,7 +7747,8 @@ command_init ()
            "    mouse: toggle debug for mouse\n"
            "     tags: display tags for lines\n"
            "     term: display infos about terminal\n"
-           "  windows: display windows tree\n"
+           "  windows: display windows tree and statistics on refreshes of "
+           "screen\n"
            "     time: measure time to execute a command or to send text to "
            "the current buffer\n"
            "  unicode: display information about string and unicode chars "
@@ -7710,6 +7765,7 @@ command_init ()
         " || buffer"
         " || certs"
         " || color"
+        " || config"
         " || cursor verbose"
         " || dirs"
         " || hdata free"
@@ -8001,10 +8057,14 @@ command_init ()
     hook_command (
         NULL, "history",
         N_("show buffer command history"),
-        N_("clear || <value>"),
-        N_("clear: clear history\n"
-           "value: number of history entries to show"),
-        "clear",
+        N_("clear || <value> || search [-global] <text>"),
+        N_("  clear: clear history\n"
+           "  value: number of history entries to show\n"
+           " search: display history entries containing text "
+           "(case sensitive)\n"
+           "-global: search in global history (instead of buffer history)\n"
+           "   text: text to search"),
+        "clear || search -global",
         &command_history, NULL, NULL);
     /*
      * give high priority (50000) so that an alias will not take precedence
@@ -30,17 +30,22 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <string.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
 #include <errno.h>
 
 #include "weechat.h"
 #include "wee-config-file.h"
 #include "wee-config.h"
+#include "wee-hashtable.h"
 #include "wee-hdata.h"
 #include "wee-hook.h"
 #include "wee-infolist.h"
 #include "wee-log.h"
 #include "wee-string.h"
+#include "wee-util.h"
 #include "wee-version.h"
 #include "../gui/gui-color.h"
 #include "../gui/gui-chat.h"
@@ -82,6 +87,19 @@ config_file_search (const char *name)
     return NULL;
 }
 
+/*
+ * Marks a configuration file as modified: it will be written on next call to
+ * function config_file_write (if not modified, the write is skipped if the
+ * file was not changed on disk).
+ */
+
+void
+config_file_set_modified (struct t_config_file *config_file)
+{
+    if (config_file)
+        config_file->modified = 1;
+}
+
 /*
  * Searches for position of configuration file (to keep configuration files
  * sorted by name).
@@ -158,6 +176,12 @@ config_file_new (struct t_weechat_plugin *plugin, const char *name,
             return NULL;
         }
         new_config_file->file = NULL;
+        new_config_file->modified = 1;
+        new_config_file->file_mtime = 0;
+        new_config_file->file_size = 0;
+        new_config_file->reading = 0;
+        new_config_file->read_lines = 0;
+        new_config_file->read_time = 0;
         new_config_file->callback_reload = callback_reload;
         new_config_file->callback_reload_pointer = callback_reload_pointer;
         new_config_file->callback_reload_data = callback_reload_data;
@@ -283,6 +307,8 @@ config_file_new_section (struct t_config_file *config_file, const char *name,
         new_section->callback_delete_option_data = callback_delete_option_data;
         new_section->options = NULL;
         new_section->last_option = NULL;
+        new_section->options_unsorted = 0;
+        new_section->options_index = NULL;
 
         new_section->prev_section = config_file->last_section;
         new_section->next_section = NULL;
@@ -291,6 +317,8 @@ config_file_new_section (struct t_config_file *config_file, const char *name,
         else
             config_file->sections = new_section;
         config_file->last_section = new_section;
+
+        config_file_set_modified (config_file);
     }
 
     return new_section;
@@ -429,8 +457,167 @@ config_file_option_find_pos (struct t_config_section *section, const char *name)
     return NULL;
 }
 
+/*
+ * Hashes an option name in index of options (case is ignored, like in
+ * function string_strcasecmp).
+ */
+
+unsigned long long
+config_file_options_index_hash_key_cb (struct t_hashtable *hashtable,
+                                       const void *key)
+{
+    unsigned long long hash;
+    const char *ptr_key;
+    int char_key;
+
+    /* make C compiler happy */
+    (void) hashtable;
+
+    hash = 5381;
+    for (ptr_key = (const char *)key; ptr_key[0]; ptr_key++)
+    {
+        char_key = ((ptr_key[0] >= 'A') && (ptr_key[0] <= 'Z')) ?
+            ptr_key[0] + ('a' - 'A') : (unsigned char)ptr_key[0];
+        hash ^= (hash << 5) + (hash >> 2) + char_key;
+    }
+
+    return hash;
+}
+
+/*
+ * Compares two option names in index of options (case is ignored).
+ */
+
+int
+config_file_options_index_keycmp_cb (struct t_hashtable *hashtable,
+                                     const void *key1, const void *key2)
+{
+    /* make C compiler happy */
+    (void) hashtable;
+
+    return string_strcasecmp ((const char *)key1, (const char *)key2);
+}
+
+/*
+ * Builds index of options in a section (used when options are not sorted,
+ * while reading a configuration file).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+config_file_options_index_build (struct t_config_section *section)
+{
+    struct t_config_option *ptr_option;
+
+    if (section->options_index)
+        return 1;
+
+    section->options_index = hashtable_new (
+        256,
+        WEECHAT_HASHTABLE_STRING,
+        WEECHAT_HASHTABLE_POINTER,
+        &config_file_options_index_hash_key_cb,
+        &config_file_options_index_keycmp_cb);
+    if (!section->options_index)
+        return 0;
+
+    for (ptr_option = section->options; ptr_option;
+         ptr_option = ptr_option->next_option)
+    {
+        hashtable_set (section->options_index, ptr_option->name, ptr_option);
+    }
+
+    return 1;
+}
+
+/*
+ * Removes an option from index of options in its section (if the index
+ * exists).
+ */
+
+void
+config_file_options_index_remove (struct t_config_option *option)
+{
+    if (option->section && option->section->options_index && option->name)
+        hashtable_remove (option->section->options_index, option->name);
+}
+
+/*
+ * Compares two options by name (used to sort options of a section).
+ */
+
+int
+config_file_options_qsort_cmp_cb (const void *option1, const void *option2)
+{
+    return string_strcasecmp (
+        (*((struct t_config_option **)option1))->name,
+        (*((struct t_config_option **)option2))->name);
+}
+
+/*
+ * Sorts options of a section (if they were added unsorted while reading
+ * configuration file) and frees the index of options.
+ */
+
+void
+config_file_section_sort_options (struct t_config_section *section)
+{
+    struct t_config_option **options, *ptr_option;
+    int i, num_options;
+
+    if (!section || !section->options_unsorted)
+        return;
+
+    num_options = 0;
+    for (ptr_option = section->options; ptr_option;
+         ptr_option = ptr_option->next_option)
+    {
+        num_options++;
+    }
+
+    options = malloc (num_options * sizeof (*options));
+    if (!options)
+        return;
+
+    i = 0;
+    for (ptr_option = section->options; ptr_option;
+         ptr_option = ptr_option->next_option)
+    {
+        options[i++] = ptr_option;
+    }
+
+    qsort (options, num_options, sizeof (*options),
+           &config_file_options_qsort_cmp_cb);
+
+    for (i = 0; i < num_options; i++)
+    {
+        options[i]->prev_option = (i > 0) ? options[i - 1] : NULL;
+        options[i]->next_option = (i < num_options - 1) ? options[i + 1] : NULL;
+    }
+    section->options = options[0];
+    section->last_option = options[num_options - 1];
+
+    free (options);
+
+    section->options_unsorted = 0;
+    if (section->options_index)
+    {
+        hashtable_free (section->options_index);
+        section->options_index = NULL;
+    }
+}
+
 /*
  * Inserts an option in section (keeping options sorted by name).
+ *
+ * While reading the configuration file, an option which should be inserted
+ * before the last option is added at the end of section, and the options of
+ * the section are sorted once at the end of read (they are searched with an
+ * index in the meantime): this avoids a linear search for each option
+ * created.
  */
 
 void
@@ -441,7 +628,30 @@ config_file_option_insert_in_section (struct t_config_option *option)
     if (!option || !option->section)
         return;
 
-    if (option->section->options)
+    if (option->section->options
+        && option->section->config_file
+        && option->section->config_file->reading
+        && !option->section->options_unsorted
+        && (string_strcasecmp (option->name,
+                               option->section->last_option->name) < 0)
+        && config_file_options_index_build (option->section))
+    {
+        option->section->options_unsorted = 1;
+    }
+
+    if (option->section->options_unsorted)
+    {
+        /* add option to end of section, it will be sorted later */
+        option->prev_option = (option->section)->last_option;
+        option->next_option = NULL;
+        if ((option->section)->last_option)
+            (option->section)->last_option->next_option = option;
+        else
+            (option->section)->options = option;
+        (option->section)->last_option = option;
+        hashtable_set (option->section->options_index, option->name, option);
+    }
+    else if (option->section->options)
     {
         pos_option = config_file_option_find_pos (option->section,
                                                   option->name);
@@ -795,6 +1005,8 @@ config_file_new_option (struct t_config_file *config_file,
             new_option->next_option = NULL;
         }
 
+        config_file_set_modified (new_option->config_file);
+
         /* run config hook(s) */
         if (new_option->config_file && new_option->section)
         {
@@ -840,6 +1052,8 @@ config_file_search_option (struct t_config_file *config_file,
 
     if (section)
     {
+        if (section->options_index)
+            return hashtable_get (section->options_index, option_name);
         for (ptr_option = section->last_option; ptr_option;
              ptr_option = ptr_option->prev_option)
         {
@@ -855,6 +1069,14 @@ config_file_search_option (struct t_config_file *config_file,
         for (ptr_section = config_file->sections; ptr_section;
              ptr_section = ptr_section->next_section)
         {
+            if (ptr_section->options_index)
+            {
+                ptr_option = hashtable_get (ptr_section->options_index,
+                                            option_name);
+                if (ptr_option)
+                    return ptr_option;
+                continue;
+            }
             for (ptr_option = ptr_section->last_option; ptr_option;
                  ptr_option = ptr_option->prev_option)
             {
@@ -1182,6 +1404,10 @@ config_file_option_reset (struct t_config_option *option, int run_callback)
         }
     }
 
+    if (rc == WEECHAT_CONFIG_OPTION_SET_OK_CHANGED)
+        config_file_set_modified (option->config_file);
+
+    /* run callback if asked and value was changed */
     if ((rc == WEECHAT_CONFIG_OPTION_SET_OK_CHANGED)
         && run_callback && option->callback_change)
     {
@@ -1508,6 +1734,9 @@ config_file_option_set (struct t_config_option *option, const char *value,
             rc = WEECHAT_CONFIG_OPTION_SET_OK_SAME_VALUE;
     }
 
+    if (rc == WEECHAT_CONFIG_OPTION_SET_OK_CHANGED)
+        config_file_set_modified (option->config_file);
+
     /* run callback if asked and value was changed */
     if ((rc == WEECHAT_CONFIG_OPTION_SET_OK_CHANGED)
         && run_callback && option->callback_change)
@@ -1666,6 +1895,9 @@ config_file_option_set_null (struct t_config_option *option, int run_callback)
         }
     }
 
+    if (rc == WEECHAT_CONFIG_OPTION_SET_OK_CHANGED)
+        config_file_set_modified (option->config_file);
+
     /* run callback if asked and value was changed */
     if ((rc == WEECHAT_CONFIG_OPTION_SET_OK_CHANGED)
         && run_callback && option->callback_change)
@@ -1786,6 +2018,7 @@ config_file_option_rename (struct t_config_option *option,
         /* remove option from list */
         if (option->section)
         {
+            config_file_options_index_remove (option);
             if (option->prev_option)
                 (option->prev_option)->next_option = option->next_option;
             if (option->next_option)
@@ -1808,6 +2041,8 @@ config_file_option_rename (struct t_config_option *option,
 
     full_new_name = config_file_option_full_name (option);
 
+    config_file_set_modified (option->config_file);
+
     /* rename "parent_name" in any option using the old option name */
     if (full_old_name && full_new_name)
     {
@@ -2468,9 +2703,127 @@ config_file_write_line (struct t_config_file *config_file,
                             option_name));
 }
 
+/*
+ * Checks if a configuration file must be written.
+ *
+ * The write is not needed if the configuration file was not modified since
+ * last write, has no section with a write callback (content written by
+ * callback is unknown) and if the file on disk was not changed since last
+ * write (same modification time and size).
+ *
+ * Returns:
+ *   1: write is needed
+ *   0: write is not needed
+ */
+
+int
+config_file_write_is_needed (struct t_config_file *config_file,
+                             const char *filename)
+{
+    struct t_config_section *ptr_section;
+    struct stat st;
+
+    if (config_file->modified)
+        return 1;
+
+    for (ptr_section = config_file->sections; ptr_section;
+         ptr_section = ptr_section->next_section)
+    {
+        if (ptr_section->callback_write)
+            return 1;
+    }
+
+    if ((stat (filename, &st) != 0)
+        || (st.st_mtime != config_file->file_mtime)
+        || (st.st_size != config_file->file_size))
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Checks if two files have the same content.
+ *
+ * Returns:
+ *   1: files have same content
+ *   0: files are different (or error)
+ */
+
+int
+config_file_same_content (const char *filename1, const char *filename2)
+{
+    FILE *file1, *file2;
+    struct stat st1, st2;
+    char buffer1[16384], buffer2[16384];
+    size_t num_read1, num_read2;
+    int same;
+
+    if ((stat (filename1, &st1) != 0) || (stat (filename2, &st2) != 0)
+        || (st1.st_size != st2.st_size))
+    {
+        return 0;
+    }
+
+    file1 = fopen (filename1, "rb");
+    if (!file1)
+        return 0;
+    file2 = fopen (filename2, "rb");
+    if (!file2)
+    {
+        fclose (file1);
+        return 0;
+    }
+
+    same = 1;
+    while (same)
+    {
+        num_read1 = fread (buffer1, 1, sizeof (buffer1), file1);
+        num_read2 = fread (buffer2, 1, sizeof (buffer2), file2);
+        if ((num_read1 != num_read2)
+            || (memcmp (buffer1, buffer2, num_read1) != 0))
+        {
+            same = 0;
+        }
+        if (num_read1 < sizeof (buffer1))
+            break;
+    }
+    if (ferror (file1) || ferror (file2))
+        same = 0;
+
+    fclose (file1);
+    fclose (file2);
+
+    return same;
+}
+
+/*
+ * Saves modification time and size of a configuration file after write, and
+ * marks the configuration file as not modified.
+ */
+
+void
+config_file_write_done (struct t_config_file *config_file,
+                        const char *filename)
+{
+    struct stat st;
+
+    if (stat (filename, &st) == 0)
+    {
+        config_file->file_mtime = st.st_mtime;
+        config_file->file_size = st.st_size;
+        config_file->modified = 0;
+    }
+}
+
 /*
  * Writes a configuration file (this function must not be called directly).
  *
+ * The write is skipped if the configuration file was not modified since last
+ * write (see function config_file_write_is_needed), and the file is not
+ * replaced if the content written is the same as the current file.
+ *
  * Returns:
  *   WEECHAT_CONFIG_WRITE_OK: OK
  *   WEECHAT_CONFIG_WRITE_ERROR: error
@@ -2525,6 +2878,13 @@ config_file_write_internal (struct t_config_file *config_file,
         }
     }
 
+    if (!default_options && !config_file_write_is_needed (config_file, filename))
+    {
+        free (filename);
+        free (filename2);
+        return WEECHAT_CONFIG_WRITE_OK;
+    }
+
     log_printf (_("Writing configuration file %s%s%s"),
                 config_file->filename,
                 (default_options) ? " " : "",
@@ -2601,6 +2961,18 @@ config_file_write_internal (struct t_config_file *config_file,
     if (fflush (config_file->file) != 0)
         goto error;
 
+    /* same content as current file: keep it (no sync and no rename) */
+    if (config_file_same_content (filename2, filename))
+    {
+        fclose (config_file->file);
+        config_file->file = NULL;
+        unlink (filename2);
+        config_file_write_done (config_file, filename);
+        free (filename);
+        free (filename2);
+        return WEECHAT_CONFIG_WRITE_OK;
+    }
+
     /*
      * ensure the file is really written on the storage device;
      * this is disabled by default because it is really slow
@@ -2622,6 +2994,9 @@ config_file_write_internal (struct t_config_file *config_file,
     /* rename temp file to target file */
     rc = rename (filename2, filename);
 
+    if (rc == 0)
+        config_file_write_done (config_file, filename);
+
     free (filename);
     free (filename2);
 
@@ -2663,6 +3038,124 @@ config_file_write (struct t_config_file *config_file)
     return config_file_write_internal (config_file, 0);
 }
 
+/*
+ * Gets content of a configuration file: the file is mapped in memory (or read
+ * in a buffer if it can not be mapped).
+ *
+ * Argument "mapped" is set to 1 if the content is mapped in memory (it must
+ * then be released with munmap), 0 if it is a buffer (it must then be freed).
+ *
+ * Returns:
+ *   1: OK (content is NULL if the file is empty)
+ *   0: error (errno is set)
+ */
+
+int
+config_file_read_content (const char *filename, char **content, size_t *size,
+                          int *mapped)
+{
+    struct stat st;
+    ssize_t num_read;
+    size_t size_read;
+    int fd, errno_saved;
+
+    *content = NULL;
+    *size = 0;
+    *mapped = 0;
+
+    fd = open (filename, O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    if ((fstat (fd, &st) == 0) && S_ISREG(st.st_mode))
+    {
+        if (st.st_size == 0)
+        {
+            close (fd);
+            return 1;
+        }
+        *content = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (*content != MAP_FAILED)
+        {
+            *size = st.st_size;
+            *mapped = 1;
+            close (fd);
+            return 1;
+        }
+        *content = NULL;
+    }
+
+    /* file can not be mapped: read it in a buffer */
+    size_read = 0;
+    while (1)
+    {
+        if (size_read == *size)
+        {
+            *size = (*size == 0) ? 4096 : *size * 2;
+            *content = realloc (*content, *size);
+            if (!*content)
+            {
+                close (fd);
+                errno = ENOMEM;
+                return 0;
+            }
+        }
+        num_read = read (fd, *content + size_read, *size - size_read);
+        if (num_read < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            errno_saved = errno;
+            free (*content);
+            *content = NULL;
+            *size = 0;
+            close (fd);
+            errno = errno_saved;
+            return 0;
+        }
+        if (num_read == 0)
+            break;
+        size_read += num_read;
+    }
+    *size = size_read;
+
+    close (fd);
+
+    return 1;
+}
+
+/*
+ * Gets next line in content of a configuration file, like function fgets
+ * does with a file: the line is copied in "line" (with the final "\n" if
+ * found), with at most "size_line" - 1 bytes.
+ *
+ * Returns pointer to line, NULL if end of content is reached.
+ */
+
+char *
+config_file_read_line (const char *content, size_t size, size_t *pos,
+                       char *line, int size_line)
+{
+    const char *pos_eol;
+    size_t length;
+
+    if (*pos >= size)
+        return NULL;
+
+    length = size - *pos;
+    if (length > (size_t)(size_line - 1))
+        length = size_line - 1;
+    pos_eol = memchr (content + *pos, '\n', length);
+    if (pos_eol)
+        length = pos_eol - (content + *pos) + 1;
+
+    memcpy (line, content + *pos, length);
+    line[length] = '\0';
+    *pos += length;
+
+    return line;
+}
+
 /*
  * Reads a configuration file (this function must not be called directly).
  *
@@ -2675,11 +3168,13 @@ config_file_write (struct t_config_file *config_file)
 int
 config_file_read_internal (struct t_config_file *config_file, int reload)
 {
-    int filename_length, line_number, rc, undefined_value;
-    char *filename;
+    int filename_length, line_number, rc, undefined_value, mapped;
+    char *filename, *content;
+    size_t size, pos_content;
     struct t_config_section *ptr_section;
     struct t_config_option *ptr_option;
     char line[16384], *ptr_line, *ptr_line2, *pos, *pos2, *ptr_option_name;
+    struct timeval tv_start, tv_end;
 
     if (!config_file)
         return WEECHAT_CONFIG_READ_FILE_NOT_FOUND;
@@ -2701,9 +3196,10 @@ config_file_read_internal (struct t_config_file *config_file, int reload)
         config_file_write_internal (config_file, 1);
     }
 
+    gettimeofday (&tv_start, NULL);
+
     /* read config file */
-    config_file->file = fopen (filename, "r");
-    if (!config_file->file)
+    if (!config_file_read_content (filename, &content, &size, &mapped))
     {
         gui_chat_printf (NULL,
                          _("%sWARNING: failed to read configuration file "
@@ -2724,12 +3220,16 @@ config_file_read_internal (struct t_config_file *config_file, int reload)
     if (!reload)
         log_printf (_("Reading configuration file %s"), config_file->filename);
 
+    config_file->reading = 1;
+
     /* read all lines */
     ptr_section = NULL;
     line_number = 0;
-    while (!feof (config_file->file))
+    pos_content = 0;
+    while (pos_content < size)
     {
-        ptr_line = fgets (line, sizeof (line) - 1, config_file->file);
+        ptr_line = config_file_read_line (content, size, &pos_content,
+                                          line, sizeof (line) - 1);
         line_number++;
         if (ptr_line)
         {
@@ -2917,10 +3417,27 @@ config_file_read_internal (struct t_config_file *config_file, int reload)
         }
     }
 
-    fclose (config_file->file);
-    config_file->file = NULL;
+    /* sort options added unsorted while reading file */
+    config_file->reading = 0;
+    for (ptr_section = config_file->sections; ptr_section;
+         ptr_section = ptr_section->next_section)
+    {
+        config_file_section_sort_options (ptr_section);
+    }
+
+    if (content)
+    {
+        if (mapped)
+            munmap (content, size);
+        else
+            free (content);
+    }
     free (filename);
 
+    gettimeofday (&tv_end, NULL);
+    config_file->read_lines = line_number;
+    config_file->read_time = util_timeval_diff (&tv_start, &tv_end);
+
     return WEECHAT_CONFIG_READ_OK;
 }
 
@@ -3041,6 +3558,10 @@ config_file_option_free (struct t_config_option *option, int run_callback)
 
     ptr_section = option->section;
 
+    config_file_set_modified (option->config_file);
+
+    config_file_options_index_remove (option);
+
     /* free data */
     config_file_option_free_data (option);
 
@@ -3103,6 +3624,8 @@ config_file_section_free (struct t_config_section *section)
 
     /* free data */
     config_file_section_free_options (section);
+    if (section->options_index)
+        hashtable_free (section->options_index);
     if (section->name)
         free (section->name);
     if (section->callback_read_data)
@@ -3133,6 +3656,8 @@ config_file_section_free (struct t_config_section *section)
     free (section);
 
     ptr_config->sections = new_sections;
+
+    config_file_set_modified (ptr_config);
 }
 
 /*
@@ -3549,6 +4074,12 @@ config_file_print_log ()
         log_printf ("  name . . . . . . . . . : '%s'",  ptr_config_file->name);
         log_printf ("  filename . . . . . . . : '%s'",  ptr_config_file->filename);
         log_printf ("  file . . . . . . . . . : 0x%lx", ptr_config_file->file);
+        log_printf ("  modified . . . . . . . : %d",    ptr_config_file->modified);
+        log_printf ("  file_mtime . . . . . . : %lld",  (long long)ptr_config_file->file_mtime);
+        log_printf ("  file_size. . . . . . . : %lld",  (long long)ptr_config_file->file_size);
+        log_printf ("  reading. . . . . . . . : %d",    ptr_config_file->reading);
+        log_printf ("  read_lines . . . . . . : %d",    ptr_config_file->read_lines);
+        log_printf ("  read_time. . . . . . . : %lld",  ptr_config_file->read_time);
         log_printf ("  callback_reload. . . . : 0x%lx", ptr_config_file->callback_reload);
         log_printf ("  callback_reload_pointer: 0x%lx", ptr_config_file->callback_reload_pointer);
         log_printf ("  callback_reload_data . : 0x%lx", ptr_config_file->callback_reload_data);
@@ -3581,6 +4112,8 @@ config_file_print_log ()
             log_printf ("      callback_delete_option_data . : 0x%lx", ptr_section->callback_delete_option_data);
             log_printf ("      options . . . . . . . . . . . : 0x%lx", ptr_section->options);
             log_printf ("      last_option . . . . . . . . . : 0x%lx", ptr_section->last_option);
+            log_printf ("      options_unsorted. . . . . . . : %d",    ptr_section->options_unsorted);
+            log_printf ("      options_index . . . . . . . . : 0x%lx", ptr_section->options_index);
             log_printf ("      prev_section. . . . . . . . . : 0x%lx", ptr_section->prev_section);
             log_printf ("      next_section. . . . . . . . . : 0x%lx", ptr_section->next_section);
 
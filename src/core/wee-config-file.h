@@ -22,6 +22,8 @@
 #define WEECHAT_CONFIG_FILE_H
 
 #include <stdio.h>
+#include <time.h>
+#include <sys/types.h>
 
 #define CONFIG_BOOLEAN(option) (*((int *)((option)->value)))
 #define CONFIG_BOOLEAN_DEFAULT(option) (*((int *)((option)->default_value)))
@@ -40,6 +42,7 @@
 
 struct t_weelist;
 struct t_infolist;
+struct t_hashtable;
 
 struct t_config_option;
 
@@ -50,6 +53,12 @@ struct t_config_file
     char *filename;                        /* filename (without path)       */
                                            /* (example: "weechat.conf")     */
     FILE *file;                            /* file pointer                  */
+    int modified;                          /* 1 if changed since last write */
+    time_t file_mtime;                     /* mtime of file (last write)    */
+    off_t file_size;                       /* size of file (last write)     */
+    int reading;                           /* 1 if file is being read       */
+    int read_lines;                        /* lines in file (last read)     */
+    long long read_time;                   /* time to read file (µs)        */
     int (*callback_reload)                 /* callback for reloading file   */
     (const void *pointer,
      void *data,
@@ -110,6 +119,10 @@ struct t_config_section
     void *callback_delete_option_data;     /* data sent to delete callback  */
     struct t_config_option *options;       /* options in section            */
     struct t_config_option *last_option;   /* last option in section        */
+    int options_unsorted;                  /* 1 if options are not sorted   */
+                                           /* (only while reading file)     */
+    struct t_hashtable *options_index;     /* options by name (only if      */
+                                           /* options are not sorted)       */
     struct t_config_section *prev_section; /* link to previous section      */
     struct t_config_section *next_section; /* link to next section          */
 };
@@ -166,6 +179,7 @@ extern struct t_config_file *config_files;
 extern struct t_config_file *last_config_file;
 
 extern struct t_config_file *config_file_search (const char *name);
+extern void config_file_set_modified (struct t_config_file *config_file);
 extern struct t_config_file *config_file_new (struct t_weechat_plugin *plugin,
                                               const char *name,
                                               int (*callback_reload)(const void *pointer,
@@ -55,6 +55,7 @@
 #include "../gui/gui-chat.h"
 #include "../gui/gui-color.h"
 #include "../gui/gui-filter.h"
+#include "../gui/gui-history.h"
 #include "../gui/gui-hotlist.h"
 #include "../gui/gui-key.h"
 #include "../gui/gui-layout.h"
@@ -153,6 +154,7 @@ struct t_config_option *config_look_jump_previous_buffer_when_closing;
 struct t_config_option *config_look_jump_smart_back_to_buffer;
 struct t_config_option *config_look_key_bind_safe;
 struct t_config_option *config_look_key_grab_delay;
+struct t_config_option *config_look_line_cache_no_color;
 struct t_config_option *config_look_mouse;
 struct t_config_option *config_look_mouse_timer_delay;
 struct t_config_option *config_look_nick_color_force;
@@ -185,6 +187,7 @@ struct t_config_option *config_look_read_marker;
 struct t_config_option *config_look_read_marker_always_show;
 struct t_config_option *config_look_read_marker_string;
 struct t_config_option *config_look_read_marker_update_on_buffer_switch;
+struct t_config_option *config_look_refresh_rate_max;
 struct t_config_option *config_look_save_config_on_exit;
 struct t_config_option *config_look_save_config_with_fsync;
 struct t_config_option *config_look_save_layout_on_exit;
@@ -286,9 +289,11 @@ struct t_config_option *config_completion_partial_completion_templates;
 /* config, history section */
 
 struct t_config_option *config_history_display_default;
+struct t_config_option *config_history_global_file;
 struct t_config_option *config_history_max_buffer_lines_minutes;
 struct t_config_option *config_history_max_buffer_lines_number;
 struct t_config_option *config_history_max_commands;
+struct t_config_option *config_history_max_commands_size;
 struct t_config_option *config_history_max_visited_buffers;
 
 /* config, network section */
@@ -297,6 +302,7 @@ struct t_config_option *config_network_connection_timeout;
 struct t_config_option *config_network_gnutls_ca_system;
 struct t_config_option *config_network_gnutls_ca_user;
 struct t_config_option *config_network_gnutls_handshake_timeout;
+struct t_config_option *config_network_process_threads;
 struct t_config_option *config_network_proxy_curl;
 
 /* config, plugin section */
@@ -602,6 +608,23 @@ config_change_buffer_content (const void *pointer, void *data,
         gui_current_window->refresh_needed = 1;
 }
 
+/*
+ * Callback for changes on option "weechat.look.line_cache_no_color".
+ */
+
+void
+config_change_line_cache_no_color (const void *pointer, void *data,
+                                   struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    if (!CONFIG_BOOLEAN(config_look_line_cache_no_color))
+        gui_line_free_no_color_all ();
+}
+
 /*
  * Callback for changes on option "weechat.look.mouse".
  */
@@ -713,6 +736,7 @@ config_compute_prefix_max_length_all_buffers ()
             ptr_buffer->own_lines->prefix_max_length_refresh = 1;
         if (ptr_buffer->mixed_lines)
             ptr_buffer->mixed_lines->prefix_max_length_refresh = 1;
+        gui_buffer_refresh_queue_add (ptr_buffer);
     }
 }
 
@@ -1318,6 +1342,30 @@ config_change_completion_partial_completion_templates (const void *pointer,
     }
 }
 
+/*
+ * Callback for changes on option "weechat.history.global_file".
+ */
+
+void
+config_change_history_global_file (const void *pointer, void *data,
+                                   struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    /*
+     * if global history was already loaded, load the new file now
+     * (otherwise it will be loaded on first use of global history)
+     */
+    if (gui_history_global_loaded)
+    {
+        gui_history_global_loaded = 0;
+        gui_history_global_load ();
+    }
+}
+
 /*
  * Callback for changes on options "weechat.network.gnutls_ca_system"
  * and "weechat.network.gnutls_ca_user".
@@ -3370,6 +3418,18 @@ config_weechat_init_options ()
            "/help input)"),
         NULL, 1, 10000, "800", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    config_look_line_cache_no_color = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "line_cache_no_color", "boolean",
+        N_("keep in memory prefix and message of lines without colors, so "
+           "that they are computed only once for highlights, filters, search "
+           "of text and print hooks; this makes these features faster but "
+           "uses more memory; when disabled, they are kept only while a "
+           "line is printed"),
+        NULL, 0, 0, "off", NULL, 0,
+        NULL, NULL, NULL,
+        &config_change_line_cache_no_color, NULL, NULL,
+        NULL, NULL, NULL);
     config_look_mouse = config_file_new_option (
         weechat_config_file, ptr_section,
         "mouse", "boolean",
@@ -3691,6 +3751,16 @@ config_weechat_init_options ()
         N_("update the read marker when switching buffers"),
         NULL, 0, 0, "on", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    config_look_refresh_rate_max = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "refresh_rate_max", "integer",
+        N_("maximum number of screen refreshes per second (0 = no limit); "
+           "all changes in chat area, bars and windows between two "
+           "refreshes are displayed at once on next refresh; the screen is "
+           "always refreshed immediately after a key is pressed or the "
+           "terminal is resized"),
+        NULL, 0, 1000, "30", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
     config_look_save_config_on_exit = config_file_new_option (
         weechat_config_file, ptr_section,
         "save_config_on_exit", "boolean",
@@ -4568,6 +4638,20 @@ config_weechat_init_options ()
            "history listing (0 = unlimited)"),
         NULL, 0, INT_MAX, "5", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    config_history_global_file = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "global_file", "string",
+        N_("file used to save global history: commands are appended to "
+           "this file, which is loaded on first use of global history "
+           "(empty value = global history is not saved); the file is "
+           "readable only by the user, but beware that it may contain "
+           "sensitive data like passwords "
+           "(path is evaluated, see function string_eval_path_home in "
+           "plugin API reference)"),
+        NULL, 0, 0, "", NULL, 0,
+        NULL, NULL, NULL,
+        &config_change_history_global_file, NULL, NULL,
+        NULL, NULL, NULL);
     config_history_max_buffer_lines_minutes = config_file_new_option (
         weechat_config_file, ptr_section,
         "max_buffer_lines_minutes", "integer",
@@ -4592,6 +4676,14 @@ config_weechat_init_options ()
            "unlimited, NOT RECOMMENDED: no limit in memory usage)"),
         NULL, 0, INT_MAX, "100", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    config_history_max_commands_size = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "max_commands_size", "integer",
+        N_("maximum total size of user commands in history, in bytes, "
+           "for each buffer and for global history (0 = unlimited); "
+           "the oldest commands are removed when this size is reached"),
+        NULL, 0, INT_MAX, "0", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
     config_history_max_visited_buffers = config_file_new_option (
         weechat_config_file, ptr_section,
         "max_visited_buffers", "integer",
@@ -4666,6 +4758,15 @@ config_weechat_init_options ()
         N_("timeout (in seconds) for gnutls handshake"),
         NULL, 1, INT_MAX, "30", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    config_network_process_threads = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "process_threads", "integer",
+        N_("number of threads used to run URL transfers and functions in "
+           "hook_process (with \"url:\" or \"func:\"), instead of forking "
+           "WeeChat; 0 = always fork (threads are created when needed and "
+           "stopped after 60 seconds of inactivity)"),
+        NULL, 0, 64, "4", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
     config_network_proxy_curl = config_file_new_option (
         weechat_config_file, ptr_section,
         "proxy_curl", "string",
@@ -205,6 +205,7 @@ extern struct t_config_option *config_look_jump_previous_buffer_when_closing;
 extern struct t_config_option *config_look_jump_smart_back_to_buffer;
 extern struct t_config_option *config_look_key_bind_safe;
 extern struct t_config_option *config_look_key_grab_delay;
+extern struct t_config_option *config_look_line_cache_no_color;
 extern struct t_config_option *config_look_mouse;
 extern struct t_config_option *config_look_mouse_timer_delay;
 extern struct t_config_option *config_look_nick_color_force;
@@ -237,6 +238,7 @@ extern struct t_config_option *config_look_read_marker;
 extern struct t_config_option *config_look_read_marker_always_show;
 extern struct t_config_option *config_look_read_marker_string;
 extern struct t_config_option *config_look_read_marker_update_on_buffer_switch;
+extern struct t_config_option *config_look_refresh_rate_max;
 extern struct t_config_option *config_look_save_config_on_exit;
 extern struct t_config_option *config_look_save_config_with_fsync;
 extern struct t_config_option *config_look_save_layout_on_exit;
@@ -332,15 +334,18 @@ extern struct t_config_option *config_completion_partial_completion_other;
 extern struct t_config_option *config_completion_partial_completion_templates;
 
 extern struct t_config_option *config_history_display_default;
+extern struct t_config_option *config_history_global_file;
 extern struct t_config_option *config_history_max_buffer_lines_minutes;
 extern struct t_config_option *config_history_max_buffer_lines_number;
 extern struct t_config_option *config_history_max_commands;
+extern struct t_config_option *config_history_max_commands_size;
 extern struct t_config_option *config_history_max_visited_buffers;
 
 extern struct t_config_option *config_network_connection_timeout;
 extern struct t_config_option *config_network_gnutls_ca_system;
 extern struct t_config_option *config_network_gnutls_ca_user;
 extern struct t_config_option *config_network_gnutls_handshake_timeout;
+extern struct t_config_option *config_network_process_threads;
 extern struct t_config_option *config_network_proxy_curl;
 
 extern struct t_config_option *config_plugin_autoload;
@@ -38,16 +38,20 @@
 #include <gnutls/gnutls.h>
 
 #include "weechat.h"
+#include "wee-arraylist.h"
 #include "wee-backtrace.h"
 #include "wee-config-file.h"
+#include "wee-config.h"
 #include "wee-hashtable.h"
 #include "wee-hdata.h"
 #include "wee-hook.h"
 #include "wee-infolist.h"
 #include "wee-list.h"
 #include "wee-log.h"
+#include "wee-pool.h"
 #include "wee-proxy.h"
 #include "wee-string.h"
+#include "wee-thread-pool.h"
 #include "wee-utf8.h"
 #include "wee-util.h"
 #include "../gui/gui-bar.h"
@@ -106,6 +110,8 @@ debug_dump (int crash)
 
     infolist_print_log ();
 
+    pool_print_log ();
+
     hook_print_log ();
 
     config_file_print_log ();
@@ -240,7 +246,7 @@ debug_windows_tree_display (struct t_gui_window_tree *tree, int indent)
 }
 
 /*
- * Displays tree of windows.
+ * Displays tree of windows and statistics on refreshes of screen.
  */
 
 void
@@ -249,6 +255,134 @@ debug_windows_tree ()
     gui_chat_printf (NULL, "");
     gui_chat_printf (NULL, _("Windows tree:"));
     debug_windows_tree_display (gui_windows_tree, 1);
+
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL,
+                     "main loop: %llu iterations, %llu with a refresh "
+                     "(%.1f%%), %llu buffers drawn, %d buffers in refresh "
+                     "queue",
+                     gui_main_stats.loops,
+                     gui_main_stats.refreshes,
+                     (gui_main_stats.loops > 0) ?
+                     ((double)gui_main_stats.refreshes) * 100
+                     / gui_main_stats.loops : 0,
+                     gui_main_stats.buffers_refreshed,
+                     arraylist_size (gui_buffers_refresh));
+    gui_chat_printf (NULL,
+                     "refresh rate: max %d/s, %llu iterations with a "
+                     "delayed refresh, %llu immediate refreshes (key "
+                     "pressed, terminal resized)",
+                     CONFIG_INTEGER(config_look_refresh_rate_max),
+                     gui_main_stats.refreshes_delayed,
+                     gui_main_stats.refreshes_immediate);
+}
+
+/*
+ * Displays usage of pools of objects: objects used/allocated, peak and
+ * fragmentation (percentage of allocated objects that are free).
+ */
+
+void
+debug_memory_pools ()
+{
+    struct t_pool *ptr_pool;
+    int total, num_pools;
+    unsigned long long memory, memory_total;
+
+    if (!weechat_pools)
+        return;
+
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL, _("Pools of objects:"));
+    gui_chat_printf (NULL,
+                     "  %-12s %-20s %6s %6s %10s %10s %10s %10s %5s",
+                     "plugin", "name", "size", "slabs", "used", "total",
+                     "peak", "memory", "free");
+
+    num_pools = 0;
+    memory_total = 0;
+    for (ptr_pool = weechat_pools; ptr_pool; ptr_pool = ptr_pool->next_pool)
+    {
+        total = pool_objects_total (ptr_pool);
+        memory = (unsigned long long)ptr_pool->slabs_count
+            * (POOL_SLAB_HEADER_SIZE
+               + (ptr_pool->object_size * ptr_pool->objects_per_slab));
+        gui_chat_printf (NULL,
+                         "  %-12s %-20s %6lu %6d %10d %10d %10d %10llu %4d%%",
+                         plugin_get_name (ptr_pool->plugin),
+                         ptr_pool->name,
+                         (unsigned long)ptr_pool->object_size,
+                         ptr_pool->slabs_count,
+                         ptr_pool->objects_used,
+                         total,
+                         ptr_pool->objects_used_max,
+                         memory,
+                         (total > 0) ?
+                         ((total - ptr_pool->objects_used) * 100) / total : 0);
+        num_pools++;
+        memory_total += memory;
+    }
+    gui_chat_printf (NULL,
+                     NG_("  %d pool, %llu bytes",
+                         "  %d pools, %llu bytes",
+                         num_pools),
+                     num_pools, memory_total);
+}
+
+/*
+ * Displays information about configuration files: number of sections and
+ * options, and time spent in last read of each file.
+ */
+
+void
+debug_config ()
+{
+    struct t_config_file *ptr_config;
+    struct t_config_section *ptr_section;
+    struct t_config_option *ptr_option;
+    int num_configs, num_sections, num_options;
+    long long total_time;
+
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL, _("Configuration files:"));
+    gui_chat_printf (NULL,
+                     "  %-12s %-20s %8s %8s %8s %12s",
+                     "plugin", "file", "sections", "options", "lines",
+                     "read time");
+
+    num_configs = 0;
+    total_time = 0;
+    for (ptr_config = config_files; ptr_config;
+         ptr_config = ptr_config->next_config)
+    {
+        num_sections = 0;
+        num_options = 0;
+        for (ptr_section = ptr_config->sections; ptr_section;
+             ptr_section = ptr_section->next_section)
+        {
+            num_sections++;
+            for (ptr_option = ptr_section->options; ptr_option;
+                 ptr_option = ptr_option->next_option)
+            {
+                num_options++;
+            }
+        }
+        gui_chat_printf (NULL,
+                         "  %-12s %-20s %8d %8d %8d %10.3fms",
+                         plugin_get_name (ptr_config->plugin),
+                         ptr_config->filename,
+                         num_sections,
+                         num_options,
+                         ptr_config->read_lines,
+                         ((double)ptr_config->read_time) / 1000);
+        num_configs++;
+        total_time += ptr_config->read_time;
+    }
+    gui_chat_printf (NULL,
+                     NG_("  %d configuration file, read in %.3fms",
+                         "  %d configuration files, read in %.3fms",
+                         num_configs),
+                     num_configs, ((double)total_time) / 1000);
 }
 
 /*
@@ -299,6 +433,8 @@ debug_memory ()
                        "found)"));
 #endif /* HAVE_MALLINFO */
 #endif /* HAVE_MALLINFO2 */
+
+    debug_memory_pools ();
 }
 
 /*
@@ -421,6 +557,7 @@ debug_hdata ()
 void
 debug_hooks ()
 {
+    struct t_thread_pool_stats stats;
     int i;
 
     gui_chat_printf (NULL, "");
@@ -433,6 +570,23 @@ debug_hooks ()
     }
     gui_chat_printf (NULL, "%17s------", "---------");
     gui_chat_printf (NULL, "%17s:%5d", "total", hooks_count_total);
+
+    thread_pool_get_stats (&stats);
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL,
+                     "thread pool: %d threads (%d idle), jobs: %d running, "
+                     "%d queued (max: %d), %llu done, avg wait: %.3fms, "
+                     "avg run: %.3fms",
+                     stats.threads,
+                     stats.threads_idle,
+                     stats.jobs_running,
+                     stats.jobs_queued,
+                     stats.jobs_queued_max,
+                     stats.jobs_done,
+                     (stats.jobs_done > 0) ?
+                     ((double)stats.time_wait) / stats.jobs_done / 1000 : 0,
+                     (stats.jobs_done > 0) ?
+                     ((double)stats.time_run) / stats.jobs_done / 1000 : 0);
 }
 
 /*
@@ -26,6 +26,7 @@ struct t_gui_window_tree;
 
 extern void debug_sigsegv_cb ();
 extern void debug_windows_tree ();
+extern void debug_config ();
 extern void debug_memory ();
 extern void debug_hdata ();
 extern void debug_hooks ();
@@ -25,8 +25,11 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
 
 #include "weechat.h"
 #include "wee-hashtable.h"
@@ -43,6 +46,18 @@ char *hashtable_type_string[HASHTABLE_NUM_TYPES] =
   WEECHAT_HASHTABLE_POINTER, WEECHAT_HASHTABLE_BUFFER,
   WEECHAT_HASHTABLE_TIME };
 
+/* seed used by new hashtables to hash keys (see hashtable_init_seed) */
+unsigned long long hashtable_hash_seed = 0;
+
+/* hashtables freed, kept for reuse by hashtable_new */
+struct t_hashtable *hashtable_pool[HASHTABLE_POOL_SIZE];
+int hashtable_pool_count = 0;
+
+/* secret constants used by wyhash */
+uint64_t hashtable_wyhash_secret[4] =
+{ 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+  0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL };
+
 
 /*
  * Searches for a hashtable type.
@@ -89,6 +104,223 @@ hashtable_hash_key_djb2 (const char *string)
     return hash;
 }
 
+/*
+ * Initializes the seed used to hash keys in new hashtables.
+ *
+ * The seed is random, so that hashes of keys (and then slots in hashtables)
+ * can not be predicted, which prevents floods of keys with the same hash
+ * (for example with data received from IRC servers).
+ */
+
+void
+hashtable_init_seed ()
+{
+    FILE *file;
+    struct timeval tv_now;
+    uint64_t seed;
+
+    seed = 0;
+
+    file = fopen ("/dev/urandom", "rb");
+    if (file)
+    {
+        if (fread (&seed, sizeof (seed), 1, file) != 1)
+            seed = 0;
+        fclose (file);
+    }
+
+    if (seed == 0)
+    {
+        gettimeofday (&tv_now, NULL);
+        seed = ((uint64_t)tv_now.tv_sec << 32)
+            ^ (uint64_t)tv_now.tv_usec
+            ^ ((uint64_t)getpid () << 16)
+            ^ (uint64_t)((unsigned long)&seed);
+    }
+
+    hashtable_hash_seed = (unsigned long long)seed;
+}
+
+/*
+ * Multiplies two 64-bit integers and returns the 128-bit result in the two
+ * integers (low 64 bits in a, high 64 bits in b).
+ */
+
+void
+hashtable_wyhash_mum (uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r;
+
+    r = *a;
+    r *= *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha, hb, la, lb, hi, lo, rh, rm0, rm1, rl, t;
+    int c;
+
+    ha = *a >> 32;
+    hb = *b >> 32;
+    la = (uint32_t)*a;
+    lb = (uint32_t)*b;
+    rh = ha * hb;
+    rm0 = ha * lb;
+    rm1 = hb * la;
+    rl = la * lb;
+    t = rl + (rm0 << 32);
+    c = t < rl;
+    lo = t + (rm1 << 32);
+    c += lo < t;
+    hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a = lo;
+    *b = hi;
+#endif /* __SIZEOF_INT128__ */
+}
+
+/*
+ * Mixes two 64-bit integers (used by wyhash).
+ */
+
+uint64_t
+hashtable_wyhash_mix (uint64_t a, uint64_t b)
+{
+    hashtable_wyhash_mum (&a, &b);
+    return a ^ b;
+}
+
+/*
+ * Reads 8 bytes as a little-endian integer.
+ */
+
+uint64_t
+hashtable_wyhash_read8 (const unsigned char *ptr)
+{
+    return (uint64_t)ptr[0]
+        | ((uint64_t)ptr[1] << 8)
+        | ((uint64_t)ptr[2] << 16)
+        | ((uint64_t)ptr[3] << 24)
+        | ((uint64_t)ptr[4] << 32)
+        | ((uint64_t)ptr[5] << 40)
+        | ((uint64_t)ptr[6] << 48)
+        | ((uint64_t)ptr[7] << 56);
+}
+
+/*
+ * Reads 4 bytes as a little-endian integer.
+ */
+
+uint64_t
+hashtable_wyhash_read4 (const unsigned char *ptr)
+{
+    return (uint64_t)ptr[0]
+        | ((uint64_t)ptr[1] << 8)
+        | ((uint64_t)ptr[2] << 16)
+        | ((uint64_t)ptr[3] << 24);
+}
+
+/*
+ * Hashes a buffer using wyhash (final version 4, by Wang Yi, public domain):
+ * the buffer is read 8 bytes at a time (48 bytes per iteration, with three
+ * independent states for long buffers), which is much faster than djb2,
+ * and the hash depends on the seed.
+ *
+ * Returns the hash of the buffer.
+ */
+
+unsigned long long
+hashtable_hash_key_wyhash (const void *buffer, int length,
+                           unsigned long long seed)
+{
+    const unsigned char *ptr;
+    uint64_t a, b, seed1, seed2, hash_seed;
+    size_t len, i;
+
+    ptr = (const unsigned char *)buffer;
+    len = (length > 0) ? (size_t)length : 0;
+
+    hash_seed = (uint64_t)seed;
+    hash_seed ^= hashtable_wyhash_mix (hash_seed ^ hashtable_wyhash_secret[0],
+                                       hashtable_wyhash_secret[1]);
+
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (hashtable_wyhash_read4 (ptr) << 32)
+                | hashtable_wyhash_read4 (ptr + ((len >> 3) << 2));
+            b = (hashtable_wyhash_read4 (ptr + len - 4) << 32)
+                | hashtable_wyhash_read4 (ptr + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = ((uint64_t)ptr[0] << 16)
+                | ((uint64_t)ptr[len >> 1] << 8)
+                | (uint64_t)ptr[len - 1];
+            b = 0;
+        }
+        else
+        {
+            a = 0;
+            b = 0;
+        }
+    }
+    else
+    {
+        i = len;
+        if (i > 48)
+        {
+            seed1 = hash_seed;
+            seed2 = hash_seed;
+            do
+            {
+                hash_seed = hashtable_wyhash_mix (
+                    hashtable_wyhash_read8 (ptr) ^ hashtable_wyhash_secret[1],
+                    hashtable_wyhash_read8 (ptr + 8) ^ hash_seed);
+                seed1 = hashtable_wyhash_mix (
+                    hashtable_wyhash_read8 (ptr + 16) ^ hashtable_wyhash_secret[2],
+                    hashtable_wyhash_read8 (ptr + 24) ^ seed1);
+                seed2 = hashtable_wyhash_mix (
+                    hashtable_wyhash_read8 (ptr + 32) ^ hashtable_wyhash_secret[3],
+                    hashtable_wyhash_read8 (ptr + 40) ^ seed2);
+                ptr += 48;
+                i -= 48;
+            } while (i > 48);
+            hash_seed ^= seed1 ^ seed2;
+        }
+        while (i > 16)
+        {
+            hash_seed = hashtable_wyhash_mix (
+                hashtable_wyhash_read8 (ptr) ^ hashtable_wyhash_secret[1],
+                hashtable_wyhash_read8 (ptr + 8) ^ hash_seed);
+            i -= 16;
+            ptr += 16;
+        }
+        a = hashtable_wyhash_read8 (ptr + i - 16);
+        b = hashtable_wyhash_read8 (ptr + i - 8);
+    }
+
+    a ^= hashtable_wyhash_secret[1];
+    b ^= hash_seed;
+    hashtable_wyhash_mum (&a, &b);
+
+    return (unsigned long long)hashtable_wyhash_mix (
+        a ^ hashtable_wyhash_secret[0] ^ len,
+        b ^ hashtable_wyhash_secret[1]);
+}
+
+/*
+ * Hashes a string using wyhash.
+ *
+ * Returns the hash of the string.
+ */
+
+unsigned long long
+hashtable_hash_key_string (const char *string, unsigned long long seed)
+{
+    return hashtable_hash_key_wyhash (string, strlen (string), seed);
+}
+
 /*
  * Hashes a key (default callback).
  *
@@ -108,7 +340,8 @@ hashtable_hash_key_default_cb (struct t_hashtable *hashtable, const void *key)
             hash = (unsigned long long)(*((int *)key));
             break;
         case HASHTABLE_STRING:
-            hash = hashtable_hash_key_djb2 ((const char *)key);
+            hash = hashtable_hash_key_string ((const char *)key,
+                                              hashtable->hash_seed);
             break;
         case HASHTABLE_POINTER:
             hash = (unsigned long long)((unsigned long)((void *)key));
@@ -177,13 +410,54 @@ hashtable_keycmp_default_cb (struct t_hashtable *hashtable,
     return rc;
 }
 
+/*
+ * Mixes bits of a hash returned by the hash callback, so that all bits of the
+ * hash are used to compute the slot (this is the finalizer of MurmurHash3).
+ *
+ * This is required because the slot is computed with the lowest bits of the
+ * hash, which are often the same for pointers (memory alignment) or integers.
+ */
+
+unsigned long long
+hashtable_hash_mix (unsigned long long hash)
+{
+    uint64_t value;
+
+    value = (uint64_t)hash;
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+
+    return (unsigned long long)value;
+}
+
+/*
+ * Returns the hash of a key, as stored in items and slots of hashtable.
+ */
+
+unsigned long long
+hashtable_hash (struct t_hashtable *hashtable, const void *key)
+{
+    return hashtable_hash_mix (hashtable->callback_hash_key (hashtable, key)
+                               ^ hashtable->hash_seed);
+}
+
 /*
  * Creates a new hashtable.
  *
- * The size is NOT a limit for number of items in hashtable. It is the size of
- * internal array to store hashed keys: a high value uses more memory, but has
- * better performance because this reduces the collisions of hashed keys and
- * then reduces length of linked lists.
+ * The size is NOT a limit for number of items in hashtable. It is the initial
+ * size of internal array to store hashed keys (rounded up to a power of 2, at
+ * least HASHTABLE_MIN_SIZE); the array is automatically enlarged when the
+ * hashtable is filled at 75%, so a high value only saves some resizes when
+ * many items are added.
+ *
+ * Small hashtables (size <= HASHTABLE_SMALL_MAX_SIZE) use the array of slots
+ * stored in the hashtable itself, with at most HASHTABLE_SMALL_SIZE slots
+ * (it is replaced by an allocated array if the hashtable grows), and freed
+ * hashtables are kept in a pool: a short-lived hashtable with few items does
+ * not need any allocation except for its items.
  *
  * Returns pointer to new hashtable, NULL if error.
  */
@@ -195,9 +469,9 @@ hashtable_new (int size,
                t_hashtable_keycmp *callback_keycmp)
 {
     struct t_hashtable *new_hashtable;
-    int i, type_keys_int, type_values_int;
+    int real_size, type_keys_int, type_values_int;
 
-    if (size <= 0)
+    if ((size <= 0) || (size > HASHTABLE_MAX_SIZE))
         return NULL;
 
     type_keys_int = hashtable_get_type (type_keys);
@@ -211,35 +485,62 @@ hashtable_new (int size,
     if ((type_keys_int == HASHTABLE_BUFFER) && (!callback_hash_key || !callback_keycmp))
         return NULL;
 
-    new_hashtable = malloc (sizeof (*new_hashtable));
-    if (new_hashtable)
+    real_size = HASHTABLE_MIN_SIZE;
+    while (real_size < size)
+    {
+        real_size *= 2;
+    }
+    if ((real_size <= HASHTABLE_SMALL_MAX_SIZE)
+        && (real_size > HASHTABLE_SMALL_SIZE))
+    {
+        real_size = HASHTABLE_SMALL_SIZE;
+    }
+
+    if (hashtable_pool_count > 0)
+    {
+        hashtable_pool_count--;
+        new_hashtable = hashtable_pool[hashtable_pool_count];
+    }
+    else
+    {
+        new_hashtable = malloc (sizeof (*new_hashtable));
+        if (!new_hashtable)
+            return NULL;
+    }
+
+    new_hashtable->size = real_size;
+    if (real_size <= HASHTABLE_SMALL_SIZE)
     {
-        new_hashtable->size = size;
-        new_hashtable->type_keys = type_keys_int;
-        new_hashtable->type_values = type_values_int;
-        new_hashtable->htable = malloc (size * sizeof (*(new_hashtable->htable)));
-        new_hashtable->keys_values = NULL;
+        new_hashtable->htable = new_hashtable->htable_small;
+        memset (new_hashtable->htable_small, 0,
+                sizeof (new_hashtable->htable_small));
+    }
+    else
+    {
+        new_hashtable->htable = calloc (real_size,
+                                        sizeof (*(new_hashtable->htable)));
         if (!new_hashtable->htable)
         {
             free (new_hashtable);
             return NULL;
         }
-        for (i = 0; i < size; i++)
-        {
-            new_hashtable->htable[i] = NULL;
-        }
-        new_hashtable->items_count = 0;
-        new_hashtable->oldest_item = NULL;
-        new_hashtable->newest_item = NULL;
-
-        new_hashtable->callback_hash_key = (callback_hash_key) ?
-            callback_hash_key : &hashtable_hash_key_default_cb;
-        new_hashtable->callback_keycmp = (callback_keycmp) ?
-            callback_keycmp : &hashtable_keycmp_default_cb;
-
-        new_hashtable->callback_free_key = NULL;
-        new_hashtable->callback_free_value = NULL;
     }
+    new_hashtable->hash_seed = hashtable_hash_seed;
+    new_hashtable->type_keys = type_keys_int;
+    new_hashtable->type_values = type_values_int;
+    new_hashtable->keys_values = NULL;
+    new_hashtable->items_count = 0;
+    new_hashtable->oldest_item = NULL;
+    new_hashtable->newest_item = NULL;
+
+    new_hashtable->callback_hash_key = (callback_hash_key) ?
+        callback_hash_key : &hashtable_hash_key_default_cb;
+    new_hashtable->callback_keycmp = (callback_keycmp) ?
+        callback_keycmp : &hashtable_keycmp_default_cb;
+
+    new_hashtable->callback_free_key = NULL;
+    new_hashtable->callback_free_value = NULL;
+
     return new_hashtable;
 }
 
@@ -300,14 +601,53 @@ hashtable_alloc_type (enum t_hashtable_type type,
     }
 }
 
+/*
+ * Returns the size needed to store a copy of a key or value in the item (0 if
+ * the key/value is not copied by the hashtable: NULL or type "pointer").
+ */
+
+int
+hashtable_get_size_type (enum t_hashtable_type type,
+                         const void *value, int size_value)
+{
+    if (!value)
+        return 0;
+
+    switch (type)
+    {
+        case HASHTABLE_INTEGER:
+            return sizeof (int);
+        case HASHTABLE_STRING:
+            return strlen ((const char *)value) + 1;
+        case HASHTABLE_POINTER:
+            return 0;
+        case HASHTABLE_BUFFER:
+            return (size_value > 0) ? size_value : 0;
+        case HASHTABLE_TIME:
+            return sizeof (time_t);
+        case HASHTABLE_NUM_TYPES:
+            break;
+    }
+
+    return 0;
+}
+
 /*
  * Frees space used by a key.
+ *
+ * Note: a key stored in the same allocation as the item is freed with the
+ * item itself (the callback "callback_free_key" is not called in this case,
+ * keys are stored this way only if this callback is not set when the item is
+ * created).
  */
 
 void
 hashtable_free_key (struct t_hashtable *hashtable,
                     struct t_hashtable_item *item)
 {
+    if (HASHTABLE_ITEM_KEY_INLINE(item))
+        return;
+
     if (hashtable->callback_free_key)
     {
         (void) (hashtable->callback_free_key) (hashtable,
@@ -334,12 +674,23 @@ hashtable_free_key (struct t_hashtable *hashtable,
 
 /*
  * Frees space used by a value.
+ *
+ * Note: a value stored in the same allocation as the item is freed with the
+ * item itself (the callback "callback_free_value" is not called in this case,
+ * values are stored this way only if this callback is not set when the item
+ * is created).
  */
 
 void
 hashtable_free_value (struct t_hashtable *hashtable,
                       struct t_hashtable_item *item)
 {
+    if (item->value_inline)
+    {
+        item->value_inline = 0;
+        return;
+    }
+
     if (hashtable->callback_free_value)
     {
         (void) (hashtable->callback_free_value) (hashtable,
@@ -365,6 +716,83 @@ hashtable_free_value (struct t_hashtable *hashtable,
     }
 }
 
+/*
+ * Searches for the slot of a key in hashtable.
+ *
+ * Returns index of the slot with the key, or index of the empty slot where
+ * the key would be added if it is not in hashtable.
+ *
+ * Note: the hashtable always has at least one empty slot, so the search
+ * always ends.
+ */
+
+int
+hashtable_find_slot (struct t_hashtable *hashtable, const void *key,
+                     unsigned long long hash)
+{
+    struct t_hashtable_slot *ptr_slot;
+    int mask, index;
+
+    mask = hashtable->size - 1;
+    index = (int)(hash & mask);
+    while (1)
+    {
+        ptr_slot = &(hashtable->htable[index]);
+        if (!ptr_slot->item)
+            return index;
+        if ((ptr_slot->hash == hash)
+            && (hashtable->callback_keycmp (hashtable, key,
+                                            ptr_slot->item->key) == 0))
+        {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+/*
+ * Resizes the array of slots in hashtable (new_size must be a power of 2,
+ * greater than number of items in hashtable).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+hashtable_resize (struct t_hashtable *hashtable, int new_size)
+{
+    struct t_hashtable_slot *new_htable;
+    int i, mask, index;
+
+    if ((new_size <= hashtable->items_count) || (new_size > HASHTABLE_MAX_SIZE))
+        return 0;
+
+    new_htable = calloc (new_size, sizeof (*new_htable));
+    if (!new_htable)
+        return 0;
+
+    mask = new_size - 1;
+    for (i = 0; i < hashtable->size; i++)
+    {
+        if (!hashtable->htable[i].item)
+            continue;
+        index = (int)(hashtable->htable[i].hash & mask);
+        while (new_htable[index].item)
+        {
+            index = (index + 1) & mask;
+        }
+        new_htable[index] = hashtable->htable[i];
+    }
+
+    if (hashtable->htable != hashtable->htable_small)
+        free (hashtable->htable);
+    hashtable->htable = new_htable;
+    hashtable->size = new_size;
+
+    return 1;
+}
+
 /*
  * Sets value for a key in hashtable.
  *
@@ -379,7 +807,8 @@ hashtable_set_with_size (struct t_hashtable *hashtable,
                          const void *value, int value_size)
 {
     unsigned long long hash;
-    struct t_hashtable_item *ptr_item, *pos_item, *new_item;
+    struct t_hashtable_item *ptr_item, *new_item;
+    int index, length_key, length_value;
 
     if (!hashtable || !key
         || ((hashtable->type_keys == HASHTABLE_BUFFER) && (key_size <= 0))
@@ -388,19 +817,13 @@ hashtable_set_with_size (struct t_hashtable *hashtable,
         return NULL;
     }
 
-    /* search position for item in hashtable */
-    hash = hashtable->callback_hash_key (hashtable, key) % hashtable->size;
-    pos_item = NULL;
-    for (ptr_item = hashtable->htable[hash];
-         ptr_item
-             && ((int)(hashtable->callback_keycmp) (hashtable, key, ptr_item->key) > 0);
-         ptr_item = ptr_item->next_item)
-    {
-        pos_item = ptr_item;
-    }
+    /* search slot for item in hashtable */
+    hash = hashtable_hash (hashtable, key);
+    index = hashtable_find_slot (hashtable, key, hash);
+    ptr_item = hashtable->htable[index].item;
 
     /* replace value if item is already in hashtable */
-    if (ptr_item && (hashtable->callback_keycmp (hashtable, key, ptr_item->key) == 0))
+    if (ptr_item)
     {
         hashtable_free_value (hashtable, ptr_item);
         hashtable_alloc_type (hashtable->type_values,
@@ -409,38 +832,62 @@ hashtable_set_with_size (struct t_hashtable *hashtable,
         return ptr_item;
     }
 
-    /* create new item */
-    new_item = malloc (sizeof (*new_item));
+    /* enlarge hashtable if it is filled at 75% (or more) */
+    if (hashtable->items_count + 1 > hashtable->size - (hashtable->size / 4))
+    {
+        if ((hashtable->size < HASHTABLE_MAX_SIZE)
+            && hashtable_resize (hashtable, hashtable->size * 2))
+            index = hashtable_find_slot (hashtable, key, hash);
+        else if (hashtable->items_count + 1 >= hashtable->size)
+            return NULL;
+    }
+
+    /*
+     * create new item, with the copy of key and value in the same allocation
+     * (unless the caller frees keys/values with its own callbacks)
+     */
+    length_key = (hashtable->callback_free_key) ?
+        0 : hashtable_get_size_type (hashtable->type_keys, key, key_size);
+    length_value = (hashtable->callback_free_value) ?
+        0 : hashtable_get_size_type (hashtable->type_values, value, value_size);
+    new_item = malloc (sizeof (*new_item)
+                       + HASHTABLE_ALIGN_SIZE(length_key) + length_value);
     if (!new_item)
         return NULL;
 
     /* set key and value */
-    hashtable_alloc_type (hashtable->type_keys,
-                          key, key_size,
-                          &new_item->key, &new_item->key_size);
-    hashtable_alloc_type (hashtable->type_values,
-                          value, value_size,
-                          &new_item->value, &new_item->value_size);
-
-    /* add item */
-    if (pos_item)
+    if (length_key > 0)
     {
-        /* insert item after position found */
-        new_item->prev_item = pos_item;
-        new_item->next_item = pos_item->next_item;
-        if (pos_item->next_item)
-            (pos_item->next_item)->prev_item = new_item;
-        pos_item->next_item = new_item;
+        new_item->key = (void *)(new_item + 1);
+        memcpy (new_item->key, key, length_key);
+        new_item->key_size = length_key;
     }
     else
     {
-        /* insert item at beginning of list */
-        new_item->prev_item = NULL;
-        new_item->next_item = hashtable->htable[hash];
-        if (hashtable->htable[hash])
-            (hashtable->htable[hash])->prev_item = new_item;
-        hashtable->htable[hash] = new_item;
+        hashtable_alloc_type (hashtable->type_keys,
+                              key, key_size,
+                              &new_item->key, &new_item->key_size);
     }
+    if (length_value > 0)
+    {
+        new_item->value = ((char *)(new_item + 1))
+            + HASHTABLE_ALIGN_SIZE(length_key);
+        memcpy (new_item->value, value, length_value);
+        new_item->value_size = length_value;
+        new_item->value_inline = 1;
+    }
+    else
+    {
+        hashtable_alloc_type (hashtable->type_values,
+                              value, value_size,
+                              &new_item->value, &new_item->value_size);
+        new_item->value_inline = 0;
+    }
+    new_item->hash = hash;
+
+    /* add item */
+    hashtable->htable[index].hash = hash;
+    hashtable->htable[index].item = new_item;
 
     /* keep items ordered by date of creation */
     if (hashtable->newest_item)
@@ -484,27 +931,15 @@ hashtable_get_item (struct t_hashtable *hashtable, const void *key,
                     unsigned long long *hash)
 {
     unsigned long long key_hash;
-    struct t_hashtable_item *ptr_item;
 
     if (!hashtable || !key)
         return NULL;
 
-    key_hash = hashtable->callback_hash_key (hashtable, key) % hashtable->size;
+    key_hash = hashtable_hash (hashtable, key);
     if (hash)
         *hash = key_hash;
-    for (ptr_item = hashtable->htable[key_hash];
-         ptr_item && hashtable->callback_keycmp (hashtable, key, ptr_item->key) > 0;
-         ptr_item = ptr_item->next_item)
-    {
-    }
 
-    if (ptr_item
-        && (hashtable->callback_keycmp (hashtable, key, ptr_item->key) == 0))
-    {
-        return ptr_item;
-    }
-
-    return NULL;
+    return hashtable->htable[hashtable_find_slot (hashtable, key, key_hash)].item;
 }
 
 /*
@@ -689,6 +1124,8 @@ hashtable_dup (struct t_hashtable *hashtable)
                                    hashtable->callback_keycmp);
     if (new_hashtable)
     {
+        /* same seed, so that keys have same hashes in both hashtables */
+        new_hashtable->hash_seed = hashtable->hash_seed;
         new_hashtable->callback_free_key = hashtable->callback_free_key;
         new_hashtable->callback_free_value = hashtable->callback_free_value;
         hashtable_map (hashtable,
@@ -1198,16 +1635,31 @@ hashtable_add_from_infolist (struct t_hashtable *hashtable,
 
 /*
  * Removes an item from hashtable.
+ *
+ * The slots following the slot of item are moved back if needed, so that
+ * there is no empty slot between the slot computed with the hash of a key
+ * and the slot of this key.
  */
 
 void
 hashtable_remove_item (struct t_hashtable *hashtable,
-                       struct t_hashtable_item *item,
-                       unsigned long long hash)
+                       struct t_hashtable_item *item)
 {
+    int mask, index, index_next, index_ideal;
+
     if (!hashtable || !item)
         return;
 
+    /* search slot of item */
+    mask = hashtable->size - 1;
+    index = (int)(item->hash & mask);
+    while (hashtable->htable[index].item != item)
+    {
+        if (!hashtable->htable[index].item)
+            return;
+        index = (index + 1) & mask;
+    }
+
     /* free key and value */
     hashtable_free_value (hashtable, item);
     hashtable_free_key (hashtable, item);
@@ -1222,13 +1674,26 @@ hashtable_remove_item (struct t_hashtable *hashtable,
     if (hashtable->newest_item == item)
         hashtable->newest_item = item->prev_created_item;
 
-    /* remove item from list */
-    if (item->prev_item)
-        (item->prev_item)->next_item = item->next_item;
-    if (item->next_item)
-        (item->next_item)->prev_item = item->prev_item;
-    if (hashtable->htable[hash] == item)
-        hashtable->htable[hash] = item->next_item;
+    /* remove item from slots, moving back next slots if needed */
+    index_next = index;
+    while (1)
+    {
+        index_next = (index_next + 1) & mask;
+        if (!hashtable->htable[index_next].item)
+            break;
+        index_ideal = (int)(hashtable->htable[index_next].hash & mask);
+        /* keep item in its slot if its ideal slot is in (index, index_next] */
+        if ((index <= index_next) ?
+            ((index < index_ideal) && (index_ideal <= index_next)) :
+            ((index < index_ideal) || (index_ideal <= index_next)))
+        {
+            continue;
+        }
+        hashtable->htable[index] = hashtable->htable[index_next];
+        index = index_next;
+    }
+    hashtable->htable[index].hash = 0;
+    hashtable->htable[index].item = NULL;
 
     free (item);
 
@@ -1243,14 +1708,13 @@ void
 hashtable_remove (struct t_hashtable *hashtable, const void *key)
 {
     struct t_hashtable_item *ptr_item;
-    unsigned long long hash;
 
     if (!hashtable || !key)
         return;
 
-    ptr_item = hashtable_get_item (hashtable, key, &hash);
+    ptr_item = hashtable_get_item (hashtable, key, NULL);
     if (ptr_item)
-        hashtable_remove_item (hashtable, ptr_item, hash);
+        hashtable_remove_item (hashtable, ptr_item);
 }
 
 /*
@@ -1260,18 +1724,25 @@ hashtable_remove (struct t_hashtable *hashtable, const void *key)
 void
 hashtable_remove_all (struct t_hashtable *hashtable)
 {
-    int i;
+    struct t_hashtable_item *ptr_item, *ptr_next_created_item;
 
     if (!hashtable)
         return;
 
-    for (i = 0; i < hashtable->size; i++)
+    ptr_item = hashtable->oldest_item;
+    while (ptr_item)
     {
-        while (hashtable->htable[i])
-        {
-            hashtable_remove_item (hashtable, hashtable->htable[i], i);
-        }
+        ptr_next_created_item = ptr_item->next_created_item;
+        hashtable_free_value (hashtable, ptr_item);
+        hashtable_free_key (hashtable, ptr_item);
+        free (ptr_item);
+        ptr_item = ptr_next_created_item;
     }
+
+    memset (hashtable->htable, 0, hashtable->size * sizeof (*(hashtable->htable)));
+    hashtable->items_count = 0;
+    hashtable->oldest_item = NULL;
+    hashtable->newest_item = NULL;
 }
 
 /*
@@ -1285,10 +1756,67 @@ hashtable_free (struct t_hashtable *hashtable)
         return;
 
     hashtable_remove_all (hashtable);
-    free (hashtable->htable);
+    if (hashtable->htable != hashtable->htable_small)
+        free (hashtable->htable);
     if (hashtable->keys_values)
         free (hashtable->keys_values);
-    free (hashtable);
+
+    /* keep hashtable for reuse by hashtable_new */
+    if (hashtable_pool_count < HASHTABLE_POOL_SIZE)
+    {
+        hashtable_pool[hashtable_pool_count] = hashtable;
+        hashtable_pool_count++;
+    }
+    else
+    {
+        free (hashtable);
+    }
+}
+
+/*
+ * Frees all hashtables kept in the pool.
+ */
+
+void
+hashtable_end ()
+{
+    while (hashtable_pool_count > 0)
+    {
+        hashtable_pool_count--;
+        free (hashtable_pool[hashtable_pool_count]);
+    }
+}
+
+/*
+ * Computes statistics about slots used in hashtable:
+ *   collisions: number of items which are not in the slot computed with
+ *               their hash
+ *   max_probe: max distance between slot computed with hash and slot used
+ *   total_probe: sum of distances for all items
+ */
+
+void
+hashtable_compute_stats (struct t_hashtable *hashtable,
+                         int *collisions, int *max_probe, int *total_probe)
+{
+    int i, mask, distance;
+
+    *collisions = 0;
+    *max_probe = 0;
+    *total_probe = 0;
+
+    mask = hashtable->size - 1;
+    for (i = 0; i < hashtable->size; i++)
+    {
+        if (!hashtable->htable[i].item)
+            continue;
+        distance = (i - (int)(hashtable->htable[i].hash & mask)) & mask;
+        if (distance > 0)
+            (*collisions)++;
+        if (distance > *max_probe)
+            *max_probe = distance;
+        *total_probe += distance;
+    }
 }
 
 /*
@@ -1299,12 +1827,13 @@ void
 hashtable_print_log (struct t_hashtable *hashtable, const char *name)
 {
     struct t_hashtable_item *ptr_item;
-    int i;
+    int i, collisions, max_probe, total_probe;
 
     log_printf ("");
     log_printf ("[hashtable %s (addr:0x%lx)]", name, hashtable);
     log_printf ("  size . . . . . . . . . : %d",    hashtable->size);
     log_printf ("  htable . . . . . . . . : 0x%lx", hashtable->htable);
+    log_printf ("  hash_seed. . . . . . . : 0x%llx", hashtable->hash_seed);
     log_printf ("  items_count. . . . . . : %d",    hashtable->items_count);
     log_printf ("  oldest_item. . . . . . : 0x%lx", hashtable->oldest_item);
     log_printf ("  newest_item. . . . . . : 0x%lx", hashtable->newest_item);
@@ -1320,59 +1849,68 @@ hashtable_print_log (struct t_hashtable *hashtable, const char *name)
     log_printf ("  callback_free_value. . : 0x%lx", hashtable->callback_free_value);
     log_printf ("  keys_values. . . . . . : '%s'",  hashtable->keys_values);
 
+    hashtable_compute_stats (hashtable, &collisions, &max_probe, &total_probe);
+    log_printf ("  stats: load factor . . : %d%%",
+                (hashtable->items_count * 100) / hashtable->size);
+    log_printf ("  stats: collisions. . . : %d", collisions);
+    log_printf ("  stats: max probe length: %d", max_probe);
+    log_printf ("  stats: avg probe length: %.2f",
+                (hashtable->items_count > 0) ?
+                (double)total_probe / hashtable->items_count : 0.0);
+
     for (i = 0; i < hashtable->size; i++)
     {
-        log_printf ("  htable[%06d] . . . . : 0x%lx", i, hashtable->htable[i]);
-        for (ptr_item = hashtable->htable[i]; ptr_item;
-             ptr_item = ptr_item->next_item)
+        ptr_item = hashtable->htable[i].item;
+        if (!ptr_item)
+            continue;
+        log_printf ("  htable[%06d] . . . . : 0x%lx (hash: 0x%llx)",
+                    i, ptr_item, hashtable->htable[i].hash);
+        log_printf ("    [item 0x%lx]", ptr_item);
+        switch (hashtable->type_keys)
         {
-            log_printf ("    [item 0x%lx]", hashtable->htable);
-            switch (hashtable->type_keys)
-            {
-                case HASHTABLE_INTEGER:
-                    log_printf ("      key (integer). . . : %d", *((int *)ptr_item->key));
-                    break;
-                case HASHTABLE_STRING:
-                    log_printf ("      key (string) . . . : '%s'", (char *)ptr_item->key);
-                    break;
-                case HASHTABLE_POINTER:
-                    log_printf ("      key (pointer). . . : 0x%lx", ptr_item->key);
-                    break;
-                case HASHTABLE_BUFFER:
-                    log_printf ("      key (buffer) . . . : 0x%lx", ptr_item->key);
-                    break;
-                case HASHTABLE_TIME:
-                    log_printf ("      key (time) . . . . : %lld", (long long)(*((time_t *)ptr_item->key)));
-                    break;
-                case HASHTABLE_NUM_TYPES:
-                    break;
-            }
-            log_printf ("      key_size . . . . . : %d", ptr_item->key_size);
-            switch (hashtable->type_values)
-            {
-                case HASHTABLE_INTEGER:
-                    log_printf ("      value (integer). . : %d", *((int *)ptr_item->value));
-                    break;
-                case HASHTABLE_STRING:
-                    log_printf ("      value (string) . . : '%s'", (char *)ptr_item->value);
-                    break;
-                case HASHTABLE_POINTER:
-                    log_printf ("      value (pointer). . : 0x%lx", ptr_item->value);
-                    break;
-                case HASHTABLE_BUFFER:
-                    log_printf ("      value (buffer) . . : 0x%lx", ptr_item->value);
-                    break;
-                case HASHTABLE_TIME:
-                    log_printf ("      value (time) . . . : %lld", (long long)(*((time_t *)ptr_item->value)));
-                    break;
-                case HASHTABLE_NUM_TYPES:
-                    break;
-            }
-            log_printf ("      value_size . . . . : %d",    ptr_item->value_size);
-            log_printf ("      prev_item. . . . . : 0x%lx", ptr_item->prev_item);
-            log_printf ("      next_item. . . . . : 0x%lx", ptr_item->next_item);
-            log_printf ("      prev_created_item. : 0x%lx", ptr_item->prev_created_item);
-            log_printf ("      next_created_item. : 0x%lx", ptr_item->next_created_item);
+            case HASHTABLE_INTEGER:
+                log_printf ("      key (integer). . . : %d", *((int *)ptr_item->key));
+                break;
+            case HASHTABLE_STRING:
+                log_printf ("      key (string) . . . : '%s'", (char *)ptr_item->key);
+                break;
+            case HASHTABLE_POINTER:
+                log_printf ("      key (pointer). . . : 0x%lx", ptr_item->key);
+                break;
+            case HASHTABLE_BUFFER:
+                log_printf ("      key (buffer) . . . : 0x%lx", ptr_item->key);
+                break;
+            case HASHTABLE_TIME:
+                log_printf ("      key (time) . . . . : %lld", (long long)(*((time_t *)ptr_item->key)));
+                break;
+            case HASHTABLE_NUM_TYPES:
+                break;
+        }
+        log_printf ("      key_size . . . . . : %d", ptr_item->key_size);
+        switch (hashtable->type_values)
+        {
+            case HASHTABLE_INTEGER:
+                log_printf ("      value (integer). . : %d", *((int *)ptr_item->value));
+                break;
+            case HASHTABLE_STRING:
+                log_printf ("      value (string) . . : '%s'", (char *)ptr_item->value);
+                break;
+            case HASHTABLE_POINTER:
+                log_printf ("      value (pointer). . : 0x%lx", ptr_item->value);
+                break;
+            case HASHTABLE_BUFFER:
+                log_printf ("      value (buffer) . . : 0x%lx", ptr_item->value);
+                break;
+            case HASHTABLE_TIME:
+                log_printf ("      value (time) . . . : %lld", (long long)(*((time_t *)ptr_item->value)));
+                break;
+            case HASHTABLE_NUM_TYPES:
+                break;
         }
+        log_printf ("      value_size . . . . : %d",    ptr_item->value_size);
+        log_printf ("      value_inline . . . : %d",    ptr_item->value_inline);
+        log_printf ("      hash . . . . . . . : 0x%llx", ptr_item->hash);
+        log_printf ("      prev_created_item. : 0x%lx", ptr_item->prev_created_item);
+        log_printf ("      next_created_item. : 0x%lx", ptr_item->next_created_item);
     }
 }
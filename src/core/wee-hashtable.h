@@ -68,36 +68,63 @@ typedef void (t_hashtable_map_string)(void *data,
                                       const char *key, const char *value);
 
 /*
- * Hashtable is a structure with an array "htable", each entry is a pointer
- * to a linked list, and it is read with hashed key (as unsigned long long).
- * Keys with same hashed key are grouped in a linked list pointed by htable.
- * The htable is not sorted, the linked list is sorted.
+ * Hashtable is a structure with an array "htable" of slots, using open
+ * addressing with linear probing: each slot contains the hash of a key and a
+ * pointer to the item (or NULL if the slot is empty).
+ * The size of htable is always a power of 2 and it is doubled when the load
+ * factor reaches 3/4, so the number of items is not limited by the initial
+ * size given to hashtable_new.
  *
- * Example of a hashtable with size 8 and 6 items added inside, items are:
- * "weechat", "fast", "light", "extensible", "chat", "client"
- * Keys "fast" and "light" have same hashed value, so they are together in
- * linked list.
+ * Items are allocated once and never moved (pointers to items remain valid
+ * until they are removed from the hashtable); keys and values copied by the
+ * hashtable are stored in the same allocation as the item (a value is
+ * allocated separately only if it is changed after the item creation).
+ *
+ * Example of a hashtable with size 8 and 6 items added inside (with seed 0),
+ * items are: "weechat", "light", "fast", "extensible", "chat", "client"
+ * Keys "fast" and "chat" have same slot (7), so "chat" (added after "fast")
+ * is stored in the next free slot, which is 0 (search continues at the
+ * beginning of array). Then "client" has slot 0, which is used, as well as
+ * slot 1, so it is stored in slot 2.
  *
  * Result is:
  * +-----+
- * |   0 |
+ * |   0 | --> "chat"
  * +-----+
- * |   1 |
+ * |   1 | --> "weechat"
  * +-----+
- * |   2 | --> "extensible"
+ * |   2 | --> "client"
  * +-----+
- * |   3 | --> "fast" --> "light"
+ * |   3 | --> "extensible"
  * +-----+
  * |   4 |
  * +-----+
- * |   5 | --> "chat"
+ * |   5 |
  * +-----+
- * |   6 | --> "client"
+ * |   6 | --> "light"
  * +-----+
- * |   7 | --> "weechat"
+ * |   7 | --> "fast"
  * +-----+
  */
 
+#define HASHTABLE_MIN_SIZE 8
+#define HASHTABLE_MAX_SIZE (1 << 30)
+
+/* small hashtables use slots stored in the hashtable itself */
+#define HASHTABLE_SMALL_SIZE 16
+#define HASHTABLE_SMALL_MAX_SIZE 32
+
+/* number of freed hashtables kept for reuse */
+#define HASHTABLE_POOL_SIZE 64
+
+/* size rounded to keep alignment of value stored after key in item */
+#define HASHTABLE_ALIGN_SIZE(__size)                                     \
+    (((__size) + 7) & ~7)
+
+/* key copied by hashtable is stored in the same allocation as the item */
+#define HASHTABLE_ITEM_KEY_INLINE(__item)                                \
+    ((__item)->key == (void *)((__item) + 1))
+
 enum t_hashtable_type
 {
     HASHTABLE_INTEGER = 0,
@@ -113,21 +140,29 @@ struct t_hashtable_item
 {
     void *key;                          /* item key                         */
     int key_size;                       /* size of key (in bytes)           */
+    int value_inline;                   /* 1 if value is stored in the same */
+                                        /* allocation as the item           */
     void *value;                        /* pointer to value                 */
     int value_size;                     /* size of value (in bytes)         */
-    struct t_hashtable_item *prev_item; /* link to previous item            */
-    struct t_hashtable_item *next_item; /* link to next item                */
+    unsigned long long hash;            /* hash of key                      */
     /* previous/next item by order of creation in the hashtable */
     struct t_hashtable_item *prev_created_item;
     struct t_hashtable_item *next_created_item;
+};
 
+struct t_hashtable_slot
+{
+    unsigned long long hash;            /* hash of key (copy of item->hash) */
+    struct t_hashtable_item *item;      /* item (NULL if slot is empty)     */
 };
 
 struct t_hashtable
 {
-    int size;                          /* hashtable size                    */
-    struct t_hashtable_item **htable;  /* table to map hashes with linked   */
-                                       /* lists                             */
+    int size;                          /* hashtable size (power of 2)       */
+    struct t_hashtable_slot *htable;   /* slots (open addressing)           */
+    struct t_hashtable_slot htable_small[HASHTABLE_SMALL_SIZE];
+                                       /* slots used by small hashtables    */
+    unsigned long long hash_seed;      /* seed used to hash keys            */
     int items_count;                   /* number of items in hashtable      */
     struct t_hashtable_item *oldest_item; /* oldest item in hashtable       */
     struct t_hashtable_item *newest_item; /* newest item in hashtable       */
@@ -147,7 +182,15 @@ struct t_hashtable
                                        /* never asked)                      */
 };
 
+extern unsigned long long hashtable_hash_seed;
+
+extern void hashtable_init_seed ();
 extern unsigned long long hashtable_hash_key_djb2 (const char *string);
+extern unsigned long long hashtable_hash_key_wyhash (const void *buffer,
+                                                     int length,
+                                                     unsigned long long seed);
+extern unsigned long long hashtable_hash_key_string (const char *string,
+                                                     unsigned long long seed);
 extern struct t_hashtable *hashtable_new (int size,
                                           const char *type_keys,
                                           const char *type_values,
@@ -192,5 +235,6 @@ extern void hashtable_remove_all (struct t_hashtable *hashtable);
 extern void hashtable_free (struct t_hashtable *hashtable);
 extern void hashtable_print_log (struct t_hashtable *hashtable,
                                  const char *name);
+extern void hashtable_end ();
 
 #endif /* WEECHAT_HASHTABLE_H */
@@ -0,0 +1,351 @@
+/*
+ * wee-pool.c - pools of fixed-size objects (slab allocator)
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "weechat.h"
+#include "wee-pool.h"
+#include "wee-log.h"
+#include "../plugins/plugin.h"
+
+
+struct t_pool *weechat_pools = NULL;       /* first pool                    */
+struct t_pool *last_weechat_pool = NULL;   /* last pool                     */
+
+
+/*
+ * Creates a new pool of objects.
+ *
+ * Argument "objects_per_slab" is the number of objects allocated at once
+ * when the pool is full (if <= 0, a default value is used).
+ *
+ * Returns pointer to new pool, NULL if error.
+ */
+
+struct t_pool *
+pool_new (struct t_weechat_plugin *plugin, const char *name, int object_size,
+          int objects_per_slab)
+{
+    struct t_pool *new_pool;
+    size_t size;
+
+    if (!name || (object_size <= 0))
+        return NULL;
+
+    /* object must be big enough to be linked in the free list */
+    size = (size_t)object_size;
+    if (size < sizeof (struct t_pool_free_object))
+        size = sizeof (struct t_pool_free_object);
+    size = (size + POOL_ALIGN_SIZE - 1) & ~((size_t)POOL_ALIGN_SIZE - 1);
+
+    if (objects_per_slab <= 0)
+        objects_per_slab = POOL_DEFAULT_PER_SLAB;
+    if ((size_t)objects_per_slab > POOL_MAX_SLAB_SIZE / size)
+        objects_per_slab = POOL_MAX_SLAB_SIZE / size;
+    if (objects_per_slab < 1)
+        objects_per_slab = 1;
+
+    new_pool = malloc (sizeof (*new_pool));
+    if (!new_pool)
+        return NULL;
+
+    new_pool->plugin = plugin;
+    new_pool->name = strdup (name);
+    if (!new_pool->name)
+    {
+        free (new_pool);
+        return NULL;
+    }
+    new_pool->object_size = size;
+    new_pool->objects_per_slab = objects_per_slab;
+    new_pool->slabs = NULL;
+    new_pool->slabs_count = 0;
+    new_pool->free_objects = NULL;
+    new_pool->objects_used = 0;
+    new_pool->objects_used_max = 0;
+    new_pool->count_alloc = 0;
+
+    new_pool->prev_pool = last_weechat_pool;
+    new_pool->next_pool = NULL;
+    if (last_weechat_pool)
+        last_weechat_pool->next_pool = new_pool;
+    else
+        weechat_pools = new_pool;
+    last_weechat_pool = new_pool;
+
+    return new_pool;
+}
+
+/*
+ * Adds a slab in a pool: all objects of the slab are added in the free
+ * list of pool.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (not enough memory)
+ */
+
+int
+pool_add_slab (struct t_pool *pool)
+{
+    struct t_pool_slab *new_slab;
+    struct t_pool_free_object *ptr_object;
+    char *ptr_objects;
+    int i;
+
+    new_slab = malloc (POOL_SLAB_HEADER_SIZE
+                       + (pool->object_size * pool->objects_per_slab));
+    if (!new_slab)
+        return 0;
+
+    new_slab->next_slab = pool->slabs;
+    pool->slabs = new_slab;
+    pool->slabs_count++;
+
+    /* chain objects so that they are used in address order */
+    ptr_objects = (char *)new_slab + POOL_SLAB_HEADER_SIZE;
+    for (i = pool->objects_per_slab - 1; i >= 0; i--)
+    {
+        ptr_object = (struct t_pool_free_object *)(ptr_objects
+                                                   + (i * pool->object_size));
+        ptr_object->next = pool->free_objects;
+        pool->free_objects = ptr_object;
+    }
+
+    return 1;
+}
+
+/*
+ * Allocates an object in a pool.
+ *
+ * Content of the object is not initialized (like malloc); if debug is
+ * enabled for core, the object is filled with POOL_POISON_ALLOC.
+ *
+ * Returns pointer to object, NULL if error.
+ */
+
+void *
+pool_alloc (struct t_pool *pool)
+{
+    struct t_pool_free_object *object;
+
+    if (!pool)
+        return NULL;
+
+    if (!pool->free_objects && !pool_add_slab (pool))
+        return NULL;
+
+    object = pool->free_objects;
+    pool->free_objects = object->next;
+
+    pool->objects_used++;
+    if (pool->objects_used > pool->objects_used_max)
+        pool->objects_used_max = pool->objects_used;
+    pool->count_alloc++;
+
+    if (weechat_debug_core >= 1)
+        memset (object, POOL_POISON_ALLOC, pool->object_size);
+
+    return object;
+}
+
+/*
+ * Checks if an object belongs to a pool (used only when debug is enabled
+ * for core, because all slabs are scanned).
+ *
+ * Returns:
+ *   1: object belongs to pool
+ *   0: object does not belong to pool
+ */
+
+int
+pool_valid_object (struct t_pool *pool, void *object)
+{
+    struct t_pool_slab *ptr_slab;
+    char *ptr_start;
+    size_t offset;
+
+    for (ptr_slab = pool->slabs; ptr_slab; ptr_slab = ptr_slab->next_slab)
+    {
+        ptr_start = (char *)ptr_slab + POOL_SLAB_HEADER_SIZE;
+        if (((char *)object >= ptr_start)
+            && ((char *)object < ptr_start + (pool->object_size
+                                              * pool->objects_per_slab)))
+        {
+            offset = (size_t)((char *)object - ptr_start);
+            return (offset % pool->object_size == 0) ? 1 : 0;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Releases an object allocated in a pool: the object is kept for reuse by
+ * next allocations (memory is given back to the system only when the pool
+ * is freed).
+ *
+ * If debug is enabled for core, the object is filled with
+ * POOL_POISON_RELEASE, so that a use after release is easier to detect.
+ */
+
+void
+pool_release (struct t_pool *pool, void *object)
+{
+    struct t_pool_free_object *ptr_object;
+
+    if (!pool || !object)
+        return;
+
+    if (weechat_debug_core >= 1)
+    {
+        if (!pool_valid_object (pool, object))
+        {
+            log_printf ("pool: object 0x%lx released in wrong pool \"%s\" "
+                        "(0x%lx)",
+                        object, pool->name, pool);
+            return;
+        }
+        memset (object, POOL_POISON_RELEASE, pool->object_size);
+    }
+
+    ptr_object = (struct t_pool_free_object *)object;
+    ptr_object->next = pool->free_objects;
+    pool->free_objects = ptr_object;
+
+    pool->objects_used--;
+}
+
+/*
+ * Returns the total number of objects in a pool (used and free).
+ */
+
+int
+pool_objects_total (struct t_pool *pool)
+{
+    if (!pool)
+        return 0;
+
+    return pool->slabs_count * pool->objects_per_slab;
+}
+
+/*
+ * Frees a pool and all its objects.
+ */
+
+void
+pool_free (struct t_pool *pool)
+{
+    struct t_pool_slab *ptr_slab, *next_slab;
+
+    if (!pool)
+        return;
+
+    /* remove pool from list */
+    if (last_weechat_pool == pool)
+        last_weechat_pool = pool->prev_pool;
+    if (pool->prev_pool)
+        (pool->prev_pool)->next_pool = pool->next_pool;
+    else
+        weechat_pools = pool->next_pool;
+    if (pool->next_pool)
+        (pool->next_pool)->prev_pool = pool->prev_pool;
+
+    /* free slabs */
+    ptr_slab = pool->slabs;
+    while (ptr_slab)
+    {
+        next_slab = ptr_slab->next_slab;
+        free (ptr_slab);
+        ptr_slab = next_slab;
+    }
+
+    free (pool->name);
+    free (pool);
+}
+
+/*
+ * Frees all pools created by a plugin.
+ */
+
+void
+pool_free_all_plugin (struct t_weechat_plugin *plugin)
+{
+    struct t_pool *ptr_pool, *next_pool;
+
+    ptr_pool = weechat_pools;
+    while (ptr_pool)
+    {
+        next_pool = ptr_pool->next_pool;
+        if (ptr_pool->plugin == plugin)
+            pool_free (ptr_pool);
+        ptr_pool = next_pool;
+    }
+}
+
+/*
+ * Frees all pools (called when WeeChat exits).
+ */
+
+void
+pool_end ()
+{
+    while (weechat_pools)
+    {
+        pool_free (weechat_pools);
+    }
+}
+
+/*
+ * Prints pools in WeeChat log file (usually for crash dump).
+ */
+
+void
+pool_print_log ()
+{
+    struct t_pool *ptr_pool;
+
+    for (ptr_pool = weechat_pools; ptr_pool; ptr_pool = ptr_pool->next_pool)
+    {
+        log_printf ("");
+        log_printf ("[pool (addr:0x%lx)]", ptr_pool);
+        log_printf ("  plugin . . . . . . . . : 0x%lx ('%s')",
+                    ptr_pool->plugin,
+                    plugin_get_name (ptr_pool->plugin));
+        log_printf ("  name . . . . . . . . . : '%s'", ptr_pool->name);
+        log_printf ("  object_size. . . . . . : %lu",
+                    (unsigned long)ptr_pool->object_size);
+        log_printf ("  objects_per_slab . . . : %d", ptr_pool->objects_per_slab);
+        log_printf ("  slabs. . . . . . . . . : 0x%lx", ptr_pool->slabs);
+        log_printf ("  slabs_count. . . . . . : %d", ptr_pool->slabs_count);
+        log_printf ("  free_objects . . . . . : 0x%lx", ptr_pool->free_objects);
+        log_printf ("  objects_used . . . . . : %d", ptr_pool->objects_used);
+        log_printf ("  objects_used_max . . . : %d", ptr_pool->objects_used_max);
+        log_printf ("  count_alloc. . . . . . : %llu", ptr_pool->count_alloc);
+        log_printf ("  prev_pool. . . . . . . : 0x%lx", ptr_pool->prev_pool);
+        log_printf ("  next_pool. . . . . . . : 0x%lx", ptr_pool->next_pool);
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEECHAT_POOL_H
+#define WEECHAT_POOL_H
+
+#include <stddef.h>
+
+#define POOL_ALIGN_SIZE            8
+#define POOL_SLAB_HEADER_SIZE      16
+#define POOL_DEFAULT_PER_SLAB      64
+#define POOL_MAX_SLAB_SIZE         (1024 * 1024)
+
+/* patterns written in objects when debug is enabled for core */
+#define POOL_POISON_ALLOC          0xCB
+#define POOL_POISON_RELEASE        0xDB
+
+struct t_weechat_plugin;
+
+/*
+ * A pool allocates fixed-size objects from slabs (big chunks holding
+ * many objects); released objects are put in a free list and reused by
+ * next allocations, so that malloc/free are not called for each object.
+ *
+ * Pools are not thread-safe: they must be used only in main thread.
+ */
+
+struct t_pool_slab
+{
+    struct t_pool_slab *next_slab;     /* link to next slab                 */
+    /* objects follow the header (at offset POOL_SLAB_HEADER_SIZE)          */
+};
+
+struct t_pool_free_object
+{
+    struct t_pool_free_object *next;   /* next free object in pool          */
+};
+
+struct t_pool
+{
+    struct t_weechat_plugin *plugin;   /* plugin (NULL for WeeChat core)    */
+    char *name;                        /* pool name (for /debug memory)     */
+    size_t object_size;                /* size of an object (aligned)       */
+    int objects_per_slab;              /* number of objects in a slab       */
+    struct t_pool_slab *slabs;         /* slabs allocated                   */
+    int slabs_count;                   /* number of slabs                   */
+    struct t_pool_free_object *free_objects; /* objects ready for reuse     */
+    int objects_used;                  /* number of objects allocated       */
+    int objects_used_max;              /* max number of objects allocated   */
+    unsigned long long count_alloc;    /* total number of allocations       */
+    struct t_pool *prev_pool;          /* link to previous pool             */
+    struct t_pool *next_pool;          /* link to next pool                 */
+};
+
+extern struct t_pool *weechat_pools;
+extern struct t_pool *last_weechat_pool;
+
+extern struct t_pool *pool_new (struct t_weechat_plugin *plugin,
+                                const char *name, int object_size,
+                                int objects_per_slab);
+extern void *pool_alloc (struct t_pool *pool);
+extern void pool_release (struct t_pool *pool, void *object);
+extern int pool_objects_total (struct t_pool *pool);
+extern void pool_free (struct t_pool *pool);
+extern void pool_free_all_plugin (struct t_weechat_plugin *plugin);
+extern void pool_end ();
+extern void pool_print_log ();
+
+#endif /* WEECHAT_POOL_H */
@@ -66,6 +66,26 @@
 
 struct t_hashtable *string_hashtable_shared = NULL;
 
+#ifdef HAVE_ICONV
+/*
+ * iconv descriptors kept open: opening a descriptor is slow (charsets are
+ * looked up and conversion tables may be loaded), so the descriptors are
+ * reused for next conversions with same charsets
+ */
+struct t_string_iconv_cache
+{
+    char *from_code;                   /* source charset                    */
+    char *to_code;                     /* target charset                    */
+    iconv_t cd;                        /* iconv descriptor                  */
+    int ascii_compatible;              /* 1 if ASCII chars are unchanged    */
+    unsigned long long last_used;      /* counter when last used (for LRU)  */
+};
+
+struct t_string_iconv_cache string_iconv_cache[STRING_ICONV_CACHE_SIZE];
+int string_iconv_cache_count = 0;
+unsigned long long string_iconv_cache_counter = 0;
+#endif /* HAVE_ICONV */
+
 
 /*
  * Defines a "strndup" function for systems where this function does not exist
@@ -383,13 +403,28 @@ string_toupper (const char *string)
 int
 string_strcasecmp (const char *string1, const char *string2)
 {
-    int diff;
+    int diff, char1, char2;
 
     if (!string1 || !string2)
         return (string1) ? 1 : ((string2) ? -1 : 0);
 
     while (string1[0] && string2[0])
     {
+        /* fast path for ASCII chars (no UTF-8 decoding needed) */
+        if (!((unsigned char)string1[0] & 0x80)
+            && !((unsigned char)string2[0] & 0x80))
+        {
+            char1 = ((string1[0] >= 'A') && (string1[0] <= 'Z')) ?
+                string1[0] + ('a' - 'A') : string1[0];
+            char2 = ((string2[0] >= 'A') && (string2[0] <= 'Z')) ?
+                string2[0] + ('a' - 'A') : string2[0];
+            if (char1 != char2)
+                return (char1 < char2) ? -1 : 1;
+            string1++;
+            string2++;
+            continue;
+        }
+
         diff = utf8_charcasecmp (string1, string2);
         if (diff != 0)
             return (diff < 0) ? -1 : 1;
@@ -2786,6 +2821,184 @@ string_free_split_tags (char ***split_tags)
     }
 }
 
+#ifdef HAVE_ICONV
+/*
+ * Checks if ASCII chars are unchanged by an iconv descriptor (this is true
+ * for most charsets, but not for UTF-16, UTF-7, HZ or ISO-2022-JP for
+ * example).
+ *
+ * All ASCII chars are converted, as well as the sequences used by stateful
+ * 7-bit charsets to switch to other chars (ISO-2022-*, UTF-7, HZ).
+ *
+ * Returns:
+ *   1: ASCII chars are unchanged
+ *   0: ASCII chars are converted
+ */
+
+int
+string_iconv_is_ascii_compatible (iconv_t cd)
+{
+    const char *sequences[] = {
+        "\x1B$B!!\x1B(B",     /* ISO-2022-JP                               */
+        "\x1B$)C\x0E!!\x0F", /* ISO-2022-KR                               */
+        "+AGE-",              /* UTF-7                                     */
+        "~{!!~}",             /* HZ                                        */
+        NULL,
+    };
+    char ascii[128], output[1024], *ptr_inbuf, *ptr_outbuf;
+    const char *ptr_input;
+    size_t err, inbytesleft, outbytesleft, length;
+    int i, rc;
+
+    /* all ASCII chars, except '\0' */
+    for (i = 1; i < 128; i++)
+    {
+        ascii[i - 1] = (char)i;
+    }
+    ascii[127] = '\0';
+
+    rc = 1;
+    for (i = -1; rc && ((i < 0) || sequences[i]); i++)
+    {
+        ptr_input = (i < 0) ? ascii : sequences[i];
+        length = strlen (ptr_input);
+        ptr_inbuf = (char *)ptr_input;
+        inbytesleft = length;
+        ptr_outbuf = output;
+        outbytesleft = sizeof (output);
+        err = iconv (cd, (ICONV_CONST char **)(&ptr_inbuf), &inbytesleft,
+                     &ptr_outbuf, &outbytesleft);
+        if (err != (size_t)(-1))
+        {
+            /* flush shift sequence (if any) */
+            err = iconv (cd, NULL, NULL, &ptr_outbuf, &outbytesleft);
+        }
+        rc = ((err != (size_t)(-1))
+              && (inbytesleft == 0)
+              && ((size_t)(ptr_outbuf - output) == length)
+              && (memcmp (output, ptr_input, length) == 0)) ? 1 : 0;
+
+        /* reset conversion state */
+        iconv (cd, NULL, NULL, NULL, NULL);
+    }
+
+    return rc;
+}
+
+/*
+ * Gets an iconv descriptor to convert from a charset to another: the
+ * descriptor is reused if it has already been opened (recently), otherwise
+ * it is opened and kept in cache (the least recently used descriptor is
+ * closed if the cache is full).
+ *
+ * Argument "ascii_compatible" is set to 1 if ASCII chars are unchanged by
+ * the conversion.
+ *
+ * Note: the descriptor must not be closed by the caller.
+ *
+ * Returns iconv descriptor, (iconv_t)(-1) if error.
+ */
+
+iconv_t
+string_iconv_open (const char *from_code, const char *to_code,
+                   int *ascii_compatible)
+{
+    iconv_t cd;
+    int i, index;
+
+    *ascii_compatible = 0;
+
+    string_iconv_cache_counter++;
+
+    for (i = 0; i < string_iconv_cache_count; i++)
+    {
+        if ((strcmp (string_iconv_cache[i].from_code, from_code) == 0)
+            && (strcmp (string_iconv_cache[i].to_code, to_code) == 0))
+        {
+            /* reset conversion state */
+            iconv (string_iconv_cache[i].cd, NULL, NULL, NULL, NULL);
+            string_iconv_cache[i].last_used = string_iconv_cache_counter;
+            *ascii_compatible = string_iconv_cache[i].ascii_compatible;
+            return string_iconv_cache[i].cd;
+        }
+    }
+
+    cd = iconv_open (to_code, from_code);
+    if (cd == (iconv_t)(-1))
+        return cd;
+
+    if (string_iconv_cache_count < STRING_ICONV_CACHE_SIZE)
+    {
+        index = string_iconv_cache_count;
+    }
+    else
+    {
+        /* cache is full: close the least recently used descriptor */
+        index = 0;
+        for (i = 1; i < string_iconv_cache_count; i++)
+        {
+            if (string_iconv_cache[i].last_used
+                < string_iconv_cache[index].last_used)
+            {
+                index = i;
+            }
+        }
+        free (string_iconv_cache[index].from_code);
+        free (string_iconv_cache[index].to_code);
+        iconv_close (string_iconv_cache[index].cd);
+        string_iconv_cache_count--;
+    }
+
+    string_iconv_cache[index].from_code = strdup (from_code);
+    string_iconv_cache[index].to_code = strdup (to_code);
+    if (!string_iconv_cache[index].from_code
+        || !string_iconv_cache[index].to_code)
+    {
+        if (string_iconv_cache[index].from_code)
+            free (string_iconv_cache[index].from_code);
+        if (string_iconv_cache[index].to_code)
+            free (string_iconv_cache[index].to_code);
+        iconv_close (cd);
+        /* keep cache consistent: move last entry in the free slot */
+        if (index < string_iconv_cache_count)
+        {
+            string_iconv_cache[index] =
+                string_iconv_cache[string_iconv_cache_count];
+        }
+        return (iconv_t)(-1);
+    }
+    string_iconv_cache[index].cd = cd;
+    string_iconv_cache[index].ascii_compatible =
+        string_iconv_is_ascii_compatible (cd);
+    string_iconv_cache[index].last_used = string_iconv_cache_counter;
+    string_iconv_cache_count++;
+
+    *ascii_compatible = string_iconv_cache[index].ascii_compatible;
+
+    return cd;
+}
+#endif /* HAVE_ICONV */
+
+/*
+ * Closes all iconv descriptors kept in cache.
+ */
+
+void
+string_iconv_cache_free ()
+{
+#ifdef HAVE_ICONV
+    int i;
+
+    for (i = 0; i < string_iconv_cache_count; i++)
+    {
+        free (string_iconv_cache[i].from_code);
+        free (string_iconv_cache[i].to_code);
+        iconv_close (string_iconv_cache[i].cd);
+    }
+    string_iconv_cache_count = 0;
+#endif /* HAVE_ICONV */
+}
+
 /*
  * Converts a string to another charset.
  *
@@ -2802,7 +3015,7 @@ string_iconv (int from_utf8, const char *from_code, const char *to_code,
     iconv_t cd;
     char *inbuf, *ptr_outbuf;
     const char *ptr_inbuf, *ptr_inbuf_shift, *next_char;
-    int done;
+    int done, ascii_compatible;
     size_t err, inbytesleft, outbytesleft;
 #endif /* HAVE_ICONV */
 
@@ -2813,9 +3026,14 @@ string_iconv (int from_utf8, const char *from_code, const char *to_code,
     if (from_code && from_code[0] && to_code && to_code[0]
         && (string_strcasecmp (from_code, to_code) != 0))
     {
-        cd = iconv_open (to_code, from_code);
+        cd = string_iconv_open (from_code, to_code, &ascii_compatible);
         if (cd == (iconv_t)(-1))
             outbuf = strdup (string);
+        else if (ascii_compatible && !utf8_has_8bits (string))
+        {
+            /* only ASCII chars, unchanged by conversion */
+            outbuf = strdup (string);
+        }
         else
         {
             inbuf = strdup (string);
@@ -2886,7 +3104,6 @@ string_iconv (int from_utf8, const char *from_code, const char *to_code,
                 ptr_inbuf = ptr_inbuf_shift;
             ptr_outbuf[0] = '\0';
             free (inbuf);
-            iconv_close (cd);
         }
     }
     else
@@ -3968,17 +4185,16 @@ string_replace_with_callback (const char *string,
  * Hashes a shared string.
  * The string starts after the reference count, which is skipped.
  *
- * Returns the hash of the shared string (variant of djb2).
+ * Returns the hash of the shared string.
  */
 
 unsigned long long
 string_shared_hash_key (struct t_hashtable *hashtable,
                         const void *key)
 {
-    /* make C compiler happy */
-    (void) hashtable;
-
-    return hashtable_hash_key_djb2 (((const char *)key) + sizeof (string_shared_count_t));
+    return hashtable_hash_key_string (
+        ((const char *)key) + sizeof (string_shared_count_t),
+        hashtable->hash_seed);
 }
 
 /*
@@ -4047,8 +4263,8 @@ string_shared_get (const char *string)
     if (!string_hashtable_shared)
     {
         /*
-         * use large htable inside hashtable to prevent too many collisions,
-         * which would slow down search of a string in the hashtable
+         * use large initial htable inside hashtable to prevent resizes
+         * when many strings are added on startup
          */
         string_hashtable_shared = hashtable_new (1024,
                                                  WEECHAT_HASHTABLE_POINTER,
@@ -4326,6 +4542,8 @@ string_dyn_free (char **string, int free_string)
 void
 string_end ()
 {
+    string_iconv_cache_free ();
+
     if (string_hashtable_shared)
     {
         hashtable_free (string_hashtable_shared);
@@ -24,6 +24,9 @@
 #include <stdint.h>
 #include <regex.h>
 
+/* number of iconv descriptors kept open for next conversions */
+#define STRING_ICONV_CACHE_SIZE 8
+
 typedef uint32_t string_shared_count_t;
 
 typedef uint32_t string_dyn_size_t;
@@ -106,6 +109,7 @@ extern char **string_split_command (const char *command, char separator);
 extern void string_free_split_command (char **split_command);
 extern char ***string_split_tags (const char *tags, int *num_tags);
 extern void string_free_split_tags (char ***split_tags);
+extern void string_iconv_cache_free ();
 extern char *string_iconv (int from_utf8, const char *from_code,
                            const char *to_code, const char *string);
 extern char *string_iconv_to_internal (const char *charset, const char *string);
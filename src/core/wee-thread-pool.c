@@ -0,0 +1,429 @@
+/*
+ * wee-thread-pool.c - pool of worker threads
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+
+#include "weechat.h"
+#include "wee-thread-pool.h"
+#include "wee-util.h"
+
+
+pthread_mutex_t thread_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t thread_pool_cond_job = PTHREAD_COND_INITIALIZER;
+pthread_cond_t thread_pool_cond_done = PTHREAD_COND_INITIALIZER;
+
+struct t_thread_pool_job *thread_pool_queue = NULL;      /* jobs waiting    */
+struct t_thread_pool_job *last_thread_pool_queue = NULL; /* last job        */
+int thread_pool_max_threads = 0;       /* max threads (set when adding job) */
+int thread_pool_stopping = 0;          /* 1 if threads must stop            */
+struct t_thread_pool_stats thread_pool_stats; /* stats (threads and jobs)   */
+
+
+/*
+ * Removes a job from the queue (mutex must be locked).
+ */
+
+void
+thread_pool_queue_remove (struct t_thread_pool_job *job)
+{
+    struct t_thread_pool_job *ptr_job, *prev_job;
+
+    prev_job = NULL;
+    for (ptr_job = thread_pool_queue; ptr_job; ptr_job = ptr_job->next_job)
+    {
+        if (ptr_job == job)
+        {
+            if (prev_job)
+                prev_job->next_job = job->next_job;
+            else
+                thread_pool_queue = job->next_job;
+            if (last_thread_pool_queue == job)
+                last_thread_pool_queue = prev_job;
+            job->next_job = NULL;
+            thread_pool_stats.jobs_queued--;
+            return;
+        }
+        prev_job = ptr_job;
+    }
+}
+
+/*
+ * Main function of a worker thread: runs jobs of the queue, and stops after
+ * THREAD_POOL_IDLE_TIMEOUT seconds without job (or if there are too many
+ * threads, or if the pool is stopping).
+ */
+
+void *
+thread_pool_worker (void *arg)
+{
+    struct t_thread_pool_job *job;
+    struct timeval tv_start, tv_end;
+    struct timespec ts;
+    int rc;
+
+    /* make C compiler happy */
+    (void) arg;
+
+    pthread_mutex_lock (&thread_pool_mutex);
+
+    while (1)
+    {
+        if (thread_pool_stopping
+            || (thread_pool_stats.threads > thread_pool_max_threads))
+        {
+            break;
+        }
+
+        if (!thread_pool_queue)
+        {
+            clock_gettime (CLOCK_REALTIME, &ts);
+            ts.tv_sec += THREAD_POOL_IDLE_TIMEOUT;
+            thread_pool_stats.threads_idle++;
+            rc = pthread_cond_timedwait (&thread_pool_cond_job,
+                                         &thread_pool_mutex, &ts);
+            thread_pool_stats.threads_idle--;
+            if ((rc == ETIMEDOUT) && !thread_pool_queue)
+                break;
+            continue;
+        }
+
+        /* take first job in queue */
+        job = thread_pool_queue;
+        thread_pool_queue_remove (job);
+        job->status = THREAD_POOL_JOB_RUNNING;
+        thread_pool_stats.jobs_running++;
+        gettimeofday (&tv_start, NULL);
+        thread_pool_stats.time_wait += util_timeval_diff (&job->time_queued,
+                                                          &tv_start);
+
+        pthread_mutex_unlock (&thread_pool_mutex);
+        rc = (job->func) (job->arg);
+        gettimeofday (&tv_end, NULL);
+        pthread_mutex_lock (&thread_pool_mutex);
+
+        job->rc = rc;
+        job->status = THREAD_POOL_JOB_DONE;
+        thread_pool_stats.jobs_running--;
+        thread_pool_stats.jobs_done++;
+        thread_pool_stats.time_run += util_timeval_diff (&tv_start, &tv_end);
+
+        if (job->detached)
+        {
+            /* nobody is waiting for this job: free it now */
+            pthread_mutex_unlock (&thread_pool_mutex);
+            if (job->free_arg)
+                (job->free_arg) (job->arg);
+            free (job);
+            pthread_mutex_lock (&thread_pool_mutex);
+        }
+
+        pthread_cond_broadcast (&thread_pool_cond_done);
+    }
+
+    thread_pool_stats.threads--;
+    pthread_cond_broadcast (&thread_pool_cond_done);
+
+    pthread_mutex_unlock (&thread_pool_mutex);
+
+    return NULL;
+}
+
+/*
+ * Starts a new worker thread (mutex must be locked).
+ *
+ * Signals are blocked in worker threads, so that they are always received
+ * by main thread.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+thread_pool_start_thread ()
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    sigset_t mask, old_mask;
+    int rc;
+
+    if (pthread_attr_init (&attr) != 0)
+        return 0;
+    pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+
+    sigfillset (&mask);
+    pthread_sigmask (SIG_SETMASK, &mask, &old_mask);
+    rc = pthread_create (&thread, &attr, &thread_pool_worker, NULL);
+    pthread_sigmask (SIG_SETMASK, &old_mask, NULL);
+
+    pthread_attr_destroy (&attr);
+
+    if (rc != 0)
+        return 0;
+
+    thread_pool_stats.threads++;
+
+    return 1;
+}
+
+/*
+ * Adds a job: function "func" is called with argument "arg" in a worker
+ * thread; a thread is started if no thread is available and if there are
+ * less than "max_threads" threads.
+ *
+ * Function "free_arg" is called (in worker thread) to free the argument if
+ * the job is freed while it is running (see function thread_pool_job_free).
+ *
+ * Returns pointer to new job, NULL if error.
+ */
+
+struct t_thread_pool_job *
+thread_pool_job_add (t_thread_pool_func *func, void *arg,
+                     t_thread_pool_free_func *free_arg, int max_threads)
+{
+    struct t_thread_pool_job *new_job;
+
+    if (!func || (max_threads < 1))
+        return NULL;
+
+    if (max_threads > THREAD_POOL_MAX_THREADS)
+        max_threads = THREAD_POOL_MAX_THREADS;
+
+    new_job = malloc (sizeof (*new_job));
+    if (!new_job)
+        return NULL;
+
+    new_job->func = func;
+    new_job->arg = arg;
+    new_job->free_arg = free_arg;
+    new_job->status = THREAD_POOL_JOB_QUEUED;
+    new_job->detached = 0;
+    new_job->rc = 0;
+    gettimeofday (&new_job->time_queued, NULL);
+    new_job->next_job = NULL;
+
+    pthread_mutex_lock (&thread_pool_mutex);
+
+    thread_pool_max_threads = max_threads;
+    thread_pool_stopping = 0;
+
+    /* add job at the end of queue */
+    if (last_thread_pool_queue)
+        last_thread_pool_queue->next_job = new_job;
+    else
+        thread_pool_queue = new_job;
+    last_thread_pool_queue = new_job;
+    thread_pool_stats.jobs_queued++;
+    if (thread_pool_stats.jobs_queued > thread_pool_stats.jobs_queued_max)
+        thread_pool_stats.jobs_queued_max = thread_pool_stats.jobs_queued;
+
+    /* start a new thread if all threads are busy */
+    if ((thread_pool_stats.threads_idle < thread_pool_stats.jobs_queued)
+        && (thread_pool_stats.threads < thread_pool_max_threads))
+    {
+        if (!thread_pool_start_thread ()
+            && (thread_pool_stats.threads == 0))
+        {
+            /* no thread at all to run the job */
+            thread_pool_queue_remove (new_job);
+            pthread_mutex_unlock (&thread_pool_mutex);
+            free (new_job);
+            return NULL;
+        }
+    }
+
+    pthread_cond_signal (&thread_pool_cond_job);
+
+    pthread_mutex_unlock (&thread_pool_mutex);
+
+    return new_job;
+}
+
+/*
+ * Checks if a job is done.
+ *
+ * Returns:
+ *   1: job is done (its return code is in job->rc)
+ *   0: job is waiting or running
+ */
+
+int
+thread_pool_job_done (struct t_thread_pool_job *job)
+{
+    int done;
+
+    if (!job)
+        return 0;
+
+    pthread_mutex_lock (&thread_pool_mutex);
+    done = (job->status == THREAD_POOL_JOB_DONE) ? 1 : 0;
+    pthread_mutex_unlock (&thread_pool_mutex);
+
+    return done;
+}
+
+/*
+ * Cancels a job not yet started: it is removed from queue, and its return
+ * code is -1 (a running job can not be cancelled).
+ *
+ * Returns:
+ *   1: job cancelled
+ *   0: job not cancelled (running or done)
+ */
+
+int
+thread_pool_job_cancel (struct t_thread_pool_job *job)
+{
+    int cancelled;
+
+    if (!job)
+        return 0;
+
+    pthread_mutex_lock (&thread_pool_mutex);
+
+    cancelled = 0;
+    if (job->status == THREAD_POOL_JOB_QUEUED)
+    {
+        thread_pool_queue_remove (job);
+        job->status = THREAD_POOL_JOB_DONE;
+        job->rc = -1;
+        cancelled = 1;
+    }
+
+    pthread_mutex_unlock (&thread_pool_mutex);
+
+    return cancelled;
+}
+
+/*
+ * Waits for the end of a job (blocking).
+ */
+
+void
+thread_pool_job_wait (struct t_thread_pool_job *job)
+{
+    if (!job)
+        return;
+
+    pthread_mutex_lock (&thread_pool_mutex);
+
+    while (job->status != THREAD_POOL_JOB_DONE)
+    {
+        pthread_cond_wait (&thread_pool_cond_done, &thread_pool_mutex);
+    }
+
+    pthread_mutex_unlock (&thread_pool_mutex);
+}
+
+/*
+ * Frees a job.
+ *
+ * A job not yet started is removed from queue. A running job can not be
+ * freed immediately: it is detached, and then freed by the worker thread at
+ * the end of job, with its argument (using function "free_arg" given when
+ * the job was added).
+ *
+ * Returns:
+ *   1: job freed (the argument must be freed by the caller)
+ *   0: job detached (the argument will be freed by the worker thread)
+ */
+
+int
+thread_pool_job_free (struct t_thread_pool_job *job)
+{
+    if (!job)
+        return 1;
+
+    pthread_mutex_lock (&thread_pool_mutex);
+
+    switch (job->status)
+    {
+        case THREAD_POOL_JOB_QUEUED:
+            thread_pool_queue_remove (job);
+            break;
+        case THREAD_POOL_JOB_RUNNING:
+            job->detached = 1;
+            pthread_mutex_unlock (&thread_pool_mutex);
+            return 0;
+        case THREAD_POOL_JOB_DONE:
+            break;
+    }
+
+    pthread_mutex_unlock (&thread_pool_mutex);
+
+    free (job);
+
+    return 1;
+}
+
+/*
+ * Gets statistics about threads and jobs.
+ */
+
+void
+thread_pool_get_stats (struct t_thread_pool_stats *stats)
+{
+    if (!stats)
+        return;
+
+    pthread_mutex_lock (&thread_pool_mutex);
+    memcpy (stats, &thread_pool_stats, sizeof (*stats));
+    pthread_mutex_unlock (&thread_pool_mutex);
+}
+
+/*
+ * Stops all threads: jobs running are waited (at most
+ * THREAD_POOL_END_TIMEOUT seconds).
+ */
+
+void
+thread_pool_end ()
+{
+    struct timespec ts;
+
+    pthread_mutex_lock (&thread_pool_mutex);
+
+    thread_pool_stopping = 1;
+    pthread_cond_broadcast (&thread_pool_cond_job);
+
+    clock_gettime (CLOCK_REALTIME, &ts);
+    ts.tv_sec += THREAD_POOL_END_TIMEOUT;
+    while (thread_pool_stats.threads > 0)
+    {
+        if (pthread_cond_timedwait (&thread_pool_cond_done, &thread_pool_mutex,
+                                    &ts) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock (&thread_pool_mutex);
+}
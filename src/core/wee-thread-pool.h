@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEECHAT_THREAD_POOL_H
+#define WEECHAT_THREAD_POOL_H
+
+#include <sys/time.h>
+
+#define THREAD_POOL_MAX_THREADS    64
+#define THREAD_POOL_IDLE_TIMEOUT   60  /* idle thread stops after 60s       */
+#define THREAD_POOL_END_TIMEOUT    5   /* max wait for running jobs on exit */
+
+enum t_thread_pool_job_status
+{
+    THREAD_POOL_JOB_QUEUED = 0,        /* job waiting for a thread          */
+    THREAD_POOL_JOB_RUNNING,           /* job running in a thread           */
+    THREAD_POOL_JOB_DONE,              /* job done (rc is set)              */
+};
+
+typedef int (t_thread_pool_func)(void *arg);
+typedef void (t_thread_pool_free_func)(void *arg);
+
+/*
+ * A job runs a function in a worker thread: the function must not use any
+ * WeeChat function which is not thread-safe (buffers, hooks, hashtables,
+ * pools of objects, ...).
+ *
+ * Jobs are added and freed in main thread; the end of job is checked by
+ * main thread (for example in a timer).
+ */
+
+struct t_thread_pool_job
+{
+    t_thread_pool_func *func;          /* function executed in a thread     */
+    void *arg;                         /* argument given to function        */
+    t_thread_pool_free_func *free_arg; /* free arg if job is detached       */
+    enum t_thread_pool_job_status status; /* status of job                  */
+    int detached;                      /* 1 if job is freed by thread       */
+    int rc;                            /* return code of function           */
+    struct timeval time_queued;        /* time when job was added           */
+    struct t_thread_pool_job *next_job; /* next job in queue                */
+};
+
+struct t_thread_pool_stats
+{
+    int threads;                       /* number of threads                 */
+    int threads_idle;                  /* threads waiting for a job         */
+    int jobs_queued;                   /* jobs waiting for a thread         */
+    int jobs_queued_max;               /* max number of jobs waiting        */
+    int jobs_running;                  /* jobs running                      */
+    unsigned long long jobs_done;      /* number of jobs done               */
+    unsigned long long time_wait;      /* total wait of jobs in queue (µs)  */
+    unsigned long long time_run;       /* total run time of jobs (µs)       */
+};
+
+extern struct t_thread_pool_job *thread_pool_job_add (t_thread_pool_func *func,
+                                                      void *arg,
+                                                      t_thread_pool_free_func *free_arg,
+                                                      int max_threads);
+extern int thread_pool_job_done (struct t_thread_pool_job *job);
+extern int thread_pool_job_cancel (struct t_thread_pool_job *job);
+extern void thread_pool_job_wait (struct t_thread_pool_job *job);
+extern int thread_pool_job_free (struct t_thread_pool_job *job);
+extern void thread_pool_get_stats (struct t_thread_pool_stats *stats);
+extern void thread_pool_end ();
+
+#endif /* WEECHAT_THREAD_POOL_H */
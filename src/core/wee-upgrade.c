@@ -656,6 +656,7 @@ upgrade_weechat_read_buffer_line (struct t_infolist *infolist)
             {
                 new_line->data->id = infolist_integer (infolist, "id");
                 gui_line_add (new_line);
+                gui_line_uncache_no_color (new_line->data);
                 new_line->data->highlight = infolist_integer (infolist,
                                                               "highlight");
                 if (infolist_integer (infolist, "last_read_line"))
@@ -814,6 +815,11 @@ upgrade_weechat_read_cb (const void *pointer, void *data,
                 else
                 {
                     gui_history_global_add (infolist_string (infolist, "text"));
+                    /*
+                     * global history restored is the one of previous
+                     * process: it must not be loaded again from file
+                     */
+                    gui_history_global_loaded = 1;
                 }
                 break;
             case UPGRADE_WEECHAT_TYPE_BUFFER:
@@ -890,8 +890,6 @@ struct t_url_option url_options[] =
     { NULL, 0, 0, NULL },
 };
 
-char url_error[CURL_ERROR_SIZE + 1];
-
 
 /*
  * Searches for a constant in array of constants.
@@ -1169,54 +1167,108 @@ weeurl_set_proxy (CURL *curl, struct t_proxy *proxy)
 }
 
 /*
- * Downloads URL using options.
+ * Callback called by curl during transfer: returns non-zero to abort the
+ * transfer if it has been cancelled.
+ */
+
+#if LIBCURL_VERSION_NUM >= 0x072000 /* 7.32.0 */
+int
+weeurl_progress_cb (void *clientp,
+                    curl_off_t dltotal, curl_off_t dlnow,
+                    curl_off_t ultotal, curl_off_t ulnow)
+#else
+int
+weeurl_progress_cb (void *clientp,
+                    double dltotal, double dlnow,
+                    double ultotal, double ulnow)
+#endif /* LIBCURL_VERSION_NUM >= 0x072000 */
+{
+    struct t_url_transfer *transfer;
+
+    /* make C compiler happy */
+    (void) dltotal;
+    (void) dlnow;
+    (void) ultotal;
+    (void) ulnow;
+
+    transfer = (struct t_url_transfer *)clientp;
+
+    return (transfer->cancel) ? 1 : 0;
+}
+
+/*
+ * Initializes a transfer of URL using options (this function must be called
+ * in main thread: options and proxy are read here).
+ *
+ * If "output" is NULL, the URL is written on standard output (if option
+ * "file_out" is not set), and if "error" is NULL, errors are written on
+ * standard error.
+ *
+ * The transfer can then be performed in another thread, with function
+ * weeurl_transfer_perform, and it must be ended with weeurl_transfer_end
+ * (even if this function fails).
  *
  * Returns:
  *   0: OK
  *   1: invalid URL
- *   2: error downloading URL
  *   3: not enough memory
  *   4: file error
  */
 
 int
-weeurl_download (const char *url, struct t_hashtable *options)
+weeurl_transfer_init (struct t_url_transfer *transfer, const char *url,
+                      struct t_hashtable *options, FILE *output, FILE *error)
 {
     CURL *curl;
-    struct t_url_file url_file[2];
     char *url_file_option[2] = { "file_in", "file_out" };
     char *url_file_mode[2] = { "rb", "wb" };
     CURLoption url_file_opt_func[2] = { CURLOPT_READFUNCTION, CURLOPT_WRITEFUNCTION };
     CURLoption url_file_opt_data[2] = { CURLOPT_READDATA, CURLOPT_WRITEDATA };
     void *url_file_opt_cb[2] = { &weeurl_read, &weeurl_write };
     struct t_proxy *ptr_proxy;
-    int rc, curl_rc, i;
+    int i;
 
-    rc = 0;
+    if (!transfer)
+        return 3;
 
-    for (i = 0; i < 2; i++)
-    {
-        url_file[i].filename = NULL;
-        url_file[i].stream = NULL;
-    }
+    memset (transfer, 0, sizeof (*transfer));
+    transfer->error = (error) ? error : stderr;
 
     if (!url || !url[0])
-    {
-        rc = 1;
-        goto end;
-    }
+        return 1;
+
+    transfer->url = strdup (url);
+    transfer->error_buffer = malloc (CURL_ERROR_SIZE + 1);
+    if (!transfer->url || !transfer->error_buffer)
+        return 3;
+    transfer->error_buffer[0] = '\0';
 
     curl = curl_easy_init ();
     if (!curl)
-    {
-        rc = 3;
-        goto end;
-    }
+        return 3;
+    transfer->curl = curl;
 
     /* set default options */
     curl_easy_setopt (curl, CURLOPT_URL, url);
     curl_easy_setopt (curl, CURLOPT_FOLLOWLOCATION, 1L);
 
+    /* do not use signals (the transfer may be done in a thread) */
+    curl_easy_setopt (curl, CURLOPT_NOSIGNAL, 1L);
+
+    /* allow cancel of transfer */
+#if LIBCURL_VERSION_NUM >= 0x072000 /* 7.32.0 */
+    curl_easy_setopt (curl, CURLOPT_XFERINFOFUNCTION, &weeurl_progress_cb);
+    curl_easy_setopt (curl, CURLOPT_XFERINFODATA, transfer);
+#else
+    curl_easy_setopt (curl, CURLOPT_PROGRESSFUNCTION, &weeurl_progress_cb);
+    curl_easy_setopt (curl, CURLOPT_PROGRESSDATA, transfer);
+#endif /* LIBCURL_VERSION_NUM >= 0x072000 */
+    curl_easy_setopt (curl, CURLOPT_NOPROGRESS, 0L);
+
+    /* write URL on output (if option "file_out" is not set) */
+    if (output)
+        curl_easy_setopt (curl, CURLOPT_WRITEDATA, output);
+
     /* set proxy (if option weechat.network.proxy_curl is set) */
     if (CONFIG_STRING(config_network_proxy_curl)
         && CONFIG_STRING(config_network_proxy_curl)[0])
@@ -1231,17 +1283,17 @@ weeurl_download (const char *url, struct t_hashtable *options)
     {
         for (i = 0; i < 2; i++)
         {
-            url_file[i].filename = hashtable_get (options, url_file_option[i]);
-            if (url_file[i].filename)
+            transfer->file[i].filename = hashtable_get (options,
+                                                        url_file_option[i]);
+            if (transfer->file[i].filename)
             {
-                url_file[i].stream = fopen (url_file[i].filename, url_file_mode[i]);
-                if (!url_file[i].stream)
-                {
-                    rc = 4;
-                    goto end;
-                }
+                transfer->file[i].stream = fopen (transfer->file[i].filename,
+                                                  url_file_mode[i]);
+                if (!transfer->file[i].stream)
+                    return 4;
                 curl_easy_setopt (curl, url_file_opt_func[i], url_file_opt_cb[i]);
-                curl_easy_setopt (curl, url_file_opt_data[i], url_file[i].stream);
+                curl_easy_setopt (curl, url_file_opt_data[i],
+                                  transfer->file[i].stream);
             }
         }
     }
@@ -1250,27 +1302,101 @@ weeurl_download (const char *url, struct t_hashtable *options)
     hashtable_map (options, &weeurl_option_map_cb, curl);
 
     /* set error buffer */
-    curl_easy_setopt (curl, CURLOPT_ERRORBUFFER, url_error);
+    curl_easy_setopt (curl, CURLOPT_ERRORBUFFER, transfer->error_buffer);
 
-    /* perform action! */
-    curl_rc = curl_easy_perform (curl);
+    return 0;
+}
+
+/*
+ * Performs a transfer initialized with weeurl_transfer_init (this function
+ * can be called in any thread).
+ *
+ * Returns:
+ *   0: OK
+ *   2: error downloading URL
+ */
+
+int
+weeurl_transfer_perform (struct t_url_transfer *transfer)
+{
+    CURLcode curl_rc;
+
+    if (!transfer || !transfer->curl)
+        return 2;
+
+    curl_rc = curl_easy_perform ((CURL *)transfer->curl);
     if (curl_rc != CURLE_OK)
     {
-        fprintf (stderr,
+        fprintf (transfer->error,
                  _("curl error %d (%s) (URL: \"%s\")\n"),
-                 curl_rc, url_error, url);
-        rc = 2;
+                 curl_rc, transfer->error_buffer, transfer->url);
+        return 2;
     }
 
-    /* cleanup */
-    curl_easy_cleanup (curl);
+    return 0;
+}
+
+/*
+ * Ends a transfer: frees curl handle and closes files (this function can be
+ * called in any thread).
+ */
+
+void
+weeurl_transfer_end (struct t_url_transfer *transfer)
+{
+    int i;
+
+    if (!transfer)
+        return;
 
-end:
+    if (transfer->curl)
+    {
+        curl_easy_cleanup ((CURL *)transfer->curl);
+        transfer->curl = NULL;
+    }
     for (i = 0; i < 2; i++)
     {
-        if (url_file[i].stream)
-            fclose (url_file[i].stream);
+        if (transfer->file[i].stream)
+        {
+            fclose (transfer->file[i].stream);
+            transfer->file[i].stream = NULL;
+        }
+    }
+    if (transfer->url)
+    {
+        free (transfer->url);
+        transfer->url = NULL;
+    }
+    if (transfer->error_buffer)
+    {
+        free (transfer->error_buffer);
+        transfer->error_buffer = NULL;
     }
+}
+
+/*
+ * Downloads URL using options (on standard output if option "file_out" is
+ * not set).
+ *
+ * Returns:
+ *   0: OK
+ *   1: invalid URL
+ *   2: error downloading URL
+ *   3: not enough memory
+ *   4: file error
+ */
+
+int
+weeurl_download (const char *url, struct t_hashtable *options)
+{
+    struct t_url_transfer transfer;
+    int rc;
+
+    rc = weeurl_transfer_init (&transfer, url, options, NULL, NULL);
+    if (rc == 0)
+        rc = weeurl_transfer_perform (&transfer);
+    weeurl_transfer_end (&transfer);
+
     return rc;
 }
 
@@ -54,8 +54,24 @@ struct t_url_file
     FILE *stream;                      /* file stream                       */
 };
 
+struct t_url_transfer
+{
+    void *curl;                        /* curl easy handle                  */
+    char *url;                         /* URL                               */
+    struct t_url_file file[2];         /* input/output files (optional)     */
+    FILE *error;                       /* stream for errors                 */
+    char *error_buffer;                /* error returned by curl            */
+    volatile int cancel;               /* 1 to abort the transfer           */
+};
+
 extern struct t_url_option url_options[];
 
+extern int weeurl_transfer_init (struct t_url_transfer *transfer,
+                                 const char *url,
+                                 struct t_hashtable *options,
+                                 FILE *output, FILE *error);
+extern int weeurl_transfer_perform (struct t_url_transfer *transfer);
+extern void weeurl_transfer_end (struct t_url_transfer *transfer);
 extern int weeurl_download (const char *url, struct t_hashtable *options);
 extern int weeurl_option_add_to_infolist (struct t_infolist *infolist,
                                           struct t_url_option *option);
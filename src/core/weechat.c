@@ -62,16 +62,19 @@
 #include "wee-debug.h"
 #include "wee-dir.h"
 #include "wee-eval.h"
+#include "wee-hashtable.h"
 #include "wee-hdata.h"
 #include "wee-hook.h"
 #include "wee-list.h"
 #include "wee-log.h"
 #include "wee-network.h"
+#include "wee-pool.h"
 #include "wee-proxy.h"
 #include "wee-secure.h"
 #include "wee-secure-config.h"
 #include "wee-signal.h"
 #include "wee-string.h"
+#include "wee-thread-pool.h"
 #include "wee-upgrade.h"
 #include "wee-utf8.h"
 #include "wee-util.h"
@@ -616,6 +619,9 @@ weechat_init (int argc, char *argv[], void (*gui_init_cb)())
             * weechat_current_start_timeval.tv_usec)
            ^ getpid ());
 
+    /* set the seed used to hash keys in hashtables */
+    hashtable_init_seed ();
+
     signal_init ();                     /* initialize signals               */
     hdata_init ();                      /* initialize hdata                 */
     hook_init ();                       /* initialize hooks                 */
@@ -686,8 +692,11 @@ weechat_end (void (*gui_end_cb)(int clean_exit))
     config_file_free_all ();            /* free all configuration files     */
     gui_key_end ();                     /* remove all keys                  */
     unhook_all ();                      /* remove all hooks                 */
+    thread_pool_end ();                 /* stop threads                     */
     hdata_end ();                       /* end hdata                        */
     secure_end ();                      /* end secured data                 */
     string_end ();                      /* end string                       */
+    hashtable_end ();                   /* free hashtables kept for reuse   */
+    pool_end ();                        /* free all pools of objects        */
     weechat_shutdown (-1, 0);           /* end other things                 */
 }
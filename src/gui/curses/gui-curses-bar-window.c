@@ -601,11 +601,10 @@ gui_bar_window_draw (struct t_gui_bar_window *bar_window,
     bar_size = CONFIG_INTEGER(bar_window->bar->options[GUI_BAR_OPTION_SIZE]);
 
     content = gui_bar_window_content_get_with_filling (bar_window, window,
-                                                       &num_spacers);
+                                                       &num_spacers,
+                                                       &length_on_screen);
     if (content)
     {
-        utf8_normalize (content, '?');
-        length_on_screen = gui_chat_strlen_screen (content);
         if ((num_spacers > 0) && gui_bar_window_can_use_spacer (bar_window))
         {
             content2 = gui_bar_window_expand_spacers (content,
@@ -549,6 +549,9 @@ gui_key_read_cb (const void *pointer, void *data, int fd)
     if (ret < 0)
         return WEECHAT_RC_OK;
 
+    /* display result of keys pressed as soon as possible */
+    gui_main_refresh_immediate = 1;
+
     for (i = 0; i < ret; i++)
     {
         if (gui_key_paste_pending && (buffer[i] == 25))
@@ -29,8 +29,10 @@
 #include <string.h>
 #include <signal.h>
 #include <time.h>
+#include <sys/time.h>
 
 #include "../../core/weechat.h"
+#include "../../core/wee-arraylist.h"
 #include "../../core/wee-command.h"
 #include "../../core/wee-config.h"
 #include "../../core/wee-hook.h"
@@ -38,6 +40,7 @@
 #include "../../core/wee-signal.h"
 #include "../../core/wee-string.h"
 #include "../../core/wee-utf8.h"
+#include "../../core/wee-util.h"
 #include "../../core/wee-version.h"
 #include "../../plugins/plugin.h"
 #include "../gui-main.h"
@@ -62,9 +65,16 @@
 
 volatile sig_atomic_t gui_signal_sigwinch_received = 0;  /* sigwinch signal */
                                        /* (terminal has been resized)       */
+
 int gui_term_cols = 0;                 /* number of columns in terminal     */
 int gui_term_lines = 0;                /* number of lines in terminal       */
 
+struct t_gui_main_stats gui_main_stats; /* main loop iterations/refreshes   */
+
+int gui_main_refresh_immediate = 0;    /* 1 to refresh screen immediately   */
+                                       /* (ignoring max refresh rate)       */
+struct timeval gui_main_refresh_last;  /* time of last screen refresh       */
+
 
 /*
  * Gets a password from user (called on startup, when GUI is not initialized).
@@ -298,18 +308,24 @@ gui_main_refreshes ()
     struct t_gui_window *ptr_win;
     struct t_gui_buffer *ptr_buffer;
     struct t_gui_bar *ptr_bar;
+    int i, refreshed;
+
+    refreshed = 0;
 
     /* refresh color buffer if needed */
     if (gui_color_buffer_refresh_needed)
     {
         gui_color_buffer_display ();
         gui_color_buffer_refresh_needed = 0;
+        refreshed = 1;
     }
 
-    /* compute max length for prefix/buffer if needed */
-    for (ptr_buffer = gui_buffers; ptr_buffer;
-         ptr_buffer = ptr_buffer->next_buffer)
+    /* compute max length for prefix/buffer if needed (buffers in queue) */
+    for (i = 0; i < arraylist_size (gui_buffers_refresh); i++)
     {
+        ptr_buffer = (struct t_gui_buffer *)arraylist_get (gui_buffers_refresh,
+                                                           i);
+
         /* compute buffer/prefix max length for own_lines */
         if (ptr_buffer->own_lines)
         {
@@ -333,6 +349,8 @@ gui_main_refreshes ()
             if (ptr_buffer->mixed_lines->prefix_max_length_refresh)
                 gui_line_compute_prefix_max_length (ptr_buffer->mixed_lines);
         }
+
+        refreshed = 1;
     }
 
     /* refresh window if needed */
@@ -340,13 +358,17 @@ gui_main_refreshes ()
     {
         gui_window_refresh_screen ((gui_window_refresh_needed > 1) ? 1 : 0);
         gui_window_refresh_needed = 0;
+        refreshed = 1;
     }
 
     /* refresh bars if needed */
     for (ptr_bar = gui_bars; ptr_bar; ptr_bar = ptr_bar->next_bar)
     {
         if (ptr_bar->bar_refresh_needed)
+        {
             gui_bar_draw (ptr_bar);
+            refreshed = 1;
+        }
     }
 
     /* refresh window if needed (if asked during refresh of bars) */
@@ -364,17 +386,21 @@ gui_main_refreshes ()
             gui_window_switch_to_buffer (ptr_win, ptr_win->buffer, 0);
             gui_chat_draw (ptr_win->buffer, 1);
             ptr_win->refresh_needed = 0;
+            refreshed = 1;
         }
     }
 
-    /* refresh chat buffers if needed */
-    for (ptr_buffer = gui_buffers; ptr_buffer;
-         ptr_buffer = ptr_buffer->next_buffer)
+    /* refresh chat buffers if needed (buffers in queue) */
+    for (i = 0; i < arraylist_size (gui_buffers_refresh); i++)
     {
+        ptr_buffer = (struct t_gui_buffer *)arraylist_get (gui_buffers_refresh,
+                                                           i);
         if (ptr_buffer->chat_refresh_needed)
         {
             gui_chat_draw (ptr_buffer,
                            (ptr_buffer->chat_refresh_needed) > 1 ? 1 : 0);
+            gui_main_stats.buffers_refreshed++;
+            refreshed = 1;
         }
     }
 
@@ -393,6 +419,82 @@ gui_main_refreshes ()
         if (gui_cursor_mode)
             gui_window_move_cursor ();
     }
+
+    /* remove buffers refreshed from queue */
+    gui_buffer_refresh_queue_update ();
+
+    if (refreshed)
+    {
+        gettimeofday (&gui_main_refresh_last, NULL);
+        gui_main_stats.refreshes++;
+    }
+}
+
+/*
+ * Checks if something must be refreshed on screen.
+ *
+ * Returns:
+ *   1: refresh needed
+ *   0: nothing to refresh
+ */
+
+int
+gui_main_refresh_is_needed ()
+{
+    struct t_gui_bar *ptr_bar;
+    struct t_gui_window *ptr_win;
+
+    if (gui_color_buffer_refresh_needed
+        || gui_window_refresh_needed
+        || (arraylist_size (gui_buffers_refresh) > 0))
+    {
+        return 1;
+    }
+
+    for (ptr_bar = gui_bars; ptr_bar; ptr_bar = ptr_bar->next_bar)
+    {
+        if (ptr_bar->bar_refresh_needed)
+            return 1;
+    }
+
+    for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
+    {
+        if (ptr_win->refresh_needed)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Returns delay (in milliseconds) before next screen refresh is allowed,
+ * according to option weechat.look.refresh_rate_max.
+ *
+ * Returns 0 if the screen can be refreshed now.
+ */
+
+int
+gui_main_refresh_delay ()
+{
+    struct timeval tv_now;
+    long long interval, elapsed;
+    int rate;
+
+    rate = CONFIG_INTEGER(config_look_refresh_rate_max);
+    if ((rate <= 0) || gui_main_refresh_immediate)
+        return 0;
+
+    if (!gui_main_refresh_is_needed ())
+        return 0;
+
+    gettimeofday (&tv_now, NULL);
+    interval = 1000000 / rate;
+    elapsed = util_timeval_diff (&gui_main_refresh_last, &tv_now);
+    if ((elapsed < 0) || (elapsed >= interval))
+        return 0;
+
+    /* round up to next millisecond, so that refresh is not too early */
+    return (int)((interval - elapsed + 999) / 1000);
 }
 
 /*
@@ -403,7 +505,7 @@ void
 gui_main_loop ()
 {
     struct t_hook *hook_fd_keyboard;
-    int send_signal_sigwinch;
+    int send_signal_sigwinch, delay;
 
     send_signal_sigwinch = 0;
 
@@ -429,6 +531,8 @@ gui_main_loop ()
 
     while (!weechat_quit)
     {
+        gui_main_stats.loops++;
+
         /* execute timer hooks */
         hook_timer_exec ();
 
@@ -439,6 +543,7 @@ gui_main_loop ()
             gui_color_pairs_auto_reset_last = time (NULL);
             gui_color_pairs_auto_reset = 0;
             gui_color_pairs_auto_reset_pending = 1;
+            gui_main_refresh_immediate = 1;
         }
 
         if (gui_signal_sigwinch_received)
@@ -446,11 +551,30 @@ gui_main_loop ()
             gui_window_ask_refresh (2);
             gui_signal_sigwinch_received = 0;
             send_signal_sigwinch = 1;
+            gui_main_refresh_immediate = 1;
         }
 
-        gui_main_refreshes ();
-        if (gui_window_refresh_needed && !gui_window_bare_display)
+        /*
+         * refresh screen, unless the last refresh is too recent: in this
+         * case all changes are coalesced and displayed on next refresh,
+         * and poll() must not wait longer than the delay
+         */
+        delay = gui_main_refresh_delay ();
+        if (delay > 0)
+        {
+            gui_main_stats.refreshes_delayed++;
+            hook_fd_timeout_max = delay;
+        }
+        else
+        {
+            if (gui_main_refresh_immediate)
+                gui_main_stats.refreshes_immediate++;
             gui_main_refreshes ();
+            if (gui_window_refresh_needed && !gui_window_bare_display)
+                gui_main_refreshes ();
+            gui_main_refresh_immediate = 0;
+            hook_fd_timeout_max = -1;
+        }
 
         if (send_signal_sigwinch)
         {
@@ -531,6 +655,7 @@ gui_main_end (int clean_exit)
         {
             gui_buffer_close (gui_buffers);
         }
+        gui_buffer_refresh_queue_free ();
 
         gui_init_ok = 0;
 
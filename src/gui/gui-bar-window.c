@@ -35,6 +35,7 @@
 #include "../core/wee-infolist.h"
 #include "../core/wee-log.h"
 #include "../core/wee-string.h"
+#include "../core/wee-utf8.h"
 #include "../plugins/plugin.h"
 #include "gui-bar-window.h"
 #include "gui-bar.h"
@@ -432,6 +433,70 @@ gui_bar_window_find_pos (struct t_gui_bar *bar, struct t_gui_window *window)
     return NULL;
 }
 
+/*
+ * Initializes layout of an item or subitem.
+ */
+
+void
+gui_bar_window_item_layout_init (struct t_gui_bar_window_item_layout *layout)
+{
+    if (!layout)
+        return;
+
+    layout->filling = -1;
+    layout->content = NULL;
+    layout->length_screen = 0;
+    layout->is_spacer = 0;
+    layout->lines_count = 0;
+    layout->lines = NULL;
+    layout->lines_length_screen = NULL;
+}
+
+/*
+ * Frees layout of an item or subitem (the layout is reinitialized, so it
+ * will be built again on next display).
+ */
+
+void
+gui_bar_window_item_layout_free (struct t_gui_bar_window_item_layout *layout)
+{
+    if (!layout)
+        return;
+
+    if (layout->content)
+        free (layout->content);
+    if (layout->lines)
+        string_free_split (layout->lines);
+    if (layout->lines_length_screen)
+        free (layout->lines_length_screen);
+
+    gui_bar_window_item_layout_init (layout);
+}
+
+/*
+ * Frees content with filling cached in a bar window (it will be built again
+ * on next display).
+ */
+
+void
+gui_bar_window_content_filling_free (struct t_gui_bar_window *bar_window)
+{
+    if (!bar_window)
+        return;
+
+    if (bar_window->content_filling)
+    {
+        free (bar_window->content_filling);
+        bar_window->content_filling = NULL;
+    }
+    bar_window->content_filling_type = -1;
+    bar_window->content_filling_position = -1;
+    bar_window->content_filling_width = 0;
+    bar_window->content_filling_height = 0;
+    bar_window->content_filling_spacers = 0;
+    bar_window->content_filling_length_screen = 0;
+}
+
 /*
  * Allocates content for a bar window.
  */
@@ -449,6 +514,9 @@ gui_bar_window_content_alloc (struct t_gui_bar_window *bar_window)
     bar_window->items_content = NULL;
     bar_window->items_num_lines = NULL;
     bar_window->items_refresh_needed = NULL;
+    bar_window->items_layout = NULL;
+    bar_window->content_filling = NULL;
+    gui_bar_window_content_filling_free (bar_window);
     bar_window->screen_col_size = 0;
     bar_window->screen_lines = 0;
     bar_window->items_subcount = calloc (1,
@@ -471,12 +539,18 @@ gui_bar_window_content_alloc (struct t_gui_bar_window *bar_window)
                                                sizeof (*bar_window->items_refresh_needed));
     if (!bar_window->items_refresh_needed)
         goto error;
+    bar_window->items_layout = calloc (1,
+                                       bar_window->items_count *
+                                       sizeof (*bar_window->items_layout));
+    if (!bar_window->items_layout)
+        goto error;
 
     for (i = 0; i < bar_window->items_count; i++)
     {
         bar_window->items_content[i] = NULL;
         bar_window->items_num_lines[i] = NULL;
         bar_window->items_refresh_needed[i] = NULL;
+        bar_window->items_layout[i] = NULL;
     }
 
     for (i = 0; i < bar_window->items_count; i++)
@@ -494,6 +568,10 @@ gui_bar_window_content_alloc (struct t_gui_bar_window *bar_window)
                                                       sizeof (**bar_window->items_refresh_needed));
         if (!bar_window->items_refresh_needed[i])
             goto error;
+        bar_window->items_layout[i] = malloc (bar_window->items_subcount[i] *
+                                              sizeof (**bar_window->items_layout));
+        if (!bar_window->items_layout[i])
+            goto error;
         for (j = 0; j < bar_window->items_subcount[i]; j++)
         {
             if (bar_window->items_content[i])
@@ -502,6 +580,8 @@ gui_bar_window_content_alloc (struct t_gui_bar_window *bar_window)
                 bar_window->items_num_lines[i][j] = 0;
             if (bar_window->items_refresh_needed[i])
                 bar_window->items_refresh_needed[i][j] = 1;
+            if (bar_window->items_layout[i])
+                gui_bar_window_item_layout_init (&bar_window->items_layout[i][j]);
         }
     }
     return;
@@ -542,6 +622,16 @@ error:
         free (bar_window->items_refresh_needed);
         bar_window->items_refresh_needed = NULL;
     }
+    if (bar_window->items_layout)
+    {
+        for (i = 0; i < bar_window->items_count; i++)
+        {
+            if (bar_window->items_layout[i])
+                free (bar_window->items_layout[i]);
+        }
+        free (bar_window->items_layout);
+        bar_window->items_layout = NULL;
+    }
 }
 
 /*
@@ -567,10 +657,14 @@ gui_bar_window_content_free (struct t_gui_bar_window *bar_window)
                 {
                     free (bar_window->items_content[i][j]);
                 }
+                if (bar_window->items_layout && bar_window->items_layout[i])
+                    gui_bar_window_item_layout_free (&bar_window->items_layout[i][j]);
             }
             free (bar_window->items_content[i]);
             free (bar_window->items_num_lines[i]);
             free (bar_window->items_refresh_needed[i]);
+            if (bar_window->items_layout)
+                free (bar_window->items_layout[i]);
         }
         free (bar_window->items_subcount);
         bar_window->items_subcount = NULL;
@@ -580,7 +674,14 @@ gui_bar_window_content_free (struct t_gui_bar_window *bar_window)
         bar_window->items_num_lines = NULL;
         free (bar_window->items_refresh_needed);
         bar_window->items_refresh_needed = NULL;
+        if (bar_window->items_layout)
+        {
+            free (bar_window->items_layout);
+            bar_window->items_layout = NULL;
+        }
     }
+
+    gui_bar_window_content_filling_free (bar_window);
 }
 
 /*
@@ -603,6 +704,11 @@ gui_bar_window_content_build_item (struct t_gui_bar_window *bar_window,
             bar_window->items_content[index_item][index_subitem] = NULL;
         }
         bar_window->items_num_lines[index_item][index_subitem] = 0;
+        if (bar_window->items_layout)
+        {
+            gui_bar_window_item_layout_free (
+                &bar_window->items_layout[index_item][index_subitem]);
+        }
 
         /* build item, but only if there's a buffer in window */
         if ((window && window->buffer)
@@ -685,12 +791,130 @@ gui_bar_window_item_is_spacer (const char *item)
             && !item[3]);
 }
 
+/*
+ * Builds layout of an item or subitem for a filling: content formatted for
+ * display (with invalid UTF-8 chars replaced), its length on screen and
+ * lines (for filling with columns).
+ *
+ * The layout does not depend on the bar window size, so it is built only
+ * when the item content or the bar filling changes.
+ */
+
+void
+gui_bar_window_item_layout_build (struct t_gui_bar_window *bar_window,
+                                  int index_item, int index_subitem,
+                                  enum t_gui_bar_filling filling)
+{
+    struct t_gui_bar_window_item_layout *ptr_layout;
+    const char *ptr_content;
+    char str_reinit_color_space_start_line[32];
+    char *item_value, *item_value2;
+    int i;
+
+    ptr_layout = &bar_window->items_layout[index_item][index_subitem];
+
+    gui_bar_window_item_layout_free (ptr_layout);
+    ptr_layout->filling = filling;
+
+    ptr_content = bar_window->items_content[index_item][index_subitem];
+    if (!ptr_content || !ptr_content[0])
+        return;
+
+    item_value = NULL;
+    if ((filling == GUI_BAR_FILLING_HORIZONTAL)
+        && (strchr (ptr_content, '\n') || strchr (ptr_content, '\r')))
+    {
+        snprintf (str_reinit_color_space_start_line,
+                  sizeof (str_reinit_color_space_start_line),
+                  "%c %c%c%c",
+                  GUI_COLOR_RESET_CHAR,
+                  GUI_COLOR_COLOR_CHAR,
+                  GUI_COLOR_BAR_CHAR,
+                  GUI_COLOR_BAR_START_LINE_ITEM);
+        item_value = string_replace (ptr_content, "\n",
+                                     str_reinit_color_space_start_line);
+        if (item_value)
+        {
+            item_value2 = string_replace (item_value, "\r", "\n");
+            if (item_value2)
+            {
+                free (item_value);
+                item_value = item_value2;
+            }
+        }
+    }
+    if (!item_value && !utf8_is_valid (ptr_content, -1, NULL))
+        item_value = strdup (ptr_content);
+    if (item_value)
+    {
+        utf8_normalize (item_value, '?');
+        ptr_content = item_value;
+    }
+
+    switch (filling)
+    {
+        case GUI_BAR_FILLING_HORIZONTAL:
+        case GUI_BAR_FILLING_VERTICAL:
+            ptr_layout->content = item_value;
+            ptr_layout->is_spacer = gui_bar_window_item_is_spacer (ptr_content);
+            ptr_layout->length_screen = gui_chat_strlen_screen (ptr_content);
+            break;
+        case GUI_BAR_FILLING_COLUMNS_HORIZONTAL:
+        case GUI_BAR_FILLING_COLUMNS_VERTICAL:
+            ptr_layout->lines = string_split (
+                ptr_content,
+                "\n",
+                NULL,
+                WEECHAT_STRING_SPLIT_STRIP_LEFT
+                | WEECHAT_STRING_SPLIT_STRIP_RIGHT
+                | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
+                0,
+                &ptr_layout->lines_count);
+            if (ptr_layout->lines && (ptr_layout->lines_count > 0))
+            {
+                ptr_layout->lines_length_screen = malloc (
+                    ptr_layout->lines_count *
+                    sizeof (*ptr_layout->lines_length_screen));
+            }
+            if (ptr_layout->lines_length_screen)
+            {
+                for (i = 0; i < ptr_layout->lines_count; i++)
+                {
+                    ptr_layout->lines_length_screen[i] =
+                        gui_chat_strlen_screen (ptr_layout->lines[i]);
+                }
+            }
+            else
+            {
+                if (ptr_layout->lines)
+                {
+                    string_free_split (ptr_layout->lines);
+                    ptr_layout->lines = NULL;
+                }
+                ptr_layout->lines_count = 0;
+            }
+            if (item_value)
+                free (item_value);
+            break;
+        case GUI_BAR_NUM_FILLING:
+            if (item_value)
+                free (item_value);
+            break;
+    }
+}
+
 /*
  * Gets content of a bar window, formatted for display, according to filling
  * for bar position.
  *
+ * Only items with a refresh needed are built again; layout of other items
+ * (which does not depend on bar window size) is reused, and the whole
+ * content is cached until an item changes (or the bar window size changes,
+ * for filling with columns).
+ *
  * The integer variable *num_spacers is set with the number of spacers found
- * (bar item "spacer").
+ * (bar item "spacer") and *length_on_screen with the length of content on
+ * screen.
  *
  * Note: result must be freed after use.
  */
@@ -698,30 +922,64 @@ gui_bar_window_item_is_spacer (const char *item)
 char *
 gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
                                          struct t_gui_window *window,
-                                         int *num_spacers)
+                                         int *num_spacers,
+                                         int *length_on_screen)
 {
     enum t_gui_bar_filling filling;
+    struct t_gui_bar_window_item_layout *ptr_layout;
     const char *ptr_content;
-    char **content, *content2, str_reinit_color[32];
-    char str_reinit_color_space[32], str_reinit_color_space_start_line[32];
-    char str_start_item[32];
-    char *item_value, *item_value2, ****split_items, **linear_items;
-    int i, j, k, sub, index;
+    char **content, str_reinit_color[32], str_reinit_color_space[32];
+    char str_start_item[32], **linear_items;
+    int i, j, k, sub, index, position;
     int at_least_one_item, first_sub_item;
     int length_reinit_color, length_reinit_color_space, length_start_item;
-    int length, max_length, max_length_screen;
+    int length, max_length_screen, length_screen;
     int total_items, columns, lines;
-    int item_is_spacer;
+    int *linear_items_length;
 
     *num_spacers = 0;
+    *length_on_screen = 0;
 
     if (!bar_window
         || !bar_window->items_subcount || !bar_window->items_content
-        || !bar_window->items_num_lines || !bar_window->items_refresh_needed)
+        || !bar_window->items_num_lines || !bar_window->items_refresh_needed
+        || !bar_window->items_layout)
     {
         return NULL;
     }
 
+    filling = gui_bar_get_filling (bar_window->bar);
+    position = CONFIG_INTEGER(bar_window->bar->options[GUI_BAR_OPTION_POSITION]);
+
+    /* build items which have changed (and their layout) */
+    for (i = 0; i < bar_window->items_count; i++)
+    {
+        for (sub = 0; sub < bar_window->items_subcount[i]; sub++)
+        {
+            if (bar_window->items_refresh_needed[i][sub]
+                || (bar_window->items_layout[i][sub].filling != (int)filling))
+            {
+                gui_bar_window_content_get (bar_window, window, i, sub);
+                gui_bar_window_item_layout_build (bar_window, i, sub, filling);
+                gui_bar_window_content_filling_free (bar_window);
+            }
+        }
+    }
+
+    /* return cached content if it is still valid */
+    if ((bar_window->content_filling_type == (int)filling)
+        && (bar_window->content_filling_position == position)
+        && (((filling != GUI_BAR_FILLING_COLUMNS_HORIZONTAL)
+             && (filling != GUI_BAR_FILLING_COLUMNS_VERTICAL))
+            || ((bar_window->content_filling_width == bar_window->width)
+                && (bar_window->content_filling_height == bar_window->height))))
+    {
+        *num_spacers = bar_window->content_filling_spacers;
+        *length_on_screen = bar_window->content_filling_length_screen;
+        return (bar_window->content_filling) ?
+            strdup (bar_window->content_filling) : NULL;
+    }
+
     snprintf (str_reinit_color, sizeof (str_reinit_color),
               "%c",
               GUI_COLOR_RESET_CHAR);
@@ -732,14 +990,6 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
               GUI_COLOR_RESET_CHAR);
     length_reinit_color_space = strlen (str_reinit_color_space);
 
-    snprintf (str_reinit_color_space_start_line,
-              sizeof (str_reinit_color_space_start_line),
-              "%c %c%c%c",
-              GUI_COLOR_RESET_CHAR,
-              GUI_COLOR_COLOR_CHAR,
-              GUI_COLOR_BAR_CHAR,
-              GUI_COLOR_BAR_START_LINE_ITEM);
-
     snprintf (str_start_item, sizeof (str_start_item),
               "%c%c%c",
               GUI_COLOR_COLOR_CHAR,
@@ -748,7 +998,7 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
     length_start_item = strlen (str_start_item);
 
     content = string_dyn_alloc (256);
-    filling = gui_bar_get_filling (bar_window->bar);
+    length_screen = 0;
     at_least_one_item = 0;
     switch (filling)
     {
@@ -759,33 +1009,13 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
                 first_sub_item = 1;
                 for (sub = 0; sub < bar_window->items_subcount[i]; sub++)
                 {
-                    ptr_content = gui_bar_window_content_get (bar_window, window,
-                                                              i, sub);
+                    ptr_layout = &bar_window->items_layout[i][sub];
+                    ptr_content = (ptr_layout->content) ?
+                        ptr_layout->content : bar_window->items_content[i][sub];
                     if (ptr_content && ptr_content[0])
                     {
-                        if (filling == GUI_BAR_FILLING_HORIZONTAL)
-                        {
-                            item_value = string_replace (ptr_content, "\n",
-                                                         str_reinit_color_space_start_line);
-                            if (item_value)
-                            {
-                                item_value2 = string_replace (item_value,
-                                                              "\r", "\n");
-                                if (item_value2)
-                                {
-                                    free (item_value);
-                                    item_value = item_value2;
-                                }
-                            }
-                        }
-                        else
-                        {
-                            item_value = NULL;
-                        }
-                        item_is_spacer = gui_bar_window_item_is_spacer (
-                            (item_value) ? item_value : ptr_content);
                         if (at_least_one_item && first_sub_item
-                            && !item_is_spacer)
+                            && !ptr_layout->is_spacer)
                         {
                             /* first sub item: insert space after last item */
                             if (filling == GUI_BAR_FILLING_HORIZONTAL)
@@ -798,6 +1028,7 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
                             {
                                 string_dyn_concat (content, "\n", -1);
                             }
+                            length_screen++;
                         }
                         else
                         {
@@ -809,14 +1040,10 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
                             string_dyn_concat (content, str_start_item,
                                                length_start_item);
                         }
-                        string_dyn_concat (
-                            content,
-                            (item_value) ? item_value : ptr_content,
-                            -1);
+                        string_dyn_concat (content, ptr_content, -1);
+                        length_screen += ptr_layout->length_screen;
                         first_sub_item = 0;
-                        if (item_value)
-                            free (item_value);
-                        if (item_is_spacer)
+                        if (ptr_layout->is_spacer)
                             (*num_spacers)++;
                         else
                             at_least_one_item = 1;
@@ -837,51 +1064,22 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
         case GUI_BAR_FILLING_COLUMNS_HORIZONTAL: /* items in columns, with horizontal filling */
         case GUI_BAR_FILLING_COLUMNS_VERTICAL:   /* items in columns, with vertical filling */
             total_items = 0;
-            max_length = 1;
             max_length_screen = 1;
-            split_items = malloc (bar_window->items_count * sizeof (*split_items));
             for (i = 0; i < bar_window->items_count; i++)
             {
-                if (bar_window->items_subcount[i] > 0)
+                for (sub = 0; sub < bar_window->items_subcount[i]; sub++)
                 {
-                    split_items[i] = malloc (bar_window->items_subcount[i] * sizeof (**split_items));
-                    for (sub = 0; sub < bar_window->items_subcount[i]; sub++)
+                    ptr_layout = &bar_window->items_layout[i][sub];
+                    total_items += ptr_layout->lines_count;
+                    for (j = 0; j < ptr_layout->lines_count; j++)
                     {
-                        ptr_content = gui_bar_window_content_get (bar_window, window,
-                                                                  i, sub);
-                        if (ptr_content && ptr_content[0])
-                        {
-                            split_items[i][sub] = string_split (
-                                ptr_content,
-                                "\n",
-                                NULL,
-                                WEECHAT_STRING_SPLIT_STRIP_LEFT
-                                | WEECHAT_STRING_SPLIT_STRIP_RIGHT
-                                | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
-                                0,
-                                NULL);
-                            for (j = 0; split_items[i][sub][j]; j++)
-                            {
-                                total_items++;
-
-                                length = strlen (split_items[i][sub][j]);
-                                if (length > max_length)
-                                    max_length = length;
-
-                                length = gui_chat_strlen_screen (split_items[i][sub][j]);
-                                if (length > max_length_screen)
-                                    max_length_screen = length;
-                            }
-                        }
-                        else
-                            split_items[i][sub] = NULL;
+                        if (ptr_layout->lines_length_screen[j] > max_length_screen)
+                            max_length_screen = ptr_layout->lines_length_screen[j];
                     }
                 }
-                else
-                    split_items[i] = NULL;
             }
-            if ((CONFIG_INTEGER(bar_window->bar->options[GUI_BAR_OPTION_POSITION]) == GUI_BAR_POSITION_BOTTOM)
-                || (CONFIG_INTEGER(bar_window->bar->options[GUI_BAR_OPTION_POSITION]) == GUI_BAR_POSITION_TOP))
+            if ((position == GUI_BAR_POSITION_BOTTOM)
+                || (position == GUI_BAR_POSITION_TOP))
             {
                 columns = bar_window->width / (max_length_screen + 1);
                 if (columns == 0)
@@ -900,26 +1098,26 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
             bar_window->screen_col_size = max_length_screen + 1;
             bar_window->screen_lines = lines;
 
-            /* build array with pointers to split items */
+            /* build arrays with pointers to lines of items and their length */
 
             linear_items = (total_items > 0) ?
                 malloc (total_items * sizeof (*linear_items)) : NULL;
-            if (linear_items)
+            linear_items_length = (total_items > 0) ?
+                malloc (total_items * sizeof (*linear_items_length)) : NULL;
+            if (linear_items && linear_items_length)
             {
                 index = 0;
                 for (i = 0; i < bar_window->items_count; i++)
                 {
-                    if (split_items[i])
+                    for (sub = 0; sub < bar_window->items_subcount[i]; sub++)
                     {
-                        for (sub = 0; sub < bar_window->items_subcount[i]; sub++)
+                        ptr_layout = &bar_window->items_layout[i][sub];
+                        for (j = 0; j < ptr_layout->lines_count; j++)
                         {
-                            if (split_items[i][sub])
-                            {
-                                for (j = 0; split_items[i][sub][j]; j++)
-                                {
-                                    linear_items[index++] = split_items[i][sub][j];
-                                }
-                            }
+                            linear_items[index] = ptr_layout->lines[j];
+                            linear_items_length[index] =
+                                ptr_layout->lines_length_screen[j];
+                            index++;
                         }
                     }
                 }
@@ -945,52 +1143,54 @@ gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
                         {
                             string_dyn_concat (content, linear_items[index], -1);
                             length = max_length_screen -
-                                gui_chat_strlen_screen (linear_items[index]);
+                                linear_items_length[index];
                             for (k = 0; k < length; k++)
                             {
                                 string_dyn_concat (content, " ", -1);
                             }
                         }
+                        length_screen += max_length_screen;
                         if (j < columns - 1)
                         {
                             string_dyn_concat (content, str_reinit_color_space,
                                                length_reinit_color_space);
+                            length_screen++;
                         }
                     }
                     string_dyn_concat (content, "\n", -1);
+                    length_screen++;
                 }
-
-                free (linear_items);
             }
-
-            for (i = 0; i < bar_window->items_count; i++)
-            {
-                if (split_items[i])
-                {
-                    for (sub = 0; sub < bar_window->items_subcount[i]; sub++)
-                    {
-                        if (split_items[i][sub])
-                            string_free_split (split_items[i][sub]);
-                    }
-                    free (split_items[i]);
-                }
-            }
-            free (split_items);
+            if (linear_items)
+                free (linear_items);
+            if (linear_items_length)
+                free (linear_items_length);
             break;
         case GUI_BAR_NUM_FILLING:
             break;
     }
 
+    /* save content in cache */
+    bar_window->content_filling_type = filling;
+    bar_window->content_filling_position = position;
+    bar_window->content_filling_width = bar_window->width;
+    bar_window->content_filling_height = bar_window->height;
+    bar_window->content_filling_spacers = *num_spacers;
+    bar_window->content_filling_length_screen = length_screen;
+
     if (!*content[0])
     {
         string_dyn_free (content, 1);
+        bar_window->content_filling_length_screen = 0;
         return NULL;
     }
 
-    content2 = *content;
+    *length_on_screen = length_screen;
+
+    bar_window->content_filling = *content;
     string_dyn_free (content, 0);
 
-    return content2;
+    return strdup (bar_window->content_filling);
 }
 
 /*
@@ -1233,6 +1433,14 @@ gui_bar_window_new (struct t_gui_bar *bar, struct t_gui_window *window)
         new_bar_window->items_content = NULL;
         new_bar_window->items_num_lines = NULL;
         new_bar_window->items_refresh_needed = NULL;
+        new_bar_window->items_layout = NULL;
+        new_bar_window->content_filling = NULL;
+        new_bar_window->content_filling_type = -1;
+        new_bar_window->content_filling_position = -1;
+        new_bar_window->content_filling_width = 0;
+        new_bar_window->content_filling_height = 0;
+        new_bar_window->content_filling_spacers = 0;
+        new_bar_window->content_filling_length_screen = 0;
         new_bar_window->screen_col_size = 0;
         new_bar_window->screen_lines = 0;
         new_bar_window->coords_count = 0;
@@ -1793,6 +2001,19 @@ gui_bar_window_print_log (struct t_gui_bar_window *bar_window)
                             bar_window->bar->items_array[i][j] : "?",
                             bar_window->items_num_lines[i][j],
                             bar_window->items_refresh_needed[i][j]);
+                if (bar_window->items_layout)
+                {
+                    log_printf ("    items_layout[%03d][%03d]: "
+                                "filling: %d, content: 0x%lx, "
+                                "length_screen: %d, is_spacer: %d, "
+                                "lines_count: %d",
+                                i, j,
+                                bar_window->items_layout[i][j].filling,
+                                bar_window->items_layout[i][j].content,
+                                bar_window->items_layout[i][j].length_screen,
+                                bar_window->items_layout[i][j].is_spacer,
+                                bar_window->items_layout[i][j].lines_count);
+                }
             }
         }
         else
@@ -1800,6 +2021,14 @@ gui_bar_window_print_log (struct t_gui_bar_window *bar_window)
             log_printf ("    items_content. . . . . . : 0x%lx", bar_window->items_content);
         }
     }
+    log_printf ("    content_filling. . . . : '%s'", bar_window->content_filling);
+    log_printf ("    content_filling_type . : %d", bar_window->content_filling_type);
+    log_printf ("    content_filling_position: %d", bar_window->content_filling_position);
+    log_printf ("    content_filling_width. : %d", bar_window->content_filling_width);
+    log_printf ("    content_filling_height : %d", bar_window->content_filling_height);
+    log_printf ("    content_filling_spacers: %d", bar_window->content_filling_spacers);
+    log_printf ("    content_filling_length_screen: %d",
+                bar_window->content_filling_length_screen);
     log_printf ("    screen_col_size. . . . : %d", bar_window->screen_col_size);
     log_printf ("    screen_lines . . . . . : %d", bar_window->screen_lines);
     log_printf ("    coords_count . . . . . : %d", bar_window->coords_count);
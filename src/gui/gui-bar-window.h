@@ -35,6 +35,19 @@ struct t_gui_bar_window_coords
     int y;                          /* Y on screen                          */
 };
 
+struct t_gui_bar_window_item_layout
+{
+    int filling;                    /* filling used to build layout         */
+                                    /* (-1 if layout is not built)          */
+    char *content;                  /* content for display (NULL if same as */
+                                    /* item content)                        */
+    int length_screen;              /* length of content on screen          */
+    int is_spacer;                  /* 1 if item is a spacer                */
+    int lines_count;                /* number of lines (filling columns)    */
+    char **lines;                   /* lines (filling columns)              */
+    int *lines_length_screen;       /* length of lines on screen            */
+};
+
 struct t_gui_bar_window
 {
     struct t_gui_bar *bar;          /* pointer to bar                       */
@@ -49,6 +62,16 @@ struct t_gui_bar_window
     char ***items_content;          /* content for each (sub)item of bar    */
     int **items_num_lines;          /* number of lines for each (sub)item   */
     int **items_refresh_needed;     /* refresh needed for (sub)item?        */
+    struct t_gui_bar_window_item_layout **items_layout; /* layout of each   */
+                                    /* (sub)item (independent of bar size)  */
+    char *content_filling;          /* content with filling (cache)         */
+    int content_filling_type;       /* filling used for content (cache),    */
+                                    /* -1 if cache is not valid             */
+    int content_filling_position;   /* bar position used for content        */
+    int content_filling_width;      /* width used for content (columns)     */
+    int content_filling_height;     /* height used for content (columns)    */
+    int content_filling_spacers;    /* number of spacers in content         */
+    int content_filling_length_screen; /* length of content on screen       */
     int screen_col_size;            /* size of columns on screen            */
                                     /* (for filling with columns)           */
     int screen_lines;               /* number of lines on screen            */
@@ -78,7 +101,8 @@ extern void gui_bar_window_content_build (struct t_gui_bar_window *bar_window,
                                           struct t_gui_window *window);
 extern char *gui_bar_window_content_get_with_filling (struct t_gui_bar_window *bar_window,
                                                       struct t_gui_window *window,
-                                                      int *num_spacers);
+                                                      int *num_spacers,
+                                                      int *length_on_screen);
 extern int gui_bar_window_can_use_spacer (struct t_gui_bar_window *bar_window);
 extern int *gui_bar_window_compute_spacers_size (int length_on_screen,
                                                  int bar_window_width,
@@ -35,6 +35,7 @@
 #include <ctype.h>
 
 #include "../core/weechat.h"
+#include "../core/wee-arraylist.h"
 #include "../core/wee-config.h"
 #include "../core/wee-hashtable.h"
 #include "../core/wee-hdata.h"
@@ -74,6 +75,9 @@ int gui_buffers_visited_count = 0;              /* number of visited buffers*/
 int gui_buffers_visited_frozen = 0;             /* 1 to forbid list updates */
 struct t_gui_buffer *gui_buffer_last_displayed = NULL; /* last b. displayed */
 
+/* buffers with a refresh asked (chat or max length of prefix/buffer) */
+struct t_arraylist *gui_buffers_refresh = NULL;
+
 char *gui_buffer_reserved_names[] =
 { GUI_BUFFER_MAIN, SECURE_BUFFER_NAME, GUI_COLOR_BUFFER_NAME,
   NULL
@@ -608,6 +612,8 @@ gui_buffer_input_buffer_init (struct t_gui_buffer *buffer)
     buffer->input_buffer_length = 0;
     buffer->input_buffer_pos = 0;
     buffer->input_buffer_1st_display = 0;
+    buffer->input_buffer_cache_pos = 0;
+    buffer->input_buffer_cache_offset = 0;
 }
 
 /*
@@ -745,6 +751,8 @@ gui_buffer_new_props (struct t_weechat_plugin *plugin,
     new_buffer->next_line_id = 0;
     new_buffer->time_for_each_line = 1;
     new_buffer->chat_refresh_needed = 2;
+    new_buffer->refresh_queued = 0;
+    gui_buffer_refresh_queue_add (new_buffer);
 
     /* nicklist */
     new_buffer->nicklist = 0;
@@ -777,6 +785,9 @@ gui_buffer_new_props (struct t_weechat_plugin *plugin,
     new_buffer->input_undo_snap = malloc (sizeof (*(new_buffer->input_undo_snap)));
     (new_buffer->input_undo_snap)->data = NULL;
     (new_buffer->input_undo_snap)->pos = 0;
+    (new_buffer->input_undo_snap)->diff_offset = 0; /* not used */
+    (new_buffer->input_undo_snap)->diff_size_next = 0; /* not used */
+    (new_buffer->input_undo_snap)->diff_text = NULL; /* not used */
     (new_buffer->input_undo_snap)->prev_undo = NULL; /* not used */
     (new_buffer->input_undo_snap)->next_undo = NULL; /* not used */
     new_buffer->input_undo = NULL;
@@ -792,6 +803,7 @@ gui_buffer_new_props (struct t_weechat_plugin *plugin,
     new_buffer->last_history = NULL;
     new_buffer->ptr_history = NULL;
     new_buffer->num_history = 0;
+    new_buffer->history_size = 0;
 
     /* text search */
     new_buffer->text_search = GUI_TEXT_SEARCH_DISABLED;
@@ -1396,6 +1408,117 @@ gui_buffer_get_pointer (struct t_gui_buffer *buffer, const char *property)
     return NULL;
 }
 
+/*
+ * Adds a buffer in refresh queue (if not already in queue): only buffers in
+ * this queue are checked by the refresh of screen.
+ *
+ * This function must be called after a refresh is asked for the buffer
+ * (flag "chat_refresh_needed" or refresh of prefix/buffer max length in its
+ * lines).
+ */
+
+void
+gui_buffer_refresh_queue_add (struct t_gui_buffer *buffer)
+{
+    if (!buffer || buffer->refresh_queued)
+        return;
+
+    if (!gui_buffers_refresh)
+    {
+        gui_buffers_refresh = arraylist_new (32, 0, 1,
+                                             NULL, NULL, NULL, NULL);
+        if (!gui_buffers_refresh)
+            return;
+    }
+
+    if (arraylist_add (gui_buffers_refresh, buffer) >= 0)
+        buffer->refresh_queued = 1;
+}
+
+/*
+ * Removes a buffer from refresh queue.
+ */
+
+void
+gui_buffer_refresh_queue_remove (struct t_gui_buffer *buffer)
+{
+    int i;
+
+    if (!buffer || !buffer->refresh_queued || !gui_buffers_refresh)
+        return;
+
+    for (i = arraylist_size (gui_buffers_refresh) - 1; i >= 0; i--)
+    {
+        if (arraylist_get (gui_buffers_refresh, i) == buffer)
+        {
+            arraylist_remove (gui_buffers_refresh, i);
+            break;
+        }
+    }
+    buffer->refresh_queued = 0;
+}
+
+/*
+ * Checks if a refresh is still needed for a buffer.
+ *
+ * Returns:
+ *   1: refresh needed
+ *   0: no refresh needed
+ */
+
+int
+gui_buffer_refresh_is_needed (struct t_gui_buffer *buffer)
+{
+    return (buffer->chat_refresh_needed
+            || (buffer->own_lines
+                && (buffer->own_lines->buffer_max_length_refresh
+                    || buffer->own_lines->prefix_max_length_refresh))
+            || (buffer->mixed_lines
+                && (buffer->mixed_lines->buffer_max_length_refresh
+                    || buffer->mixed_lines->prefix_max_length_refresh))) ?
+        1 : 0;
+}
+
+/*
+ * Removes from refresh queue the buffers which do not need a refresh any
+ * more (called after the refresh of screen).
+ */
+
+void
+gui_buffer_refresh_queue_update ()
+{
+    struct t_gui_buffer *ptr_buffer;
+    int i;
+
+    if (!gui_buffers_refresh)
+        return;
+
+    for (i = arraylist_size (gui_buffers_refresh) - 1; i >= 0; i--)
+    {
+        ptr_buffer = (struct t_gui_buffer *)arraylist_get (gui_buffers_refresh,
+                                                           i);
+        if (!gui_buffer_refresh_is_needed (ptr_buffer))
+        {
+            ptr_buffer->refresh_queued = 0;
+            arraylist_remove (gui_buffers_refresh, i);
+        }
+    }
+}
+
+/*
+ * Frees refresh queue.
+ */
+
+void
+gui_buffer_refresh_queue_free ()
+{
+    if (gui_buffers_refresh)
+    {
+        arraylist_free (gui_buffers_refresh);
+        gui_buffers_refresh = NULL;
+    }
+}
+
 /*
  * Sets flag "chat_refresh_needed".
  */
@@ -1408,6 +1531,8 @@ gui_buffer_ask_chat_refresh (struct t_gui_buffer *buffer, int refresh)
 
     if (refresh > buffer->chat_refresh_needed)
         buffer->chat_refresh_needed = refresh;
+    if (buffer->chat_refresh_needed)
+        gui_buffer_refresh_queue_add (buffer);
 }
 
 /*
@@ -3178,6 +3303,8 @@ gui_buffer_close (struct t_gui_buffer *buffer)
     if (gui_buffer_last_displayed == buffer)
         gui_buffer_last_displayed = NULL;
 
+    gui_buffer_refresh_queue_remove (buffer);
+
     if (gui_buffers_count > 0)
         gui_buffers_count--;
 
@@ -3910,6 +4037,7 @@ gui_buffer_unmerge (struct t_gui_buffer *buffer, int number)
     {
         ptr_new_active_buffer->mixed_lines->prefix_max_length_refresh = 1;
         ptr_new_active_buffer->mixed_lines->buffer_max_length_refresh = 1;
+        gui_buffer_refresh_queue_add (ptr_new_active_buffer);
     }
 
     gui_window_ask_refresh (1);
@@ -4110,6 +4238,120 @@ gui_buffer_undo_snap_free (struct t_gui_buffer *buffer)
     (buffer->input_undo_snap)->pos = 0;
 }
 
+/*
+ * Sets diff of an undo with the next undo, which has content "data_next":
+ * the content of undo is given in "data", it is replaced by the diff.
+ *
+ * Argument "data" is freed by this function.
+ */
+
+void
+gui_buffer_undo_set_diff (struct t_gui_input_undo *undo, char *data,
+                          const char *data_next)
+{
+    int size, size_next, prefix, suffix;
+    char *diff_text;
+
+    size = strlen (data);
+    size_next = strlen (data_next);
+
+    /* skip common bytes at beginning and at end */
+    prefix = 0;
+    while ((prefix < size) && (prefix < size_next)
+           && (data[prefix] == data_next[prefix]))
+    {
+        prefix++;
+    }
+    suffix = 0;
+    while ((suffix < size - prefix) && (suffix < size_next - prefix)
+           && (data[size - suffix - 1] == data_next[size_next - suffix - 1]))
+    {
+        suffix++;
+    }
+
+    undo->diff_offset = prefix;
+    undo->diff_size_next = size_next - prefix - suffix;
+    if (size - prefix - suffix > 0)
+    {
+        memmove (data, data + prefix, size - prefix - suffix);
+        data[size - prefix - suffix] = '\0';
+        diff_text = realloc (data, size - prefix - suffix + 1);
+        undo->diff_text = (diff_text) ? diff_text : data;
+    }
+    else
+    {
+        undo->diff_text = NULL;
+        free (data);
+    }
+}
+
+/*
+ * Applies diff of an undo on content of next undo ("data", allocated
+ * string): returns content of undo (reallocated "data"), NULL if error
+ * ("data" is freed in this case).
+ */
+
+char *
+gui_buffer_undo_apply_diff (struct t_gui_input_undo *undo, char *data)
+{
+    int size, size_diff, size_tail;
+    char *new_data;
+
+    size = strlen (data);
+    size_diff = (undo->diff_text) ? strlen (undo->diff_text) : 0;
+    size_tail = size - undo->diff_offset - undo->diff_size_next;
+
+    if (size_diff > undo->diff_size_next)
+    {
+        new_data = realloc (data,
+                            size - undo->diff_size_next + size_diff + 1);
+        if (!new_data)
+        {
+            free (data);
+            return NULL;
+        }
+        data = new_data;
+    }
+    memmove (data + undo->diff_offset + size_diff,
+             data + undo->diff_offset + undo->diff_size_next,
+             size_tail + 1);
+    if (size_diff > 0)
+        memcpy (data + undo->diff_offset, undo->diff_text, size_diff);
+
+    return data;
+}
+
+/*
+ * Returns content of input for an undo (built from the last undo, by
+ * applying diffs of undos from the end of list).
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+gui_buffer_undo_get_data (struct t_gui_buffer *buffer,
+                          struct t_gui_input_undo *undo)
+{
+    struct t_gui_input_undo *ptr_undo;
+    char *data;
+
+    if (!buffer || !undo || !buffer->last_input_undo
+        || !(buffer->last_input_undo)->data)
+    {
+        return NULL;
+    }
+
+    data = strdup ((buffer->last_input_undo)->data);
+    for (ptr_undo = (buffer->last_input_undo)->prev_undo;
+         data && ptr_undo && (ptr_undo != undo->prev_undo);
+         ptr_undo = ptr_undo->prev_undo)
+    {
+        data = gui_buffer_undo_apply_diff (ptr_undo, data);
+    }
+
+    return data;
+}
+
 /*
  * Adds undo in list, with current input buffer + position.
  *
@@ -4147,12 +4389,12 @@ gui_buffer_undo_add (struct t_gui_buffer *buffer)
         gui_buffer_undo_free (buffer, buffer->input_undo);
     }
 
-    /* remove all undos after current undo */
+    /* remove all undos after current undo (starting from the end) */
     if (buffer->ptr_input_undo)
     {
         while (buffer->ptr_input_undo->next_undo)
         {
-            gui_buffer_undo_free (buffer, buffer->ptr_input_undo->next_undo);
+            gui_buffer_undo_free (buffer, buffer->last_input_undo);
         }
     }
 
@@ -4171,15 +4413,34 @@ gui_buffer_undo_add (struct t_gui_buffer *buffer)
 
     if ((buffer->input_undo_snap)->data)
     {
-        new_undo->data = strdup ((buffer->input_undo_snap)->data);
+        /* use content of snapshot (no copy needed) */
+        new_undo->data = (buffer->input_undo_snap)->data;
+        (buffer->input_undo_snap)->data = NULL;
         new_undo->pos = (buffer->input_undo_snap)->pos;
     }
     else
     {
-        new_undo->data = (buffer->input_buffer) ?
-            strdup (buffer->input_buffer) : NULL;
+        new_undo->data = strdup ((buffer->input_buffer) ?
+                                 buffer->input_buffer : "");
         new_undo->pos = buffer->input_buffer_pos;
     }
+    if (!new_undo->data)
+    {
+        free (new_undo);
+        goto end;
+    }
+    new_undo->diff_offset = 0;
+    new_undo->diff_size_next = 0;
+    new_undo->diff_text = NULL;
+
+    /* previous last undo now keeps only diff with the new undo */
+    if (buffer->last_input_undo && (buffer->last_input_undo)->data)
+    {
+        gui_buffer_undo_set_diff (buffer->last_input_undo,
+                                  (buffer->last_input_undo)->data,
+                                  new_undo->data);
+        (buffer->last_input_undo)->data = NULL;
+    }
 
     /* add undo to the list */
     new_undo->prev_undo = buffer->last_input_undo;
@@ -4205,6 +4466,8 @@ void
 gui_buffer_undo_free (struct t_gui_buffer *buffer,
                       struct t_gui_input_undo *undo)
 {
+    char *data_prev, *data_next;
+
     if (!buffer || !undo)
         return;
 
@@ -4217,9 +4480,41 @@ gui_buffer_undo_free (struct t_gui_buffer *buffer,
             buffer->ptr_input_undo = (buffer->ptr_input_undo)->prev_undo;
     }
 
+    /* diff of previous undo is based on this undo: update it */
+    if (undo->prev_undo)
+    {
+        if (undo->next_undo)
+        {
+            data_prev = gui_buffer_undo_get_data (buffer, undo->prev_undo);
+            data_next = gui_buffer_undo_get_data (buffer, undo->next_undo);
+            if (data_prev && data_next)
+            {
+                free ((undo->prev_undo)->diff_text);
+                gui_buffer_undo_set_diff (undo->prev_undo, data_prev,
+                                          data_next);
+                data_prev = NULL;
+            }
+            free (data_prev);
+            free (data_next);
+        }
+        else if (undo->data)
+        {
+            /* the previous undo becomes the last one: build its content */
+            (undo->prev_undo)->data = gui_buffer_undo_apply_diff (
+                undo->prev_undo, undo->data);
+            undo->data = NULL;
+            free ((undo->prev_undo)->diff_text);
+            (undo->prev_undo)->diff_offset = 0;
+            (undo->prev_undo)->diff_size_next = 0;
+            (undo->prev_undo)->diff_text = NULL;
+        }
+    }
+
     /* free data */
     if (undo->data)
         free (undo->data);
+    if (undo->diff_text)
+        free (undo->diff_text);
 
     /* remove undo from list */
     if (undo->prev_undo)
@@ -4578,6 +4873,9 @@ gui_buffer_hdata_input_undo_cb (const void *pointer, void *data,
     {
         HDATA_VAR(struct t_gui_input_undo, data, STRING, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_input_undo, pos, INTEGER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_input_undo, diff_offset, INTEGER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_input_undo, diff_size_next, INTEGER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_input_undo, diff_text, STRING, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_input_undo, prev_undo, POINTER, 0, NULL, hdata_name);
         HDATA_VAR(struct t_gui_input_undo, next_undo, POINTER, 0, NULL, hdata_name);
     }
@@ -4949,6 +5247,8 @@ gui_buffer_print_log ()
         log_printf ("  input_buffer_length . . : %d",    ptr_buffer->input_buffer_length);
         log_printf ("  input_buffer_pos. . . . : %d",    ptr_buffer->input_buffer_pos);
         log_printf ("  input_buffer_1st_disp . : %d",    ptr_buffer->input_buffer_1st_display);
+        log_printf ("  input_buffer_cache_pos. : %d",    ptr_buffer->input_buffer_cache_pos);
+        log_printf ("  input_buffer_cache_off. : %d",    ptr_buffer->input_buffer_cache_offset);
         log_printf ("  input_undo_snap->data . : '%s'",  (ptr_buffer->input_undo_snap)->data);
         log_printf ("  input_undo_snap->pos. . : %d",    (ptr_buffer->input_undo_snap)->pos);
         log_printf ("  input_undo. . . . . . . : 0x%lx", ptr_buffer->input_undo);
@@ -4959,8 +5259,19 @@ gui_buffer_print_log ()
         for (ptr_undo = ptr_buffer->input_undo; ptr_undo;
              ptr_undo = ptr_undo->next_undo)
         {
-            log_printf ("    undo[%04d]. . . . . . : 0x%lx ('%s' / %d)",
-                        num, ptr_undo, ptr_undo->data, ptr_undo->pos);
+            if (ptr_undo->data)
+            {
+                log_printf ("    undo[%04d]. . . . . . : 0x%lx ('%s' / %d)",
+                            num, ptr_undo, ptr_undo->data, ptr_undo->pos);
+            }
+            else
+            {
+                log_printf ("    undo[%04d]. . . . . . : 0x%lx "
+                            "(diff: %d/%d/'%s' / %d)",
+                            num, ptr_undo, ptr_undo->diff_offset,
+                            ptr_undo->diff_size_next, ptr_undo->diff_text,
+                            ptr_undo->pos);
+            }
             num++;
         }
         log_printf ("  completion. . . . . . . . . . . : 0x%lx", ptr_buffer->completion);
@@ -4968,6 +5279,7 @@ gui_buffer_print_log ()
         log_printf ("  last_history. . . . . . : 0x%lx", ptr_buffer->last_history);
         log_printf ("  ptr_history . . . . . . : 0x%lx", ptr_buffer->ptr_history);
         log_printf ("  num_history . . . . . . : %d",    ptr_buffer->num_history);
+        log_printf ("  history_size. . . . . . : %d",    ptr_buffer->history_size);
         log_printf ("  text_search . . . . . . . . . . : %d",    ptr_buffer->text_search);
         log_printf ("  text_search_exact . . . . . . . : %d",    ptr_buffer->text_search_exact);
         log_printf ("  text_search_regex . . . . . . . : %d",    ptr_buffer->text_search_regex);
@@ -64,10 +64,21 @@ enum t_gui_buffer_notify
 
 /* buffer structures */
 
+/*
+ * Undos are stored as diffs: only the last undo has the full content of
+ * input ("data"), and each other undo has the bytes that differ from the
+ * next undo: to get content of an undo, the bytes of next undo at offset
+ * "diff_offset" (with size "diff_size_next") are replaced by "diff_text".
+ */
+
 struct t_gui_input_undo
 {
     char *data;                        /* content of input buffer           */
+                                       /* (NULL if it's not the last undo)  */
     int pos;                           /* position of cursor in buffer      */
+    int diff_offset;                   /* offset of diff with next undo     */
+    int diff_size_next;                /* size of diff in next undo         */
+    char *diff_text;                   /* text replacing diff of next undo  */
     struct t_gui_input_undo *prev_undo;/* link to previous undo             */
     struct t_gui_input_undo *next_undo;/* link to next undo                 */
 };
@@ -129,6 +140,7 @@ struct t_gui_buffer
     int time_for_each_line;            /* time is displayed for each line?  */
     int chat_refresh_needed;           /* refresh for chat is needed ?      */
                                        /* (1=refresh, 2=erase+refresh)      */
+    int refresh_queued;                /* 1 if buffer is in refresh queue   */
 
     /* nicklist */
     int nicklist;                      /* = 1 if nicklist is enabled        */
@@ -171,6 +183,9 @@ struct t_gui_buffer
     int input_buffer_length;           /* number of chars in buffer         */
     int input_buffer_pos;              /* position into buffer              */
     int input_buffer_1st_display;      /* first char displayed on screen    */
+    int input_buffer_cache_pos;        /* char position cached (with its    */
+    int input_buffer_cache_offset;     /* offset in bytes), to convert      */
+                                       /* positions without full scan       */
 
     /* undo/redo for input */
     struct t_gui_input_undo *input_undo_snap; /* snapshot of input buffer   */
@@ -187,6 +202,7 @@ struct t_gui_buffer
     struct t_gui_history *last_history;/* last command in history           */
     struct t_gui_history *ptr_history; /* current command in history        */
     int num_history;                   /* number of commands in history     */
+    int history_size;                  /* size of commands in history       */
 
     /* text search */
     int text_search;                   /* text search type                  */
@@ -247,6 +263,7 @@ extern int gui_buffers_visited_index;
 extern int gui_buffers_visited_count;
 extern int gui_buffers_visited_frozen;
 extern struct t_gui_buffer *gui_buffer_last_displayed;
+extern struct t_arraylist *gui_buffers_refresh;
 extern char *gui_buffer_reserved_names[];
 extern char *gui_buffer_type_string[];
 extern char *gui_buffer_notify_string[];
@@ -314,6 +331,9 @@ extern const char *gui_buffer_get_string (struct t_gui_buffer *buffer,
                                           const char *property);
 extern void *gui_buffer_get_pointer (struct t_gui_buffer *buffer,
                                      const char *property);
+extern void gui_buffer_refresh_queue_add (struct t_gui_buffer *buffer);
+extern void gui_buffer_refresh_queue_update ();
+extern void gui_buffer_refresh_queue_free ();
 extern void gui_buffer_ask_chat_refresh (struct t_gui_buffer *buffer,
                                          int refresh);
 extern void gui_buffer_set_title (struct t_gui_buffer *buffer,
@@ -375,6 +395,12 @@ extern void gui_buffer_unhide_all ();
 extern void gui_buffer_sort_by_layout_number ();
 extern void gui_buffer_undo_snap (struct t_gui_buffer *buffer);
 extern void gui_buffer_undo_snap_free (struct t_gui_buffer *buffer);
+extern void gui_buffer_undo_set_diff (struct t_gui_input_undo *undo,
+                                     char *data, const char *data_next);
+extern char *gui_buffer_undo_apply_diff (struct t_gui_input_undo *undo,
+                                         char *data);
+extern char *gui_buffer_undo_get_data (struct t_gui_buffer *buffer,
+                                       struct t_gui_input_undo *undo);
 extern void gui_buffer_undo_add (struct t_gui_buffer *buffer);
 extern void gui_buffer_undo_free (struct t_gui_buffer *buffer,
                                   struct t_gui_input_undo *undo);
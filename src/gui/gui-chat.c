@@ -731,6 +731,7 @@ gui_chat_printf_date_tags_internal (struct t_gui_buffer *buffer,
                 if (new_line->data->message)
                     free (new_line->data->message);
                 new_line->data->message = strdup (ptr_msg);
+                gui_line_free_no_color (new_line->data);
             }
         }
     }
@@ -742,6 +743,8 @@ gui_chat_printf_date_tags_internal (struct t_gui_buffer *buffer,
     if (new_line->data->buffer && new_line->data->buffer->print_hooks_enabled)
         hook_print_exec (new_line->data->buffer, new_line);
 
+    gui_line_uncache_no_color (new_line->data);
+
     gui_buffer_ask_chat_refresh (new_line->data->buffer, 1);
 
     if (string)
@@ -757,7 +760,7 @@ no_print:
     if (new_line)
     {
         gui_line_free_data (new_line);
-        free (new_line);
+        gui_line_release (new_line);
     }
     if (string)
         free (string);
@@ -936,7 +939,7 @@ gui_chat_printf_y_date_tags (struct t_gui_buffer *buffer, int y, time_t date,
     if (!new_line->data->buffer)
     {
         gui_line_free_data (new_line);
-        free (new_line);
+        gui_line_release (new_line);
         goto end;
     }
 
@@ -975,7 +978,7 @@ gui_chat_printf_y_date_tags (struct t_gui_buffer *buffer, int y, time_t date,
         {
             string_fprintf (stdout, "%s\n", new_line->data->message);
             gui_line_free_data (new_line);
-            free (new_line);
+            gui_line_release (new_line);
         }
     }
     else
@@ -987,12 +990,8 @@ gui_chat_printf_y_date_tags (struct t_gui_buffer *buffer, int y, time_t date,
                 new_line->data->buffer->own_lines->last_line->data->y : 0;
             if (y <= last_y)
             {
-                for (ptr_line = new_line->data->buffer->own_lines->first_line;
-                     ptr_line; ptr_line = ptr_line->next_line)
-                {
-                    if (ptr_line->data->y >= y)
-                        break;
-                }
+                ptr_line = gui_line_search_by_y (
+                    new_line->data->buffer->own_lines, y);
                 if (ptr_line && (ptr_line->data->y == y))
                 {
                     if (ptr_line->next_line)
@@ -1004,7 +1003,7 @@ gui_chat_printf_y_date_tags (struct t_gui_buffer *buffer, int y, time_t date,
             }
         }
         gui_line_free_data (new_line);
-        free (new_line);
+        gui_line_release (new_line);
     }
 
 end:
@@ -780,34 +780,40 @@ gui_color_code_size (const char *string)
 }
 
 /*
- * Removes WeeChat color codes from a message.
+ * Removes WeeChat color codes from a message, result is written in
+ * "output", which has a size of "output_size" bytes (no memory is
+ * allocated).
  *
  * If replacement is not NULL and not empty, it is used to replace color codes
  * by first char of replacement (and next chars in string are NOT removed).
  * If replacement is NULL or empty, color codes are removed, with following
  * chars if they are related to color code.
  *
- * Note: result must be freed after use.
+ * The output is never longer than the string: with a size of
+ * strlen (string) + 1, the output is never truncated; if the output is too
+ * small, it is truncated (an UTF-8 char is never cut).
+ *
+ * Returns the length of output (in bytes, without the final '\0').
  */
 
-char *
-gui_color_decode (const char *string, const char *replacement)
+int
+gui_color_decode_into (const char *string, const char *replacement,
+                       char *output, int output_size)
 {
     const unsigned char *ptr_string;
-    unsigned char *out;
-    int out_length, out_pos, length;
+    int out_pos, length;
 
-    if (!string)
-        return NULL;
+    if (!output || (output_size <= 0))
+        return 0;
 
-    out_length = (strlen ((char *)string) * 2) + 1;
-    out = malloc (out_length);
-    if (!out)
-        return NULL;
+    output[0] = '\0';
+
+    if (!string)
+        return 0;
 
     ptr_string = (unsigned char *)string;
     out_pos = 0;
-    while (ptr_string && ptr_string[0] && (out_pos < out_length - 1))
+    while (ptr_string[0] && (out_pos < output_size - 1))
     {
         switch (ptr_string[0])
         {
@@ -946,7 +952,7 @@ gui_color_decode (const char *string, const char *replacement)
                 }
                 if (replacement && replacement[0])
                 {
-                    out[out_pos] = replacement[0];
+                    output[out_pos] = replacement[0];
                     out_pos++;
                 }
                 break;
@@ -957,7 +963,7 @@ gui_color_decode (const char *string, const char *replacement)
                     ptr_string++;
                 if (replacement && replacement[0])
                 {
-                    out[out_pos] = replacement[0];
+                    output[out_pos] = replacement[0];
                     out_pos++;
                 }
                 break;
@@ -965,25 +971,71 @@ gui_color_decode (const char *string, const char *replacement)
                 ptr_string++;
                 if (replacement && replacement[0])
                 {
-                    out[out_pos] = replacement[0];
+                    output[out_pos] = replacement[0];
                     out_pos++;
                 }
                 break;
             default:
-                length = utf8_char_size ((char *)ptr_string);
-                if (length == 0)
-                    length = 1;
-                memcpy (out + out_pos, ptr_string, length);
+                /* copy all chars up to the next color code */
+                length = strcspn ((const char *)ptr_string,
+                                  GUI_COLOR_DECODE_STOP_CHARS);
+                if (length > output_size - 1 - out_pos)
+                {
+                    /* output is full: do not cut an UTF-8 char */
+                    length = output_size - 1 - out_pos;
+                    while ((length > 0)
+                           && ((ptr_string[length] & 0xC0) == 0x80))
+                    {
+                        length--;
+                    }
+                    memcpy (output + out_pos, ptr_string, length);
+                    out_pos += length;
+                    output[out_pos] = '\0';
+                    return out_pos;
+                }
+                memcpy (output + out_pos, ptr_string, length);
                 out_pos += length;
                 ptr_string += length;
                 break;
         }
     }
-    out[out_pos] = '\0';
+    output[out_pos] = '\0';
 
-    return (char *)out;
+    return out_pos;
 }
 
+/*
+ * Removes WeeChat color codes from a message.
+ *
+ * If replacement is not NULL and not empty, it is used to replace color codes
+ * by first char of replacement (and next chars in string are NOT removed).
+ * If replacement is NULL or empty, color codes are removed, with following
+ * chars if they are related to color code.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+gui_color_decode (const char *string, const char *replacement)
+{
+    char *out;
+    int out_size;
+
+    if (!string)
+        return NULL;
+
+    /* each color code is replaced by at most one char */
+    out_size = strlen (string) + 1;
+    out = malloc (out_size);
+    if (!out)
+        return NULL;
+
+    gui_color_decode_into (string, replacement, out, out_size);
+
+    return out;
+}
+
+
 /*
  * Converts ANSI color codes to WeeChat colors (or removes them).
  *
@@ -1219,6 +1271,13 @@ end:
 char *
 gui_color_decode_ansi (const char *string, int keep_colors)
 {
+    if (!string)
+        return NULL;
+
+    /* fast path: no ANSI escape char in string */
+    if (!strchr (string, '\x1B'))
+        return strdup (string);
+
     /* allocate/compile regex if needed (first call) */
     if (!gui_color_regex_ansi)
     {
@@ -100,6 +100,9 @@ enum t_gui_color_enum
 #define GUI_COLOR_REMOVE_ATTR_CHAR     '\x1B'
 #define GUI_COLOR_RESET_CHAR           '\x1C'
 
+/* chars starting a color code (scanned when decoding colors) */
+#define GUI_COLOR_DECODE_STOP_CHARS    "\x19\x1A\x1B\x1C"
+
 #define GUI_COLOR_ATTR_BOLD_CHAR       '\x01'
 #define GUI_COLOR_ATTR_REVERSE_CHAR    '\x02'
 #define GUI_COLOR_ATTR_ITALIC_CHAR     '\x03'
@@ -194,6 +197,8 @@ extern const char *gui_color_get_custom (const char *color_name);
 extern int gui_color_convert_term_to_rgb (int color);
 extern int gui_color_convert_rgb_to_term (int rgb, int limit);
 extern int gui_color_code_size (const char *string);
+extern int gui_color_decode_into (const char *string, const char *replacement,
+                                  char *output, int output_size);
 extern char *gui_color_decode (const char *string, const char *replacement);
 extern char *gui_color_decode_ansi (const char *string, int keep_colors);
 extern char *gui_color_encode_ansi (const char *string);
@@ -144,13 +144,21 @@ gui_filter_buffer (struct t_gui_buffer *buffer,
         if (line_data)
             break;
 
+        gui_line_uncache_no_color (ptr_line_data);
+
         ptr_line = ptr_line->next_line;
     }
 
     if (line_data)
+    {
         line_data->buffer->lines->prefix_max_length_refresh = 1;
+        gui_buffer_refresh_queue_add (line_data->buffer);
+    }
     else
+    {
         buffer->lines->prefix_max_length_refresh = 1;
+        gui_buffer_refresh_queue_add (buffer);
+    }
 
     if (buffer->lines->lines_hidden != lines_hidden)
     {
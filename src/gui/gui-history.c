@@ -25,11 +25,14 @@
 #endif
 
 #include <stdlib.h>
+#include <unistd.h>
 #include <stdio.h>
 #include <stddef.h>
 #include <string.h>
+#include <fcntl.h>
 
 #include "../core/weechat.h"
+#include "../core/wee-arraylist.h"
 #include "../core/wee-config.h"
 #include "../core/wee-hashtable.h"
 #include "../core/wee-hdata.h"
@@ -45,8 +48,140 @@ struct t_gui_history *gui_history = NULL;
 struct t_gui_history *last_gui_history = NULL;
 struct t_gui_history *gui_history_ptr = NULL;
 int num_gui_history = 0;
+int gui_history_size = 0;
+int gui_history_global_loaded = 0;
 
 
+/*
+ * Returns mask of bytes and pairs of bytes in a string: each byte and pair
+ * of consecutive bytes sets one of the 64 bits.
+ *
+ * If a string contains another string, then its mask contains all bits set
+ * in the mask of the other string: this is used to quickly skip history
+ * entries when searching text in history.
+ */
+
+unsigned long long
+gui_history_text_mask (const char *string)
+{
+    const unsigned char *ptr_string;
+    unsigned long long mask;
+
+    mask = 0;
+
+    if (!string)
+        return mask;
+
+    for (ptr_string = (const unsigned char *)string; ptr_string[0];
+         ptr_string++)
+    {
+        mask |= 1ULL << (ptr_string[0] & 0x3F);
+        if (ptr_string[1])
+        {
+            mask |= 1ULL << (((ptr_string[0] * 31) + ptr_string[1]) & 0x3F);
+        }
+    }
+
+    return mask;
+}
+
+/*
+ * Removes the oldest entry (last in list) in a history.
+ */
+
+void
+gui_history_remove_last (struct t_gui_history **history,
+                         struct t_gui_history **last_history,
+                         struct t_gui_history **ptr_history,
+                         int *num_history, int *history_size)
+{
+    struct t_gui_history *ptr_prev;
+
+    if (!*last_history)
+        return;
+
+    ptr_prev = (*last_history)->prev_history;
+    if (*ptr_history == *last_history)
+        *ptr_history = ptr_prev;
+    if (ptr_prev)
+        ptr_prev->next_history = NULL;
+    else
+        *history = NULL;
+    *history_size -= strlen ((*last_history)->text);
+    string_shared_free ((*last_history)->text);
+    free (*last_history);
+    *last_history = ptr_prev;
+    (*num_history)--;
+}
+
+/*
+ * Removes oldest entries in a history until the limits are reached (number
+ * of commands and total size of commands); the most recent entry is always
+ * kept.
+ */
+
+void
+gui_history_apply_limits (struct t_gui_history **history,
+                          struct t_gui_history **last_history,
+                          struct t_gui_history **ptr_history,
+                          int *num_history, int *history_size)
+{
+    while ((*num_history > 1)
+           && (((CONFIG_INTEGER(config_history_max_commands) > 0)
+                && (*num_history > CONFIG_INTEGER(config_history_max_commands)))
+               || ((CONFIG_INTEGER(config_history_max_commands_size) > 0)
+                   && (*history_size > CONFIG_INTEGER(config_history_max_commands_size)))))
+    {
+        gui_history_remove_last (history, last_history, ptr_history,
+                                 num_history, history_size);
+    }
+}
+
+/*
+ * Adds a text/command at the beginning of a history (if different from the
+ * most recent entry), then removes oldest entries if needed.
+ *
+ * The text is stored as a shared string: the same text in buffers histories
+ * and in global history is stored only once in memory.
+ */
+
+void
+gui_history_list_add (struct t_gui_history **history,
+                      struct t_gui_history **last_history,
+                      struct t_gui_history **ptr_history,
+                      int *num_history, int *history_size,
+                      const char *string)
+{
+    struct t_gui_history *new_history;
+
+    if (*history && (strcmp ((*history)->text, string) == 0))
+        return;
+
+    new_history = malloc (sizeof (*new_history));
+    if (!new_history)
+        return;
+
+    new_history->text = (char *)string_shared_get (string);
+    if (!new_history->text)
+    {
+        free (new_history);
+        return;
+    }
+    new_history->text_mask = gui_history_text_mask (string);
+    if (*history)
+        (*history)->prev_history = new_history;
+    else
+        *last_history = new_history;
+    new_history->next_history = *history;
+    new_history->prev_history = NULL;
+    *history = new_history;
+    (*num_history)++;
+    *history_size += strlen (string);
+
+    gui_history_apply_limits (history, last_history, ptr_history,
+                              num_history, history_size);
+}
+
 /*
  * Adds a text/command to buffer's history.
  */
@@ -54,91 +189,371 @@ int num_gui_history = 0;
 void
 gui_history_buffer_add (struct t_gui_buffer *buffer, const char *string)
 {
-    struct t_gui_history *new_history, *ptr_history;
+    if (!buffer || !string)
+        return;
+
+    gui_history_list_add (&buffer->history, &buffer->last_history,
+                          &buffer->ptr_history, &buffer->num_history,
+                          &buffer->history_size, string);
+}
 
+/*
+ * Adds a text/command to global history.
+ */
+
+void
+gui_history_global_add (const char *string)
+{
     if (!string)
         return;
 
-    if (!buffer->history
-        || (buffer->history
-            && (strcmp (buffer->history->text, string) != 0)))
+    gui_history_list_add (&gui_history, &last_gui_history, &gui_history_ptr,
+                          &num_gui_history, &gui_history_size, string);
+}
+
+/*
+ * Replaces text of an entry in history of buffer (or in global history if
+ * buffer is NULL).
+ */
+
+void
+gui_history_set_text (struct t_gui_buffer *buffer,
+                      struct t_gui_history *history, const char *text)
+{
+    const char *new_text;
+    int *history_size;
+
+    if (!history || !text)
+        return;
+
+    new_text = string_shared_get (text);
+    if (!new_text)
+        return;
+
+    history_size = (buffer) ? &buffer->history_size : &gui_history_size;
+    *history_size += strlen (new_text) - strlen (history->text);
+
+    string_shared_free (history->text);
+    history->text = (char *)new_text;
+    history->text_mask = gui_history_text_mask (new_text);
+}
+
+/*
+ * Searches a text in history, starting at entry "history" and then
+ * going to more recent entries.
+ *
+ * Returns pointer to first history entry found, NULL if not found.
+ */
+
+struct t_gui_history *
+gui_history_search (struct t_gui_history *history, const char *string)
+{
+    struct t_gui_history *ptr_history;
+    unsigned long long mask;
+
+    if (!string)
+        return NULL;
+
+    mask = gui_history_text_mask (string);
+
+    for (ptr_history = history; ptr_history;
+         ptr_history = ptr_history->prev_history)
     {
-        new_history = malloc (sizeof (*new_history));
-        if (new_history)
+        if (((ptr_history->text_mask & mask) == mask)
+            && strstr (ptr_history->text, string))
+        {
+            return ptr_history;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Returns path to the file used to save global history (evaluated option
+ * weechat.history.global_file), NULL if global history is not saved.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+gui_history_global_file_path ()
+{
+    char *path;
+
+    if (!CONFIG_STRING(config_history_global_file)
+        || !CONFIG_STRING(config_history_global_file)[0])
+    {
+        return NULL;
+    }
+
+    path = string_eval_path_home (CONFIG_STRING(config_history_global_file),
+                                  NULL, NULL, NULL);
+    if (path && !path[0])
+    {
+        free (path);
+        return NULL;
+    }
+
+    return path;
+}
+
+/*
+ * Returns a text/command escaped for global history file: chars "\" and
+ * "\n" are escaped and a final "\n" is added.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+gui_history_global_file_escape (const char *string)
+{
+    char **line;
+    const char *ptr_string;
+
+    line = string_dyn_alloc (strlen (string) + 2);
+    if (!line)
+        return NULL;
+
+    for (ptr_string = string; ptr_string[0]; ptr_string++)
+    {
+        if (ptr_string[0] == '\\')
+            string_dyn_concat (line, "\\\\", -1);
+        else if (ptr_string[0] == '\n')
+            string_dyn_concat (line, "\\n", -1);
+        else
+            string_dyn_concat (line, ptr_string, 1);
+    }
+    string_dyn_concat (line, "\n", -1);
+
+    return string_dyn_free (line, 0);
+}
+
+/*
+ * Appends a text/command in global history file (the file is created with
+ * permissions 0600 if it does not exist).
+ */
+
+void
+gui_history_global_file_append (const char *path, const char *string)
+{
+    char *line;
+    int fd;
+
+    line = gui_history_global_file_escape (string);
+    if (!line)
+        return;
+
+    fd = open (path, O_WRONLY | O_CREAT | O_APPEND, 0600);
+    if (fd >= 0)
+    {
+        if (write (fd, line, strlen (line)) < 0)
         {
-            new_history->text = strdup (string);
-            if (buffer->history)
-                buffer->history->prev_history = new_history;
+            /* ignore error: entry is not saved */
+        }
+        close (fd);
+    }
+
+    free (line);
+}
+
+/*
+ * Reads one entry in global history file (chars "\" and "\n" are
+ * unescaped).
+ *
+ * Returns the entry read, NULL if end of file is reached.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+gui_history_global_file_read (FILE *file)
+{
+    char buffer[4096], **entry, *ptr_buf;
+    int eol, found, escape;
+
+    entry = string_dyn_alloc (256);
+    if (!entry)
+        return NULL;
+
+    eol = 0;
+    found = 0;
+    escape = 0;
+    while (!eol && fgets (buffer, sizeof (buffer), file))
+    {
+        found = 1;
+        for (ptr_buf = buffer; ptr_buf[0]; ptr_buf++)
+        {
+            if (ptr_buf[0] == '\n')
+            {
+                eol = 1;
+                break;
+            }
+            if (escape)
+            {
+                string_dyn_concat (entry, (ptr_buf[0] == 'n') ? "\n" : ptr_buf,
+                                   1);
+                escape = 0;
+            }
+            else if (ptr_buf[0] == '\\')
+            {
+                escape = 1;
+            }
             else
-                buffer->last_history = new_history;
-            new_history->next_history = buffer->history;
-            new_history->prev_history = NULL;
-            buffer->history = new_history;
-            buffer->num_history++;
-
-            /* remove one command if necessary */
-            if ((CONFIG_INTEGER(config_history_max_commands) > 0)
-                && (buffer->num_history > CONFIG_INTEGER(config_history_max_commands)))
             {
-                ptr_history = buffer->last_history->prev_history;
-                if (buffer->ptr_history == buffer->last_history)
-                    buffer->ptr_history = ptr_history;
-                ((buffer->last_history)->prev_history)->next_history = NULL;
-                if (buffer->last_history->text)
-                    free (buffer->last_history->text);
-                free (buffer->last_history);
-                buffer->last_history = ptr_history;
-                buffer->num_history++;
+                string_dyn_concat (entry, ptr_buf, 1);
             }
         }
     }
+
+    return string_dyn_free (entry, !found);
 }
 
 /*
- * Adds a text/command to global history.
+ * Writes global history in file (the file is replaced).
  */
 
 void
-gui_history_global_add (const char *string)
+gui_history_global_file_write (const char *path)
 {
-    struct t_gui_history *new_history, *ptr_history;
+    struct t_gui_history *ptr_history;
+    char *path2, *line;
+    int length, fd;
+    FILE *file;
 
-    if (!string)
+    length = strlen (path) + 32;
+    path2 = malloc (length);
+    if (!path2)
+        return;
+    snprintf (path2, length, "%s.weechattmp", path);
+
+    fd = open (path2, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    file = (fd >= 0) ? fdopen (fd, "w") : NULL;
+    if (!file)
+    {
+        if (fd >= 0)
+            close (fd);
+        free (path2);
+        return;
+    }
+
+    for (ptr_history = last_gui_history; ptr_history;
+         ptr_history = ptr_history->prev_history)
+    {
+        line = gui_history_global_file_escape (ptr_history->text);
+        if (line)
+        {
+            fputs (line, file);
+            free (line);
+        }
+    }
+
+    if (fclose (file) == 0)
+        rename (path2, path);
+    else
+        unlink (path2);
+
+    free (path2);
+}
+
+/*
+ * Loads global history from file (if option weechat.history.global_file is
+ * set): entries read are added as oldest entries in global history.
+ *
+ * The file is loaded only once, on first use of global history (and again
+ * if option weechat.history.global_file is changed after that); if the
+ * file has many more entries than the entries kept in memory, it is
+ * rewritten to keep only these entries.
+ */
+
+void
+gui_history_global_load ()
+{
+    struct t_arraylist *entries;
+    struct t_gui_history *new_history;
+    char *path, *entry;
+    FILE *file;
+    int i, count_read, count_added, max_commands, max_size;
+
+    if (gui_history_global_loaded)
         return;
 
-    if (!gui_history
-        || (gui_history
-            && (strcmp (gui_history->text, string) != 0)))
+    gui_history_global_loaded = 1;
+
+    path = gui_history_global_file_path ();
+    if (!path)
+        return;
+
+    file = fopen (path, "r");
+    if (!file)
+    {
+        free (path);
+        return;
+    }
+
+    entries = arraylist_new (64, 0, 1, NULL, NULL, NULL, NULL);
+    if (!entries)
     {
+        fclose (file);
+        free (path);
+        return;
+    }
+
+    while ((entry = gui_history_global_file_read (file)))
+    {
+        arraylist_add (entries, entry);
+    }
+    fclose (file);
+
+    max_commands = CONFIG_INTEGER(config_history_max_commands);
+    max_size = CONFIG_INTEGER(config_history_max_commands_size);
+
+    /* add entries from the most recent, after entries already in memory */
+    count_read = arraylist_size (entries);
+    count_added = 0;
+    for (i = count_read - 1; i >= 0; i--)
+    {
+        entry = (char *)arraylist_get (entries, i);
+        if (((max_commands > 0) && (num_gui_history >= max_commands))
+            || ((max_size > 0) && (num_gui_history > 0)
+                && (gui_history_size + (int)strlen (entry) > max_size)))
+        {
+            break;
+        }
+        if (last_gui_history && (strcmp (last_gui_history->text, entry) == 0))
+            continue;
         new_history = malloc (sizeof (*new_history));
-        if (new_history)
+        if (!new_history)
+            break;
+        new_history->text = (char *)string_shared_get (entry);
+        if (!new_history->text)
         {
-            new_history->text = strdup (string);
-            if (gui_history)
-                gui_history->prev_history = new_history;
-            else
-                last_gui_history = new_history;
-            new_history->next_history = gui_history;
-            new_history->prev_history = NULL;
+            free (new_history);
+            break;
+        }
+        new_history->text_mask = gui_history_text_mask (entry);
+        new_history->prev_history = last_gui_history;
+        new_history->next_history = NULL;
+        if (last_gui_history)
+            last_gui_history->next_history = new_history;
+        else
             gui_history = new_history;
-            num_gui_history++;
+        last_gui_history = new_history;
+        num_gui_history++;
+        gui_history_size += strlen (entry);
+        count_added++;
+    }
 
-            /* remove one command if necessary */
-            if ((CONFIG_INTEGER(config_history_max_commands) > 0)
-                && (num_gui_history > CONFIG_INTEGER(config_history_max_commands)))
-            {
-                ptr_history = last_gui_history->prev_history;
-                if (gui_history_ptr == last_gui_history)
-                    gui_history_ptr = ptr_history;
-                (last_gui_history->prev_history)->next_history = NULL;
-                if (last_gui_history->text)
-                    free (last_gui_history->text);
-                free (last_gui_history);
-                last_gui_history = ptr_history;
-                num_gui_history--;
-            }
-        }
+    /* compact the file if it has too many entries */
+    if (count_read > (2 * count_added) + 64)
+        gui_history_global_file_write (path);
+
+    for (i = 0; i < count_read; i++)
+    {
+        free (arraylist_get (entries, i));
     }
+    arraylist_free (entries);
+    free (path);
 }
 
 /*
@@ -148,7 +563,8 @@ gui_history_global_add (const char *string)
 void
 gui_history_add (struct t_gui_buffer *buffer, const char *string)
 {
-    char *string2, str_buffer[128];
+    char *string2, str_buffer[128], *path;
+    const char *ptr_string;
 
     snprintf (str_buffer, sizeof (str_buffer),
               "0x%lx", (unsigned long)(buffer));
@@ -160,8 +576,17 @@ gui_history_add (struct t_gui_buffer *buffer, const char *string)
      */
     if (!string2 || string2[0])
     {
-        gui_history_buffer_add (buffer, (string2) ? string2 : string);
-        gui_history_global_add ((string2) ? string2 : string);
+        ptr_string = (string2) ? string2 : string;
+        gui_history_buffer_add (buffer, ptr_string);
+        gui_history_global_load ();
+        path = gui_history_global_file_path ();
+        if (path)
+        {
+            if (!gui_history || (strcmp (gui_history->text, ptr_string) != 0))
+                gui_history_global_file_append (path, ptr_string);
+            free (path);
+        }
+        gui_history_global_add (ptr_string);
     }
 
     if (string2)
@@ -175,20 +600,13 @@ gui_history_add (struct t_gui_buffer *buffer, const char *string)
 void
 gui_history_global_free ()
 {
-    struct t_gui_history *ptr_history;
-
     while (gui_history)
     {
-        ptr_history = gui_history->next_history;
-        if (gui_history->text)
-            free (gui_history->text);
-        free (gui_history);
-        gui_history = ptr_history;
+        gui_history_remove_last (&gui_history, &last_gui_history,
+                                 &gui_history_ptr, &num_gui_history,
+                                 &gui_history_size);
     }
-    gui_history = NULL;
-    last_gui_history = NULL;
     gui_history_ptr = NULL;
-    num_gui_history = 0;
 }
 
 
@@ -199,23 +617,16 @@ gui_history_global_free ()
 void
 gui_history_buffer_free (struct t_gui_buffer *buffer)
 {
-    struct t_gui_history *ptr_history;
-
     if (!buffer)
         return;
 
     while (buffer->history)
     {
-        ptr_history = buffer->history->next_history;
-        if (buffer->history->text)
-            free (buffer->history->text);
-        free (buffer->history);
-        buffer->history = ptr_history;
+        gui_history_remove_last (&buffer->history, &buffer->last_history,
+                                 &buffer->ptr_history, &buffer->num_history,
+                                 &buffer->history_size);
     }
-    buffer->history = NULL;
-    buffer->last_history = NULL;
     buffer->ptr_history = NULL;
-    buffer->num_history = 0;
 }
 
 /*
@@ -246,11 +657,34 @@ gui_history_hdata_history_update_cb (void *data,
 
     if (pointer)
     {
-        /* update history */
-        ptr_history = (struct t_gui_history *)pointer;
-        if (ptr_history->text)
-            free (ptr_history->text);
-        ptr_history->text = strdup (text);
+        /* update history (global history or history of a buffer) */
+        for (ptr_history = gui_history; ptr_history;
+             ptr_history = ptr_history->next_history)
+        {
+            if (ptr_history == pointer)
+                break;
+        }
+        ptr_buffer = NULL;
+        if (!ptr_history)
+        {
+            for (ptr_buffer = gui_buffers; ptr_buffer;
+                 ptr_buffer = ptr_buffer->next_buffer)
+            {
+                for (ptr_history = ptr_buffer->history; ptr_history;
+                     ptr_history = ptr_history->next_history)
+                {
+                    if (ptr_history == pointer)
+                        break;
+                }
+                if (ptr_history)
+                    break;
+            }
+        }
+        if (ptr_history)
+        {
+            gui_history_set_text (ptr_buffer, ptr_history, text);
+            rc = 1;
+        }
     }
     else
     {
@@ -293,7 +727,7 @@ gui_history_hdata_history_cb (const void *pointer, void *data,
                        1, 1, &gui_history_hdata_history_update_cb, NULL);
     if (hdata)
     {
-        HDATA_VAR(struct t_gui_history, text, STRING, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_history, text, SHARED_STRING, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_history, prev_history, POINTER, 0, NULL, hdata_name);
         HDATA_VAR(struct t_gui_history, next_history, POINTER, 0, NULL, hdata_name);
         HDATA_LIST(gui_history, WEECHAT_HDATA_LIST_CHECK_POINTERS);
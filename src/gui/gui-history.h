@@ -20,11 +20,15 @@
 #ifndef WEECHAT_GUI_HISTORY_H
 #define WEECHAT_GUI_HISTORY_H
 
+#include <stdio.h>
+
 struct t_gui_buffer;
 
 struct t_gui_history
 {
     char *text;                        /* text or command (entered by user) */
+                                       /* (shared string)                   */
+    unsigned long long text_mask;      /* mask of bytes in text (search)    */
     struct t_gui_history *next_history;/* link to next text/command         */
     struct t_gui_history *prev_history;/* link to previous text/command     */
 };
@@ -32,10 +36,22 @@ struct t_gui_history
 extern struct t_gui_history *gui_history;
 extern struct t_gui_history *last_gui_history;
 extern struct t_gui_history *gui_history_ptr;
+extern int num_gui_history;
+extern int gui_history_size;
+extern int gui_history_global_loaded;
 
+extern unsigned long long gui_history_text_mask (const char *string);
 extern void gui_history_buffer_add (struct t_gui_buffer *buffer,
                                     const char *string);
 extern void gui_history_global_add (const char *string);
+extern void gui_history_set_text (struct t_gui_buffer *buffer,
+                                  struct t_gui_history *history,
+                                  const char *text);
+extern struct t_gui_history *gui_history_search (struct t_gui_history *history,
+                                                 const char *string);
+extern char *gui_history_global_file_escape (const char *string);
+extern char *gui_history_global_file_read (FILE *file);
+extern void gui_history_global_load ();
 extern void gui_history_add (struct t_gui_buffer *buffer, const char *string);
 extern void gui_history_global_free ();
 extern void gui_history_buffer_free (struct t_gui_buffer *buffer);
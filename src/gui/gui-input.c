@@ -52,6 +52,14 @@ char *gui_input_clipboard = NULL;      /* internal clipboard content        */
  * Optimizes input buffer size by adding or deleting data block (predefined
  * size).
  *
+ * The allocated size is at least doubled when the input grows, and is
+ * reduced only when the input uses less than a quarter of it, so that a
+ * large input (for example a paste of many lines) is not reallocated on
+ * each key.
+ *
+ * The cached position in input is reset, because content of input is
+ * changed by the caller.
+ *
  * Returns:
  *   1: input size optimized
  *   0: error (input and its size are not changed)
@@ -69,6 +77,16 @@ gui_input_optimize_size (struct t_gui_buffer *buffer,
 
     optimal_size = ((new_size / GUI_BUFFER_INPUT_BLOCK_SIZE) *
                     GUI_BUFFER_INPUT_BLOCK_SIZE) + GUI_BUFFER_INPUT_BLOCK_SIZE;
+    if (optimal_size > buffer->input_buffer_alloc)
+    {
+        if (optimal_size < buffer->input_buffer_alloc * 2)
+            optimal_size = buffer->input_buffer_alloc * 2;
+    }
+    else if ((buffer->input_buffer_alloc <= GUI_BUFFER_INPUT_BLOCK_SIZE)
+             || (new_size + 1 > buffer->input_buffer_alloc / 4))
+    {
+        optimal_size = buffer->input_buffer_alloc;
+    }
     if (buffer->input_buffer_alloc != optimal_size)
     {
         input_buffer2 = realloc (buffer->input_buffer, optimal_size);
@@ -81,9 +99,123 @@ gui_input_optimize_size (struct t_gui_buffer *buffer,
     buffer->input_buffer_size = new_size;
     buffer->input_buffer_length = new_length;
 
+    buffer->input_buffer_cache_pos = 0;
+    buffer->input_buffer_cache_offset = 0;
+
     return 1;
 }
 
+/*
+ * Sets the cached position in input: "ptr" is a pointer to the char at
+ * position "pos" in input.
+ *
+ * Content of input before "ptr" must not change while this position is
+ * cached (any change of size resets the cache, see function
+ * gui_input_optimize_size).
+ */
+
+void
+gui_input_pos_cache_set (struct t_gui_buffer *buffer, int pos, const char *ptr)
+{
+    buffer->input_buffer_cache_pos = pos;
+    buffer->input_buffer_cache_offset = ptr - buffer->input_buffer;
+}
+
+/*
+ * Returns pointer to the char at position "pos" (number of chars) in input.
+ *
+ * The scan starts from the nearest known position: beginning of input, end
+ * of input or the cached position (usually the cursor), so that an edit
+ * near the cursor does not scan the whole input.
+ *
+ * If "pos" is after the end of input, a pointer to the final '\0' is
+ * returned.
+ */
+
+char *
+gui_input_pos_to_ptr (struct t_gui_buffer *buffer, int pos)
+{
+    char *ptr;
+    int current_pos;
+
+    if (pos <= 0)
+        return buffer->input_buffer;
+    if (pos >= buffer->input_buffer_length)
+        return buffer->input_buffer + buffer->input_buffer_size;
+
+    current_pos = buffer->input_buffer_cache_pos;
+    ptr = buffer->input_buffer + buffer->input_buffer_cache_offset;
+
+    if ((pos < current_pos) && (pos < current_pos - pos))
+    {
+        /* nearer to beginning of input */
+        current_pos = 0;
+        ptr = buffer->input_buffer;
+    }
+    else if ((pos > current_pos)
+             && (buffer->input_buffer_length - pos < pos - current_pos))
+    {
+        /* nearer to end of input */
+        current_pos = buffer->input_buffer_length;
+        ptr = buffer->input_buffer + buffer->input_buffer_size;
+    }
+
+    while ((current_pos < pos) && ptr[0])
+    {
+        ptr = (char *)utf8_next_char (ptr);
+        current_pos++;
+    }
+    while ((current_pos > pos) && (ptr > buffer->input_buffer))
+    {
+        ptr = (char *)utf8_prev_char (buffer->input_buffer, ptr);
+        current_pos--;
+    }
+
+    gui_input_pos_cache_set (buffer, current_pos, ptr);
+
+    return ptr;
+}
+
+/*
+ * Returns position (number of chars) of a pointer in input.
+ *
+ * Like function gui_input_pos_to_ptr, chars are counted from the nearest
+ * known position.
+ */
+
+int
+gui_input_ptr_to_pos (struct t_gui_buffer *buffer, const char *ptr)
+{
+    const char *ptr_cache;
+    int pos;
+
+    if (ptr <= buffer->input_buffer)
+        return 0;
+    if (ptr >= buffer->input_buffer + buffer->input_buffer_size)
+        return buffer->input_buffer_length;
+
+    ptr_cache = buffer->input_buffer + buffer->input_buffer_cache_offset;
+
+    if (ptr >= ptr_cache)
+    {
+        pos = buffer->input_buffer_cache_pos
+            + utf8_strnlen (ptr_cache, ptr - ptr_cache);
+    }
+    else if (ptr - buffer->input_buffer < ptr_cache - ptr)
+    {
+        pos = utf8_strnlen (buffer->input_buffer, ptr - buffer->input_buffer);
+    }
+    else
+    {
+        pos = buffer->input_buffer_cache_pos
+            - utf8_strnlen (ptr, ptr_cache - ptr);
+    }
+
+    gui_input_pos_cache_set (buffer, pos, ptr);
+
+    return pos;
+}
+
 /*
  * Replaces full input by another string, trying to keep cursor position if new
  * string is long enough.
@@ -242,7 +374,7 @@ gui_input_set_pos (struct t_gui_buffer *buffer, int pos)
 void
 gui_input_insert_string (struct t_gui_buffer *buffer, const char *string)
 {
-    int size, length;
+    int size, length, offset, size_to_move;
     char *string_utf8, *ptr_start;
 
     if (!buffer->input || !string)
@@ -257,20 +389,27 @@ gui_input_insert_string (struct t_gui_buffer *buffer, const char *string)
     size = strlen (string_utf8);
     length = utf8_strlen (string_utf8);
 
+    /* get offset of cursor before input is reallocated */
+    offset = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos)
+        - buffer->input_buffer;
+    size_to_move = buffer->input_buffer_size - offset;
+
     if (gui_input_optimize_size (buffer,
                                  buffer->input_buffer_size + size,
                                  buffer->input_buffer_length + length))
     {
-        buffer->input_buffer[buffer->input_buffer_size] = '\0';
-
         /* move end of string to the right */
-        ptr_start = (char *)utf8_add_offset (buffer->input_buffer, buffer->input_buffer_pos);
-        memmove (ptr_start + size, ptr_start, strlen (ptr_start));
+        ptr_start = buffer->input_buffer + offset;
+        memmove (ptr_start + size, ptr_start, size_to_move);
 
         /* insert new string */
         memcpy (ptr_start, string_utf8, size);
 
+        buffer->input_buffer[buffer->input_buffer_size] = '\0';
+
         buffer->input_buffer_pos += length;
+        gui_input_pos_cache_set (buffer, buffer->input_buffer_pos,
+                                 ptr_start + size);
     }
 
     free (string_utf8);
@@ -324,6 +463,8 @@ gui_input_move_to_buffer (struct t_gui_buffer *from_buffer,
     to_buffer->input_buffer_length = from_buffer->input_buffer_length;
     to_buffer->input_buffer_pos = from_buffer->input_buffer_pos;
     to_buffer->input_buffer_1st_display = from_buffer->input_buffer_1st_display;
+    to_buffer->input_buffer_cache_pos = from_buffer->input_buffer_cache_pos;
+    to_buffer->input_buffer_cache_offset = from_buffer->input_buffer_cache_offset;
     gui_buffer_input_buffer_init (from_buffer);
 
     /* move undo data */
@@ -482,8 +623,9 @@ gui_input_complete (struct t_gui_buffer *buffer)
              buffer->completion->word_found,
              strlen (buffer->completion->word_found));
     buffer->input_buffer_pos =
-        utf8_pos (buffer->input_buffer,
-                  buffer->completion->position_replace) +
+        gui_input_ptr_to_pos (buffer,
+                              buffer->input_buffer
+                              + buffer->completion->position_replace) +
         utf8_strlen (buffer->completion->word_found);
 
     /*
@@ -491,14 +633,16 @@ gui_input_complete (struct t_gui_buffer *buffer)
      * so reinit to stop completion
      */
     if (buffer->completion->position >= 0)
-        buffer->completion->position = utf8_real_pos (buffer->input_buffer,
-                                                      buffer->input_buffer_pos);
+    {
+        buffer->completion->position =
+            gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos)
+            - buffer->input_buffer;
+    }
 
     /* add space if needed after completion */
     if (buffer->completion->add_space)
     {
-        if (buffer->input_buffer[utf8_real_pos (buffer->input_buffer,
-                                                buffer->input_buffer_pos)] != ' ')
+        if (gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos)[0] != ' ')
         {
             gui_input_insert_string (buffer, " ");
         }
@@ -767,17 +911,17 @@ void
 gui_input_delete_previous_char (struct t_gui_buffer *buffer)
 {
     char *pos, *pos_last;
-    int char_size, size_to_move;
+    int char_size, size_to_move, offset;
 
     if (!buffer->input || (buffer->input_buffer_pos <= 0))
         return;
 
     gui_buffer_undo_snap (buffer);
-    pos = (char *)utf8_add_offset (buffer->input_buffer,
-                                   buffer->input_buffer_pos);
+    pos = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos);
     pos_last = (char *)utf8_prev_char (buffer->input_buffer, pos);
     char_size = pos - pos_last;
-    size_to_move = strlen (pos);
+    size_to_move = buffer->input_buffer_size - (pos - buffer->input_buffer);
+    offset = pos_last - buffer->input_buffer;
     memmove (pos_last, pos, size_to_move);
     if (gui_input_optimize_size (buffer,
                                  buffer->input_buffer_size - char_size,
@@ -785,6 +929,8 @@ gui_input_delete_previous_char (struct t_gui_buffer *buffer)
     {
         buffer->input_buffer_pos--;
         buffer->input_buffer[buffer->input_buffer_size] = '\0';
+        gui_input_pos_cache_set (buffer, buffer->input_buffer_pos,
+                                 buffer->input_buffer + offset);
     }
     gui_input_text_changed_modifier_and_signal (buffer,
                                                 1, /* save undo */
@@ -799,7 +945,7 @@ void
 gui_input_delete_next_char (struct t_gui_buffer *buffer)
 {
     char *pos, *pos_next;
-    int char_size, size_to_move;
+    int char_size, size_to_move, offset;
 
     if (!buffer->input
         || (buffer->input_buffer_pos >= buffer->input_buffer_length))
@@ -808,17 +954,20 @@ gui_input_delete_next_char (struct t_gui_buffer *buffer)
     }
 
     gui_buffer_undo_snap (buffer);
-    pos = (char *)utf8_add_offset (buffer->input_buffer,
-                                   buffer->input_buffer_pos);
+    pos = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos);
     pos_next = (char *)utf8_next_char (pos);
     char_size = pos_next - pos;
-    size_to_move = strlen (pos_next);
+    size_to_move = buffer->input_buffer_size
+        - (pos_next - buffer->input_buffer);
+    offset = pos - buffer->input_buffer;
     memmove (pos, pos_next, size_to_move);
     if (gui_input_optimize_size (buffer,
                                  buffer->input_buffer_size - char_size,
                                  buffer->input_buffer_length - 1))
     {
         buffer->input_buffer[buffer->input_buffer_size] = '\0';
+        gui_input_pos_cache_set (buffer, buffer->input_buffer_pos,
+                                 buffer->input_buffer + offset);
     }
     gui_input_text_changed_modifier_and_signal (buffer,
                                                 1, /* save undo */
@@ -835,14 +984,18 @@ gui_input_delete_range (struct t_gui_buffer *buffer,
                         char *start,
                         char *end)
 {
-    int size_deleted, length_deleted;
+    int size_deleted, length_deleted, pos_start, offset_start;
 
     size_deleted = utf8_next_char (end) - start;
     length_deleted = utf8_strnlen (start, size_deleted);
+    pos_start = gui_input_ptr_to_pos (buffer, start);
+    offset_start = start - buffer->input_buffer;
 
     gui_input_clipboard_copy (start, size_deleted);
 
-    memmove (start, start + size_deleted, strlen (start + size_deleted));
+    memmove (start, start + size_deleted,
+             buffer->input_buffer_size
+             - (start + size_deleted - buffer->input_buffer));
 
     if (gui_input_optimize_size (
             buffer,
@@ -851,6 +1004,8 @@ gui_input_delete_range (struct t_gui_buffer *buffer,
     {
         buffer->input_buffer[buffer->input_buffer_size] = '\0';
         buffer->input_buffer_pos -= length_deleted;
+        gui_input_pos_cache_set (buffer, pos_start,
+                                 buffer->input_buffer + offset_start);
     }
     gui_input_text_changed_modifier_and_signal (buffer,
                                                 1, /* save undo */
@@ -870,8 +1025,7 @@ gui_input_delete_previous_word (struct t_gui_buffer *buffer)
         return;
 
     gui_buffer_undo_snap (buffer);
-    start = (char *)utf8_add_offset (buffer->input_buffer,
-                                     buffer->input_buffer_pos - 1);
+    start = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos - 1);
     string = start;
     /* move to the left until we reach a word char */
     while (string && !string_is_word_char_input (string))
@@ -908,8 +1062,7 @@ gui_input_delete_previous_word_whitespace (struct t_gui_buffer *buffer)
         return;
 
     gui_buffer_undo_snap (buffer);
-    start = (char *)utf8_add_offset (buffer->input_buffer,
-                                     buffer->input_buffer_pos - 1);
+    start = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos - 1);
     string = start;
     /* move to the left, skipping whitespace */
     while (string && string_is_whitespace_char (string))
@@ -940,15 +1093,14 @@ gui_input_delete_previous_word_whitespace (struct t_gui_buffer *buffer)
 void
 gui_input_delete_next_word (struct t_gui_buffer *buffer)
 {
-    int size_deleted, length_deleted;
+    int size_deleted, length_deleted, offset;
     char *start, *string;
 
     if (!buffer->input)
         return;
 
     gui_buffer_undo_snap (buffer);
-    start = (char *)utf8_add_offset (buffer->input_buffer,
-                                     buffer->input_buffer_pos);
+    start = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos);
     string = start;
     length_deleted = 0;
     /* move to the right until we reach a word char */
@@ -967,7 +1119,9 @@ gui_input_delete_next_word (struct t_gui_buffer *buffer)
 
     gui_input_clipboard_copy (start, size_deleted);
 
-    memmove (start, string, strlen (string));
+    offset = start - buffer->input_buffer;
+    memmove (start, string,
+             buffer->input_buffer_size - (string - buffer->input_buffer));
 
     if (gui_input_optimize_size (
             buffer,
@@ -975,6 +1129,8 @@ gui_input_delete_next_word (struct t_gui_buffer *buffer)
             buffer->input_buffer_length - length_deleted))
     {
         buffer->input_buffer[buffer->input_buffer_size] = '\0';
+        gui_input_pos_cache_set (buffer, buffer->input_buffer_pos,
+                                 buffer->input_buffer + offset);
     }
     gui_input_text_changed_modifier_and_signal (buffer,
                                                 1, /* save undo */
@@ -996,14 +1152,14 @@ gui_input_delete_beginning_of_line (struct t_gui_buffer *buffer)
         return;
 
     gui_buffer_undo_snap (buffer);
-    start = (char *)utf8_add_offset (buffer->input_buffer,
-                                     buffer->input_buffer_pos);
+    start = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos);
     size_deleted = start - buffer->input_buffer;
-    length_deleted = utf8_strnlen (buffer->input_buffer, size_deleted);
+    length_deleted = buffer->input_buffer_pos;
     gui_input_clipboard_copy (buffer->input_buffer,
                               start - buffer->input_buffer);
 
-    memmove (buffer->input_buffer, start, strlen (start));
+    memmove (buffer->input_buffer, start,
+             buffer->input_buffer_size - size_deleted);
 
     if (gui_input_optimize_size (
             buffer,
@@ -1032,14 +1188,13 @@ gui_input_delete_end_of_line (struct t_gui_buffer *buffer)
         return;
 
     gui_buffer_undo_snap (buffer);
-    start = (char *)utf8_add_offset (buffer->input_buffer,
-                                     buffer->input_buffer_pos);
-    size_deleted = strlen (start);
+    start = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos);
+    size_deleted = buffer->input_buffer_size - (start - buffer->input_buffer);
     gui_input_clipboard_copy (start, size_deleted);
     start[0] = '\0';
     (void) gui_input_optimize_size (buffer,
-                                    strlen (buffer->input_buffer),
-                                    utf8_strlen (buffer->input_buffer));
+                                    start - buffer->input_buffer,
+                                    buffer->input_buffer_pos);
     gui_input_text_changed_modifier_and_signal (buffer,
                                                 1, /* save undo */
                                                 1); /* stop completion */
@@ -1088,17 +1243,18 @@ gui_input_transpose_chars (struct t_gui_buffer *buffer)
     if (buffer->input_buffer_pos == buffer->input_buffer_length)
         buffer->input_buffer_pos--;
 
-    start = (char *)utf8_add_offset (buffer->input_buffer,
-                                     buffer->input_buffer_pos);
+    start = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos);
     prev_char = (char *)utf8_prev_char (buffer->input_buffer, start);
     size_prev_char = start - prev_char;
     size_start_char = utf8_char_size (start);
 
     memcpy (saved_char, prev_char, size_prev_char);
-    memcpy (prev_char, start, size_start_char);
+    memmove (prev_char, start, size_start_char);
     memcpy (prev_char + size_start_char, saved_char, size_prev_char);
 
     buffer->input_buffer_pos++;
+    gui_input_pos_cache_set (buffer, buffer->input_buffer_pos,
+                             prev_char + size_start_char + size_prev_char);
 
     gui_input_text_changed_modifier_and_signal (buffer,
                                                 1, /* save undo */
@@ -1180,8 +1336,7 @@ gui_input_move_previous_word (struct t_gui_buffer *buffer)
     if (!buffer->input || (buffer->input_buffer_pos <= 0))
         return;
 
-    pos = (char *)utf8_add_offset (buffer->input_buffer,
-                                   buffer->input_buffer_pos - 1);
+    pos = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos - 1);
     while (pos && !string_is_word_char_input (pos))
     {
         pos = (char *)utf8_prev_char (buffer->input_buffer, pos);
@@ -1196,8 +1351,7 @@ gui_input_move_previous_word (struct t_gui_buffer *buffer)
             pos = (char *)utf8_next_char (pos);
         else
             pos = buffer->input_buffer;
-        buffer->input_buffer_pos = utf8_pos (buffer->input_buffer,
-                                             pos - buffer->input_buffer);
+        buffer->input_buffer_pos = gui_input_ptr_to_pos (buffer, pos);
     }
     else
         buffer->input_buffer_pos = 0;
@@ -1221,8 +1375,7 @@ gui_input_move_next_word (struct t_gui_buffer *buffer)
         return;
     }
 
-    pos = (char *)utf8_add_offset (buffer->input_buffer,
-                                   buffer->input_buffer_pos);
+    pos = gui_input_pos_to_ptr (buffer, buffer->input_buffer_pos);
     while (pos[0] && !string_is_word_char_input (pos))
     {
         pos = (char *)utf8_next_char (pos);
@@ -1235,18 +1388,15 @@ gui_input_move_next_word (struct t_gui_buffer *buffer)
         }
         if (pos[0])
         {
-            buffer->input_buffer_pos =
-                utf8_pos (buffer->input_buffer,
-                          pos - buffer->input_buffer);
+            buffer->input_buffer_pos = gui_input_ptr_to_pos (buffer, pos);
         }
         else
             buffer->input_buffer_pos = buffer->input_buffer_length;
     }
     else
     {
-        buffer->input_buffer_pos =
-            utf8_pos (buffer->input_buffer,
-                      utf8_prev_char (buffer->input_buffer, pos) - buffer->input_buffer);
+        buffer->input_buffer_pos = gui_input_ptr_to_pos (
+            buffer, utf8_prev_char (buffer->input_buffer, pos));
     }
 
     gui_input_text_cursor_moved_signal (buffer);
@@ -1283,10 +1433,10 @@ gui_input_history_previous (struct t_gui_window *window,
         {
             /* replace text in history with current input */
             window->buffer->input_buffer[window->buffer->input_buffer_size] = '\0';
-            if ((*ptr_history)->prev_history->text)
-                free ((*ptr_history)->prev_history->text);
-            (*ptr_history)->prev_history->text =
-                strdup (window->buffer->input_buffer);
+            gui_history_set_text (
+                (ptr_history == &gui_history_ptr) ? NULL : window->buffer,
+                (*ptr_history)->prev_history,
+                window->buffer->input_buffer);
         }
         else
         {
@@ -1333,9 +1483,10 @@ gui_input_history_next (struct t_gui_window *window,
     {
         /* replace text in history with current input */
         window->buffer->input_buffer[window->buffer->input_buffer_size] = '\0';
-        if ((*ptr_history)->text)
-            free ((*ptr_history)->text);
-        (*ptr_history)->text = strdup (window->buffer->input_buffer);
+        gui_history_set_text (
+            (ptr_history == &gui_history_ptr) ? NULL : window->buffer,
+            *ptr_history,
+            window->buffer->input_buffer);
 
         *ptr_history = (*ptr_history)->prev_history;
         if (*ptr_history)
@@ -1436,6 +1587,7 @@ gui_input_history_global_previous (struct t_gui_buffer *buffer)
     window = gui_window_search_with_buffer (buffer);
     if (window)
     {
+        gui_history_global_load ();
         gui_input_history_previous (window,
                                     gui_history,
                                     &gui_history_ptr);
@@ -1899,14 +2051,24 @@ gui_input_insert (struct t_gui_buffer *buffer, const char *args)
 void
 gui_input_undo_use (struct t_gui_buffer *buffer, struct t_gui_input_undo *undo)
 {
-    if ((!undo->data) || (strcmp (undo->data, buffer->input_buffer) == 0))
+    char *data;
+
+    data = gui_buffer_undo_get_data (buffer, undo);
+    if (!data)
         return;
 
-    gui_input_replace_input (buffer, undo->data);
+    if (strcmp (data, buffer->input_buffer) == 0)
+    {
+        free (data);
+        return;
+    }
+
+    gui_input_replace_input (buffer, data);
     gui_input_set_pos (buffer, undo->pos);
     gui_input_text_changed_modifier_and_signal (buffer,
                                                 0, /* save undo */
                                                 1); /* stop completion */
+    free (data);
 }
 
 /*
@@ -36,6 +36,7 @@
 #include "../core/wee-hook.h"
 #include "../core/wee-infolist.h"
 #include "../core/wee-log.h"
+#include "../core/wee-pool.h"
 #include "../core/wee-string.h"
 #include "../plugins/plugin.h"
 #include "gui-line.h"
@@ -48,6 +49,10 @@
 #include "gui-window.h"
 
 
+struct t_pool *gui_line_pool_lines = NULL;     /* pool for lines            */
+struct t_pool *gui_line_pool_data = NULL;      /* pool for lines data       */
+
+
 /*
  * Allocates structure "t_gui_lines" and initializes it.
  *
@@ -469,6 +474,114 @@ gui_line_build_string_message_tags (const char *message,
     return result;
 }
 
+/*
+ * Returns prefix of a line without colors.
+ *
+ * The string is computed on first call and kept in line data, so that it is
+ * shared by all functions needing it (highlight, filters, search, hooks...).
+ *
+ * Note: result must not be freed; it is valid until prefix of line is changed
+ * or until function gui_line_uncache_no_color is called.
+ */
+
+const char *
+gui_line_get_prefix_no_color (struct t_gui_line_data *line_data)
+{
+    if (!line_data || !line_data->prefix)
+        return NULL;
+
+    if (!line_data->prefix_no_color)
+        line_data->prefix_no_color = gui_color_decode (line_data->prefix, NULL);
+
+    return line_data->prefix_no_color;
+}
+
+/*
+ * Returns message of a line without colors.
+ *
+ * The string is computed on first call and kept in line data, so that it is
+ * shared by all functions needing it (highlight, filters, search, hooks...).
+ *
+ * Note: result must not be freed; it is valid until message of line is
+ * changed or until function gui_line_uncache_no_color is called.
+ */
+
+const char *
+gui_line_get_message_no_color (struct t_gui_line_data *line_data)
+{
+    if (!line_data || !line_data->message)
+        return NULL;
+
+    if (!line_data->message_no_color)
+    {
+        line_data->message_no_color = gui_color_decode (line_data->message,
+                                                        NULL);
+    }
+
+    return line_data->message_no_color;
+}
+
+/*
+ * Frees prefix and message without colors in a line.
+ *
+ * This function must be called each time prefix or message of line is
+ * changed.
+ */
+
+void
+gui_line_free_no_color (struct t_gui_line_data *line_data)
+{
+    if (!line_data)
+        return;
+
+    if (line_data->prefix_no_color)
+    {
+        free (line_data->prefix_no_color);
+        line_data->prefix_no_color = NULL;
+    }
+    if (line_data->message_no_color)
+    {
+        free (line_data->message_no_color);
+        line_data->message_no_color = NULL;
+    }
+}
+
+/*
+ * Frees prefix and message without colors in a line if they must not be
+ * kept in memory (option weechat.look.line_cache_no_color is off).
+ *
+ * This function is called when an operation on line is finished (line
+ * printed, filters or search applied on the line).
+ */
+
+void
+gui_line_uncache_no_color (struct t_gui_line_data *line_data)
+{
+    if (!CONFIG_BOOLEAN(config_look_line_cache_no_color))
+        gui_line_free_no_color (line_data);
+}
+
+/*
+ * Frees prefix and message without colors in lines of all buffers.
+ */
+
+void
+gui_line_free_no_color_all ()
+{
+    struct t_gui_buffer *ptr_buffer;
+    struct t_gui_line *ptr_line;
+
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        for (ptr_line = ptr_buffer->own_lines->first_line; ptr_line;
+             ptr_line = ptr_line->next_line)
+        {
+            gui_line_free_no_color (ptr_line->data);
+        }
+    }
+}
+
 /*
  * Checks if a line is displayed (no filter on line or filters disabled).
  *
@@ -582,7 +695,8 @@ gui_line_get_next_displayed (struct t_gui_line *line)
 int
 gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
 {
-    char *prefix, *message;
+    const char *prefix;
+    char *message;
     int rc;
 
     if (!line || !line->data->message
@@ -596,7 +710,7 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
     if ((buffer->text_search_where & GUI_TEXT_SEARCH_IN_PREFIX)
         && line->data->prefix)
     {
-        prefix = gui_color_decode (line->data->prefix, NULL);
+        prefix = gui_line_get_prefix_no_color (line->data);
         if (prefix)
         {
             if (buffer->text_search_regex)
@@ -617,7 +731,6 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
             {
                 rc = 1;
             }
-            free (prefix);
         }
     }
 
@@ -633,7 +746,7 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
         }
         else
         {
-            message = gui_color_decode (line->data->message, NULL);
+            message = (char *)gui_line_get_message_no_color (line->data);
         }
         if (message)
         {
@@ -655,10 +768,13 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
             {
                 rc = 1;
             }
-            free (message);
+            if (gui_chat_display_tags)
+                free (message);
         }
     }
 
+    gui_line_uncache_no_color (line->data);
+
     return rc;
 }
 
@@ -674,21 +790,18 @@ int
 gui_line_match_regex (struct t_gui_line_data *line_data, regex_t *regex_prefix,
                       regex_t *regex_message)
 {
-    char *prefix, *message;
+    const char *prefix, *message;
     int match_prefix, match_message;
 
     if (!line_data || (!regex_prefix && !regex_message))
         return 0;
 
-    prefix = NULL;
-    message = NULL;
-
     match_prefix = 1;
     match_message = 1;
 
     if (line_data->prefix)
     {
-        prefix = gui_color_decode (line_data->prefix, NULL);
+        prefix = gui_line_get_prefix_no_color (line_data);
         if (!prefix
             || (regex_prefix && (regexec (regex_prefix, prefix, 0, NULL, 0) != 0)))
             match_prefix = 0;
@@ -701,7 +814,7 @@ gui_line_match_regex (struct t_gui_line_data *line_data, regex_t *regex_prefix,
 
     if (line_data->message)
     {
-        message = gui_color_decode (line_data->message, NULL);
+        message = gui_line_get_message_no_color (line_data);
         if (!message
             || (regex_message && (regexec (regex_message, message, 0, NULL, 0) != 0)))
             match_message = 0;
@@ -712,11 +825,6 @@ gui_line_match_regex (struct t_gui_line_data *line_data, regex_t *regex_prefix,
             match_message = 0;
     }
 
-    if (prefix)
-        free (prefix);
-    if (message)
-        free (message);
-
     return (match_prefix && match_message);
 }
 
@@ -867,18 +975,14 @@ int
 gui_line_has_highlight (struct t_gui_line *line)
 {
     int rc, rc_regex, i, no_highlight, action, length;
-    char *msg_no_color, *ptr_msg_no_color, *highlight_words;
-    const char *ptr_nick;
+    char *highlight_words;
+    const char *ptr_msg_no_color, *ptr_nick;
     regmatch_t regex_match;
 
-    /* remove color codes from line message */
-    msg_no_color = gui_color_decode (line->data->message, NULL);
-    if (!msg_no_color)
-    {
-        rc = 0;
-        goto end;
-    }
-    ptr_msg_no_color = msg_no_color;
+    /* get line message without color codes */
+    ptr_msg_no_color = gui_line_get_message_no_color (line->data);
+    if (!ptr_msg_no_color)
+        return 0;
 
     /*
      * highlights are disabled on this buffer? (special value "-" means that
@@ -1052,9 +1156,6 @@ gui_line_has_highlight (struct t_gui_line *line)
     }
 
 end:
-    if (msg_no_color)
-        free (msg_no_color);
-
     return rc;
 }
 
@@ -1185,6 +1286,60 @@ gui_line_add_to_list (struct t_gui_lines *lines,
     lines->lines_count++;
 }
 
+/*
+ * Allocates a line structure (data is not allocated).
+ *
+ * Lines are allocated in a pool, so this structure must be released with
+ * function gui_line_release.
+ *
+ * Returns pointer to line, NULL if error.
+ */
+
+struct t_gui_line *
+gui_line_alloc ()
+{
+    if (!gui_line_pool_lines)
+    {
+        gui_line_pool_lines = pool_new (NULL, "gui_line",
+                                        sizeof (struct t_gui_line), 256);
+        if (!gui_line_pool_lines)
+            return NULL;
+    }
+
+    return pool_alloc (gui_line_pool_lines);
+}
+
+/*
+ * Allocates a line data structure.
+ *
+ * Returns pointer to line data, NULL if error.
+ */
+
+struct t_gui_line_data *
+gui_line_alloc_data ()
+{
+    if (!gui_line_pool_data)
+    {
+        gui_line_pool_data = pool_new (NULL, "gui_line_data",
+                                       sizeof (struct t_gui_line_data), 256);
+        if (!gui_line_pool_data)
+            return NULL;
+    }
+
+    return pool_alloc (gui_line_pool_data);
+}
+
+/*
+ * Releases a line structure allocated by gui_line_alloc (line data must
+ * have been freed or moved to another line before).
+ */
+
+void
+gui_line_release (struct t_gui_line *line)
+{
+    pool_release (gui_line_pool_lines, line);
+}
+
 /*
  * Frees data in a line.
  */
@@ -1199,7 +1354,8 @@ gui_line_free_data (struct t_gui_line *line)
         string_shared_free (line->data->prefix);
     if (line->data->message)
         free (line->data->message);
-    free (line->data);
+    gui_line_free_no_color (line->data);
+    pool_release (gui_line_pool_data, line->data);
 
     line->data = NULL;
 }
@@ -1253,7 +1409,10 @@ gui_line_remove_from_list (struct t_gui_buffer *buffer,
     if (prefix_is_nick)
         prefix_length += config_length_nick_prefix_suffix;
     if (prefix_length == lines->prefix_max_length)
+    {
         lines->prefix_max_length_refresh = 1;
+        gui_buffer_refresh_queue_add (buffer);
+    }
 
     /* move read marker if it was on line we are removing */
     if (lines->last_read_line == line)
@@ -1283,7 +1442,7 @@ gui_line_remove_from_list (struct t_gui_buffer *buffer,
 
     lines->lines_count--;
 
-    free (line);
+    gui_line_release (line);
 }
 
 /*
@@ -1296,7 +1455,7 @@ gui_line_mixed_add (struct t_gui_lines *lines,
 {
     struct t_gui_line *new_line;
 
-    new_line = malloc (sizeof (*new_line));
+    new_line = gui_line_alloc ();
     if (new_line)
     {
         new_line->data = line_data;
@@ -1492,15 +1651,15 @@ gui_line_new (struct t_gui_buffer *buffer, int y, time_t date,
         return NULL;
 
     /* create new line */
-    new_line = malloc (sizeof (*new_line));
+    new_line = gui_line_alloc ();
     if (!new_line)
         return NULL;
 
     /* create data for line */
-    new_line_data = malloc (sizeof (*new_line_data));
+    new_line_data = gui_line_alloc_data ();
     if (!new_line_data)
     {
-        free (new_line);
+        gui_line_release (new_line);
         return NULL;
     }
     new_line->data = new_line_data;
@@ -1508,6 +1667,8 @@ gui_line_new (struct t_gui_buffer *buffer, int y, time_t date,
     /* fill data in new line */
     new_line->data->buffer = buffer;
     new_line->data->message = (message) ? strdup (message) : strdup ("");
+    new_line->data->prefix_no_color = NULL;
+    new_line->data->message_no_color = NULL;
 
     if (buffer->type == GUI_BUFFER_TYPE_FORMATTED)
     {
@@ -1709,6 +1870,7 @@ gui_line_hook_update (struct t_gui_line *line,
             string_shared_free (line->data->prefix);
         line->data->prefix = (char *)string_shared_get (
             (ptr_value2) ? ptr_value2 : "");
+        gui_line_free_no_color (line->data);
         line->data->prefix_length = (line->data->prefix) ?
             gui_chat_strlen_screen (line->data->prefix) : 0;
     }
@@ -1720,6 +1882,7 @@ gui_line_hook_update (struct t_gui_line *line,
         if (line->data->message)
             free (line->data->message);
         line->data->message = (ptr_value2) ? strdup (ptr_value2) : NULL;
+        gui_line_free_no_color (line->data);
     }
 
     max_notify_level = gui_line_get_max_notify_level (line);
@@ -1862,6 +2025,44 @@ gui_line_add (struct t_gui_line *line)
                              WEECHAT_HOOK_SIGNAL_POINTER, line);
 }
 
+/*
+ * Searches for the first line with y greater than or equal to "y" in lines
+ * of a buffer with free content (lines are sorted by y).
+ *
+ * The search starts from the end of list if "y" is in the second half of
+ * lines, so that adding a line at the end of buffer is fast.
+ *
+ * Returns pointer to line found, NULL if all lines have a lower y.
+ */
+
+struct t_gui_line *
+gui_line_search_by_y (struct t_gui_lines *lines, int y)
+{
+    struct t_gui_line *ptr_line;
+
+    if (!lines || !lines->last_line || (lines->last_line->data->y < y))
+        return NULL;
+
+    if (y > lines->last_line->data->y / 2)
+    {
+        ptr_line = lines->last_line;
+        while (ptr_line->prev_line && (ptr_line->prev_line->data->y >= y))
+        {
+            ptr_line = ptr_line->prev_line;
+        }
+        return ptr_line;
+    }
+
+    for (ptr_line = lines->first_line; ptr_line;
+         ptr_line = ptr_line->next_line)
+    {
+        if (ptr_line->data->y >= y)
+            break;
+    }
+
+    return ptr_line;
+}
+
 /*
  * Adds or updates a line in a buffer with free content.
  *
@@ -1878,12 +2079,8 @@ gui_line_add_y (struct t_gui_line *line)
     int old_line_displayed;
 
     /* search if line exists for "y" */
-    for (ptr_line = line->data->buffer->own_lines->first_line; ptr_line;
-         ptr_line = ptr_line->next_line)
-    {
-        if (ptr_line->data->y >= line->data->y)
-            break;
-    }
+    ptr_line = gui_line_search_by_y (line->data->buffer->own_lines,
+                                     line->data->y);
 
     if (ptr_line && (ptr_line->data->y == line->data->y))
     {
@@ -1901,7 +2098,7 @@ gui_line_add_y (struct t_gui_line *line)
         /* replace ptr_line by line in list */
         gui_line_free_data (ptr_line);
         ptr_line->data = line->data;
-        free (line);
+        gui_line_release (line);
     }
     else
     {
@@ -1950,6 +2147,8 @@ gui_line_add_y (struct t_gui_line *line)
 
     ptr_line->data->refresh_needed = 1;
 
+    gui_line_uncache_no_color (ptr_line->data);
+
     gui_buffer_ask_chat_refresh (ptr_line->data->buffer, 1);
 }
 
@@ -1979,6 +2178,7 @@ gui_line_clear (struct t_gui_line *line)
     if (line->data->message)
         free (line->data->message);
     line->data->message = strdup ("");
+    gui_line_free_no_color (line->data);
 }
 
 /*
@@ -2054,6 +2254,7 @@ gui_line_mix_buffers (struct t_gui_buffer *buffer)
     /* ask refresh of prefix/buffer max length for mixed lines */
     new_lines->prefix_max_length_refresh = 1;
     new_lines->buffer_max_length_refresh = 1;
+    gui_buffer_refresh_queue_add (buffer);
 
     /* free old mixed lines */
     if (ptr_buffer_found->mixed_lines)
@@ -2189,9 +2390,11 @@ gui_line_hdata_line_data_update_cb (void *data,
     {
         value = hashtable_get (hashtable, "prefix");
         hdata_set (hdata, pointer, "prefix", value);
+        gui_line_free_no_color (line_data);
         line_data->prefix_length = (line_data->prefix) ?
             gui_chat_strlen_screen (line_data->prefix) : 0;
         line_data->buffer->lines->prefix_max_length_refresh = 1;
+        gui_buffer_refresh_queue_add (line_data->buffer);
         rc++;
         update_coords = 1;
     }
@@ -2200,6 +2403,7 @@ gui_line_hdata_line_data_update_cb (void *data,
     {
         value = hashtable_get (hashtable, "message");
         hdata_set (hdata, pointer, "message", value);
+        gui_line_free_no_color (line_data);
         rc++;
         update_coords = 1;
     }
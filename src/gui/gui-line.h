@@ -46,6 +46,10 @@ struct t_gui_line_data
     char *prefix;                      /* prefix for line (may be NULL)     */
     int prefix_length;                 /* prefix length (on screen)         */
     char *message;                     /* line content (after prefix)       */
+    char *prefix_no_color;             /* prefix without colors (computed   */
+                                       /* on demand, NULL if not computed)  */
+    char *message_no_color;            /* message without colors (computed  */
+                                       /* on demand, NULL if not computed)  */
 };
 
 struct t_gui_line
@@ -89,11 +93,18 @@ extern char *gui_line_build_string_message_tags (const char *message,
                                                  int tags_count,
                                                  char **tags_array,
                                                  int colors);
+extern const char *gui_line_get_prefix_no_color (struct t_gui_line_data *line_data);
+extern const char *gui_line_get_message_no_color (struct t_gui_line_data *line_data);
+extern void gui_line_free_no_color (struct t_gui_line_data *line_data);
+extern void gui_line_uncache_no_color (struct t_gui_line_data *line_data);
+extern void gui_line_free_no_color_all ();
 extern int gui_line_is_displayed (struct t_gui_line *line);
 extern struct t_gui_line *gui_line_get_first_displayed (struct t_gui_buffer *buffer);
 extern struct t_gui_line *gui_line_get_last_displayed (struct t_gui_buffer *buffer);
 extern struct t_gui_line *gui_line_get_prev_displayed (struct t_gui_line *line);
 extern struct t_gui_line *gui_line_get_next_displayed (struct t_gui_line *line);
+extern struct t_gui_line *gui_line_search_by_y (struct t_gui_lines *lines,
+                                                int y);
 extern int gui_line_search_text (struct t_gui_buffer *buffer,
                                  struct t_gui_line *line);
 extern int gui_line_match_regex (struct t_gui_line_data *line_data,
@@ -112,6 +123,9 @@ extern void gui_line_compute_buffer_max_length (struct t_gui_buffer *buffer,
 extern void gui_line_compute_prefix_max_length (struct t_gui_lines *lines);
 extern void gui_line_mixed_free_buffer (struct t_gui_buffer *buffer);
 extern void gui_line_mixed_free_all (struct t_gui_buffer *buffer);
+extern struct t_gui_line *gui_line_alloc ();
+extern struct t_gui_line_data *gui_line_alloc_data ();
+extern void gui_line_release (struct t_gui_line *line);
 extern void gui_line_free_data (struct t_gui_line *line);
 extern void gui_line_free (struct t_gui_buffer *buffer,
                            struct t_gui_line *line);
@@ -20,6 +20,19 @@
 #ifndef WEECHAT_GUI_MAIN_H
 #define WEECHAT_GUI_MAIN_H
 
+struct t_gui_main_stats
+{
+    unsigned long long loops;          /* iterations of main loop           */
+    unsigned long long refreshes;      /* iterations with a refresh         */
+    unsigned long long buffers_refreshed; /* chat of buffers drawn          */
+    unsigned long long refreshes_delayed; /* refreshes delayed (max rate)   */
+    unsigned long long refreshes_immediate; /* immediate refreshes (key...) */
+};
+
+/* main variables (GUI dependent) */
+
+extern struct t_gui_main_stats gui_main_stats;
+
 /* main functions (GUI dependent) */
 
 extern void gui_main_get_password (const char **prompt,
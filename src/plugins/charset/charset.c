@@ -41,6 +41,9 @@ WEECHAT_PLUGIN_PRIORITY(16000);
 
 #define CHARSET_CONFIG_NAME "charset"
 
+/* max number of names kept in cache of charsets (for decode and encode) */
+#define CHARSET_CACHE_MAX_SIZE 4096
+
 struct t_weechat_plugin *weechat_charset_plugin = NULL;
 #define weechat_plugin weechat_charset_plugin
 
@@ -53,6 +56,62 @@ struct t_config_section *charset_config_section_encode = NULL;
 char *charset_terminal = NULL;
 char *charset_internal = NULL;
 
+/*
+ * charsets found for names (modifier data, like "irc.libera.#weechat"):
+ * key is the name, value is the charset (empty string if no charset)
+ */
+struct t_hashtable *charset_cache_decode = NULL;
+struct t_hashtable *charset_cache_encode = NULL;
+
+
+/*
+ * Clears the cache of charsets (called when a charset option is changed).
+ */
+
+void
+charset_cache_clear ()
+{
+    if (charset_cache_decode)
+        weechat_hashtable_remove_all (charset_cache_decode);
+    if (charset_cache_encode)
+        weechat_hashtable_remove_all (charset_cache_encode);
+}
+
+/*
+ * Frees the cache of charsets.
+ */
+
+void
+charset_cache_free ()
+{
+    if (charset_cache_decode)
+    {
+        weechat_hashtable_free (charset_cache_decode);
+        charset_cache_decode = NULL;
+    }
+    if (charset_cache_encode)
+    {
+        weechat_hashtable_free (charset_cache_encode);
+        charset_cache_encode = NULL;
+    }
+}
+
+/*
+ * Callback for changes on a charset option.
+ */
+
+void
+charset_config_change_cb (const void *pointer, void *data,
+                          struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    charset_cache_clear ();
+}
+
 
 /*
  * Reloads charset configuration file.
@@ -70,6 +129,8 @@ charset_config_reload (const void *pointer, void *data,
     weechat_config_section_free_options (charset_config_section_decode);
     weechat_config_section_free_options (charset_config_section_encode);
 
+    charset_cache_clear ();
+
     return weechat_config_reload (config_file);
 }
 
@@ -151,6 +212,7 @@ charset_config_create_option (const void *pointer, void *data,
             else
             {
                 weechat_config_option_free (ptr_option);
+                charset_cache_clear ();
                 rc = WEECHAT_CONFIG_OPTION_SET_OK_SAME_VALUE;
             }
         }
@@ -166,10 +228,11 @@ charset_config_create_option (const void *pointer, void *data,
                         option_name, "string", NULL,
                         NULL, 0, 0, "", value, 0,
                         (section == charset_config_section_decode) ? &charset_check_charset_decode_cb : NULL, NULL, NULL,
-                        NULL, NULL, NULL,
-                        NULL, NULL, NULL);
+                        &charset_config_change_cb, NULL, NULL,
+                        &charset_config_change_cb, NULL, NULL);
                     rc = (ptr_option) ?
                         WEECHAT_CONFIG_OPTION_SET_OK_SAME_VALUE : WEECHAT_CONFIG_OPTION_SET_ERROR;
+                    charset_cache_clear ();
                 }
             }
             else
@@ -231,7 +294,7 @@ charset_config_init ()
                                  charset_internal) != 0)) ?
         charset_terminal : "iso-8859-1", NULL, 0,
         &charset_check_charset_decode_cb, NULL, NULL,
-        NULL, NULL, NULL,
+        &charset_config_change_cb, NULL, NULL,
         NULL, NULL, NULL);
     charset_default_encode = weechat_config_new_option (
         charset_config_file, ptr_section,
@@ -240,7 +303,9 @@ charset_config_init ()
            "(if empty, default is UTF-8 because it is the WeeChat internal "
            "charset)"),
         NULL, 0, 0, "", NULL, 0,
-        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+        NULL, NULL, NULL,
+        &charset_config_change_cb, NULL, NULL,
+        NULL, NULL, NULL);
 
     ptr_section = weechat_config_new_section (
         charset_config_file, "decode",
@@ -331,8 +396,8 @@ charset_check (const char *charset)
  */
 
 const char *
-charset_get (struct t_config_section *section, const char *name,
-             struct t_config_option *default_charset)
+charset_search (struct t_config_section *section, const char *name,
+                struct t_config_option *default_charset)
 {
     char *option_name, *ptr_end;
     struct t_config_option *ptr_option;
@@ -378,6 +443,38 @@ charset_get (struct t_config_section *section, const char *name,
     return NULL;
 }
 
+/*
+ * Gets charset to use for a name (the charset found is kept in cache, so that
+ * next calls with same name are fast).
+ *
+ * Returns charset, NULL if no charset is defined for this name.
+ */
+
+const char *
+charset_get (struct t_hashtable *cache, struct t_config_section *section,
+             const char *name, struct t_config_option *default_charset)
+{
+    const char *ptr_charset;
+
+    if (!name)
+        return charset_search (section, "", default_charset);
+
+    ptr_charset = weechat_hashtable_get (cache, name);
+    if (!ptr_charset)
+    {
+        ptr_charset = charset_search (section, name, default_charset);
+        if (weechat_hashtable_get_integer (cache, "items_count")
+            >= CHARSET_CACHE_MAX_SIZE)
+        {
+            weechat_hashtable_remove_all (cache);
+        }
+        weechat_hashtable_set (cache, name, (ptr_charset) ? ptr_charset : "");
+        return ptr_charset;
+    }
+
+    return (ptr_charset[0]) ? ptr_charset : NULL;
+}
+
 /*
  * Decodes a string with a charset to internal charset (UTF-8).
  */
@@ -394,8 +491,8 @@ charset_decode_cb (const void *pointer, void *data,
     (void) data;
     (void) modifier;
 
-    charset = charset_get (charset_config_section_decode, modifier_data,
-                           charset_default_decode);
+    charset = charset_get (charset_cache_decode, charset_config_section_decode,
+                           modifier_data, charset_default_decode);
     if (weechat_charset_plugin->debug)
     {
         weechat_printf (NULL,
@@ -425,8 +522,8 @@ charset_encode_cb (const void *pointer, void *data,
     (void) data;
     (void) modifier;
 
-    charset = charset_get (charset_config_section_encode, modifier_data,
-                           charset_default_encode);
+    charset = charset_get (charset_cache_encode, charset_config_section_encode,
+                           modifier_data, charset_default_encode);
     if (weechat_charset_plugin->debug)
     {
         weechat_printf (NULL,
@@ -602,8 +699,25 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
     if (weechat_charset_plugin->debug >= 1)
         charset_display_charsets ();
 
+    charset_cache_decode = weechat_hashtable_new (32,
+                                                  WEECHAT_HASHTABLE_STRING,
+                                                  WEECHAT_HASHTABLE_STRING,
+                                                  NULL, NULL);
+    charset_cache_encode = weechat_hashtable_new (32,
+                                                  WEECHAT_HASHTABLE_STRING,
+                                                  WEECHAT_HASHTABLE_STRING,
+                                                  NULL, NULL);
+    if (!charset_cache_decode || !charset_cache_encode)
+    {
+        charset_cache_free ();
+        return WEECHAT_RC_ERROR;
+    }
+
     if (!charset_config_init ())
+    {
+        charset_cache_free ();
         return WEECHAT_RC_ERROR;
+    }
 
     charset_config_read ();
 
@@ -641,6 +755,8 @@ weechat_plugin_end (struct t_weechat_plugin *plugin)
 
     weechat_config_free (charset_config_file);
 
+    charset_cache_free ();
+
     if (charset_terminal)
         free (charset_terminal);
     if (charset_internal)
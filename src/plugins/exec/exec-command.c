@@ -519,6 +519,8 @@ exec_command_run (struct t_gui_buffer *buffer,
         weechat_hashtable_set (process_options, "detached", "1");
     if (cmd_options.flush)
         weechat_hashtable_set (process_options, "buffer_flush", "1");
+    if (!cmd_options.hsignal)
+        weechat_hashtable_set (process_options, "line_mode", "1");
 
     /* set variables in new command (before running the command) */
     new_exec_cmd->name = (cmd_options.ptr_command_name) ?
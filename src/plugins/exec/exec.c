@@ -367,8 +367,93 @@ exec_display_line (struct t_exec_cmd *exec_cmd, struct t_gui_buffer *buffer,
     free (line_color);
 }
 
+/*
+ * Displays many lines of output ("length" bytes of "lines", separated by
+ * '\n').
+ *
+ * When lines are displayed in a buffer with formatted content, they are
+ * displayed with a single call to printf (so with one refresh of buffer),
+ * otherwise each line is displayed with function exec_display_line.
+ */
+
+void
+exec_display_lines (struct t_exec_cmd *exec_cmd, struct t_gui_buffer *buffer,
+                    int out, const char *lines, int length)
+{
+    char **output, *line, *line_color, str_number[32], str_tags[1024];
+    const char *ptr_lines, *pos, *end;
+
+    if (!exec_cmd || !lines || (length < 0))
+        return;
+
+    output = NULL;
+    if (!exec_cmd->pipe_command && !exec_cmd->output_to_buffer
+        && (weechat_buffer_get_integer (buffer, "type") != 1))
+    {
+        output = weechat_string_dyn_alloc (length + 256);
+    }
+
+    ptr_lines = lines;
+    end = lines + length;
+    while (ptr_lines <= end)
+    {
+        pos = memchr (ptr_lines, '\n', end - ptr_lines);
+        if (!pos)
+            pos = end;
+        line = weechat_strndup (ptr_lines, pos - ptr_lines);
+        if (!line)
+            break;
+        if (output)
+        {
+            line_color = exec_decode_color (exec_cmd, line);
+            if (line_color)
+            {
+                exec_cmd->output_line_nb++;
+                if ((*output)[0])
+                    weechat_string_dyn_concat (output, "\n", -1);
+                if (exec_cmd->line_numbers)
+                {
+                    snprintf (str_number, sizeof (str_number),
+                              "%d\t", exec_cmd->output_line_nb);
+                    weechat_string_dyn_concat (output, str_number, -1);
+                }
+                else
+                {
+                    weechat_string_dyn_concat (output, " \t", -1);
+                }
+                weechat_string_dyn_concat (output, line_color, -1);
+                free (line_color);
+            }
+        }
+        else
+        {
+            exec_display_line (exec_cmd, buffer, out, line);
+        }
+        free (line);
+        ptr_lines = pos + 1;
+    }
+
+    if (output)
+    {
+        if ((*output)[0])
+        {
+            snprintf (str_number, sizeof (str_number), "%ld", exec_cmd->number);
+            snprintf (str_tags, sizeof (str_tags),
+                      "exec_%s,exec_cmd_%s",
+                      (out == EXEC_STDOUT) ? "stdout" : "stderr",
+                      (exec_cmd->name) ? exec_cmd->name : str_number);
+            weechat_printf_date_tags (buffer, 0, str_tags, "%s", *output);
+        }
+        weechat_string_dyn_free (output, 1);
+    }
+}
+
 /*
  * Concatenates some text to stdout/stderr of a command.
+ *
+ * Complete lines are displayed, and the incomplete line at the end of text
+ * (if any) is kept for next call (in line mode, the process hook sends only
+ * complete lines, except at the end of process).
  */
 
 void
@@ -377,45 +462,43 @@ exec_concat_output (struct t_exec_cmd *exec_cmd, struct t_gui_buffer *buffer,
 {
     int length, new_size;
     const char *ptr_text;
-    char *new_output, *pos, *line;
+    char *new_output, *pos, *pos_last, *line;
 
     ptr_text = text;
 
     /* if output is not sent as hsignal, display lines (ending with '\n') */
     if (!exec_cmd->hsignal)
     {
-        ptr_text = text;
-        while (ptr_text[0])
+        pos_last = strrchr (ptr_text, '\n');
+        if (pos_last)
         {
-            pos = strchr (ptr_text, '\n');
-            if (!pos)
-                break;
+            /* complete the incomplete line received before */
             if (exec_cmd->output_size[out] > 0)
             {
+                pos = strchr (ptr_text, '\n');
                 length = exec_cmd->output_size[out] + (pos - ptr_text) + 1;
                 line = malloc (length);
-                if (line)
-                {
-                    memcpy (line, exec_cmd->output[out],
-                            exec_cmd->output_size[out]);
-                    memcpy (line + exec_cmd->output_size[out],
-                            ptr_text, pos - ptr_text);
-                    line[length - 1] = '\0';
-                }
-            }
-            else
-                line = weechat_strndup (ptr_text, pos - ptr_text);
-            if (!line)
-                break;
-            if (exec_cmd->output[out])
-            {
+                if (!line)
+                    return;
+                memcpy (line, exec_cmd->output[out],
+                        exec_cmd->output_size[out]);
+                memcpy (line + exec_cmd->output_size[out],
+                        ptr_text, pos - ptr_text);
+                line[length - 1] = '\0';
                 free (exec_cmd->output[out]);
                 exec_cmd->output[out] = NULL;
+                exec_cmd->output_size[out] = 0;
+                exec_display_line (exec_cmd, buffer, out, line);
+                free (line);
+                ptr_text = pos + 1;
+            }
+            /* display all other complete lines at once */
+            if (pos_last >= ptr_text)
+            {
+                exec_display_lines (exec_cmd, buffer, out,
+                                    ptr_text, pos_last - ptr_text);
+                ptr_text = pos_last + 1;
             }
-            exec_cmd->output_size[out] = 0;
-            exec_display_line (exec_cmd, buffer, out, line);
-            free (line);
-            ptr_text = pos + 1;
         }
     }
 
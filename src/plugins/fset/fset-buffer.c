@@ -35,6 +35,8 @@ struct t_gui_buffer *fset_buffer = NULL;
 int fset_buffer_selected_line = 0;
 struct t_hashtable *fset_buffer_hashtable_pointers = NULL;
 struct t_hashtable *fset_buffer_hashtable_extra_vars = NULL;
+char *fset_buffer_options_displayed = NULL; /* 1 if option displayed        */
+int fset_buffer_options_displayed_size = 0; /* size of array above          */
 
 
 /*
@@ -981,6 +983,9 @@ fset_buffer_display_option (struct t_fset_option *fset_option)
     int format_number;
     const char *ptr_format;
 
+    if (!fset_option)
+        return;
+
     format_number = weechat_config_integer (fset_config_look_format_number);
     ptr_format = weechat_config_string (fset_config_format_option[format_number - 1]);
 
@@ -988,17 +993,27 @@ fset_buffer_display_option (struct t_fset_option *fset_option)
         fset_buffer_display_option_eval (fset_option);
     else
         fset_buffer_display_option_predefined_format (fset_option);
+
+    if ((fset_option->index >= 0)
+        && (fset_option->index < fset_buffer_options_displayed_size))
+    {
+        fset_buffer_options_displayed[fset_option->index] = 1;
+    }
 }
 
 /*
  * Updates list of options in fset buffer.
+ *
+ * Only the options visible in the window (and the last option, so that the
+ * buffer has the right number of lines) are displayed, the other options are
+ * displayed when the buffer is scrolled.
  */
 
 void
 fset_buffer_refresh (int clear)
 {
-    int num_options, i;
-    struct t_fset_option *ptr_fset_option;
+    int num_options;
+    char *new_displayed;
 
     if (!fset_buffer)
         return;
@@ -1008,11 +1023,27 @@ fset_buffer_refresh (int clear)
     if (clear)
         weechat_buffer_clear (fset_buffer);
 
-    for (i = 0; i < num_options; i++)
+    if (num_options > fset_buffer_options_displayed_size)
     {
-        ptr_fset_option = weechat_arraylist_get (fset_options, i);
-        if (ptr_fset_option)
-            fset_buffer_display_option (ptr_fset_option);
+        new_displayed = realloc (fset_buffer_options_displayed, num_options);
+        if (new_displayed)
+        {
+            fset_buffer_options_displayed = new_displayed;
+            fset_buffer_options_displayed_size = num_options;
+        }
+    }
+    if (fset_buffer_options_displayed)
+    {
+        memset (fset_buffer_options_displayed, 0,
+                fset_buffer_options_displayed_size);
+    }
+
+    if (num_options > 0)
+    {
+        fset_buffer_display_option (
+            weechat_arraylist_get (fset_options, num_options - 1));
+        fset_buffer_display_visible_options (
+            weechat_window_search_with_buffer (fset_buffer));
     }
 
     fset_buffer_set_title ();
@@ -1041,6 +1072,9 @@ fset_buffer_set_current_line (int line)
         fset_buffer_display_option (
             weechat_arraylist_get (fset_options, fset_buffer_selected_line));
 
+        /* display options around the new selected line */
+        fset_buffer_display_visible_options (NULL);
+
         fset_buffer_set_title ();
         fset_bar_item_update ();
     }
@@ -1082,6 +1116,63 @@ fset_buffer_get_window_info (struct t_gui_window *window,
                                           "win_chat_height");
 }
 
+/*
+ * Displays options visible in a window (with one screen of margin before and
+ * after), if they are not yet displayed.
+ *
+ * If window is NULL, the options around the selected line are displayed
+ * (using height of window displaying fset buffer, or current window).
+ */
+
+void
+fset_buffer_display_visible_options (struct t_gui_window *window)
+{
+    int num_options, format_number, lines_per_option;
+    int start_line_y, chat_height, first, last, i;
+
+    if (!fset_buffer || !fset_buffer_options_displayed)
+        return;
+
+    num_options = weechat_arraylist_size (fset_options);
+    if (num_options > fset_buffer_options_displayed_size)
+        num_options = fset_buffer_options_displayed_size;
+    if (num_options <= 0)
+        return;
+
+    format_number = weechat_config_integer (fset_config_look_format_number);
+    lines_per_option = fset_config_format_option_num_lines[format_number - 1];
+    if (lines_per_option < 1)
+        lines_per_option = 1;
+
+    if (window)
+    {
+        fset_buffer_get_window_info (window, &start_line_y, &chat_height);
+    }
+    else
+    {
+        window = weechat_window_search_with_buffer (fset_buffer);
+        start_line_y = fset_buffer_selected_line * lines_per_option;
+        chat_height = weechat_window_get_integer (
+            (window) ? window : weechat_current_window (),
+            "win_chat_height");
+    }
+    if (chat_height < 1)
+        chat_height = 1;
+
+    first = (start_line_y - chat_height) / lines_per_option;
+    if (first < 0)
+        first = 0;
+    last = (start_line_y + (2 * chat_height)) / lines_per_option;
+    if (last >= num_options)
+        last = num_options - 1;
+
+    for (i = first; i <= last; i++)
+    {
+        if (!fset_buffer_options_displayed[i])
+            fset_buffer_display_option (weechat_arraylist_get (fset_options, i));
+    }
+}
+
 /*
  * Checks if current line is outside window.
  *
@@ -1147,6 +1238,8 @@ fset_buffer_window_scrolled_cb (const void *pointer, void *data,
     if (weechat_window_get_pointer (signal_data, "buffer") != fset_buffer)
         return WEECHAT_RC_OK;
 
+    fset_buffer_display_visible_options (signal_data);
+
     fset_buffer_get_window_info (signal_data, &start_line_y, &chat_height);
 
     format_number = weechat_config_integer (fset_config_look_format_number);
@@ -1171,6 +1264,45 @@ fset_buffer_window_scrolled_cb (const void *pointer, void *data,
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Callback for signals "buffer_switch" and "window_switch": displays options
+ * visible in the window displaying fset buffer.
+ */
+
+int
+fset_buffer_switch_cb (const void *pointer, void *data,
+                       const char *signal, const char *type_data,
+                       void *signal_data)
+{
+    struct t_gui_window *ptr_window;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) type_data;
+
+    if (!fset_buffer)
+        return WEECHAT_RC_OK;
+
+    if (strcmp (signal, "window_switch") == 0)
+    {
+        if (weechat_window_get_pointer (signal_data, "buffer") != fset_buffer)
+            return WEECHAT_RC_OK;
+        ptr_window = signal_data;
+    }
+    else
+    {
+        if (signal_data != fset_buffer)
+            return WEECHAT_RC_OK;
+        ptr_window = weechat_window_search_with_buffer (fset_buffer);
+    }
+
+    if (ptr_window)
+        fset_buffer_display_visible_options (ptr_window);
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Callback for user data in fset buffer.
  */
@@ -1320,6 +1452,12 @@ fset_buffer_close_cb (const void *pointer, void *data,
     fset_buffer = NULL;
     fset_buffer_selected_line = 0;
     weechat_arraylist_clear (fset_options);
+    if (fset_buffer_options_displayed)
+    {
+        free (fset_buffer_options_displayed);
+        fset_buffer_options_displayed = NULL;
+    }
+    fset_buffer_options_displayed_size = 0;
     fset_option_count_marked = 0;
 
     return WEECHAT_RC_OK;
@@ -1485,4 +1623,11 @@ fset_buffer_end ()
 
     weechat_hashtable_free (fset_buffer_hashtable_extra_vars);
     fset_buffer_hashtable_extra_vars = NULL;
+
+    if (fset_buffer_options_displayed)
+    {
+        free (fset_buffer_options_displayed);
+        fset_buffer_options_displayed = NULL;
+    }
+    fset_buffer_options_displayed_size = 0;
 }
@@ -29,6 +29,7 @@ extern int fset_buffer_selected_line;
 
 extern void fset_buffer_set_title ();
 extern void fset_buffer_display_option (struct t_fset_option *fset_option);
+extern void fset_buffer_display_visible_options (struct t_gui_window *window);
 extern void fset_buffer_refresh (int clear);
 extern void fset_buffer_set_current_line (int line);
 extern void fset_buffer_check_line_outside_window ();
@@ -37,6 +38,11 @@ extern int fset_buffer_window_scrolled_cb (const void *pointer,
                                            const char *signal,
                                            const char *type_data,
                                            void *signal_data);
+extern int fset_buffer_switch_cb (const void *pointer,
+                                  void *data,
+                                  const char *signal,
+                                  const char *type_data,
+                                  void *signal_data);
 extern void fset_buffer_set_keys ();
 extern void fset_buffer_set_localvar_filter ();
 extern void fset_buffer_open ();
@@ -27,6 +27,7 @@
 #include "../weechat-plugin.h"
 #include "fset.h"
 #include "fset-option.h"
+#include "fset-bar-item.h"
 #include "fset-buffer.h"
 #include "fset-config.h"
 
@@ -411,20 +412,50 @@ fset_option_match_filter (struct t_fset_option *fset_option, const char *filter)
 }
 
 /*
- * Sets (or sets again) values (except name) in an fset option.
+ * Checks if a filter uses only the name of options (file, section, option
+ * or full name), so that it can be checked before values are set in the
+ * fset option.
+ *
+ * Returns:
+ *   1: filter uses only the name of options
+ *   0: filter uses other fields (type, values, description, ...)
+ */
+
+int
+fset_option_filter_is_name_only (const char *filter)
+{
+    if (!filter || !filter[0])
+        return 1;
+
+    if (strncmp (filter, "f:", 2) == 0)
+        return 1;
+
+    if ((strncmp (filter, "c:", 2) == 0)
+        || (strncmp (filter, "t:", 2) == 0)
+        || (strncmp (filter, "d=", 2) == 0)
+        || (strncmp (filter, "d:", 2) == 0)
+        || (strcmp (filter, "d") == 0)
+        || (strncmp (filter, "h=", 2) == 0)
+        || (strncmp (filter, "he=", 3) == 0)
+        || (filter[0] == '='))
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Sets (or sets again) name (file, section, option and full name) in an fset
+ * option.
  */
 
 void
-fset_option_set_values (struct t_fset_option *fset_option,
-                        struct t_config_option *option)
+fset_option_set_name (struct t_fset_option *fset_option,
+                      struct t_config_option *option)
 {
     const char *ptr_config_name, *ptr_section_name, *ptr_option_name;
-    const char *ptr_parent_name, *ptr_description;
-    const char **ptr_string_values;
-    void *ptr_default_value, *ptr_value;
-    struct t_config_option *ptr_parent_option;
-    int length, *ptr_type, *ptr_min, *ptr_max;
-    char str_value[64];
+    int length;
 
     /* file */
     if (fset_option->file)
@@ -470,6 +501,22 @@ fset_option_set_values (struct t_fset_option *fset_option,
                   ptr_section_name,
                   ptr_option_name);
     }
+}
+
+/*
+ * Sets (or sets again) values (except name) in an fset option.
+ */
+
+void
+fset_option_set_values (struct t_fset_option *fset_option,
+                        struct t_config_option *option)
+{
+    const char *ptr_parent_name, *ptr_description;
+    const char **ptr_string_values;
+    void *ptr_default_value, *ptr_value;
+    struct t_config_option *ptr_parent_option;
+    int *ptr_type, *ptr_min, *ptr_max;
+    char str_value[64];
 
     /* parent name */
     if (fset_option->parent_name)
@@ -769,11 +816,14 @@ fset_option_set_max_length_fields_all ()
  * Allocates an fset option structure using a pointer to a
  * WeeChat/plugin option.
  *
+ * If with_values == 0, only the name is set (values can be set later with
+ * function fset_option_set_values).
+ *
  * Returns pointer to new fset option, NULL if error.
  */
 
 struct t_fset_option *
-fset_option_alloc (struct t_config_option *option)
+fset_option_alloc (struct t_config_option *option, int with_values)
 {
     struct t_fset_option *new_fset_option;
 
@@ -797,7 +847,9 @@ fset_option_alloc (struct t_config_option *option)
     new_fset_option->string_values = NULL;
     new_fset_option->marked = 0;
 
-    fset_option_set_values (new_fset_option, option);
+    fset_option_set_name (new_fset_option, option);
+    if (with_values)
+        fset_option_set_values (new_fset_option, option);
 
     return new_fset_option;
 }
@@ -814,8 +866,15 @@ struct t_fset_option *
 fset_option_add (struct t_config_option *option)
 {
     struct t_fset_option *new_fset_option;
+    int filter_name_only;
 
-    new_fset_option = fset_option_alloc (option);
+    filter_name_only = fset_option_filter_is_name_only (fset_option_filter);
+
+    /*
+     * values are formatted only if needed by the filter, or if the option
+     * matches the filter
+     */
+    new_fset_option = fset_option_alloc (option, !filter_name_only);
     if (!new_fset_option)
         return NULL;
 
@@ -834,6 +893,9 @@ fset_option_add (struct t_config_option *option)
         return NULL;
     }
 
+    if (filter_name_only)
+        fset_option_set_values (new_fset_option, option);
+
     fset_option_set_max_length_fields_option (new_fset_option);
 
     return new_fset_option;
@@ -882,6 +944,19 @@ fset_option_compare_options_cb (void *data, struct t_arraylist *arraylist,
     return 1;
 }
 
+/*
+ * Compares two options to sort them by name (callback used by qsort).
+ */
+
+int
+fset_option_qsort_cmp_cb (const void *option1, const void *option2)
+{
+    return fset_option_compare_options_cb (
+        NULL, fset_options,
+        *((struct t_fset_option **)option1),
+        *((struct t_fset_option **)option2));
+}
+
 /*
  * Frees an fset option.
  */
@@ -977,8 +1052,9 @@ fset_option_get_options ()
     struct t_config_file *ptr_config;
     struct t_config_section *ptr_section;
     struct t_config_option *ptr_option;
+    struct t_fset_option **new_options, **new_options2;
     struct t_hashtable *marked_options;
-    int i, num_options;
+    int i, num_options, size_new_options;
 
     /* save marked options in a hashtable */
     if (!weechat_config_boolean (fset_config_look_auto_unmark))
@@ -1005,7 +1081,13 @@ fset_option_get_options ()
     fset_option_count_marked = 0;
     fset_option_init_max_length (fset_option_max_length);
 
-    /* get options */
+    /*
+     * get options in a temporary array, which is sorted with a single sort
+     * (faster than adding each option in the sorted arraylist)
+     */
+    new_options = NULL;
+    num_options = 0;
+    size_new_options = 0;
     ptr_config = weechat_hdata_get_list (fset_hdata_config_file,
                                          "config_files");
     while (ptr_config)
@@ -1020,7 +1102,23 @@ fset_option_get_options ()
             {
                 new_fset_option = fset_option_add (ptr_option);
                 if (new_fset_option)
-                    weechat_arraylist_add (fset_options, new_fset_option);
+                {
+                    if (num_options >= size_new_options)
+                    {
+                        size_new_options = (size_new_options == 0) ?
+                            1024 : size_new_options * 2;
+                        new_options2 = realloc (
+                            new_options,
+                            size_new_options * sizeof (*new_options));
+                        if (!new_options2)
+                        {
+                            fset_option_free (new_fset_option);
+                            break;
+                        }
+                        new_options = new_options2;
+                    }
+                    new_options[num_options++] = new_fset_option;
+                }
                 ptr_option = weechat_hdata_move (fset_hdata_config_option,
                                                  ptr_option, 1);
             }
@@ -1031,6 +1129,18 @@ fset_option_get_options ()
                                          ptr_config, 1);
     }
 
+    if (new_options)
+    {
+        qsort (new_options, num_options, sizeof (*new_options),
+               &fset_option_qsort_cmp_cb);
+        /* options are sorted: each option is added at the end of arraylist */
+        for (i = 0; i < num_options; i++)
+        {
+            weechat_arraylist_add (fset_options, new_options[i]);
+        }
+        free (new_options);
+    }
+
     num_options = weechat_arraylist_size (fset_options);
 
     for (i = 0; i < num_options; i++)
@@ -1414,6 +1524,7 @@ void
 fset_option_config_changed (const char *option_name)
 {
     struct t_fset_option *ptr_fset_option, *new_fset_option;
+    struct t_fset_option_max_length old_max_length;
     struct t_config_option *ptr_option;
     int full_refresh, line, num_options;
 
@@ -1422,6 +1533,12 @@ fset_option_config_changed (const char *option_name)
 
     full_refresh = 0;
 
+    /*
+     * max lengths are updated only with the options changed: if they are
+     * not changed, only these options are displayed again
+     */
+    memcpy (&old_max_length, fset_option_max_length, sizeof (old_max_length));
+
     ptr_fset_option = (option_name) ?
         fset_option_search_by_name (option_name, &line) : NULL;
     ptr_option = (option_name) ? weechat_config_get (option_name) : NULL;
@@ -1431,6 +1548,7 @@ fset_option_config_changed (const char *option_name)
         if (ptr_option)
         {
             fset_option_set_values (ptr_fset_option, ptr_option);
+            fset_option_set_max_length_fields_option (ptr_fset_option);
             fset_buffer_display_option (ptr_fset_option);
         }
         else
@@ -1441,7 +1559,7 @@ fset_option_config_changed (const char *option_name)
     }
     else if (ptr_option)
     {
-        new_fset_option = fset_option_alloc (ptr_option);
+        new_fset_option = fset_option_alloc (ptr_option, 1);
         if (fset_option_match_filter (new_fset_option, fset_option_filter))
         {
             /* option added: get options and refresh the whole buffer */
@@ -1468,11 +1586,23 @@ fset_option_config_changed (const char *option_name)
             {
                 ptr_option = weechat_config_get (ptr_fset_option->name);
                 if (ptr_option)
+                {
                     fset_option_set_values (ptr_fset_option, ptr_option);
+                    fset_option_set_max_length_fields_option (ptr_fset_option);
+                    fset_buffer_display_option (ptr_fset_option);
+                }
             }
         }
-        fset_option_set_max_length_fields_all ();
-        fset_buffer_refresh (0);
+        if (memcmp (&old_max_length, fset_option_max_length,
+                    sizeof (old_max_length)) != 0)
+        {
+            fset_buffer_refresh (0);
+        }
+        else
+        {
+            fset_buffer_set_title ();
+            fset_bar_item_update ();
+        }
     }
 }
 
@@ -92,6 +92,7 @@ extern int fset_option_valid (struct t_fset_option *option);
 extern struct t_fset_option *fset_option_search_by_name (const char *name,
                                                          int *line);
 extern int fset_option_value_is_changed (struct t_fset_option *option);
+extern int fset_option_filter_is_name_only (const char *filter);
 extern void fset_option_set_max_length_fields_all ();
 extern void fset_option_free (struct t_fset_option *fset_option);
 extern struct t_arraylist *fset_option_get_arraylist_options ();
@@ -144,6 +144,10 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
     weechat_hook_signal ("debug_dump", &fset_debug_dump_cb, NULL, NULL);
     weechat_hook_signal ("window_scrolled",
                          &fset_buffer_window_scrolled_cb, NULL, NULL);
+    weechat_hook_signal ("buffer_switch",
+                         &fset_buffer_switch_cb, NULL, NULL);
+    weechat_hook_signal ("window_switch",
+                         &fset_buffer_switch_cb, NULL, NULL);
 
     fset_mouse_init ();
 
@@ -255,14 +255,13 @@ irc_color_decode (const char *string, int keep_colors)
                 break;
             default:
                 /*
-                 * we are not on an IRC color code, just copy the UTF-8 char
-                 * into "str_to_add"
+                 * we are not on an IRC color code, just copy all chars up to
+                 * the next IRC color code
                  */
-                length = weechat_utf8_char_size ((char *)ptr_string);
-                if (length == 0)
-                    length = 1;
-                memcpy (str_to_add, ptr_string, length);
-                str_to_add[length] = '\0';
+                length = strcspn ((const char *)ptr_string,
+                                  IRC_COLOR_DECODE_STOP_CHARS);
+                weechat_string_dyn_concat (out, (const char *)ptr_string,
+                                           length);
                 ptr_string += length;
                 break;
         }
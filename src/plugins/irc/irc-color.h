@@ -59,6 +59,9 @@
 #define IRC_COLOR_UNDERLINE_CHAR '\x1F'  /* underlined text                 */
 #define IRC_COLOR_UNDERLINE_STR  "\x1F"  /*   [1F]...[1F]                   */
 
+/* chars starting an IRC color code (scanned when decoding colors) */
+#define IRC_COLOR_DECODE_STOP_CHARS "\x02\x03\x0F\x11\x16\x1D\x1F"
+
 #define IRC_COLOR_TERM2IRC_NUM_COLORS 16
 
 /* macros for WeeChat core and IRC colors */
@@ -35,6 +35,9 @@
 #include "irc-channel.h"
 
 
+struct t_pool *irc_nick_pool = NULL;   /* pool for nicks                    */
+
+
 /*
  * Checks if a nick pointer is valid.
  *
@@ -558,7 +561,13 @@ irc_nick_new (struct t_irc_server *server, struct t_irc_channel *channel,
     }
 
     /* alloc memory for new nick */
-    if ((new_nick = malloc (sizeof (*new_nick))) == NULL)
+    if (!irc_nick_pool)
+    {
+        irc_nick_pool = weechat_pool_new ("irc_nick", sizeof (*new_nick), 256);
+        if (!irc_nick_pool)
+            return NULL;
+    }
+    if ((new_nick = weechat_pool_alloc (irc_nick_pool)) == NULL)
         return NULL;
 
     /* initialize new nick */
@@ -583,7 +592,7 @@ irc_nick_new (struct t_irc_server *server, struct t_irc_channel *channel,
             free (new_nick->prefixes);
         if (new_nick->prefix)
             free (new_nick->prefix);
-        free (new_nick);
+        weechat_pool_release (irc_nick_pool, new_nick);
         return NULL;
     }
     memset (new_nick->prefixes, ' ', length);
@@ -778,7 +787,7 @@ irc_nick_free (struct t_irc_server *server, struct t_irc_channel *channel,
     if (nick->color)
         free (nick->color);
 
-    free (nick);
+    weechat_pool_release (irc_nick_pool, nick);
 
     channel->nicks = new_nicks;
     channel->nick_completion_reset = 1;
@@ -1186,3 +1195,17 @@ irc_nick_print_log (struct t_irc_nick *nick)
     weechat_log_printf ("         prev_nick. . . : 0x%lx", nick->prev_nick);
     weechat_log_printf ("         next_nick. . . : 0x%lx", nick->next_nick);
 }
+
+/*
+ * Frees pool used to allocate nicks (all nicks must have been freed).
+ */
+
+void
+irc_nick_end ()
+{
+    if (irc_nick_pool)
+    {
+        weechat_pool_free (irc_nick_pool);
+        irc_nick_pool = NULL;
+    }
+}
@@ -112,5 +112,6 @@ extern struct t_hdata *irc_nick_hdata_nick_cb (const void *pointer,
 extern int irc_nick_add_to_infolist (struct t_infolist *infolist,
                                      struct t_irc_nick *nick);
 extern void irc_nick_print_log (struct t_irc_nick *nick);
+extern void irc_nick_end ();
 
 #endif /* WEECHAT_PLUGIN_IRC_NICK_H */
@@ -321,6 +321,8 @@ weechat_plugin_end (struct t_weechat_plugin *plugin)
 
     irc_server_free_all ();
 
+    irc_nick_end ();
+
     irc_config_free ();
 
     irc_notify_end ();
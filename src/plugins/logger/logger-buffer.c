@@ -341,43 +341,35 @@ logger_buffer_create_log_file (struct t_logger_buffer *logger_buffer)
 }
 
 /*
- * Compresses a log file, in the child process.
+ * Compresses a log file, in the child process (this function must not use
+ * the logger buffer, nor read options).
  */
 
-void
-logger_buffer_compress_file (struct t_logger_buffer *logger_buffer)
+int
+logger_buffer_compress_file (struct t_logger_buffer_compress *compress)
 {
-    char filename[PATH_MAX], new_filename[PATH_MAX];
-    const char *ptr_extension;
-    int compression_type, compression_level;
-
-    compression_type = weechat_config_integer (
-        logger_config_file_rotation_compression_type);
-    ptr_extension = logger_buffer_compression_extension[compression_type];
+    char filename[PATH_MAX + 16], new_filename[PATH_MAX + 16];
 
     snprintf (filename, sizeof (filename),
               "%s.1",
-              logger_buffer->log_filename);
+              compress->log_filename);
     snprintf (new_filename, sizeof (new_filename),
               "%s.1%s",
-              logger_buffer->log_filename,
-              ptr_extension);
+              compress->log_filename,
+              logger_buffer_compression_extension[compress->type]);
 
-    compression_level = weechat_config_integer (
-        logger_config_file_rotation_compression_level);
-
-    switch (compression_type)
+    switch (compress->type)
     {
         case LOGGER_BUFFER_COMPRESSION_GZIP:
             if (weechat_file_compress (filename, new_filename,
-                                       "gzip", compression_level))
+                                       "gzip", compress->level))
             {
                 unlink (filename);
             }
             break;
         case LOGGER_BUFFER_COMPRESSION_ZSTD:
             if (weechat_file_compress (filename, new_filename,
-                                       "zstd", compression_level))
+                                       "zstd", compress->level))
             {
                 unlink (filename);
             }
@@ -386,7 +378,7 @@ logger_buffer_compress_file (struct t_logger_buffer *logger_buffer)
             break;
     }
 
-    exit (0);
+    return 0;
 }
 
 /*
@@ -401,28 +393,59 @@ logger_buffer_compress_cb (const void *pointer, void *data,
     struct t_logger_buffer *logger_buffer;
 
     /* make C compiler happy */
-    (void) data;
     (void) command;
-    (void) return_code;
     (void) out;
     (void) err;
 
+    if (return_code == WEECHAT_HOOK_PROCESS_CHILD)
+    {
+        return logger_buffer_compress_file (
+            (struct t_logger_buffer_compress *)data);
+    }
+
     logger_buffer = (struct t_logger_buffer *)pointer;
     if (!logger_buffer_valid (logger_buffer))
         return WEECHAT_RC_OK;
 
-    if (return_code == WEECHAT_HOOK_PROCESS_CHILD)
-    {
-        logger_buffer_compress_file (logger_buffer);
-    }
-    else if (return_code >= 0)
-    {
+    if (return_code >= 0)
         logger_buffer->compressing = 0;
-    }
 
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Starts compression of rotated log file, in a child process.
+ */
+
+void
+logger_buffer_compress (struct t_logger_buffer *logger_buffer,
+                        int compression_type)
+{
+    struct t_logger_buffer_compress *compress;
+    struct t_hook *ptr_hook;
+
+    compress = malloc (sizeof (*compress));
+    if (!compress)
+        return;
+    compress->type = compression_type;
+    compress->level = weechat_config_integer (
+        logger_config_file_rotation_compression_level);
+    snprintf (compress->log_filename, sizeof (compress->log_filename),
+              "%s", logger_buffer->log_filename);
+
+    logger_buffer->compressing = 1;
+    ptr_hook = weechat_hook_process ("func:compress",
+                                     0,
+                                     &logger_buffer_compress_cb,
+                                     logger_buffer,
+                                     compress);
+    if (!ptr_hook)
+    {
+        logger_buffer->compressing = 0;
+        free (compress);
+    }
+}
+
 /*
  * Rotates a log file if needed (rotation enabled and max size reached).
  *
@@ -451,7 +474,7 @@ void
 logger_buffer_rotate (struct t_logger_buffer *logger_buffer)
 {
     int compression_type, extension_index, found_comp, found_not_comp, i;
-    char filename[PATH_MAX], new_filename[PATH_MAX];
+    char filename[PATH_MAX + 16], new_filename[PATH_MAX + 16];
     const char *ptr_extension;
     struct stat st;
 
@@ -598,12 +621,7 @@ logger_buffer_rotate (struct t_logger_buffer *logger_buffer)
                                 logger_buffer->log_filename,
                                 ptr_extension);
         }
-        logger_buffer->compressing = 1;
-        (void) weechat_hook_process ("func:compress",
-                                     0,
-                                     &logger_buffer_compress_cb,
-                                     logger_buffer,
-                                     NULL);
+        logger_buffer_compress (logger_buffer, compression_type);
     }
 }
 
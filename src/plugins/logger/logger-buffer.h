@@ -25,6 +25,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <limits.h>
 
 enum t_logger_buffer_compression
 {
@@ -55,6 +56,15 @@ struct t_logger_buffer
     struct t_logger_buffer *next_buffer;  /* link to next buffer            */
 };
 
+/* data for compression of a rotated log file (in child process) */
+
+struct t_logger_buffer_compress
+{
+    int type;                             /* compression type               */
+    int level;                            /* compression level (1-100)      */
+    char log_filename[PATH_MAX];          /* log filename (without ".1")    */
+};
+
 extern struct t_logger_buffer *logger_buffers;
 extern struct t_logger_buffer *last_logger_buffer;
 
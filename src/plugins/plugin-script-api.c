@@ -28,6 +28,7 @@
 #include "weechat-plugin.h"
 #include "plugin-script.h"
 #include "plugin-script-api.h"
+#include "plugin-script-async.h"
 
 
 /*
@@ -717,6 +718,50 @@ plugin_script_api_hook_connect (struct t_weechat_plugin *weechat_plugin,
     return new_hook;
 }
 
+/*
+ * Checks if the callback of a hook must run in the script thread (function
+ * name starting with "async:"), and if so, starts the thread of script (if
+ * not already started) and skips the prefix in function name.
+ *
+ * Returns:
+ *   1: callback runs in the script thread
+ *   0: callback runs in main thread
+ *  -1: error (async callbacks not supported or thread not started)
+ */
+
+int
+plugin_script_api_hook_async (struct t_weechat_plugin *weechat_plugin,
+                              struct t_plugin_script *script,
+                              const char **function)
+{
+    if (!plugin_script_async_is_async_function (*function))
+        return 0;
+
+    if (!plugin_script_async_supported (script))
+    {
+        weechat_printf (NULL,
+                        _("%s%s: async callbacks are not supported "
+                          "(script: %s)"),
+                        weechat_prefix ("error"), weechat_plugin->name,
+                        script->name);
+        return -1;
+    }
+
+    if (!plugin_script_async_start (weechat_plugin, script))
+    {
+        weechat_printf (NULL,
+                        _("%s%s: unable to start thread for async callbacks "
+                          "(script: %s)"),
+                        weechat_prefix ("error"), weechat_plugin->name,
+                        script->name);
+        return -1;
+    }
+
+    *function += PLUGIN_SCRIPT_ASYNC_PREFIX_LENGTH;
+
+    return 1;
+}
+
 /*
  * Hooks a line.
  *
@@ -737,13 +782,20 @@ plugin_script_api_hook_line (struct t_weechat_plugin *weechat_plugin,
 {
     char *function_and_data;
     struct t_hook *new_hook;
+    int async;
 
     if (!script)
         return NULL;
 
+    async = plugin_script_api_hook_async (weechat_plugin, script, &function);
+    if (async < 0)
+        return NULL;
+
     function_and_data = plugin_script_build_function_and_data (function, data);
 
-    new_hook = weechat_hook_line (buffer_type, buffer_name, tags, callback,
+    new_hook = weechat_hook_line (buffer_type, buffer_name, tags,
+                                  (async) ?
+                                  &plugin_script_async_hook_line_cb : callback,
                                   script, function_and_data);
 
     if (new_hook)
@@ -785,14 +837,21 @@ plugin_script_api_hook_print (struct t_weechat_plugin *weechat_plugin,
 {
     char *function_and_data;
     struct t_hook *new_hook;
+    int async;
 
     if (!script)
         return NULL;
 
+    async = plugin_script_api_hook_async (weechat_plugin, script, &function);
+    if (async < 0)
+        return NULL;
+
     function_and_data = plugin_script_build_function_and_data (function, data);
 
     new_hook = weechat_hook_print (buffer, tags, message, strip_colors,
-                                   callback, script, function_and_data);
+                                   (async) ?
+                                   &plugin_script_async_hook_print_cb : callback,
+                                   script, function_and_data);
 
     if (new_hook)
     {
@@ -827,14 +886,21 @@ plugin_script_api_hook_signal (struct t_weechat_plugin *weechat_plugin,
 {
     char *function_and_data;
     struct t_hook *new_hook;
+    int async;
 
     if (!script)
         return NULL;
 
+    async = plugin_script_api_hook_async (weechat_plugin, script, &function);
+    if (async < 0)
+        return NULL;
+
     function_and_data = plugin_script_build_function_and_data (function, data);
 
-    new_hook = weechat_hook_signal (signal, callback, script,
-                                    function_and_data);
+    new_hook = weechat_hook_signal (signal,
+                                    (async) ?
+                                    &plugin_script_async_hook_signal_cb : callback,
+                                    script, function_and_data);
 
     if (new_hook)
     {
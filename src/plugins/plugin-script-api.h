@@ -213,6 +213,9 @@ extern struct t_hook *plugin_script_api_hook_connect (struct t_weechat_plugin *w
                                                                       const char *ip_address),
                                                       const char *function,
                                                       const char *data);
+extern int plugin_script_api_hook_async (struct t_weechat_plugin *weechat_plugin,
+                                         struct t_plugin_script *script,
+                                         const char **function);
 extern struct t_hook *plugin_script_api_hook_line (struct t_weechat_plugin *weechat_plugin,
                                                    struct t_plugin_script *script,
                                                    const char *buffer_type,
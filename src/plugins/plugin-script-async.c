@@ -0,0 +1,951 @@
+/*
+ * plugin-script-async.c - callbacks of scripts running in a script thread
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A script can ask to run some callbacks (print, line and signal hooks) in a
+ * thread dedicated to the script, by giving a function name starting with
+ * "async:": arguments are copied in an event queued for the script thread,
+ * and the hook returns immediately, without waiting for the callback.
+ *
+ * The script thread must not use the WeeChat API: only print and command
+ * functions are allowed, and they are queued as actions executed later in
+ * main thread (the main loop is waken up with a pipe).
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "weechat-plugin.h"
+#include "plugin-script.h"
+#include "plugin-script-api.h"
+#include "plugin-script-async.h"
+
+
+/*
+ * Initializes async data of a language plugin; "callbacks" is NULL if async
+ * callbacks are not supported by the language plugin.
+ *
+ * Note: there is no global variable in this file: the language plugins are
+ * loaded in the same namespace and share the code of this file, so the data
+ * is kept by each language plugin.
+ *
+ * This function must be called in main thread.
+ */
+
+void
+plugin_script_async_init (struct t_plugin_script_async_data *async_data,
+                          struct t_plugin_script_async_callbacks *callbacks)
+{
+    async_data->callbacks = callbacks;
+    async_data->main_thread = pthread_self ();
+    async_data->count = 0;
+    async_data->asyncs = NULL;
+    pthread_mutex_init (&async_data->mutex, NULL);
+}
+
+/*
+ * Ends async data of a language plugin (all scripts must have been unloaded).
+ */
+
+void
+plugin_script_async_end (struct t_plugin_script_async_data *async_data)
+{
+    pthread_mutex_destroy (&async_data->mutex);
+}
+
+/*
+ * Checks if async callbacks are supported by the language plugin of a
+ * script.
+ *
+ * Returns:
+ *   1: async callbacks are supported
+ *   0: async callbacks are not supported
+ */
+
+int
+plugin_script_async_supported (struct t_plugin_script *script)
+{
+    return (script && script->async_data
+            && script->async_data->callbacks) ? 1 : 0;
+}
+
+/*
+ * Checks if a function name starts with the async prefix ("async:").
+ *
+ * Returns:
+ *   1: function must run in the script thread
+ *   0: function must run in main thread
+ */
+
+int
+plugin_script_async_is_async_function (const char *function)
+{
+    return (function
+            && (strncmp (function, PLUGIN_SCRIPT_ASYNC_PREFIX,
+                         PLUGIN_SCRIPT_ASYNC_PREFIX_LENGTH) == 0)) ? 1 : 0;
+}
+
+/*
+ * Returns the script running in the current thread if this is a script
+ * thread of the language plugin, NULL if this is the main thread (or another
+ * thread).
+ */
+
+struct t_plugin_script *
+plugin_script_async_current_script (struct t_plugin_script_async_data *async_data)
+{
+    struct t_plugin_script_async *ptr_async;
+    struct t_plugin_script *script;
+    pthread_t self;
+
+    self = pthread_self ();
+    if (pthread_equal (self, async_data->main_thread))
+        return NULL;
+
+    script = NULL;
+    pthread_mutex_lock (&async_data->mutex);
+    for (ptr_async = async_data->asyncs; ptr_async;
+         ptr_async = ptr_async->next_async)
+    {
+        if (ptr_async->thread_running
+            && pthread_equal (self, ptr_async->thread))
+        {
+            script = ptr_async->script;
+            break;
+        }
+    }
+    pthread_mutex_unlock (&async_data->mutex);
+
+    return script;
+}
+
+/*
+ * Checks if an async data of script is still valid (script not unloaded).
+ *
+ * This function must be called in main thread.
+ *
+ * Returns:
+ *   1: async data is valid
+ *   0: async data is not valid
+ */
+
+int
+plugin_script_async_valid (struct t_plugin_script_async_data *async_data,
+                           struct t_plugin_script_async *async)
+{
+    struct t_plugin_script_async *ptr_async;
+
+    for (ptr_async = async_data->asyncs; ptr_async;
+         ptr_async = ptr_async->next_async)
+    {
+        if (ptr_async == async)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Creates a new event.
+ *
+ * Returns pointer to new event, NULL if error.
+ */
+
+struct t_plugin_script_async_event *
+plugin_script_async_event_new (const char *function, const char *format)
+{
+    struct t_plugin_script_async_event *new_event;
+
+    new_event = malloc (sizeof (*new_event));
+    if (!new_event)
+        return NULL;
+
+    new_event->function = strdup (function);
+    new_event->format = strdup (format);
+    new_event->argv = calloc (strlen (format) + 1, sizeof (*new_event->argv));
+    new_event->next_event = NULL;
+
+    if (!new_event->function || !new_event->format || !new_event->argv)
+    {
+        if (new_event->function)
+            free (new_event->function);
+        if (new_event->format)
+            free (new_event->format);
+        if (new_event->argv)
+            free (new_event->argv);
+        free (new_event);
+        return NULL;
+    }
+
+    return new_event;
+}
+
+/*
+ * Frees an event.
+ */
+
+void
+plugin_script_async_event_free (struct t_plugin_script_async_event *event)
+{
+    char **ptr_array;
+    int i;
+
+    if (!event)
+        return;
+
+    for (i = 0; event->format[i]; i++)
+    {
+        if (!event->argv[i])
+            continue;
+        if (event->format[i] == 'h')
+        {
+            for (ptr_array = (char **)event->argv[i]; *ptr_array; ptr_array++)
+            {
+                free (*ptr_array);
+            }
+        }
+        free (event->argv[i]);
+    }
+    free (event->function);
+    free (event->format);
+    free (event->argv);
+    free (event);
+}
+
+/*
+ * Adds an event in queue of script thread (the event is freed if it can not
+ * be added).
+ *
+ * This function must be called in main thread.
+ */
+
+void
+plugin_script_async_event_add (struct t_plugin_script_async *async,
+                               struct t_plugin_script_async_event *event)
+{
+    if (!event)
+        return;
+
+    pthread_mutex_lock (&async->mutex);
+
+    if (async->quit
+        || (async->events_count >= PLUGIN_SCRIPT_ASYNC_QUEUE_MAX))
+    {
+        async->events_dropped++;
+        pthread_mutex_unlock (&async->mutex);
+        plugin_script_async_event_free (event);
+        return;
+    }
+
+    if (async->last_event)
+        async->last_event->next_event = event;
+    else
+        async->events = event;
+    async->last_event = event;
+    async->events_count++;
+
+    pthread_cond_signal (&async->cond);
+
+    pthread_mutex_unlock (&async->mutex);
+}
+
+/*
+ * Frees an action.
+ */
+
+void
+plugin_script_async_action_free (struct t_plugin_script_async_action *action)
+{
+    if (!action)
+        return;
+
+    if (action->buffer)
+        free (action->buffer);
+    if (action->tags)
+        free (action->tags);
+    if (action->text)
+        free (action->text);
+    free (action);
+}
+
+/*
+ * Adds an action in queue of main thread.
+ *
+ * This function is called in the script thread.
+ */
+
+void
+plugin_script_async_action_add (struct t_plugin_script *script,
+                                enum t_plugin_script_async_action_type type,
+                                const char *buffer,
+                                time_t date,
+                                const char *tags,
+                                const char *text)
+{
+    struct t_plugin_script_async *async;
+    struct t_plugin_script_async_action *new_action;
+    int wake_up;
+
+    if (!script || !script->async)
+        return;
+
+    async = script->async;
+
+    new_action = malloc (sizeof (*new_action));
+    if (!new_action)
+        return;
+
+    new_action->type = type;
+    new_action->buffer = (buffer) ? strdup (buffer) : NULL;
+    new_action->date = date;
+    new_action->tags = (tags) ? strdup (tags) : NULL;
+    new_action->text = (text) ? strdup (text) : NULL;
+    new_action->next_action = NULL;
+
+    pthread_mutex_lock (&async->mutex);
+
+    wake_up = (async->actions) ? 0 : 1;
+
+    if (async->last_action)
+        async->last_action->next_action = new_action;
+    else
+        async->actions = new_action;
+    async->last_action = new_action;
+
+    pthread_mutex_unlock (&async->mutex);
+
+    /* wake up main thread (it reads all actions at once) */
+    if (wake_up)
+        (void) write (async->pipe_actions[1], "a", 1);
+}
+
+/*
+ * Queues a message to print on core buffer.
+ *
+ * This function is called in the script thread (to report errors, since the
+ * WeeChat API can not be used in this thread).
+ */
+
+void
+plugin_script_async_printf (struct t_plugin_script *script,
+                            const char *format, ...)
+{
+    weechat_va_format (format);
+    if (!vbuffer)
+        return;
+
+    plugin_script_async_action_add (script, PLUGIN_SCRIPT_ASYNC_ACTION_PRINT,
+                                    NULL, 0, NULL, vbuffer);
+
+    free (vbuffer);
+}
+
+/*
+ * Executes an action in main thread.
+ */
+
+void
+plugin_script_async_action_exec (struct t_plugin_script_async *async,
+                                 struct t_plugin_script_async_action *action)
+{
+    struct t_weechat_plugin *weechat_plugin;
+    struct t_gui_buffer *ptr_buffer;
+    static const char *function_name[PLUGIN_SCRIPT_ASYNC_NUM_ACTIONS] =
+        { "print", "print_date_tags", "command" };
+
+    weechat_plugin = async->plugin;
+
+    ptr_buffer = plugin_script_str2ptr (weechat_plugin, async->script->name,
+                                        function_name[action->type],
+                                        action->buffer);
+
+    /* the buffer may have been closed since the action was queued */
+    if (ptr_buffer
+        && !weechat_hdata_check_pointer (weechat_hdata_get ("buffer"), NULL,
+                                         ptr_buffer))
+    {
+        return;
+    }
+
+    switch (action->type)
+    {
+        case PLUGIN_SCRIPT_ASYNC_ACTION_PRINT:
+            plugin_script_api_printf (weechat_plugin, async->script,
+                                      ptr_buffer, "%s",
+                                      (action->text) ? action->text : "");
+            break;
+        case PLUGIN_SCRIPT_ASYNC_ACTION_PRINT_DATE_TAGS:
+            plugin_script_api_printf_date_tags (weechat_plugin, async->script,
+                                                ptr_buffer, action->date,
+                                                action->tags, "%s",
+                                                (action->text) ?
+                                                action->text : "");
+            break;
+        case PLUGIN_SCRIPT_ASYNC_ACTION_COMMAND:
+            if (action->text)
+            {
+                (void) plugin_script_api_command (weechat_plugin,
+                                                  async->script,
+                                                  ptr_buffer, action->text);
+            }
+            break;
+        case PLUGIN_SCRIPT_ASYNC_NUM_ACTIONS:
+            break;
+    }
+}
+
+/*
+ * Callback for pipe of actions: executes actions queued by the script
+ * thread, in main thread.
+ */
+
+int
+plugin_script_async_fd_actions_cb (const void *pointer, void *data, int fd)
+{
+    struct t_plugin_script_async_data *async_data;
+    struct t_plugin_script_async *async;
+    struct t_plugin_script_async_action *action;
+    char buf[256];
+
+    /* make C compiler happy */
+    (void) data;
+
+    async = (struct t_plugin_script_async *)pointer;
+    async_data = async->data;
+
+    while (read (fd, buf, sizeof (buf)) > 0)
+    {
+    }
+
+    while (1)
+    {
+        pthread_mutex_lock (&async->mutex);
+        action = async->actions;
+        if (action)
+        {
+            async->actions = action->next_action;
+            if (!async->actions)
+                async->last_action = NULL;
+            async->actions_done++;
+        }
+        pthread_mutex_unlock (&async->mutex);
+
+        if (!action)
+            break;
+
+        plugin_script_async_action_exec (async, action);
+        plugin_script_async_action_free (action);
+
+        /* the script may have been unloaded by the action (a command) */
+        if (!plugin_script_async_valid (async_data, async))
+            break;
+    }
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Runs events of a script, in the script thread.
+ */
+
+void *
+plugin_script_async_thread (void *arg)
+{
+    struct t_plugin_script_async *async;
+    struct t_plugin_script_async_callbacks *callbacks;
+    struct t_plugin_script_async_event *event;
+    void *thread_data;
+
+    async = (struct t_plugin_script_async *)arg;
+    callbacks = async->data->callbacks;
+
+    thread_data = (callbacks->thread_start) ?
+        (callbacks->thread_start) (async->script) : NULL;
+
+    pthread_mutex_lock (&async->mutex);
+
+    while (1)
+    {
+        while (!async->quit && !async->events)
+        {
+            pthread_cond_wait (&async->cond, &async->mutex);
+        }
+        if (async->quit)
+            break;
+
+        event = async->events;
+        async->events = event->next_event;
+        if (!async->events)
+            async->last_event = NULL;
+        async->events_count--;
+
+        pthread_mutex_unlock (&async->mutex);
+
+        (callbacks->exec) (async->script, thread_data, event);
+        plugin_script_async_event_free (event);
+
+        pthread_mutex_lock (&async->mutex);
+        async->events_done++;
+    }
+
+    pthread_mutex_unlock (&async->mutex);
+
+    if (callbacks->thread_end)
+        (callbacks->thread_end) (async->script, thread_data);
+
+    return NULL;
+}
+
+/*
+ * Starts the thread of a script (if not already started).
+ *
+ * This function must be called in main thread.
+ *
+ * Returns pointer to async data of script, NULL if error.
+ */
+
+struct t_plugin_script_async *
+plugin_script_async_start (struct t_weechat_plugin *weechat_plugin,
+                           struct t_plugin_script *script)
+{
+    struct t_plugin_script_async *new_async;
+    int flags;
+
+    if (!plugin_script_async_supported (script))
+        return NULL;
+
+    if (script->async)
+        return script->async;
+
+    new_async = malloc (sizeof (*new_async));
+    if (!new_async)
+        return NULL;
+
+    new_async->plugin = weechat_plugin;
+    new_async->data = script->async_data;
+    new_async->script = script;
+    new_async->quit = 0;
+    new_async->thread_running = 0;
+    new_async->events = NULL;
+    new_async->last_event = NULL;
+    new_async->events_count = 0;
+    new_async->actions = NULL;
+    new_async->last_action = NULL;
+    new_async->hook_fd_actions = NULL;
+    new_async->buffer_output = NULL;
+    new_async->events_done = 0;
+    new_async->events_dropped = 0;
+    new_async->actions_done = 0;
+
+    new_async->buffer_output = weechat_string_dyn_alloc (256);
+    if (!new_async->buffer_output)
+    {
+        free (new_async);
+        return NULL;
+    }
+
+    if (pipe (new_async->pipe_actions) < 0)
+    {
+        weechat_string_dyn_free (new_async->buffer_output, 1);
+        free (new_async);
+        return NULL;
+    }
+    flags = fcntl (new_async->pipe_actions[0], F_GETFL);
+    fcntl (new_async->pipe_actions[0], F_SETFL, flags | O_NONBLOCK);
+    flags = fcntl (new_async->pipe_actions[1], F_GETFL);
+    fcntl (new_async->pipe_actions[1], F_SETFL, flags | O_NONBLOCK);
+
+    pthread_mutex_init (&new_async->mutex, NULL);
+    pthread_cond_init (&new_async->cond, NULL);
+
+    new_async->hook_fd_actions = weechat_hook_fd (
+        new_async->pipe_actions[0], 1, 0, 0,
+        &plugin_script_async_fd_actions_cb, new_async, NULL);
+
+    /* add async data in list (before thread is created) */
+    pthread_mutex_lock (&new_async->data->mutex);
+    new_async->prev_async = NULL;
+    new_async->next_async = new_async->data->asyncs;
+    if (new_async->data->asyncs)
+        (new_async->data->asyncs)->prev_async = new_async;
+    new_async->data->asyncs = new_async;
+    script->async = new_async;
+    if (pthread_create (&new_async->thread, NULL,
+                        &plugin_script_async_thread, new_async) == 0)
+    {
+        new_async->thread_running = 1;
+        new_async->data->count++;
+    }
+    pthread_mutex_unlock (&new_async->data->mutex);
+
+    if (!new_async->thread_running)
+    {
+        plugin_script_async_free (weechat_plugin, script);
+        return NULL;
+    }
+
+    return new_async;
+}
+
+/*
+ * Builds the array of keys/values of a hashtable.
+ */
+
+void
+plugin_script_async_hashtable_map_cb (void *data,
+                                      struct t_hashtable *hashtable,
+                                      const char *key,
+                                      const char *value)
+{
+    char ***ptr_array;
+
+    /* make C compiler happy */
+    (void) hashtable;
+
+    ptr_array = (char ***)data;
+
+    *((*ptr_array)++) = strdup (key);
+    *((*ptr_array)++) = strdup ((value) ? value : "");
+}
+
+/*
+ * Copies a hashtable as an array of keys/values (NULL-terminated).
+ *
+ * Note: result must be freed after use (each string then the array).
+ */
+
+char **
+plugin_script_async_hashtable_to_array (struct t_weechat_plugin *weechat_plugin,
+                                        struct t_hashtable *hashtable)
+{
+    char **array, **ptr_array;
+    int count;
+
+    count = weechat_hashtable_get_integer (hashtable, "items_count");
+    array = calloc ((count * 2) + 1, sizeof (*array));
+    if (!array)
+        return NULL;
+
+    ptr_array = array;
+    weechat_hashtable_map_string (hashtable,
+                                  &plugin_script_async_hashtable_map_cb,
+                                  &ptr_array);
+    *ptr_array = NULL;
+
+    return array;
+}
+
+/*
+ * Callback for print hooks with an async function: queues an event with
+ * same arguments as the callback of language plugin.
+ */
+
+int
+plugin_script_async_hook_print_cb (const void *pointer, void *data,
+                                   struct t_gui_buffer *buffer,
+                                   time_t date,
+                                   int tags_count, const char **tags,
+                                   int displayed, int highlight,
+                                   const char *prefix, const char *message)
+{
+    struct t_plugin_script *script;
+    struct t_plugin_script_async_event *event;
+    struct t_weechat_plugin *weechat_plugin;
+    const char *ptr_function, *ptr_data;
+    char str_date[64];
+    int *ptr_int;
+
+    /* make C compiler happy */
+    (void) tags_count;
+
+    script = (struct t_plugin_script *)pointer;
+    if (!script->async)
+        return WEECHAT_RC_ERROR;
+    weechat_plugin = script->async->plugin;
+
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+    if (!ptr_function || !ptr_function[0])
+        return WEECHAT_RC_ERROR;
+
+    event = plugin_script_async_event_new (ptr_function, "ssssiiss");
+    if (!event)
+        return WEECHAT_RC_ERROR;
+
+    snprintf (str_date, sizeof (str_date), "%lld", (long long)date);
+
+    event->argv[0] = strdup ((ptr_data) ? ptr_data : "");
+    event->argv[1] = strdup (plugin_script_ptr2str (buffer));
+    event->argv[2] = strdup (str_date);
+    event->argv[3] = weechat_string_rebuild_split_string (tags, ",", 0, -1);
+    if (!event->argv[3])
+        event->argv[3] = strdup ("");
+    ptr_int = malloc (sizeof (*ptr_int));
+    if (ptr_int)
+        *ptr_int = displayed;
+    event->argv[4] = ptr_int;
+    ptr_int = malloc (sizeof (*ptr_int));
+    if (ptr_int)
+        *ptr_int = highlight;
+    event->argv[5] = ptr_int;
+    event->argv[6] = strdup ((prefix) ? prefix : "");
+    event->argv[7] = strdup ((message) ? message : "");
+
+    if (!event->argv[4] || !event->argv[5])
+    {
+        plugin_script_async_event_free (event);
+        return WEECHAT_RC_ERROR;
+    }
+
+    plugin_script_async_event_add (script->async, event);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Callback for line hooks with an async function: queues an event with a
+ * copy of the line (the line can not be changed by the callback).
+ */
+
+struct t_hashtable *
+plugin_script_async_hook_line_cb (const void *pointer, void *data,
+                                  struct t_hashtable *line)
+{
+    struct t_plugin_script *script;
+    struct t_plugin_script_async_event *event;
+    const char *ptr_function, *ptr_data;
+
+    script = (struct t_plugin_script *)pointer;
+    if (!script->async)
+        return NULL;
+
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+    if (!ptr_function || !ptr_function[0])
+        return NULL;
+
+    event = plugin_script_async_event_new (ptr_function, "sh");
+    if (!event)
+        return NULL;
+
+    event->argv[0] = strdup ((ptr_data) ? ptr_data : "");
+    event->argv[1] = plugin_script_async_hashtable_to_array (
+        script->async->plugin, line);
+
+    if (!event->argv[1])
+    {
+        plugin_script_async_event_free (event);
+        return NULL;
+    }
+
+    plugin_script_async_event_add (script->async, event);
+
+    return NULL;
+}
+
+/*
+ * Callback for signal hooks with an async function: queues an event with
+ * same arguments as the callback of language plugin (the return code of
+ * function is ignored, so the signal can not be eaten).
+ */
+
+int
+plugin_script_async_hook_signal_cb (const void *pointer, void *data,
+                                    const char *signal,
+                                    const char *type_data,
+                                    void *signal_data)
+{
+    struct t_plugin_script *script;
+    struct t_plugin_script_async_event *event;
+    const char *ptr_function, *ptr_data, *ptr_signal_data;
+    char str_value[64];
+
+    script = (struct t_plugin_script *)pointer;
+    if (!script->async)
+        return WEECHAT_RC_ERROR;
+
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+    if (!ptr_function || !ptr_function[0])
+        return WEECHAT_RC_ERROR;
+
+    event = plugin_script_async_event_new (ptr_function, "sss");
+    if (!event)
+        return WEECHAT_RC_ERROR;
+
+    if (strcmp (type_data, WEECHAT_HOOK_SIGNAL_STRING) == 0)
+    {
+        ptr_signal_data = (signal_data) ? (const char *)signal_data : "";
+    }
+    else if (strcmp (type_data, WEECHAT_HOOK_SIGNAL_INT) == 0)
+    {
+        str_value[0] = '\0';
+        if (signal_data)
+        {
+            snprintf (str_value, sizeof (str_value),
+                      "%d", *((int *)signal_data));
+        }
+        ptr_signal_data = str_value;
+    }
+    else if (strcmp (type_data, WEECHAT_HOOK_SIGNAL_POINTER) == 0)
+    {
+        ptr_signal_data = plugin_script_ptr2str (signal_data);
+    }
+    else
+        ptr_signal_data = "";
+
+    event->argv[0] = strdup ((ptr_data) ? ptr_data : "");
+    event->argv[1] = strdup ((signal) ? signal : "");
+    event->argv[2] = strdup (ptr_signal_data);
+
+    plugin_script_async_event_add (script->async, event);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Stops the thread of a script: events not yet executed are dropped, and
+ * the function waits for the end of callback running (if any).
+ *
+ * This function must be called in main thread; the language plugin must
+ * release any lock needed by the script thread before calling this function
+ * (for example the GIL in python).
+ */
+
+void
+plugin_script_async_stop (struct t_plugin_script *script)
+{
+    struct t_plugin_script_async *async;
+
+    if (!script || !script->async)
+        return;
+
+    async = script->async;
+
+    if (!async->thread_running)
+        return;
+
+    pthread_mutex_lock (&async->mutex);
+    async->quit = 1;
+    pthread_cond_signal (&async->cond);
+    pthread_mutex_unlock (&async->mutex);
+
+    pthread_join (async->thread, NULL);
+
+    pthread_mutex_lock (&async->data->mutex);
+    async->thread_running = 0;
+    async->data->count--;
+    pthread_mutex_unlock (&async->data->mutex);
+}
+
+/*
+ * Frees async data of a script (the thread is stopped if needed).
+ *
+ * This function must be called in main thread.
+ */
+
+void
+plugin_script_async_free (struct t_weechat_plugin *weechat_plugin,
+                          struct t_plugin_script *script)
+{
+    struct t_plugin_script_async *async;
+    struct t_plugin_script_async_event *ptr_event, *next_event;
+    struct t_plugin_script_async_action *ptr_action, *next_action;
+
+    if (!script || !script->async)
+        return;
+
+    async = script->async;
+
+    plugin_script_async_stop (script);
+
+    if (async->hook_fd_actions)
+        weechat_unhook (async->hook_fd_actions);
+
+    /* remove async data from list */
+    pthread_mutex_lock (&async->data->mutex);
+    if (async->prev_async)
+        (async->prev_async)->next_async = async->next_async;
+    if (async->next_async)
+        (async->next_async)->prev_async = async->prev_async;
+    if (async->data->asyncs == async)
+        async->data->asyncs = async->next_async;
+    pthread_mutex_unlock (&async->data->mutex);
+
+    /* free events and actions not executed */
+    ptr_event = async->events;
+    while (ptr_event)
+    {
+        next_event = ptr_event->next_event;
+        plugin_script_async_event_free (ptr_event);
+        ptr_event = next_event;
+    }
+    ptr_action = async->actions;
+    while (ptr_action)
+    {
+        next_action = ptr_action->next_action;
+        plugin_script_async_action_free (ptr_action);
+        ptr_action = next_action;
+    }
+
+    close (async->pipe_actions[0]);
+    close (async->pipe_actions[1]);
+    weechat_string_dyn_free (async->buffer_output, 1);
+    pthread_mutex_destroy (&async->mutex);
+    pthread_cond_destroy (&async->cond);
+
+    free (async);
+
+    script->async = NULL;
+}
+
+/*
+ * Prints async data of a script in WeeChat log file (usually for crash dump).
+ */
+
+void
+plugin_script_async_print_log (struct t_weechat_plugin *weechat_plugin,
+                               struct t_plugin_script *script)
+{
+    struct t_plugin_script_async *async;
+
+    if (!script || !script->async)
+        return;
+
+    async = script->async;
+
+    weechat_log_printf ("    quit. . . . . . . : %d",    async->quit);
+    weechat_log_printf ("    thread_running. . : %d",    async->thread_running);
+    weechat_log_printf ("    events. . . . . . : 0x%lx", async->events);
+    weechat_log_printf ("    last_event. . . . : 0x%lx", async->last_event);
+    weechat_log_printf ("    events_count. . . : %d",    async->events_count);
+    weechat_log_printf ("    actions . . . . . : 0x%lx", async->actions);
+    weechat_log_printf ("    last_action . . . : 0x%lx", async->last_action);
+    weechat_log_printf ("    pipe_actions. . . : %d, %d",
+                        async->pipe_actions[0], async->pipe_actions[1]);
+    weechat_log_printf ("    hook_fd_actions . : 0x%lx", async->hook_fd_actions);
+    weechat_log_printf ("    buffer_output . . : 0x%lx", async->buffer_output);
+    weechat_log_printf ("    events_done . . . : %llu",  async->events_done);
+    weechat_log_printf ("    events_dropped. . : %llu",  async->events_dropped);
+    weechat_log_printf ("    actions_done. . . : %llu",  async->actions_done);
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEECHAT_PLUGIN_PLUGIN_SCRIPT_ASYNC_H
+#define WEECHAT_PLUGIN_PLUGIN_SCRIPT_ASYNC_H
+
+#include <pthread.h>
+#include <time.h>
+
+/* prefix of function name for a callback running in the script thread */
+#define PLUGIN_SCRIPT_ASYNC_PREFIX        "async:"
+#define PLUGIN_SCRIPT_ASYNC_PREFIX_LENGTH 6
+
+/* max number of events waiting for the script thread (others are dropped) */
+#define PLUGIN_SCRIPT_ASYNC_QUEUE_MAX     1024
+
+struct t_plugin_script;
+
+enum t_plugin_script_async_action_type
+{
+    PLUGIN_SCRIPT_ASYNC_ACTION_PRINT = 0,      /* print a message           */
+    PLUGIN_SCRIPT_ASYNC_ACTION_PRINT_DATE_TAGS, /* print with date/tags     */
+    PLUGIN_SCRIPT_ASYNC_ACTION_COMMAND,        /* execute a command         */
+    /* number of action types */
+    PLUGIN_SCRIPT_ASYNC_NUM_ACTIONS,
+};
+
+/*
+ * An event is a call of a script function, queued by main thread and
+ * executed in the script thread; arguments are copied, according to format:
+ *   's': string (char *, can be NULL)
+ *   'i': integer (int *)
+ *   'h': hashtable, as an array of keys/values (char **, NULL-terminated)
+ */
+
+struct t_plugin_script_async_event
+{
+    char *function;                    /* name of script function           */
+    char *format;                      /* format of arguments               */
+    void **argv;                       /* arguments                         */
+    struct t_plugin_script_async_event *next_event; /* next event in queue  */
+};
+
+/*
+ * An action is a call to WeeChat API made by the script thread, queued and
+ * executed later in main thread.
+ */
+
+struct t_plugin_script_async_action
+{
+    enum t_plugin_script_async_action_type type; /* type of action          */
+    char *buffer;                      /* buffer pointer (as string)        */
+    time_t date;                       /* date (for print_date_tags)        */
+    char *tags;                        /* tags (for print_date_tags)        */
+    char *text;                        /* message or command                */
+    struct t_plugin_script_async_action *next_action; /* next action        */
+};
+
+struct t_plugin_script_async
+{
+    struct t_weechat_plugin *plugin;   /* plugin (language)                 */
+    struct t_plugin_script_async_data *data; /* async data of plugin        */
+    struct t_plugin_script *script;    /* script                            */
+    pthread_t thread;                  /* thread running script callbacks   */
+    pthread_mutex_t mutex;             /* mutex for queues and counters     */
+    pthread_cond_t cond;               /* signaled when an event is queued  */
+    int quit;                          /* 1 if the thread must stop         */
+    int thread_running;                /* 1 if the thread has been created  */
+    struct t_plugin_script_async_event *events;      /* queue of events     */
+    struct t_plugin_script_async_event *last_event;  /* last event          */
+    int events_count;                  /* number of events in queue         */
+    struct t_plugin_script_async_action *actions;     /* queue of actions   */
+    struct t_plugin_script_async_action *last_action; /* last action        */
+    int pipe_actions[2];               /* pipe to wake up main thread       */
+    struct t_hook *hook_fd_actions;    /* hook on pipe (in main thread)     */
+    char **buffer_output;              /* stdout/stderr of script thread    */
+    unsigned long long events_done;    /* number of events executed         */
+    unsigned long long events_dropped; /* events dropped (queue full)       */
+    unsigned long long actions_done;   /* number of actions executed        */
+    struct t_plugin_script_async *prev_async; /* link to previous async     */
+    struct t_plugin_script_async *next_async; /* link to next async         */
+};
+
+/*
+ * Functions given by the language plugin: they are called in the script
+ * thread (thread_start is called first, thread_end last).
+ */
+
+struct t_plugin_script_async_callbacks
+{
+    void *(*thread_start)(struct t_plugin_script *script);
+    void (*exec)(struct t_plugin_script *script, void *thread_data,
+                 struct t_plugin_script_async_event *event);
+    void (*thread_end)(struct t_plugin_script *script, void *thread_data);
+};
+
+/* async data of a language plugin (one per plugin, shared by its scripts) */
+
+struct t_plugin_script_async_data
+{
+    struct t_plugin_script_async_callbacks *callbacks; /* NULL = no async   */
+    pthread_t main_thread;             /* main thread of WeeChat            */
+    int count;                         /* number of script threads running  */
+    struct t_plugin_script_async *asyncs; /* async data of scripts          */
+    pthread_mutex_t mutex;             /* mutex for list and counter        */
+};
+
+extern void plugin_script_async_init (struct t_plugin_script_async_data *async_data,
+                                      struct t_plugin_script_async_callbacks *callbacks);
+extern void plugin_script_async_end (struct t_plugin_script_async_data *async_data);
+extern int plugin_script_async_supported (struct t_plugin_script *script);
+extern int plugin_script_async_is_async_function (const char *function);
+extern struct t_plugin_script *plugin_script_async_current_script (struct t_plugin_script_async_data *async_data);
+extern struct t_plugin_script_async *plugin_script_async_start (struct t_weechat_plugin *weechat_plugin,
+                                                                struct t_plugin_script *script);
+extern int plugin_script_async_hook_print_cb (const void *pointer, void *data,
+                                              struct t_gui_buffer *buffer,
+                                              time_t date,
+                                              int tags_count,
+                                              const char **tags,
+                                              int displayed, int highlight,
+                                              const char *prefix,
+                                              const char *message);
+extern struct t_hashtable *plugin_script_async_hook_line_cb (const void *pointer,
+                                                             void *data,
+                                                             struct t_hashtable *line);
+extern int plugin_script_async_hook_signal_cb (const void *pointer, void *data,
+                                               const char *signal,
+                                               const char *type_data,
+                                               void *signal_data);
+extern void plugin_script_async_action_add (struct t_plugin_script *script,
+                                            enum t_plugin_script_async_action_type type,
+                                            const char *buffer,
+                                            time_t date,
+                                            const char *tags,
+                                            const char *text);
+extern void plugin_script_async_printf (struct t_plugin_script *script,
+                                        const char *format, ...);
+extern void plugin_script_async_stop (struct t_plugin_script *script);
+extern void plugin_script_async_free (struct t_weechat_plugin *weechat_plugin,
+                                      struct t_plugin_script *script);
+extern void plugin_script_async_print_log (struct t_weechat_plugin *weechat_plugin,
+                                           struct t_plugin_script *script);
+
+#endif /* WEECHAT_PLUGIN_PLUGIN_SCRIPT_ASYNC_H */
@@ -34,6 +34,7 @@
 #include "weechat-plugin.h"
 #include "plugin-script.h"
 #include "plugin-script-config.h"
+#include "plugin-script-async.h"
 
 
 /*
@@ -448,6 +449,83 @@ plugin_script_get_function_and_data (void *callback_data,
     }
 }
 
+/*
+ * Gets a callable resolved by the language plugin for a function of a script
+ * (the callable is resolved once with the function name, then kept in a
+ * cache until the script is unloaded).
+ *
+ * Returns pointer to callable, NULL if not found in cache.
+ */
+
+void *
+plugin_script_callable_get (struct t_weechat_plugin *weechat_plugin,
+                            struct t_plugin_script *script,
+                            const char *function)
+{
+    if (!script || !script->callables || !function)
+        return NULL;
+
+    return weechat_hashtable_get (script->callables, function);
+}
+
+/*
+ * Adds a callable resolved by the language plugin for a function of a script
+ * in the cache of callables.
+ *
+ * Argument "callback_free" is called to free the callable when the cache is
+ * freed (can be NULL).
+ */
+
+void
+plugin_script_callable_set (struct t_weechat_plugin *weechat_plugin,
+                            struct t_plugin_script *script,
+                            const char *function,
+                            void *callable,
+                            void (*callback_free)(struct t_hashtable *hashtable,
+                                                  const void *key,
+                                                  void *value))
+{
+    if (!script || !function || !callable)
+        return;
+
+    if (!script->callables)
+    {
+        script->callables = weechat_hashtable_new (32,
+                                                   WEECHAT_HASHTABLE_STRING,
+                                                   WEECHAT_HASHTABLE_POINTER,
+                                                   NULL, NULL);
+        if (!script->callables)
+            return;
+        if (callback_free)
+        {
+            weechat_hashtable_set_pointer (script->callables,
+                                           "callback_free_value",
+                                           callback_free);
+        }
+    }
+
+    weechat_hashtable_set (script->callables, function, callable);
+}
+
+/*
+ * Frees the cache of callables of a script.
+ *
+ * The language plugin must call this function before its interpreter is
+ * destroyed if the callables are objects of the interpreter; otherwise the
+ * cache is freed when the script is removed.
+ */
+
+void
+plugin_script_callables_free (struct t_weechat_plugin *weechat_plugin,
+                              struct t_plugin_script *script)
+{
+    if (!script || !script->callables)
+        return;
+
+    weechat_hashtable_free (script->callables);
+    script->callables = NULL;
+}
+
 /*
  * Auto-loads all scripts in a directory.
  */
@@ -716,6 +794,9 @@ plugin_script_alloc (const char *filename, const char *name,
         strdup (shutdown_func) : NULL;
     new_script->charset = (charset) ? strdup (charset) : NULL;
     new_script->unloading = 0;
+    new_script->callables = NULL;
+    new_script->async_data = NULL;
+    new_script->async = NULL;
     new_script->prev_script = NULL;
     new_script->next_script = NULL;
 
@@ -769,6 +850,8 @@ plugin_script_add (struct t_weechat_plugin *weechat_plugin,
         return NULL;
     }
 
+    new_script->async_data = plugin_data->async_data;
+
     /* add script to the list (except the internal "eval" fake script) */
     if (strcmp (new_script->name, WEECHAT_SCRIPT_EVAL_NAME) != 0)
     {
@@ -1055,6 +1138,11 @@ plugin_script_remove (struct t_weechat_plugin *weechat_plugin,
     /* remove all hooks created by this script */
     weechat_unhook_all (script->name);
 
+    /* stop thread of script (hooks are removed, no more events queued) */
+    plugin_script_async_free (weechat_plugin, script);
+
+    plugin_script_callables_free (weechat_plugin, script);
+
     /* remove script from list */
     if (script->prev_script)
         (script->prev_script)->next_script = script->next_script;
@@ -1549,6 +1637,8 @@ plugin_script_display_list (struct t_weechat_plugin *weechat_plugin,
                             const char *name, int full)
 {
     struct t_plugin_script *ptr_script;
+    unsigned long long events_done, events_dropped;
+    int events_count;
 
     weechat_printf (NULL, "");
     weechat_printf (NULL,
@@ -1578,6 +1668,20 @@ plugin_script_display_list (struct t_weechat_plugin *weechat_plugin,
                                     _("    written by \"%s\", license: %s"),
                                     ptr_script->author,
                                     ptr_script->license);
+                    if (ptr_script->async)
+                    {
+                        /* counters are copied: printf may queue events */
+                        pthread_mutex_lock (&ptr_script->async->mutex);
+                        events_count = ptr_script->async->events_count;
+                        events_done = ptr_script->async->events_done;
+                        events_dropped = ptr_script->async->events_dropped;
+                        pthread_mutex_unlock (&ptr_script->async->mutex);
+                        weechat_printf (
+                            NULL,
+                            _("    async callbacks: %d queued, %llu done, "
+                              "%llu dropped"),
+                            events_count, events_done, events_dropped);
+                    }
                 }
             }
         }
@@ -1824,8 +1928,15 @@ plugin_script_print_log (struct t_weechat_plugin *weechat_plugin,
         weechat_log_printf ("  shutdown_func . . . : '%s'",  ptr_script->shutdown_func);
         weechat_log_printf ("  charset . . . . . . : '%s'",  ptr_script->charset);
         weechat_log_printf ("  unloading . . . . . : %d",    ptr_script->unloading);
+        weechat_log_printf ("  callables . . . . . : 0x%lx (%d)",
+                            ptr_script->callables,
+                            weechat_hashtable_get_integer (ptr_script->callables,
+                                                           "items_count"));
+        weechat_log_printf ("  async_data. . . . . : 0x%lx", ptr_script->async_data);
+        weechat_log_printf ("  async . . . . . . . : 0x%lx", ptr_script->async);
         weechat_log_printf ("  prev_script . . . . : 0x%lx", ptr_script->prev_script);
         weechat_log_printf ("  next_script . . . . : 0x%lx", ptr_script->next_script);
+        plugin_script_async_print_log (weechat_plugin, ptr_script);
     }
 
     weechat_log_printf ("");
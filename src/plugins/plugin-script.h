@@ -20,6 +20,9 @@
 #ifndef WEECHAT_PLUGIN_PLUGIN_SCRIPT_H
 #define WEECHAT_PLUGIN_PLUGIN_SCRIPT_H
 
+struct t_plugin_script_async;
+struct t_plugin_script_async_data;
+
 /* constants which defines return types for weechat_<lang>_exec functions */
 
 enum t_weechat_script_exec_type
@@ -66,6 +69,10 @@ struct t_plugin_script
     char *shutdown_func;                 /* function when script is unloaded*/
     char *charset;                       /* script charset                  */
     int unloading;                       /* script is being unloaded        */
+    struct t_hashtable *callables;       /* callables resolved by language  */
+                                         /* (key: function name)            */
+    struct t_plugin_script_async_data *async_data; /* async data of plugin  */
+    struct t_plugin_script_async *async; /* thread for async callbacks      */
     struct t_plugin_script *prev_script; /* link to previous script         */
     struct t_plugin_script *next_script; /* link to next script             */
 };
@@ -78,6 +85,7 @@ struct t_plugin_script_data
     struct t_config_option **config_look_eval_keep_context;
     struct t_plugin_script **scripts;
     struct t_plugin_script **last_script;
+    struct t_plugin_script_async_data *async_data;
 
     /* callbacks */
     int (*callback_command) (const void *pointer, void *data,
@@ -130,6 +138,18 @@ extern char *plugin_script_build_function_and_data (const char *function,
 extern void plugin_script_get_function_and_data (void *callback_data,
                                                  const char **function,
                                                  const char **data);
+extern void *plugin_script_callable_get (struct t_weechat_plugin *weechat_plugin,
+                                         struct t_plugin_script *script,
+                                         const char *function);
+extern void plugin_script_callable_set (struct t_weechat_plugin *weechat_plugin,
+                                        struct t_plugin_script *script,
+                                        const char *function,
+                                        void *callable,
+                                        void (*callback_free)(struct t_hashtable *hashtable,
+                                                              const void *key,
+                                                              void *value));
+extern void plugin_script_callables_free (struct t_weechat_plugin *weechat_plugin,
+                                          struct t_plugin_script *script);
 extern void plugin_script_auto_load (struct t_weechat_plugin *weechat_plugin,
                                      void (*callback)(void *data,
                                                       const char *filename));
@@ -47,6 +47,7 @@
 #include "../core/wee-list.h"
 #include "../core/wee-log.h"
 #include "../core/wee-network.h"
+#include "../core/wee-pool.h"
 #include "../core/wee-string.h"
 #include "../core/wee-upgrade-file.h"
 #include "../core/wee-utf8.h"
@@ -713,6 +714,11 @@ plugin_load (const char *filename, int init_plugin, int argc, char **argv)
         new_plugin->arraylist_clear = arraylist_clear;
         new_plugin->arraylist_free = arraylist_free;
 
+        new_plugin->pool_new = &pool_new;
+        new_plugin->pool_alloc = &pool_alloc;
+        new_plugin->pool_release = &pool_release;
+        new_plugin->pool_free = &pool_free;
+
         new_plugin->hashtable_new = &hashtable_new;
         new_plugin->hashtable_set_with_size = &hashtable_set_with_size;
         new_plugin->hashtable_set = &hashtable_set;
@@ -1197,6 +1203,9 @@ plugin_remove (struct t_weechat_plugin *plugin)
     /* remove all bar items */
     gui_bar_item_free_all_plugin (plugin);
 
+    /* remove all pools */
+    pool_free_all_plugin (plugin);
+
     /* free data */
     if (plugin->filename)
         free (plugin->filename);
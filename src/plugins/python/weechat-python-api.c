@@ -29,6 +29,7 @@
 #include "../weechat-plugin.h"
 #include "../plugin-script.h"
 #include "../plugin-script-api.h"
+#include "../plugin-script-async.h"
 #include "weechat-python.h"
 
 
@@ -39,8 +40,21 @@
     weechat_python_api_##__name (PyObject *self, PyObject *args)
 #define API_INIT_FUNC(__init, __name, __ret)                            \
     char *python_function_name = __name;                                \
+    struct t_plugin_script *python_async_script =                       \
+        plugin_script_async_current_script (&python_async_data);        \
     (void) self;                                                        \
-    if (__init                                                          \
+    if (python_async_script                                             \
+        && !weechat_python_api_async_allowed (python_function_name))    \
+    {                                                                   \
+        plugin_script_async_printf (                                    \
+            python_async_script,                                        \
+            weechat_gettext ("%s%s: function \"%s\" can not be called " \
+                             "in an async callback (script: %s)"),      \
+            weechat_prefix ("error"), weechat_python_plugin->name,      \
+            python_function_name, python_async_script->name);           \
+        __ret;                                                          \
+    }                                                                   \
+    if (__init && !python_async_script                                  \
         && (!python_current_script || !python_current_script->name))    \
     {                                                                   \
         WEECHAT_SCRIPT_MSG_NOT_INIT(PYTHON_CURRENT_SCRIPT_NAME,         \
@@ -49,8 +63,20 @@
     }
 #define API_WRONG_ARGS(__ret)                                           \
     {                                                                   \
-        WEECHAT_SCRIPT_MSG_WRONG_ARGS(PYTHON_CURRENT_SCRIPT_NAME,       \
-                                      python_function_name);            \
+        if (python_async_script)                                        \
+        {                                                               \
+            plugin_script_async_printf (                                \
+                python_async_script,                                    \
+                weechat_gettext ("%s%s: wrong arguments for function "  \
+                                 "\"%s\" (script: %s)"),                \
+                weechat_prefix ("error"), weechat_python_plugin->name,  \
+                python_function_name, python_async_script->name);       \
+        }                                                               \
+        else                                                            \
+        {                                                               \
+            WEECHAT_SCRIPT_MSG_WRONG_ARGS(PYTHON_CURRENT_SCRIPT_NAME,   \
+                                          python_function_name);        \
+        }                                                               \
         __ret;                                                          \
     }
 #define API_PTR2STR(__pointer)                                          \
@@ -82,6 +108,24 @@
     return PyLong_FromLong(__long)
 
 
+/*
+ * Checks if a function can be called in an async callback (script thread):
+ * only functions to print messages and execute commands are allowed, they
+ * are executed later in main thread.
+ *
+ * Returns:
+ *   1: function can be called in an async callback
+ *   0: function can not be called in an async callback
+ */
+
+int
+weechat_python_api_async_allowed (const char *function)
+{
+    return ((strcmp (function, "prnt") == 0)
+            || (strcmp (function, "prnt_date_tags") == 0)
+            || (strcmp (function, "command") == 0)) ? 1 : 0;
+}
+
 /*
  * Registers a python script.
  */
@@ -1891,6 +1935,14 @@ API_FUNC(prnt)
     if (!PyArg_ParseTuple (args, "ss", &buffer, &message))
         API_WRONG_ARGS(API_RETURN_ERROR);
 
+    if (python_async_script)
+    {
+        plugin_script_async_action_add (python_async_script,
+                                        PLUGIN_SCRIPT_ASYNC_ACTION_PRINT,
+                                        buffer, 0, NULL, message);
+        API_RETURN_OK;
+    }
+
     plugin_script_api_printf (weechat_python_plugin,
                               python_current_script,
                               API_STR2PTR(buffer),
@@ -1912,6 +1964,14 @@ API_FUNC(prnt_date_tags)
     if (!PyArg_ParseTuple (args, "slss", &buffer, &date, &tags, &message))
         API_WRONG_ARGS(API_RETURN_ERROR);
 
+    if (python_async_script)
+    {
+        plugin_script_async_action_add (python_async_script,
+                                        PLUGIN_SCRIPT_ASYNC_ACTION_PRINT_DATE_TAGS,
+                                        buffer, (time_t)date, tags, message);
+        API_RETURN_OK;
+    }
+
     plugin_script_api_printf_date_tags (weechat_python_plugin,
                                         python_current_script,
                                         API_STR2PTR(buffer),
@@ -4292,6 +4352,15 @@ API_FUNC(command)
     if (!PyArg_ParseTuple (args, "ss", &buffer, &command))
         API_WRONG_ARGS(API_RETURN_INT(WEECHAT_RC_ERROR));
 
+    /* in an async callback, the command is executed later in main thread */
+    if (python_async_script)
+    {
+        plugin_script_async_action_add (python_async_script,
+                                        PLUGIN_SCRIPT_ASYNC_ACTION_COMMAND,
+                                        buffer, 0, NULL, command);
+        API_RETURN_INT(WEECHAT_RC_OK);
+    }
+
     rc = plugin_script_api_command (weechat_python_plugin,
                                     python_current_script,
                                     API_STR2PTR(buffer),
@@ -31,6 +31,7 @@
 
 #include "../weechat-plugin.h"
 #include "../plugin-script.h"
+#include "../plugin-script-async.h"
 #include "weechat-python.h"
 #include "weechat-python-api.h"
 
@@ -74,6 +75,16 @@ const char *python_current_script_filename = NULL;
 PyThreadState *python_mainThreadState = NULL;
 PyThreadState *python_current_interpreter = NULL;
 char **python_buffer_output = NULL;
+int python_gil_depth = 0;              /* number of nested calls to python  */
+int python_gil_released = 0;           /* 1 if GIL released by main thread  */
+struct t_plugin_script_async_data python_async_data;
+struct t_plugin_script_async_callbacks python_async_callbacks;
+PyThreadState *python_async_interpreter = NULL; /* interpreter of script   */
+                                       /* running in a script thread        */
+int python_async_main_waiting = 0;     /* 1 if main thread waits for GIL    */
+pthread_mutex_t python_async_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t python_async_cond = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t python_async_exec_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /* outputs subroutines */
 static PyObject *weechat_python_output (PyObject *self, PyObject *args);
@@ -214,6 +225,35 @@ weechat_python_hashtable_to_dict (struct t_hashtable *hashtable)
     return dict;
 }
 
+/*
+ * Converts an array of keys/values (NULL-terminated) to a python dictionary.
+ */
+
+PyObject *
+weechat_python_array_to_dict (char **array)
+{
+    PyObject *dict;
+    char **ptr_array;
+
+    dict = PyDict_New ();
+    if (!dict)
+    {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+
+    if (array)
+    {
+        for (ptr_array = array; ptr_array[0] && ptr_array[1]; ptr_array += 2)
+        {
+            weechat_python_hashtable_map_cb (dict, NULL,
+                                             ptr_array[0], ptr_array[1]);
+        }
+    }
+
+    return dict;
+}
+
 /*
  * Converts a python dictionary to a WeeChat hashtable.
  *
@@ -290,10 +330,29 @@ weechat_python_dict_to_hashtable (PyObject *dict, int size,
 void
 weechat_python_output_flush ()
 {
+    struct t_plugin_script *async_script;
     const char *ptr_command;
     char *temp_buffer, *command;
     int length;
 
+    /* script thread: the message is printed later by main thread */
+    async_script = plugin_script_async_current_script (&python_async_data);
+    if (async_script)
+    {
+        if (*async_script->async->buffer_output[0])
+        {
+            plugin_script_async_printf (
+                async_script,
+                weechat_gettext ("%s: stdout/stderr (%s): %s"),
+                PYTHON_PLUGIN_NAME,
+                async_script->name,
+                *async_script->async->buffer_output);
+            weechat_string_dyn_copy (async_script->async->buffer_output,
+                                     NULL);
+        }
+        return;
+    }
+
     if (!*python_buffer_output[0])
         return;
 
@@ -359,13 +418,19 @@ weechat_python_output_flush ()
 static PyObject *
 weechat_python_output (PyObject *self, PyObject *args)
 {
-    char *msg, *ptr_msg, *ptr_newline;
+    struct t_plugin_script *async_script;
+    char *msg, *ptr_msg, *ptr_newline, **buffer_output;
 
     /* make C compiler happy */
     (void) self;
 
     msg = NULL;
 
+    /* each script thread has its own output */
+    async_script = plugin_script_async_current_script (&python_async_data);
+    buffer_output = (async_script) ?
+        async_script->async->buffer_output : python_buffer_output;
+
     if (!PyArg_ParseTuple (args, "s", &msg))
     {
         weechat_python_output_flush ();
@@ -375,19 +440,199 @@ weechat_python_output (PyObject *self, PyObject *args)
         ptr_msg = msg;
         while ((ptr_newline = strchr (ptr_msg, '\n')) != NULL)
         {
-            weechat_string_dyn_concat (python_buffer_output,
+            weechat_string_dyn_concat (buffer_output,
                                        ptr_msg,
                                        ptr_newline - ptr_msg);
             weechat_python_output_flush ();
             ptr_msg = ++ptr_newline;
         }
-        weechat_string_dyn_concat (python_buffer_output, ptr_msg, -1);
+        weechat_string_dyn_concat (buffer_output, ptr_msg, -1);
     }
 
     Py_INCREF(Py_None);
     return Py_None;
 }
 
+/*
+ * Frees a python object in cache of callables of a script.
+ */
+
+void
+weechat_python_callable_free_cb (struct t_hashtable *hashtable,
+                                 const void *key, void *value)
+{
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    Py_XDECREF((PyObject *)value);
+}
+
+/*
+ * Gets python string object (interned) with a name, used to look up a
+ * function or a module: the object is created only on first call, then kept
+ * in cache of callables of script (so its hash is computed only once).
+ *
+ * The interpreter of script must be the current one.
+ *
+ * Returns a borrowed reference, NULL if error.
+ */
+
+PyObject *
+weechat_python_get_name_object (struct t_plugin_script *script,
+                                const char *name)
+{
+    PyObject *name_object;
+
+    name_object = (PyObject *)plugin_script_callable_get (
+        weechat_python_plugin, script, name);
+    if (name_object)
+        return name_object;
+
+    name_object = PyUnicode_InternFromString (name);
+    if (!name_object)
+    {
+        PyErr_Clear ();
+        return NULL;
+    }
+
+    plugin_script_callable_set (weechat_python_plugin, script, name,
+                                name_object,
+                                &weechat_python_callable_free_cb);
+
+    /* if the object could not be added in cache, it is not freed */
+    if (plugin_script_callable_get (weechat_python_plugin,
+                                    script, name) != name_object)
+    {
+        Py_DECREF(name_object);
+        return NULL;
+    }
+
+    return name_object;
+}
+
+/*
+ * Calls a python function with arguments (new references, they are released
+ * by this function).
+ *
+ * Returns the value returned by the function (new reference), NULL if error.
+ */
+
+PyObject *
+weechat_python_call (PyObject *function, PyObject **args, int argc)
+{
+    PyObject *rc;
+#if PY_VERSION_HEX < 0x03090000
+    PyObject *tuple;
+#endif /* PY_VERSION_HEX < 0x03090000 */
+    int i;
+
+#if PY_VERSION_HEX >= 0x03090000
+    /* vectorcall: no tuple built for arguments */
+    rc = PyObject_Vectorcall (function, args, argc, NULL);
+    for (i = 0; i < argc; i++)
+    {
+        Py_DECREF(args[i]);
+    }
+#else
+    tuple = PyTuple_New (argc);
+    if (!tuple)
+    {
+        for (i = 0; i < argc; i++)
+        {
+            Py_DECREF(args[i]);
+        }
+        return NULL;
+    }
+    /* the tuple steals references to arguments */
+    for (i = 0; i < argc; i++)
+    {
+        PyTuple_SET_ITEM(tuple, i, args[i]);
+    }
+    rc = PyObject_CallObject (function, tuple);
+    Py_DECREF(tuple);
+#endif /* PY_VERSION_HEX >= 0x03090000 */
+
+    return rc;
+}
+
+/*
+ * Acquires the GIL in main thread, if it has been released for script
+ * threads; this function must be called before any call to python in main
+ * thread.
+ */
+
+void
+weechat_python_gil_acquire ()
+{
+    PyThreadState *thread_state;
+
+    if (python_gil_released)
+    {
+        /*
+         * if a script thread is running python code, the GIL is requested
+         * with a thread state of same interpreter, otherwise the script
+         * thread is not asked to release the GIL; this interpreter can not
+         * change while main thread is waiting: script threads run python
+         * one at a time, and no script thread starts while main thread is
+         * waiting (see function weechat_python_async_gil_acquire)
+         */
+        pthread_mutex_lock (&python_async_mutex);
+        python_async_main_waiting = 1;
+        thread_state = python_async_interpreter;
+        pthread_mutex_unlock (&python_async_mutex);
+
+        PyEval_RestoreThread ((thread_state) ?
+                              thread_state : python_mainThreadState);
+
+        pthread_mutex_lock (&python_async_mutex);
+        python_async_main_waiting = 0;
+        pthread_cond_broadcast (&python_async_cond);
+        pthread_mutex_unlock (&python_async_mutex);
+
+        python_gil_released = 0;
+    }
+    python_gil_depth++;
+}
+
+/*
+ * Releases the GIL in main thread when python is not running any more in
+ * main thread and at least one script thread exists (so that async callbacks
+ * can run while WeeChat is waiting in its main loop).
+ */
+
+void
+weechat_python_gil_release ()
+{
+    python_gil_depth--;
+    if ((python_gil_depth == 0) && (python_async_data.count > 0))
+    {
+        PyThreadState_Swap (python_mainThreadState);
+        (void) PyEval_SaveThread ();
+        python_gil_released = 1;
+    }
+}
+
+/*
+ * Stops the thread of a script (if running), with the GIL released while
+ * waiting for the thread.
+ */
+
+void
+weechat_python_async_stop (struct t_plugin_script *script)
+{
+    PyThreadState *old_interpreter;
+
+    if (!script || !script->async || !script->interpreter)
+        return;
+
+    old_interpreter = PyThreadState_Swap (script->interpreter);
+    Py_BEGIN_ALLOW_THREADS
+    plugin_script_async_stop (script);
+    Py_END_ALLOW_THREADS
+    PyThreadState_Swap (old_interpreter);
+}
+
 /*
  * Executes a python function.
  */
@@ -399,14 +644,15 @@ weechat_python_exec (struct t_plugin_script *script,
 {
     struct t_plugin_script *old_python_current_script;
     PyThreadState *old_interpreter;
-    PyObject *evMain, *evDict, *evFunc, *rc;
-    void *argv2[16], *ret_value, *ret_temp;
-    char format2[17];
+    PyObject *evMain, *evDict, *evFunc, *rc, *name_main, *name_func;
+    PyObject *args[16];
+    void *ret_value, *ret_temp;
     int i, argc, *ret_int;
 
     ret_value = NULL;
 
     /* PyEval_AcquireLock (); */
+    weechat_python_gil_acquire ();
 
     old_python_current_script = python_current_script;
     python_current_script = script;
@@ -418,7 +664,12 @@ weechat_python_exec (struct t_plugin_script *script,
         PyThreadState_Swap (script->interpreter);
     }
 
-    evMain = PyImport_AddModule ((char *) "__main__");
+    name_main = weechat_python_get_name_object (script, "__main__");
+    name_func = weechat_python_get_name_object (script, function);
+    if (!name_main || !name_func)
+        goto end;
+
+    evMain = PyImport_AddModuleObject (name_main);
     /*
      * FIXME: sometimes NULL is returned with nested calls of hook callbacks,
      * to prevent any crash, we just skip execution of the function
@@ -426,7 +677,11 @@ weechat_python_exec (struct t_plugin_script *script,
     if (!evMain)
         goto end;
     evDict = PyModule_GetDict (evMain);
-    evFunc = PyDict_GetItemString (evDict, function);
+    /*
+     * the function is looked up on each call (it may be redefined by the
+     * script), but the name object has a cached hash, so this is fast
+     */
+    evFunc = PyDict_GetItem (evDict, name_func);
 
     if ( !(evFunc && PyCallable_Check (evFunc)) )
     {
@@ -437,65 +692,55 @@ weechat_python_exec (struct t_plugin_script *script,
         goto end;
     }
 
+    argc = 0;
     if (argv && argv[0])
     {
-        argc = strlen (format);
-        for (i = 0; i < 16; i++)
+        for (i = 0; format[i] && (i < 16); i++)
         {
-            if (i < argc)
+            switch (format[i])
             {
-                switch (format[i])
-                {
-                    case 's': /* string or null */
-                        argv2[i] = argv[i];
-                        if (weechat_utf8_is_valid (argv2[i], -1, NULL))
-                            format2[i] = 's';  /* str */
-                        else
-                            format2[i] = 'y';  /* bytes */
-                        break;
-                    case 'i': /* integer */
-                        argv2[i] = PyLong_FromLong ((long)(*((int *)argv[i])));
-                        format2[i] = 'O';
-                        break;
-                    case 'h': /* hash */
-                        argv2[i] = weechat_python_hashtable_to_dict (
-                            (struct t_hashtable *)argv[i]);
-                        format2[i] = 'O';
-                        break;
-                    case 'O': /* object */
-                        argv2[i] = argv[i];
-                        format2[i] = 'O';
+                case 's': /* string or null */
+                    if (!argv[i])
+                    {
+                        Py_INCREF(Py_None);
+                        args[i] = Py_None;
                         break;
-                }
+                    }
+                    /* str if valid UTF-8, otherwise bytes */
+                    args[i] = PyUnicode_DecodeUTF8 (argv[i],
+                                                    strlen (argv[i]),
+                                                    NULL);
+                    if (!args[i])
+                    {
+                        PyErr_Clear ();
+                        args[i] = PyBytes_FromString (argv[i]);
+                    }
+                    break;
+                case 'i': /* integer */
+                    args[i] = PyLong_FromLong ((long)(*((int *)argv[i])));
+                    break;
+                case 'h': /* hash */
+                    args[i] = weechat_python_hashtable_to_dict (
+                        (struct t_hashtable *)argv[i]);
+                    break;
+                case 'O': /* object (reference is given to this function) */
+                    args[i] = (PyObject *)argv[i];
+                    break;
+                default:
+                    args[i] = NULL;
+                    break;
             }
-            else
+            if (!args[i])
             {
-                argv2[i] = NULL;
-                format2[i] = '\0';
+                PyErr_Clear ();
+                Py_INCREF(Py_None);
+                args[i] = Py_None;
             }
-        }
-        format2[argc] = '\0';
-
-        rc = PyObject_CallFunction (evFunc, format2,
-                                    argv2[0], argv2[1],
-                                    argv2[2], argv2[3],
-                                    argv2[4], argv2[5],
-                                    argv2[6], argv2[7],
-                                    argv2[8], argv2[9],
-                                    argv2[10], argv2[11],
-                                    argv2[12], argv2[13],
-                                    argv2[14], argv2[15]);
-
-        for (i = 0; i < argc; i++)
-        {
-            if (argv2[i] && (format2[i] == 'O'))
-                Py_XDECREF((PyObject *)argv2[i]);
+            argc++;
         }
     }
-    else
-    {
-        rc = PyObject_CallFunction (evFunc, NULL);
-    }
+
+    rc = weechat_python_call (evFunc, args, argc);
 
     weechat_python_output_flush ();
 
@@ -599,9 +844,197 @@ end:
     if (old_interpreter)
         PyThreadState_Swap (old_interpreter);
 
+    weechat_python_gil_release ();
+
     return ret_value;
 }
 
+#if PY_VERSION_HEX >= 0x03070000
+/*
+ * Acquires the GIL in a script thread.
+ *
+ * Only one script thread runs python code at a time (so that main thread
+ * knows the interpreter running in script thread), and a script thread does
+ * not start while main thread is waiting for the GIL.
+ *
+ * This function is called in the script thread.
+ */
+
+void
+weechat_python_async_gil_acquire (struct t_plugin_script *script,
+                                  PyThreadState *thread_state)
+{
+    pthread_mutex_lock (&python_async_exec_mutex);
+
+    pthread_mutex_lock (&python_async_mutex);
+    while (python_async_main_waiting)
+    {
+        pthread_cond_wait (&python_async_cond, &python_async_mutex);
+    }
+    python_async_interpreter = script->interpreter;
+    pthread_mutex_unlock (&python_async_mutex);
+
+    PyEval_RestoreThread (thread_state);
+}
+
+/*
+ * Releases the GIL in a script thread; if "delete_thread_state" is 1, the
+ * current thread state is deleted.
+ *
+ * This function is called in the script thread.
+ */
+
+void
+weechat_python_async_gil_release (int delete_thread_state)
+{
+    if (delete_thread_state)
+    {
+        PyThreadState_Clear (PyThreadState_Get ());
+        PyThreadState_DeleteCurrent ();
+    }
+    else
+    {
+        (void) PyEval_SaveThread ();
+    }
+
+    pthread_mutex_lock (&python_async_mutex);
+    python_async_interpreter = NULL;
+    pthread_mutex_unlock (&python_async_mutex);
+
+    pthread_mutex_unlock (&python_async_exec_mutex);
+}
+
+/*
+ * Creates the python thread state of a script thread (in the interpreter of
+ * script).
+ *
+ * This function is called in the script thread.
+ */
+
+void *
+weechat_python_async_thread_start (struct t_plugin_script *script)
+{
+    PyInterpreterState *interp;
+
+    if (!script->interpreter)
+        return NULL;
+
+#if PY_VERSION_HEX >= 0x03090000
+    interp = PyThreadState_GetInterpreter (
+        (PyThreadState *)script->interpreter);
+#else
+    interp = ((PyThreadState *)script->interpreter)->interp;
+#endif /* PY_VERSION_HEX >= 0x03090000 */
+
+    return PyThreadState_New (interp);
+}
+
+/*
+ * Executes a python function in a script thread (async callback): the value
+ * returned by the function is ignored.
+ *
+ * This function is called in the script thread.
+ */
+
+void
+weechat_python_async_exec (struct t_plugin_script *script, void *thread_data,
+                           struct t_plugin_script_async_event *event)
+{
+    PyObject *evMain, *evDict, *evFunc, *rc;
+    PyObject *args[16];
+    int i, argc;
+
+    if (!thread_data)
+        return;
+
+    weechat_python_async_gil_acquire (script, (PyThreadState *)thread_data);
+
+    evMain = PyImport_AddModule ("__main__");
+    evDict = (evMain) ? PyModule_GetDict (evMain) : NULL;
+    evFunc = (evDict) ? PyDict_GetItemString (evDict, event->function) : NULL;
+
+    if (!(evFunc && PyCallable_Check (evFunc)))
+    {
+        PyErr_Clear ();
+        plugin_script_async_printf (
+            script,
+            weechat_gettext ("%s%s: unable to run function \"%s\""),
+            weechat_prefix ("error"), PYTHON_PLUGIN_NAME, event->function);
+        weechat_python_async_gil_release (0);
+        return;
+    }
+
+    argc = 0;
+    for (i = 0; event->format[i] && (i < 16); i++)
+    {
+        switch (event->format[i])
+        {
+            case 's': /* string or null */
+                if (!event->argv[i])
+                {
+                    Py_INCREF(Py_None);
+                    args[i] = Py_None;
+                    break;
+                }
+                /* str if valid UTF-8, otherwise bytes */
+                args[i] = PyUnicode_DecodeUTF8 (event->argv[i],
+                                                strlen (event->argv[i]),
+                                                NULL);
+                if (!args[i])
+                {
+                    PyErr_Clear ();
+                    args[i] = PyBytes_FromString (event->argv[i]);
+                }
+                break;
+            case 'i': /* integer */
+                args[i] = PyLong_FromLong ((long)(*((int *)event->argv[i])));
+                break;
+            case 'h': /* hash (array of keys/values) */
+                args[i] = weechat_python_array_to_dict (
+                    (char **)event->argv[i]);
+                break;
+            default:
+                args[i] = NULL;
+                break;
+        }
+        if (!args[i])
+        {
+            PyErr_Clear ();
+            Py_INCREF(Py_None);
+            args[i] = Py_None;
+        }
+        argc++;
+    }
+
+    rc = weechat_python_call (evFunc, args, argc);
+
+    if (PyErr_Occurred ())
+        PyErr_Print ();
+    Py_XDECREF(rc);
+
+    weechat_python_output_flush ();
+
+    weechat_python_async_gil_release (0);
+}
+
+/*
+ * Deletes the python thread state of a script thread.
+ *
+ * This function is called in the script thread.
+ */
+
+void
+weechat_python_async_thread_end (struct t_plugin_script *script,
+                                 void *thread_data)
+{
+    if (!thread_data)
+        return;
+
+    weechat_python_async_gil_acquire (script, (PyThreadState *)thread_data);
+    weechat_python_async_gil_release (1);
+}
+#endif /* PY_VERSION_HEX >= 0x03070000 */
+
 /*
  * Initializes the "weechat" module.
  */
@@ -754,6 +1187,7 @@ weechat_python_load (const char *filename, const char *code)
     python_registered_script = NULL;
 
     /* PyEval_AcquireLock (); */
+    weechat_python_gil_acquire ();
     python_current_interpreter = Py_NewInterpreter ();
     len = mbstowcs (NULL, argv[0], 0) + 1;
     wargv[0] = malloc ((len + 1) * sizeof (wargv[0][0]));
@@ -778,6 +1212,7 @@ weechat_python_load (const char *filename, const char *code)
         if (fp)
             fclose (fp);
         /* PyEval_ReleaseLock (); */
+        weechat_python_gil_release ();
         return NULL;
     }
 
@@ -848,6 +1283,7 @@ weechat_python_load (const char *filename, const char *code)
             /* if script was registered, remove it from list */
             if (python_current_script)
             {
+                weechat_python_async_stop (python_current_script);
                 plugin_script_remove (weechat_python_plugin,
                                       &python_scripts, &last_python_script,
                                       python_current_script);
@@ -856,6 +1292,7 @@ weechat_python_load (const char *filename, const char *code)
 
             Py_EndInterpreter (python_current_interpreter);
             /* PyEval_ReleaseLock (); */
+            weechat_python_gil_release ();
 
             return NULL;
         }
@@ -878,6 +1315,7 @@ weechat_python_load (const char *filename, const char *code)
             /* if script was registered, remove it from list */
             if (python_current_script)
             {
+                weechat_python_async_stop (python_current_script);
                 plugin_script_remove (weechat_python_plugin,
                                       &python_scripts, &last_python_script,
                                       python_current_script);
@@ -886,6 +1324,7 @@ weechat_python_load (const char *filename, const char *code)
 
             Py_EndInterpreter (python_current_interpreter);
             /* PyEval_ReleaseLock (); */
+            weechat_python_gil_release ();
 
             return NULL;
         }
@@ -906,6 +1345,7 @@ weechat_python_load (const char *filename, const char *code)
             PyErr_Print ();
         Py_EndInterpreter (python_current_interpreter);
         /* PyEval_ReleaseLock (); */
+        weechat_python_gil_release ();
 
         return NULL;
     }
@@ -923,6 +1363,8 @@ weechat_python_load (const char *filename, const char *code)
                                         &weechat_python_api_buffer_input_data_cb,
                                         &weechat_python_api_buffer_close_cb);
 
+    weechat_python_gil_release ();
+
     (void) weechat_hook_signal_send ("python_script_loaded",
                                      WEECHAT_HOOK_SIGNAL_STRING,
                                      python_current_script->filename);
@@ -965,6 +1407,8 @@ weechat_python_unload (struct t_plugin_script *script)
                         PYTHON_PLUGIN_NAME, script->name);
     }
 
+    weechat_python_gil_acquire ();
+
     if (script->shutdown_func && script->shutdown_func[0])
     {
         rc = (int *) weechat_python_exec (script, WEECHAT_SCRIPT_EXEC_INT,
@@ -973,6 +1417,9 @@ weechat_python_unload (struct t_plugin_script *script)
             free (rc);
     }
 
+    /* stop thread of script: pending async callbacks are not executed */
+    weechat_python_async_stop (script);
+
     filename = strdup (script->filename);
     interpreter = script->interpreter;
 
@@ -982,18 +1429,25 @@ weechat_python_unload (struct t_plugin_script *script)
             python_current_script->prev_script : python_current_script->next_script;
     }
 
+    /*
+     * the interpreter of script must be the current one when the script is
+     * removed, so that python objects in cache of callables are released
+     * in this interpreter
+     */
+    if (interpreter)
+        PyThreadState_Swap (interpreter);
+
     plugin_script_remove (weechat_python_plugin, &python_scripts, &last_python_script,
                           script);
 
     if (interpreter)
-    {
-        PyThreadState_Swap (interpreter);
         Py_EndInterpreter (interpreter);
-    }
 
     if (python_current_script)
         PyThreadState_Swap (python_current_script->interpreter);
 
+    weechat_python_gil_release ();
+
     (void) weechat_hook_signal_send ("python_script_unloaded",
                                      WEECHAT_HOOK_SIGNAL_STRING, filename);
     if (filename)
@@ -1538,6 +1992,7 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
     python_data.config_look_eval_keep_context = &python_config_look_eval_keep_context;
     python_data.scripts = &python_scripts;
     python_data.last_script = &last_python_script;
+    python_data.async_data = &python_async_data;
     python_data.callback_command = &weechat_python_command_cb;
     python_data.callback_completion = &weechat_python_completion_cb;
     python_data.callback_hdata = &weechat_python_hdata_cb;
@@ -1548,6 +2003,15 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
     python_data.callback_load_file = &weechat_python_load_cb;
     python_data.unload_all = &weechat_python_unload_all;
 
+#if PY_VERSION_HEX >= 0x03070000
+    python_async_callbacks.thread_start = &weechat_python_async_thread_start;
+    python_async_callbacks.exec = &weechat_python_async_exec;
+    python_async_callbacks.thread_end = &weechat_python_async_thread_end;
+    plugin_script_async_init (&python_async_data, &python_async_callbacks);
+#else
+    plugin_script_async_init (&python_async_data, NULL);
+#endif /* PY_VERSION_HEX >= 0x03070000 */
+
     python_quiet = 1;
     plugin_script_init (weechat_python_plugin, argc, argv, &python_data);
     python_quiet = 0;
@@ -1566,6 +2030,9 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
 int
 weechat_plugin_end (struct t_weechat_plugin *plugin)
 {
+    /* the GIL is kept by main thread until the end */
+    weechat_python_gil_acquire ();
+
     /* unload all scripts */
     python_quiet = 1;
     if (python_script_eval)
@@ -1576,6 +2043,8 @@ weechat_plugin_end (struct t_weechat_plugin *plugin)
     plugin_script_end (plugin, &python_data);
     python_quiet = 0;
 
+    plugin_script_async_end (&python_async_data);
+
     /* free python interpreter */
     if (python_mainThreadState != NULL)
     {
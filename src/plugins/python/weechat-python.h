@@ -31,6 +31,7 @@
 extern struct t_weechat_plugin *weechat_python_plugin;
 
 extern struct t_plugin_script_data python_data;
+extern struct t_plugin_script_async_data python_async_data;
 
 extern int python_quiet;
 extern struct t_plugin_script *python_scripts;
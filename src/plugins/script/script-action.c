@@ -1532,9 +1532,11 @@ script_action_schedule (const char *action,
     {
         if (script_repo_file_is_uptodate ())
         {
-            if (!scripts_repo)
-                script_repo_file_read (quiet);
-            script_action_run_all ();
+            /* if list is not yet read, actions are executed after read */
+            if (!scripts_repo || script_repo_read_hook)
+                script_repo_file_read_async (quiet);
+            else
+                script_action_run_all ();
         }
         else
         {
@@ -148,13 +148,13 @@ script_config_get_diff_command ()
 }
 
 /*
- * Gets filename with list of scripts.
+ * Gets filename of a file in scripts path (used for repository files).
  *
  * Note: result must be freed after use.
  */
 
 char *
-script_config_get_xml_filename ()
+script_config_get_repo_filename (const char *name)
 {
     char *path, *filename;
     int length;
@@ -171,14 +171,39 @@ script_config_get_xml_filename ()
         weechat_config_string (script_config_scripts_path), NULL, NULL, options);
     if (options)
         weechat_hashtable_free (options);
-    length = strlen (path) + 64;
+    length = strlen (path) + strlen (name) + 2;
     filename = malloc (length);
     if (filename)
-        snprintf (filename, length, "%s/plugins.xml.gz", path);
+        snprintf (filename, length, "%s/%s", path, name);
     free (path);
     return filename;
 }
 
+/*
+ * Gets filename with list of scripts.
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+script_config_get_xml_filename ()
+{
+    return script_config_get_repo_filename ("plugins.xml.gz");
+}
+
+/*
+ * Gets filename with cache of list of scripts (scripts already read in
+ * file plugins.xml.gz).
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+script_config_get_xml_cache_filename ()
+{
+    return script_config_get_repo_filename ("plugins.cache");
+}
+
 /*
  * Gets filename for a script to download.
  * If suffix is not NULL, it is added to filename.
@@ -259,6 +284,26 @@ script_config_reload_scripts_cb (const void *pointer, void *data,
     }
 }
 
+/*
+ * Callback for changes on option "script.look.sort".
+ */
+
+void
+script_config_change_sort_cb (const void *pointer, void *data,
+                              struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    if (scripts_repo)
+    {
+        script_repo_sort ();
+        script_buffer_refresh (1);
+    }
+}
+
 /*
  * Callback for changes on option "script.look.use_keys".
  */
@@ -495,7 +540,7 @@ script_config_init ()
            "date"),
         NULL, 0, 0, "i,p,n", NULL, 0,
         NULL, NULL, NULL,
-        &script_config_reload_scripts_cb, NULL, NULL,
+        &script_config_change_sort_cb, NULL, NULL,
         NULL, NULL, NULL);
     script_config_look_translate_description = weechat_config_new_option (
         script_config_file, ptr_section,
@@ -70,6 +70,7 @@ extern struct t_config_option *script_config_scripts_url;
 
 extern const char *script_config_get_diff_command ();
 extern char *script_config_get_xml_filename ();
+extern char *script_config_get_xml_cache_filename ();
 extern char *script_config_get_script_download_filename (struct t_script_repo *script,
                                                          const char *suffix);
 extern void script_config_hold (const char *name_with_extension);
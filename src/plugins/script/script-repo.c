@@ -51,6 +51,9 @@ int script_repo_count = 0;
 int script_repo_count_displayed = 0;
 struct t_hashtable *script_repo_max_length_field = NULL;
 char *script_repo_filter = NULL;
+struct t_script_repo **script_repo_sorted_by_name = NULL; /* for search     */
+struct t_hook *script_repo_read_hook = NULL;  /* async read of repository   */
+struct t_script_repo_read *script_repo_read = NULL; /* data for async read  */
 
 
 /*
@@ -112,47 +115,155 @@ script_repo_search_displayed_by_number (int number)
 }
 
 /*
- * Searches for a script by name (example: "iset").
+ * Compares two scripts by name and extension (used to sort array of scripts
+ * by name).
+ */
+
+int
+script_repo_compare_names_cb (const void *script1, const void *script2)
+{
+    struct t_script_repo *ptr_script1, *ptr_script2;
+    int cmp;
+
+    ptr_script1 = *((struct t_script_repo **)script1);
+    ptr_script2 = *((struct t_script_repo **)script2);
+
+    cmp = strcmp (ptr_script1->name, ptr_script2->name);
+    if (cmp != 0)
+        return cmp;
+
+    return strcmp (script_extension[ptr_script1->language],
+                   script_extension[ptr_script2->language]);
+}
+
+/*
+ * Builds array with scripts sorted by name (if not already built).
  *
- * Returns pointer to script found, NULL if not found.
+ * Returns:
+ *   1: OK
+ *   0: error
  */
 
-struct t_script_repo *
-script_repo_search_by_name (const char *name)
+int
+script_repo_build_sorted_by_name ()
 {
     struct t_script_repo *ptr_script;
+    int i;
 
-    for (ptr_script = scripts_repo; ptr_script;
+    if (script_repo_sorted_by_name)
+        return 1;
+
+    if (script_repo_count == 0)
+        return 0;
+
+    script_repo_sorted_by_name = malloc (
+        script_repo_count * sizeof (*script_repo_sorted_by_name));
+    if (!script_repo_sorted_by_name)
+        return 0;
+
+    i = 0;
+    for (ptr_script = scripts_repo; ptr_script && (i < script_repo_count);
          ptr_script = ptr_script->next_script)
     {
-        if (strcmp (ptr_script->name, name) == 0)
-            return ptr_script;
+        script_repo_sorted_by_name[i++] = ptr_script;
     }
+    qsort (script_repo_sorted_by_name, i,
+           sizeof (*script_repo_sorted_by_name),
+           &script_repo_compare_names_cb);
 
-    /* script not found */
-    return NULL;
+    return 1;
 }
 
 /*
- * Searches for a script by name/extension (example: "go.py").
+ * Searches for a script by name and extension (if extension is NULL, the
+ * first script with this name is returned), using a binary search in array
+ * of scripts sorted by name.
  *
  * Returns pointer to script found, NULL if not found.
  */
 
 struct t_script_repo *
-script_repo_search_by_name_ext (const char *name_with_extension)
+script_repo_search_name_extension (const char *name, int length_name,
+                                   const char *extension)
 {
     struct t_script_repo *ptr_script;
+    int low, high, middle, cmp;
 
-    for (ptr_script = scripts_repo; ptr_script;
-         ptr_script = ptr_script->next_script)
+    if (!script_repo_build_sorted_by_name ())
+        return NULL;
+
+    /* search the first script with name >= (name, extension) */
+    low = 0;
+    high = script_repo_count;
+    while (low < high)
     {
-        if (strcmp (ptr_script->name_with_extension, name_with_extension) == 0)
-            return ptr_script;
+        middle = low + ((high - low) / 2);
+        ptr_script = script_repo_sorted_by_name[middle];
+        cmp = strncmp (ptr_script->name, name, length_name);
+        if ((cmp == 0) && ptr_script->name[length_name])
+            cmp = 1;
+        if ((cmp == 0) && extension)
+            cmp = strcmp (script_extension[ptr_script->language], extension);
+        if (cmp < 0)
+            low = middle + 1;
+        else
+            high = middle;
     }
 
-    /* script not found */
-    return NULL;
+    if (low >= script_repo_count)
+        return NULL;
+
+    ptr_script = script_repo_sorted_by_name[low];
+    if ((strncmp (ptr_script->name, name, length_name) != 0)
+        || ptr_script->name[length_name])
+    {
+        return NULL;
+    }
+    if (extension
+        && (strcmp (script_extension[ptr_script->language], extension) != 0))
+    {
+        return NULL;
+    }
+
+    return ptr_script;
+}
+
+/*
+ * Searches for a script by name (example: "iset").
+ *
+ * Returns pointer to script found, NULL if not found.
+ */
+
+struct t_script_repo *
+script_repo_search_by_name (const char *name)
+{
+    if (!name)
+        return NULL;
+
+    return script_repo_search_name_extension (name, strlen (name), NULL);
+}
+
+/*
+ * Searches for a script by name/extension (example: "go.py").
+ *
+ * Returns pointer to script found, NULL if not found.
+ */
+
+struct t_script_repo *
+script_repo_search_by_name_ext (const char *name_with_extension)
+{
+    const char *pos;
+
+    if (!name_with_extension)
+        return NULL;
+
+    pos = strrchr (name_with_extension, '.');
+    if (!pos)
+        return NULL;
+
+    return script_repo_search_name_extension (name_with_extension,
+                                              pos - name_with_extension,
+                                              pos + 1);
 }
 
 /*
@@ -509,23 +620,58 @@ script_repo_compare_scripts (struct t_script_repo *script1,
 }
 
 /*
- * Searches for position for script in list (to keep list sorted).
+ * Compares two scripts using sort key(s) (callback used by qsort); scripts
+ * equal with sort keys are sorted by name and extension.
  */
 
-struct t_script_repo *
-script_repo_find_pos (struct t_script_repo *script)
+int
+script_repo_compare_scripts_cb (const void *script1, const void *script2)
 {
-    struct t_script_repo *ptr_script;
+    int cmp;
 
-    for (ptr_script = scripts_repo; ptr_script;
+    cmp = script_repo_compare_scripts (*((struct t_script_repo **)script1),
+                                       *((struct t_script_repo **)script2));
+    if (cmp != 0)
+        return cmp;
+
+    return script_repo_compare_names_cb (script1, script2);
+}
+
+/*
+ * Sorts list of scripts using sort key(s) (from option script.look.sort).
+ */
+
+void
+script_repo_sort ()
+{
+    struct t_script_repo **scripts, *ptr_script;
+    int i, count;
+
+    if (script_repo_count < 2)
+        return;
+
+    scripts = malloc (script_repo_count * sizeof (*scripts));
+    if (!scripts)
+        return;
+
+    count = 0;
+    for (ptr_script = scripts_repo; ptr_script && (count < script_repo_count);
          ptr_script = ptr_script->next_script)
     {
-        if (script_repo_compare_scripts (ptr_script, script) > 0)
-            return ptr_script;
+        scripts[count++] = ptr_script;
     }
+    qsort (scripts, count, sizeof (*scripts), &script_repo_compare_scripts_cb);
 
-    /* position not found, add to the end */
-    return NULL;
+    /* link scripts again, in sorted order */
+    for (i = 0; i < count; i++)
+    {
+        scripts[i]->prev_script = (i > 0) ? scripts[i - 1] : NULL;
+        scripts[i]->next_script = (i < count - 1) ? scripts[i + 1] : NULL;
+    }
+    scripts_repo = scripts[0];
+    last_script_repo = scripts[count - 1];
+
+    free (scripts);
 }
 
 /*
@@ -543,36 +689,25 @@ script_repo_set_max_length_field (const char *field, int length)
 }
 
 /*
- * Adds a script to list of scripts.
+ * Adds a script at the end of list of scripts (the list must then be sorted
+ * with function script_repo_sort).
  */
 
 void
 script_repo_add (struct t_script_repo *script)
 {
-    struct t_script_repo *ptr_script;
-
-    ptr_script = script_repo_find_pos (script);
-    if (ptr_script)
-    {
-        /* insert script before script found */
-        script->prev_script = ptr_script->prev_script;
-        script->next_script = ptr_script;
-        if (ptr_script->prev_script)
-            (ptr_script->prev_script)->next_script = script;
-        else
-            scripts_repo = script;
-        ptr_script->prev_script = script;
-    }
+    script->prev_script = last_script_repo;
+    script->next_script = NULL;
+    if (last_script_repo)
+        last_script_repo->next_script = script;
     else
+        scripts_repo = script;
+    last_script_repo = script;
+
+    if (script_repo_sorted_by_name)
     {
-        /* add script to the end */
-        script->prev_script = last_script_repo;
-        script->next_script = NULL;
-        if (last_script_repo)
-            last_script_repo->next_script = script;
-        else
-            scripts_repo = script;
-        last_script_repo = script;
+        free (script_repo_sorted_by_name);
+        script_repo_sorted_by_name = NULL;
     }
 
     /* set max length for fields */
@@ -664,6 +799,12 @@ script_repo_remove (struct t_script_repo *script)
     if (script_buffer_detail_script == script)
         script_buffer_detail_script = NULL;
 
+    if (script_repo_sorted_by_name)
+    {
+        free (script_repo_sorted_by_name);
+        script_repo_sorted_by_name = NULL;
+    }
+
     /* remove script from list */
     if (last_script_repo == script)
         last_script_repo = script->prev_script;
@@ -765,20 +906,19 @@ script_repo_sha512sum_file (const char *filename)
 }
 
 /*
- * Updates following status of a script:
+ * Checks following status of a script:
  *   - script installed?
  *   - script running?
  *   - new version available?
  */
 
 void
-script_repo_update_status (struct t_script_repo *script)
+script_repo_check_status (struct t_script_repo *script)
 {
     const char *version;
     char *weechat_data_dir, *filename, *sha512sum;
     struct stat st;
     int length;
-    struct t_script_repo *ptr_script;
 
     script->status = 0;
     sha512sum = NULL;
@@ -846,7 +986,20 @@ script_repo_update_status (struct t_script_repo *script)
         script->status |= SCRIPT_STATUS_NEW_VERSION;
     }
 
-    /* recompute max length for version loaded (for display) */
+    if (sha512sum)
+        free (sha512sum);
+}
+
+/*
+ * Computes max length for version loaded (for display).
+ */
+
+void
+script_repo_set_max_length_version_loaded ()
+{
+    struct t_script_repo *ptr_script;
+    int length;
+
     if (script_repo_max_length_field)
     {
         length = 0;
@@ -858,9 +1011,17 @@ script_repo_update_status (struct t_script_repo *script)
                 script_repo_set_max_length_field ("V", weechat_utf8_strlen_screen (ptr_script->version_loaded));
         }
     }
+}
 
-    if (sha512sum)
-        free (sha512sum);
+/*
+ * Updates status of a script (see function script_repo_check_status).
+ */
+
+void
+script_repo_update_status (struct t_script_repo *script)
+{
+    script_repo_check_status (script);
+    script_repo_set_max_length_version_loaded ();
 }
 
 /*
@@ -875,8 +1036,9 @@ script_repo_update_status_all ()
     for (ptr_script = scripts_repo; ptr_script;
          ptr_script = ptr_script->next_script)
     {
-        script_repo_update_status (ptr_script);
+        script_repo_check_status (ptr_script);
     }
+    script_repo_set_max_length_version_loaded ();
 }
 
 /*
@@ -1107,341 +1269,1067 @@ script_repo_file_is_uptodate ()
 }
 
 /*
- * Reads scripts in repository file (plugins.xml.gz).
- *
- * Returns:
- *   1: OK
- *   0: error
+ * Frees scripts read (scripts not yet added to the list).
  */
 
-int
-script_repo_file_read (int quiet)
+void
+script_repo_read_free_scripts (struct t_script_repo_read *repo_read)
 {
-    char *filename, *ptr_line, line[4096], *pos, *pos2, *pos3;
-    char *name, *value1, *value2, *value3, *value, *error;
-    char *info_locale, *locale, *locale_language, *version;
-    const char *ptr_desc;
-    gzFile file;
-    struct t_script_repo *script;
-    int version_number, version_ok, script_ok, length;
-    struct tm tm_script;
-    struct t_hashtable *descriptions;
-
-    script_get_loaded_plugins ();
-    script_get_scripts ();
-
-    script_repo_remove_all ();
+    int i;
 
-    if (!script_repo_max_length_field)
+    for (i = 0; i < repo_read->num_scripts; i++)
     {
-        script_repo_max_length_field = weechat_hashtable_new (
-            32,
-            WEECHAT_HASHTABLE_STRING,
-            WEECHAT_HASHTABLE_INTEGER,
-            NULL, NULL);
+        script_repo_free (repo_read->scripts[i]);
     }
-    else
-        weechat_hashtable_remove_all (script_repo_max_length_field);
+    if (repo_read->scripts)
+        free (repo_read->scripts);
+    repo_read->scripts = NULL;
+    repo_read->num_scripts = 0;
+    repo_read->size_scripts = 0;
+}
+
+/*
+ * Frees data used to read repository file.
+ */
+
+void
+script_repo_read_free (struct t_script_repo_read *repo_read)
+{
+    if (!repo_read)
+        return;
+
+    script_repo_read_free_scripts (repo_read);
+    if (repo_read->filename)
+        free (repo_read->filename);
+    if (repo_read->cache_filename)
+        free (repo_read->cache_filename);
+    if (repo_read->locale)
+        free (repo_read->locale);
+    if (repo_read->locale_language)
+        free (repo_read->locale_language);
+
+    free (repo_read);
+}
+
+/*
+ * Creates data to read repository file (this function must be called in
+ * main process: options and infos are read here).
+ *
+ * Returns pointer to new data, NULL if error.
+ */
+
+struct t_script_repo_read *
+script_repo_read_new (int quiet)
+{
+    struct t_script_repo_read *new_read;
+    char *version, *info_locale, *pos;
+
+    new_read = malloc (sizeof (*new_read));
+    if (!new_read)
+        return NULL;
 
+    new_read->filename = script_config_get_xml_filename ();
+    new_read->cache_filename = script_config_get_xml_cache_filename ();
     version = weechat_info_get ("version", NULL);
-    version_number = weechat_util_version_number (version);
+    new_read->version_number = weechat_util_version_number (version);
     if (version)
         free (version);
 
-    filename = script_config_get_xml_filename ();
-    if (!filename)
-    {
-        weechat_printf (NULL, _("%s%s: error reading list of scripts"),
-                        weechat_prefix ("error"),
-                        SCRIPT_PLUGIN_NAME);
-        return 0;
-    }
-
-    script = NULL;
-    file = gzopen (filename, "r");
-    free (filename);
-    if (!file)
-    {
-        weechat_printf (NULL, _("%s%s: error reading list of scripts"),
-                        weechat_prefix ("error"),
-                        SCRIPT_PLUGIN_NAME);
-        return 0;
-    }
-
     /*
      * get locale and locale_languages
      * example: if LANG=fr_FR.UTF-8, result is:
      *   locale          = "fr_FR"
      *   locale_language = "fr"
      */
-    locale = NULL;
-    locale_language = NULL;
+    new_read->locale = NULL;
+    new_read->locale_language = NULL;
     info_locale = weechat_info_get ("locale", NULL);
     if (info_locale)
     {
         pos = strchr (info_locale, '.');
         if (pos)
-            locale = weechat_strndup (info_locale, pos - info_locale);
+            new_read->locale = weechat_strndup (info_locale, pos - info_locale);
         else
-            locale = strdup (info_locale);
+            new_read->locale = strdup (info_locale);
         free (info_locale);
     }
-    if (locale)
+    if (new_read->locale)
     {
-        pos = strchr (locale, '_');
+        pos = strchr (new_read->locale, '_');
         if (pos)
-            locale_language = weechat_strndup (locale, pos - locale);
+        {
+            new_read->locale_language = weechat_strndup (
+                new_read->locale, pos - new_read->locale);
+        }
         else
-            locale_language = strdup (locale);
+            new_read->locale_language = strdup (new_read->locale);
     }
 
-    descriptions = weechat_hashtable_new (32,
-                                          WEECHAT_HASHTABLE_STRING,
-                                          WEECHAT_HASHTABLE_STRING,
-                                          NULL, NULL);
+    new_read->translate_description = weechat_config_boolean (
+        script_config_look_translate_description);
+    new_read->quiet = quiet;
+    new_read->scripts = NULL;
+    new_read->num_scripts = 0;
+    new_read->size_scripts = 0;
 
-    /* read plugins.xml.gz */
-    while (!gzeof (file))
+    if (!new_read->filename || !new_read->cache_filename)
     {
-        ptr_line = gzgets (file, line, sizeof (line) - 1);
-        if (ptr_line)
-        {
-            if (strstr (ptr_line, "<plugin id="))
-            {
-                if (script)
-                    script_repo_free (script);
-                script = script_repo_alloc ();
-                weechat_hashtable_remove_all (descriptions);
-            }
-            else if (strstr (ptr_line, "</plugin>"))
-            {
-                if (script)
-                {
-                    script_ok = 0;
-                    if (script->name && (script->language >= 0))
-                    {
-                        version_ok = 1;
-                        if (script->min_weechat)
-                        {
-                            if (weechat_util_version_number (script->min_weechat) > version_number)
-                                version_ok = 0;
-                        }
-                        if (version_ok && script->max_weechat)
-                        {
-                            if (weechat_util_version_number (script->max_weechat) < version_number)
-                                version_ok = 0;
-                        }
-                        if (version_ok)
-                        {
-                            ptr_desc = NULL;
-                            if (weechat_config_boolean (script_config_look_translate_description))
-                            {
-                                /* try translated description (format "fr_FR") */
-                                ptr_desc = weechat_hashtable_get (descriptions,
-                                                                  locale);
-                                if (!ptr_desc)
-                                {
-                                    /* try translated description (format "fr") */
-                                    ptr_desc = weechat_hashtable_get (descriptions,
-                                                                      locale_language);
-                                }
-                            }
-                            if (!ptr_desc)
-                            {
-                                /* default description (English) */
-                                ptr_desc = weechat_hashtable_get (descriptions,
-                                                                  "en");
-                            }
-                            if (ptr_desc)
-                            {
-                                script->description = strdup (ptr_desc);
-                                length = strlen (script->name) + 1 +
-                                    strlen (script_extension[script->language]) + 1;
-                                script->name_with_extension = malloc (length);
-                                if (script->name_with_extension)
-                                {
-                                    snprintf (script->name_with_extension,
-                                              length,
-                                              "%s.%s",
-                                              script->name,
-                                              script_extension[script->language]);
-                                }
-                                script_repo_update_status (script);
-                                script->displayed = (script_repo_match_filter (script));
-                                script_repo_add (script);
-                                script_ok = 1;
-                            }
-                        }
-                    }
-                    if (!script_ok)
-                    {
-                        script_repo_free (script);
-                    }
-                    script = NULL;
-                }
-            }
-            else if (script)
-            {
-                pos = strchr (ptr_line, '<');
-                if (pos)
-                {
-                    pos2 = strchr (pos + 1, '>');
-                    if (pos2 && (pos2 > pos + 1))
-                    {
-                        pos3 = strstr (pos2 + 1, "</");
-                        if (pos3 && (pos3 > pos2 + 1))
-                        {
-                            name = weechat_strndup (pos + 1, pos2 - pos - 1);
-                            value1 = weechat_strndup (pos2 + 1, pos3 - pos2 - 1);
-                            value2 = weechat_string_replace (value1, "&amp;", "&");
-                            value3 = weechat_string_replace (value2, "&gt;", ">");
-                            value = weechat_string_replace (value3, "&lt;", "<");
-                            if (name && value)
-                            {
-                                if (strcmp (name, "name") == 0)
-                                    script->name = strdup (value);
-                                else if (strcmp (name, "language") == 0)
-                                    script->language = script_language_search (value);
-                                else if (strcmp (name, "author") == 0)
-                                    script->author = strdup (value);
-                                else if (strcmp (name, "mail") == 0)
-                                    script->mail = strdup (value);
-                                else if (strcmp (name, "version") == 0)
-                                    script->version = strdup (value);
-                                else if (strcmp (name, "license") == 0)
-                                    script->license = strdup (value);
-                                else if (strncmp (name, "desc_", 5) == 0)
-                                {
-                                    /*
-                                     * store translated description in hashtable
-                                     * (will be used later, by choosing
-                                     * appropriate language according to locale)
-                                     */
-                                    weechat_hashtable_set (descriptions,
-                                                           name + 5,
-                                                           value);
-                                }
-                                else if (strcmp (name, "tags") == 0)
-                                    script->tags = strdup (value);
-                                else if (strcmp (name, "requirements") == 0)
-                                    script->requirements = strdup (value);
-                                else if (strcmp (name, "min_weechat") == 0)
-                                    script->min_weechat = strdup (value);
-                                else if (strcmp (name, "max_weechat") == 0)
-                                    script->max_weechat = strdup (value);
-                                else if (strcmp (name, "sha512sum") == 0)
-                                    script->sha512sum = strdup (value);
-                                else if (strcmp (name, "url") == 0)
-                                    script->url = strdup (value);
-                                else if (strcmp (name, "popularity") == 0)
-                                {
-                                    error = NULL;
-                                    script->popularity = (int)strtol (value,
-                                                                      &error,
-                                                                      10);
-                                    if (!error || error[0])
-                                        script->popularity = 0;
-                                }
-                                else if (strcmp (name, "added") == 0)
-                                {
-                                    /*
-                                     * initialize structure, because strptime
-                                     * does not do it
-                                     */
-                                    memset (&tm_script, 0, sizeof (tm_script));
-                                    error = strptime (value,
-                                                      "%Y-%m-%d %H:%M:%S",
-                                                      &tm_script);
-                                    if (error && !error[0])
-                                        script->date_added = mktime (&tm_script);
-                                }
-                                else if (strcmp (name, "updated") == 0)
-                                {
-                                    /*
-                                     * initialize structure, because strptime
-                                     * does not do it
-                                     */
-                                    memset (&tm_script, 0, sizeof (tm_script));
-                                    error = strptime (value,
-                                                      "%Y-%m-%d %H:%M:%S",
-                                                      &tm_script);
-                                    if (error && !error[0])
-                                        script->date_updated = mktime (&tm_script);
-                                }
-                            }
-                            if (name)
-                                free (name);
-                            if (value1)
-                                free (value1);
-                            if (value2)
-                                free (value2);
-                            if (value3)
-                                free (value3);
-                            if (value)
-                                free (value);
-                        }
-                    }
-                }
-            }
-        }
+        script_repo_read_free (new_read);
+        return NULL;
     }
 
-    gzclose (file);
+    return new_read;
+}
 
-    if (scripts_repo && !quiet)
-    {
-        version = weechat_info_get ("version", NULL);
-        weechat_printf (NULL,
-                        _("%s: %d scripts for WeeChat %s"),
-                        SCRIPT_PLUGIN_NAME, script_repo_count,
-                        version);
-        if (version)
-            free (version);
-    }
+/*
+ * Adds a script read in array of scripts.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
 
-    if (!scripts_repo)
+int
+script_repo_read_add (struct t_script_repo_read *repo_read,
+                      struct t_script_repo *script)
+{
+    struct t_script_repo **new_scripts;
+    int new_size;
+
+    if (repo_read->num_scripts >= repo_read->size_scripts)
     {
-        weechat_printf (NULL,
-                        _("%s%s: list of scripts is empty (repository file "
-                          "is broken, or download has failed)"),
-                        weechat_prefix ("error"),
-                        SCRIPT_PLUGIN_NAME);
+        new_size = (repo_read->size_scripts > 0) ?
+            repo_read->size_scripts * 2 : 256;
+        new_scripts = realloc (repo_read->scripts,
+                               new_size * sizeof (*new_scripts));
+        if (!new_scripts)
+            return 0;
+        repo_read->scripts = new_scripts;
+        repo_read->size_scripts = new_size;
     }
 
-    if (script)
-        script_repo_free (script);
-    if (locale)
-        free (locale);
-    if (locale_language)
-        free (locale_language);
-    if (descriptions)
-        weechat_hashtable_free (descriptions);
+    repo_read->scripts[repo_read->num_scripts++] = script;
 
     return 1;
 }
 
 /*
- * Callback called when list of scripts is downloaded.
+ * Builds name with extension of a script (example: "go.py").
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
  */
 
 int
-script_repo_file_update_process_cb (const void *pointer, void *data,
-                                    const char *command,
-                                    int return_code, const char *out,
-                                    const char *err)
+script_repo_set_name_with_extension (struct t_script_repo *script)
 {
-    int quiet;
+    int length;
 
-    /* make C compiler happy */
-    (void) data;
-    (void) command;
-    (void) out;
+    length = strlen (script->name) + 1 +
+        strlen (script_extension[script->language]) + 1;
+    script->name_with_extension = malloc (length);
+    if (!script->name_with_extension)
+        return 0;
 
-    quiet = (pointer) ? 1 : 0;
+    snprintf (script->name_with_extension, length,
+              "%s.%s",
+              script->name,
+              script_extension[script->language]);
 
-    if (return_code >= 0)
-    {
-        if (err && err[0])
+    return 1;
+}
+
+/*
+ * Replaces XML entities "&amp;", "&gt;" and "&lt;" in a string (the string
+ * is updated in place).
+ */
+
+void
+script_repo_xml_unescape (char *string)
+{
+    char *ptr_read, *ptr_write;
+
+    ptr_read = string;
+    ptr_write = string;
+    while (ptr_read[0])
+    {
+        if (ptr_read[0] == '&')
+        {
+            if (strncmp (ptr_read, "&amp;", 5) == 0)
+            {
+                *ptr_write++ = '&';
+                ptr_read += 5;
+                continue;
+            }
+            if (strncmp (ptr_read, "&gt;", 4) == 0)
+            {
+                *ptr_write++ = '>';
+                ptr_read += 4;
+                continue;
+            }
+            if (strncmp (ptr_read, "&lt;", 4) == 0)
+            {
+                *ptr_write++ = '<';
+                ptr_read += 4;
+                continue;
+            }
+        }
+        *ptr_write++ = *ptr_read++;
+    }
+    ptr_write[0] = '\0';
+}
+
+/*
+ * Sets a string field of a script (the value is not duplicated: the script
+ * becomes the owner of the string).
+ */
+
+void
+script_repo_set_string (char **field, char *value)
+{
+    if (*field)
+        free (*field);
+    *field = value;
+}
+
+/*
+ * Parses a date in repository file (format: "2022-12-31 23:59:59").
+ *
+ * Returns the date, 0 if error.
+ */
+
+time_t
+script_repo_parse_date (const char *value)
+{
+    struct tm tm_script;
+    char *error;
+
+    /* initialize structure, because strptime does not do it */
+    memset (&tm_script, 0, sizeof (tm_script));
+    error = strptime (value, "%Y-%m-%d %H:%M:%S", &tm_script);
+    if (error && !error[0])
+        return mktime (&tm_script);
+
+    return 0;
+}
+
+/*
+ * Reads scripts in repository file (plugins.xml.gz).
+ *
+ * This function is called in a child process: it must not use
+ * the list of scripts, nor read options.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+script_repo_read_xml (struct t_script_repo_read *repo_read)
+{
+    char *ptr_line, line[4096], *pos, *pos2, *pos3, *name, *value, *error;
+    char *description;
+    gzFile file;
+    struct t_script_repo *script;
+    int priority, description_priority, version_ok;
+
+    file = gzopen (repo_read->filename, "r");
+    if (!file)
+        return 0;
+
+    script = NULL;
+    description = NULL;
+    description_priority = 0;
+
+    while (!gzeof (file))
+    {
+        ptr_line = gzgets (file, line, sizeof (line) - 1);
+        if (!ptr_line)
+            break;
+        if (strstr (ptr_line, "<plugin id="))
+        {
+            script_repo_free (script);
+            script = script_repo_alloc ();
+            script_repo_set_string (&description, NULL);
+            description_priority = 0;
+        }
+        else if (strstr (ptr_line, "</plugin>"))
+        {
+            if (!script)
+                continue;
+            version_ok = (script->name && (script->language >= 0)
+                          && description) ? 1 : 0;
+            if (version_ok && script->min_weechat
+                && (weechat_util_version_number (script->min_weechat) >
+                    repo_read->version_number))
+            {
+                version_ok = 0;
+            }
+            if (version_ok && script->max_weechat
+                && (weechat_util_version_number (script->max_weechat) <
+                    repo_read->version_number))
+            {
+                version_ok = 0;
+            }
+            if (version_ok
+                && script_repo_set_name_with_extension (script)
+                && script_repo_read_add (repo_read, script))
+            {
+                script->description = description;
+                description = NULL;
+            }
+            else
+            {
+                script_repo_free (script);
+            }
+            script = NULL;
+        }
+        else if (script)
+        {
+            pos = strchr (ptr_line, '<');
+            if (!pos)
+                continue;
+            pos2 = strchr (pos + 1, '>');
+            if (!pos2 || (pos2 <= pos + 1))
+                continue;
+            pos3 = strstr (pos2 + 1, "</");
+            if (!pos3 || (pos3 <= pos2 + 1))
+                continue;
+            name = weechat_strndup (pos + 1, pos2 - pos - 1);
+            value = weechat_strndup (pos2 + 1, pos3 - pos2 - 1);
+            if (name && value)
+            {
+                script_repo_xml_unescape (value);
+                if (strcmp (name, "name") == 0)
+                {
+                    script_repo_set_string (&script->name, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "language") == 0)
+                    script->language = script_language_search (value);
+                else if (strcmp (name, "author") == 0)
+                {
+                    script_repo_set_string (&script->author, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "mail") == 0)
+                {
+                    script_repo_set_string (&script->mail, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "version") == 0)
+                {
+                    script_repo_set_string (&script->version, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "license") == 0)
+                {
+                    script_repo_set_string (&script->license, value);
+                    value = NULL;
+                }
+                else if (strncmp (name, "desc_", 5) == 0)
+                {
+                    /*
+                     * keep the best description according to locale:
+                     * translated (format "fr_FR" then "fr"), or English
+                     */
+                    priority = 0;
+                    if (repo_read->translate_description
+                        && repo_read->locale
+                        && (strcmp (name + 5, repo_read->locale) == 0))
+                    {
+                        priority = 3;
+                    }
+                    else if (repo_read->translate_description
+                             && repo_read->locale_language
+                             && (strcmp (name + 5,
+                                         repo_read->locale_language) == 0))
+                    {
+                        priority = 2;
+                    }
+                    else if (strcmp (name + 5, "en") == 0)
+                    {
+                        priority = 1;
+                    }
+                    if (priority > description_priority)
+                    {
+                        script_repo_set_string (&description, value);
+                        value = NULL;
+                        description_priority = priority;
+                    }
+                }
+                else if (strcmp (name, "tags") == 0)
+                {
+                    script_repo_set_string (&script->tags, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "requirements") == 0)
+                {
+                    script_repo_set_string (&script->requirements, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "min_weechat") == 0)
+                {
+                    script_repo_set_string (&script->min_weechat, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "max_weechat") == 0)
+                {
+                    script_repo_set_string (&script->max_weechat, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "sha512sum") == 0)
+                {
+                    script_repo_set_string (&script->sha512sum, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "url") == 0)
+                {
+                    script_repo_set_string (&script->url, value);
+                    value = NULL;
+                }
+                else if (strcmp (name, "popularity") == 0)
+                {
+                    error = NULL;
+                    script->popularity = (int)strtol (value, &error, 10);
+                    if (!error || error[0])
+                        script->popularity = 0;
+                }
+                else if (strcmp (name, "added") == 0)
+                    script->date_added = script_repo_parse_date (value);
+                else if (strcmp (name, "updated") == 0)
+                    script->date_updated = script_repo_parse_date (value);
+            }
+            if (name)
+                free (name);
+            if (value)
+                free (value);
+        }
+    }
+
+    gzclose (file);
+
+    script_repo_free (script);
+    if (description)
+        free (description);
+
+    return 1;
+}
+
+/*
+ * Builds the key of cache: the cache is valid only if the repository file,
+ * the WeeChat version, the locale and option to translate descriptions
+ * are the same as when the cache was written.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (repository file not found)
+ */
+
+int
+script_repo_cache_key (struct t_script_repo_read *repo_read,
+                       char *key, int size)
+{
+    struct stat st;
+
+    if (stat (repo_read->filename, &st) != 0)
+        return 0;
+
+    snprintf (key, size,
+              "weechat_script_cache:1:%lld:%lld:%d:%s:%d",
+              (long long)st.st_mtime,
+              (long long)st.st_size,
+              repo_read->version_number,
+              (repo_read->locale) ? repo_read->locale : "",
+              repo_read->translate_description);
+
+    return 1;
+}
+
+/*
+ * Writes a string in cache file, followed by a separator (chars "\", tab
+ * and new line are escaped).
+ */
+
+void
+script_repo_cache_write_string (FILE *file, const char *string,
+                                char separator)
+{
+    const char *ptr_string;
+
+    if (string)
+    {
+        for (ptr_string = string; ptr_string[0]; ptr_string++)
+        {
+            switch (ptr_string[0])
+            {
+                case '\\':
+                    fputs ("\\\\", file);
+                    break;
+                case '\t':
+                    fputs ("\\t", file);
+                    break;
+                case '\n':
+                    fputs ("\\n", file);
+                    break;
+                default:
+                    fputc (ptr_string[0], file);
+                    break;
+            }
+        }
+    }
+    fputc (separator, file);
+}
+
+/*
+ * Writes scripts read in cache file (the file is written in a temporary file
+ * which is then renamed, so that the cache is never read partially).
+ *
+ * This function is called in a child process.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+script_repo_cache_write (struct t_script_repo_read *repo_read,
+                         const char *key)
+{
+    char filename[PATH_MAX];
+    struct t_script_repo *ptr_script;
+    FILE *file;
+    int i, rc;
+
+    snprintf (filename, sizeof (filename),
+              "%s.%d.tmp", repo_read->cache_filename, (int)getpid ());
+
+    file = fopen (filename, "w");
+    if (!file)
+        return 0;
+
+    fprintf (file, "%s\n", key);
+    for (i = 0; i < repo_read->num_scripts; i++)
+    {
+        ptr_script = repo_read->scripts[i];
+        script_repo_cache_write_string (file, ptr_script->name, '\t');
+        script_repo_cache_write_string (
+            file, script_extension[ptr_script->language], '\t');
+        script_repo_cache_write_string (file, ptr_script->author, '\t');
+        script_repo_cache_write_string (file, ptr_script->mail, '\t');
+        script_repo_cache_write_string (file, ptr_script->version, '\t');
+        script_repo_cache_write_string (file, ptr_script->license, '\t');
+        script_repo_cache_write_string (file, ptr_script->description, '\t');
+        script_repo_cache_write_string (file, ptr_script->tags, '\t');
+        script_repo_cache_write_string (file, ptr_script->requirements, '\t');
+        script_repo_cache_write_string (file, ptr_script->min_weechat, '\t');
+        script_repo_cache_write_string (file, ptr_script->max_weechat, '\t');
+        script_repo_cache_write_string (file, ptr_script->sha512sum, '\t');
+        script_repo_cache_write_string (file, ptr_script->url, '\t');
+        fprintf (file, "%d\t%lld\t%lld\n",
+                 ptr_script->popularity,
+                 (long long)ptr_script->date_added,
+                 (long long)ptr_script->date_updated);
+    }
+
+    rc = (ferror (file)) ? 0 : 1;
+    if (fclose (file) != 0)
+        rc = 0;
+
+    if (rc && (rename (filename, repo_read->cache_filename) != 0))
+        rc = 0;
+    if (!rc)
+        unlink (filename);
+
+    return rc;
+}
+
+/*
+ * Unescapes a string read in cache file (the string is updated in place).
+ *
+ * Returns the string unescaped, NULL if the string is empty.
+ */
+
+char *
+script_repo_cache_unescape (char *string)
+{
+    char *ptr_read, *ptr_write;
+
+    if (!string[0])
+        return NULL;
+
+    ptr_read = string;
+    ptr_write = string;
+    while (ptr_read[0])
+    {
+        if ((ptr_read[0] == '\\') && ptr_read[1])
+        {
+            ptr_read++;
+            switch (ptr_read[0])
+            {
+                case 't':
+                    *ptr_write++ = '\t';
+                    break;
+                case 'n':
+                    *ptr_write++ = '\n';
+                    break;
+                default:
+                    *ptr_write++ = ptr_read[0];
+                    break;
+            }
+            ptr_read++;
+        }
+        else
+            *ptr_write++ = *ptr_read++;
+    }
+    ptr_write[0] = '\0';
+
+    return string;
+}
+
+/*
+ * Reads a script in a line of cache file (the line is updated).
+ *
+ * Returns pointer to new script, NULL if error.
+ */
+
+struct t_script_repo *
+script_repo_cache_read_script (char *line)
+{
+    struct t_script_repo *script;
+    char *fields[SCRIPT_REPO_CACHE_NUM_FIELDS], *pos, *value;
+    int i;
+
+    pos = line;
+    for (i = 0; i < SCRIPT_REPO_CACHE_NUM_FIELDS; i++)
+    {
+        fields[i] = pos;
+        pos = strchr (pos, (i < SCRIPT_REPO_CACHE_NUM_FIELDS - 1) ? '\t' : '\n');
+        if (!pos)
+        {
+            if (i < SCRIPT_REPO_CACHE_NUM_FIELDS - 1)
+                return NULL;
+        }
+        else
+        {
+            pos[0] = '\0';
+            pos++;
+        }
+    }
+
+    script = script_repo_alloc ();
+    if (!script)
+        return NULL;
+
+    for (i = 0; i < SCRIPT_REPO_CACHE_NUM_FIELDS - 3; i++)
+    {
+        value = script_repo_cache_unescape (fields[i]);
+        if (!value)
+            continue;
+        switch (i)
+        {
+            case 0:
+                script->name = strdup (value);
+                break;
+            case 1:
+                script->language = script_language_search_by_extension (value);
+                break;
+            case 2:
+                script->author = strdup (value);
+                break;
+            case 3:
+                script->mail = strdup (value);
+                break;
+            case 4:
+                script->version = strdup (value);
+                break;
+            case 5:
+                script->license = strdup (value);
+                break;
+            case 6:
+                script->description = strdup (value);
+                break;
+            case 7:
+                script->tags = strdup (value);
+                break;
+            case 8:
+                script->requirements = strdup (value);
+                break;
+            case 9:
+                script->min_weechat = strdup (value);
+                break;
+            case 10:
+                script->max_weechat = strdup (value);
+                break;
+            case 11:
+                script->sha512sum = strdup (value);
+                break;
+            case 12:
+                script->url = strdup (value);
+                break;
+        }
+    }
+    script->popularity = (int)strtol (fields[13], NULL, 10);
+    script->date_added = (time_t)strtoll (fields[14], NULL, 10);
+    script->date_updated = (time_t)strtoll (fields[15], NULL, 10);
+
+    if (!script->name || (script->language < 0) || !script->description
+        || !script_repo_set_name_with_extension (script))
+    {
+        script_repo_free (script);
+        return NULL;
+    }
+
+    return script;
+}
+
+/*
+ * Reads scripts in cache file.
+ *
+ * This function is called in child process (before the repository file is
+ * parsed) and in main process (to get scripts read by child process).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (cache not found or outdated)
+ */
+
+int
+script_repo_cache_read (struct t_script_repo_read *repo_read,
+                        const char *key)
+{
+    FILE *file;
+    char *line;
+    size_t size_line;
+    ssize_t length;
+    struct t_script_repo *script;
+    int rc;
+
+    file = fopen (repo_read->cache_filename, "r");
+    if (!file)
+        return 0;
+
+    line = NULL;
+    size_line = 0;
+
+    /* first line is the key: cache is outdated if the key is different */
+    length = getline (&line, &size_line, file);
+    if ((length <= 0)
+        || (line[length - 1] != '\n')
+        || ((size_t)(length - 1) != strlen (key))
+        || (strncmp (line, key, length - 1) != 0))
+    {
+        rc = 0;
+        goto end;
+    }
+
+    rc = 1;
+    while ((length = getline (&line, &size_line, file)) > 0)
+    {
+        script = script_repo_cache_read_script (line);
+        if (!script)
+        {
+            rc = 0;
+            break;
+        }
+        if (!script_repo_read_add (repo_read, script))
+        {
+            script_repo_free (script);
+            rc = 0;
+            break;
+        }
+    }
+
+    if (repo_read->num_scripts == 0)
+        rc = 0;
+
+end:
+    if (!rc)
+        script_repo_read_free_scripts (repo_read);
+    if (line)
+        free (line);
+    fclose (file);
+
+    return rc;
+}
+
+/*
+ * Reads scripts: in cache file if it is up-to-date, otherwise in repository
+ * file (and then cache file is written).
+ *
+ * This function is called in child process (which writes the cache if
+ * needed), then in main process (which reads the cache).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+script_repo_read_scripts (struct t_script_repo_read *repo_read)
+{
+    char key[PATH_MAX];
+
+    if (!script_repo_cache_key (repo_read, key, sizeof (key)))
+        return 0;
+
+    if (script_repo_cache_read (repo_read, key))
+        return 1;
+
+    if (!script_repo_read_xml (repo_read))
+        return 0;
+
+    if (repo_read->num_scripts > 0)
+        script_repo_cache_write (repo_read, key);
+
+    return 1;
+}
+
+/*
+ * Replaces list of scripts by scripts read (in main process).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+script_repo_set_scripts (struct t_script_repo_read *repo_read, int rc)
+{
+    char *version;
+    int i;
+
+    script_get_loaded_plugins ();
+    script_get_scripts ();
+
+    script_repo_remove_all ();
+
+    script_repo_max_length_field = weechat_hashtable_new (
+        32,
+        WEECHAT_HASHTABLE_STRING,
+        WEECHAT_HASHTABLE_INTEGER,
+        NULL, NULL);
+
+    if (!rc)
+    {
+        weechat_printf (NULL, _("%s%s: error reading list of scripts"),
+                        weechat_prefix ("error"),
+                        SCRIPT_PLUGIN_NAME);
+        return 0;
+    }
+
+    for (i = 0; i < repo_read->num_scripts; i++)
+    {
+        script_repo_check_status (repo_read->scripts[i]);
+        repo_read->scripts[i]->displayed = script_repo_match_filter (
+            repo_read->scripts[i]);
+        script_repo_add (repo_read->scripts[i]);
+    }
+    repo_read->num_scripts = 0;
+
+    script_repo_sort ();
+
+    if (scripts_repo && !repo_read->quiet)
+    {
+        version = weechat_info_get ("version", NULL);
+        weechat_printf (NULL,
+                        _("%s: %d scripts for WeeChat %s"),
+                        SCRIPT_PLUGIN_NAME, script_repo_count,
+                        version);
+        if (version)
+            free (version);
+    }
+
+    if (!scripts_repo)
+    {
+        weechat_printf (NULL,
+                        _("%s%s: list of scripts is empty (repository file "
+                          "is broken, or download has failed)"),
+                        weechat_prefix ("error"),
+                        SCRIPT_PLUGIN_NAME);
+    }
+
+    return 1;
+}
+
+/*
+ * Reads scripts in repository file (plugins.xml.gz), or in the cache file
+ * if it is up-to-date.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+script_repo_file_read (int quiet)
+{
+    struct t_script_repo_read *repo_read;
+    int rc;
+
+    script_repo_file_read_cancel ();
+
+    repo_read = script_repo_read_new (quiet);
+    rc = (repo_read) ? script_repo_read_scripts (repo_read) : 0;
+    rc = script_repo_set_scripts (repo_read, rc);
+    script_repo_read_free (repo_read);
+
+    return rc;
+}
+
+/*
+ * Runs actions and refreshes script buffer after the list of scripts has
+ * been read.
+ */
+
+void
+script_repo_file_read_end (int rc)
+{
+    if (rc && scripts_repo)
+    {
+        if (script_buffer)
+            script_buffer_refresh (1);
+        if (!script_action_run_all ())
+            script_buffer_refresh (1);
+    }
+    else
+        script_buffer_refresh (1);
+}
+
+/*
+ * Callback for asynchronous read of repository file: scripts are read in a
+ * child process (which writes the cache), then added to the list in main
+ * process.
+ */
+
+int
+script_repo_file_read_process_cb (const void *pointer, void *data,
+                                  const char *command,
+                                  int return_code, const char *out,
+                                  const char *err)
+{
+    struct t_script_repo_read *repo_read;
+    int rc;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) command;
+    (void) out;
+    (void) err;
+
+    repo_read = (struct t_script_repo_read *)pointer;
+
+    if (return_code == WEECHAT_HOOK_PROCESS_CHILD)
+        return (script_repo_read_scripts (repo_read)) ? 0 : 1;
+
+    if (return_code == WEECHAT_HOOK_PROCESS_RUNNING)
+        return WEECHAT_RC_OK;
+
+    script_repo_read_hook = NULL;
+    script_repo_read = NULL;
+
+    /*
+     * scripts were read in a child process, they are not in our memory:
+     * read them again (this is fast: the cache has been written by child)
+     */
+    rc = script_repo_read_scripts (repo_read);
+
+    rc = script_repo_set_scripts (repo_read, rc);
+    script_repo_read_free (repo_read);
+
+    script_repo_file_read_end (rc);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Reads scripts in repository file, in a child process; actions scheduled
+ * are executed at the end of read.
+ *
+ * If the repository file is already being read, nothing is done.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+script_repo_file_read_async (int quiet)
+{
+    struct t_script_repo_read *repo_read;
+    int rc;
+
+    if (script_repo_read_hook)
+        return 1;
+
+    repo_read = script_repo_read_new (quiet);
+    if (repo_read)
+    {
+        script_repo_read_hook = weechat_hook_process (
+            "func:script_repo_read",
+            0,
+            &script_repo_file_read_process_cb,
+            repo_read,
+            NULL);
+        if (script_repo_read_hook)
+        {
+            script_repo_read = repo_read;
+            return 1;
+        }
+    }
+
+    /* read can not be done in background: read it now */
+    rc = (repo_read) ? script_repo_read_scripts (repo_read) : 0;
+    rc = script_repo_set_scripts (repo_read, rc);
+    script_repo_read_free (repo_read);
+
+    script_repo_file_read_end (rc);
+
+    return rc;
+}
+
+/*
+ * Cancels the asynchronous read of repository file (if running).
+ */
+
+void
+script_repo_file_read_cancel ()
+{
+    if (script_repo_read_hook)
+    {
+        weechat_unhook (script_repo_read_hook);
+        script_repo_read_hook = NULL;
+    }
+    if (script_repo_read)
+    {
+        script_repo_read_free (script_repo_read);
+        script_repo_read = NULL;
+    }
+}
+
+/*
+ * Callback called when list of scripts is downloaded.
+ */
+
+int
+script_repo_file_update_process_cb (const void *pointer, void *data,
+                                    const char *command,
+                                    int return_code, const char *out,
+                                    const char *err)
+{
+    int quiet;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) command;
+    (void) out;
+
+    quiet = (pointer) ? 1 : 0;
+
+    if (return_code >= 0)
+    {
+        if (err && err[0])
         {
             weechat_printf (NULL,
                             _("%s%s: error downloading list of scripts: %s"),
@@ -1451,15 +2339,7 @@ script_repo_file_update_process_cb (const void *pointer, void *data,
             return WEECHAT_RC_OK;
         }
 
-        if (script_repo_file_read (quiet) && scripts_repo)
-        {
-            if (script_buffer)
-                script_buffer_refresh (1);
-            if (!script_action_run_all ())
-                script_buffer_refresh (1);
-        }
-        else
-            script_buffer_refresh (1);
+        script_repo_file_read_async (quiet);
     }
 
     return WEECHAT_RC_OK;
@@ -1482,6 +2362,7 @@ script_repo_file_update (int quiet)
     if (!script_download_enabled (1))
         return 0;
 
+    script_repo_file_read_cancel ();
     script_repo_remove_all ();
 
     filename = script_config_get_xml_filename ();
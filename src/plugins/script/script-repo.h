@@ -29,6 +29,9 @@
 #define SCRIPT_STATUS_RUNNING     (1 << 3)
 #define SCRIPT_STATUS_NEW_VERSION (1 << 4)
 
+/* number of fields for a script in cache file */
+#define SCRIPT_REPO_CACHE_NUM_FIELDS 16
+
 struct t_script_repo
 {
     char *name;                          /* script name                     */
@@ -56,11 +59,31 @@ struct t_script_repo
     struct t_script_repo *next_script;   /* link to next script             */
 };
 
+/*
+ * Read of repository file: scripts are read in a child process, then added
+ * to the list in main process.
+ */
+
+struct t_script_repo_read
+{
+    char *filename;                      /* repository file (plugins.xml.gz)*/
+    char *cache_filename;                /* cache with scripts already read */
+    int version_number;                  /* WeeChat version (as number)     */
+    char *locale;                        /* locale (example: "fr_FR")       */
+    char *locale_language;               /* language of locale ("fr")       */
+    int translate_description;           /* use translated descriptions?    */
+    int quiet;                           /* no message at end of read       */
+    struct t_script_repo **scripts;      /* scripts read                    */
+    int num_scripts;                     /* number of scripts read          */
+    int size_scripts;                    /* size of array "scripts"         */
+};
+
 extern struct t_script_repo *scripts_repo;
 extern struct t_script_repo *last_script_repo;
 extern int script_repo_count, script_repo_count_displayed;
 extern struct t_hashtable *script_repo_max_length_field;
 extern char *script_repo_filter;
+extern struct t_hook *script_repo_read_hook;
 
 extern int script_repo_script_valid (struct t_script_repo *script);
 extern struct t_script_repo *script_repo_search_displayed_by_number (int number);
@@ -72,6 +95,7 @@ extern const char *script_repo_get_status_for_display (struct t_script_repo *scr
                                                        int collapse);
 extern const char *script_repo_get_status_desc_for_display (struct t_script_repo *script,
                                                             const char *list);
+extern void script_repo_sort ();
 extern void script_repo_remove_all ();
 extern void script_repo_update_status (struct t_script_repo *script);
 extern void script_repo_update_status_all ();
@@ -80,6 +104,8 @@ extern void script_repo_filter_scripts (const char *search);
 extern int script_repo_file_exists ();
 extern int script_repo_file_is_uptodate ();
 extern int script_repo_file_read (int quiet);
+extern int script_repo_file_read_async (int quiet);
+extern void script_repo_file_read_cancel ();
 extern int script_repo_file_update (int quiet);
 extern struct t_hdata *script_repo_hdata_script_cb (const void *pointer,
                                                     void *data,
@@ -389,9 +389,8 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
     script_mouse_init ();
 
     if (script_repo_file_exists ())
-        script_repo_file_read (0);
-
-    if (script_buffer)
+        script_repo_file_read_async (0);
+    else if (script_buffer)
         script_buffer_refresh (1);
 
     return WEECHAT_RC_OK;
@@ -411,6 +410,7 @@ weechat_plugin_end (struct t_weechat_plugin *plugin)
 
     script_config_write ();
 
+    script_repo_file_read_cancel ();
     script_repo_remove_all ();
 
     if (script_repo_filter)
@@ -250,6 +250,10 @@ trigger_callback_check_conditions (struct t_trigger *trigger,
     char *value;
     int rc;
 
+    /* constant conditions, already evaluated when trigger was created */
+    if (trigger->conditions_static >= 0)
+        return trigger->conditions_static;
+
     conditions = weechat_config_string (trigger->options[TRIGGER_OPTION_CONDITIONS]);
     if (!conditions || !conditions[0])
         return 1;
@@ -277,34 +281,18 @@ trigger_callback_check_conditions (struct t_trigger *trigger,
 char *
 trigger_callback_regex_replace (struct t_trigger_context *context,
                                 const char *text,
-                                regex_t *regex,
-                                const char *replace)
+                                struct t_trigger_regex *regex)
 {
-    char *value;
-    struct t_hashtable *hashtable_options_regex;
-
-    if (!regex)
+    if (!regex->regex || !regex->options_eval)
         return NULL;
 
-    hashtable_options_regex = weechat_hashtable_new (
-        32,
-        WEECHAT_HASHTABLE_STRING,
-        WEECHAT_HASHTABLE_STRING,
-        NULL, NULL);
-
-    weechat_hashtable_set (context->pointers, "regex", regex);
-    weechat_hashtable_set (hashtable_options_regex,
-                           "regex_replace", replace);
+    weechat_hashtable_set (context->pointers, "regex", regex->regex);
 
-    value = weechat_string_eval_expression (
+    return weechat_string_eval_expression (
         text,
         context->pointers,
         context->extra_vars,
-        hashtable_options_regex);
-
-    weechat_hashtable_free (hashtable_options_regex);
-
-    return value;
+        regex->options_eval);
 }
 
 /*
@@ -323,6 +311,10 @@ trigger_callback_regex_translate_chars (struct t_trigger_context *context,
 {
     char *value, *chars1_eval, *chars2_eval;
 
+    /* chars without variables are used as-is (no evaluation) */
+    if (!strchr (chars1, '$') && !strchr (chars2, '$'))
+        return weechat_string_translate_chars (text, chars1, chars2);
+
     chars1_eval = weechat_string_eval_expression (
         chars1,
         context->pointers,
@@ -423,8 +415,7 @@ trigger_callback_regex (struct t_trigger *trigger,
                 value = trigger_callback_regex_replace (
                     context,
                     ptr_value,
-                    trigger->regex[i].regex,
-                    trigger->regex[i].replace_escaped);
+                    &trigger->regex[i]);
                 break;
             case TRIGGER_REGEX_COMMAND_TRANSLATE_CHARS:
                 value = trigger_callback_regex_translate_chars (
@@ -506,10 +497,13 @@ trigger_callback_run_command (struct t_trigger *trigger,
 
     for (i = 0; trigger->commands[i]; i++)
     {
-        command_eval = weechat_string_eval_expression (trigger->commands[i],
-                                                       context->pointers,
-                                                       context->extra_vars,
-                                                       NULL);
+        /* command without variables is run as-is (no evaluation) */
+        command_eval = (strchr (trigger->commands[i], '$')) ?
+            weechat_string_eval_expression (trigger->commands[i],
+                                            context->pointers,
+                                            context->extra_vars,
+                                            NULL) :
+            strdup (trigger->commands[i]);
         if (command_eval)
         {
             /* display debug info on trigger buffer */
@@ -593,6 +587,7 @@ trigger_callback_execute (struct t_trigger *trigger,
             gettimeofday (&(context->start_run_command), NULL);
         trigger_callback_run_command (trigger, context, display_monitor);
 
+        trigger->hook_count_match++;
         rc = 1;
     }
 
@@ -629,6 +624,29 @@ trigger_callback_execute (struct t_trigger *trigger,
     return rc;
 }
 
+/*
+ * Executes the post action of a trigger (after the callback).
+ */
+
+void
+trigger_callback_post_action (struct t_trigger *trigger)
+{
+    switch (weechat_config_integer (
+                trigger->options[TRIGGER_OPTION_POST_ACTION]))
+    {
+        case TRIGGER_POST_ACTION_DISABLE:
+            weechat_config_option_set (
+                trigger->options[TRIGGER_OPTION_ENABLED], "off", 1);
+            break;
+        case TRIGGER_POST_ACTION_DELETE:
+            trigger_free (trigger);
+            break;
+        default:
+            /* do nothing in the other cases */
+            break;
+    }
+}
+
 /*
  * Callback for a signal hooked.
  */
@@ -996,14 +1014,15 @@ trigger_callback_line_cb (const void *pointer, void *data,
     struct t_hashtable *hashtable;
     struct t_weelist_item *ptr_item;
     unsigned long value;
-    const char *ptr_key, *ptr_value;
-    char **tags, *str_tags, *string_no_color;
+    const char *ptr_key, *ptr_value, **tags;
+    char *str_tags, *string_no_color, *error;
     int rc, num_tags, length;
 
     TRIGGER_CALLBACK_CB_INIT(NULL);
 
     hashtable = NULL;
     tags = NULL;
+    num_tags = 0;
 
     TRIGGER_CALLBACK_CB_NEW_POINTERS;
     TRIGGER_CALLBACK_CB_NEW_VARS_UPDATED;
@@ -1012,6 +1031,7 @@ trigger_callback_line_cb (const void *pointer, void *data,
 
     weechat_hashtable_remove (ctx.extra_vars, "buffer");
     weechat_hashtable_remove (ctx.extra_vars, "tags_count");
+    weechat_hashtable_remove (ctx.extra_vars, "tags_array");
     weechat_hashtable_remove (ctx.extra_vars, "tags");
 
     /* add data in hashtables used for conditions/replace/command */
@@ -1025,17 +1045,28 @@ trigger_callback_line_cb (const void *pointer, void *data,
     ctx.buffer = (void *)value;
 
     weechat_hashtable_set (ctx.pointers, "buffer", ctx.buffer);
-    ptr_value = weechat_hashtable_get (line, "tags");
-    tags = weechat_string_split ((ptr_value) ? ptr_value : "",
-                                 ",",
-                                 NULL,
-                                 WEECHAT_STRING_SPLIT_STRIP_LEFT
-                                 | WEECHAT_STRING_SPLIT_STRIP_RIGHT
-                                 | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
-                                 0,
-                                 &num_tags);
+
+    /* get tags of line (already split by WeeChat) */
+    ptr_value = weechat_hashtable_get (line, "tags_array");
+    if (ptr_value && (ptr_value[0] == '0') && (ptr_value[1] == 'x'))
+    {
+        rc = sscanf (ptr_value + 2, "%lx", &value);
+        if ((rc != EOF) && (rc >= 1))
+            tags = (const char **)value;
+    }
+    ptr_value = weechat_hashtable_get (line, "tags_count");
+    if (tags && ptr_value)
+    {
+        error = NULL;
+        num_tags = (int)strtol (ptr_value, &error, 10);
+        if (!error || error[0] || (num_tags < 0))
+            tags = NULL;
+    }
+    if (!tags)
+        num_tags = 0;
 
     /* build string with tags and commas around: ",tag1,tag2,tag3," */
+    ptr_value = weechat_hashtable_get (line, "tags");
     length = 1 + strlen ((ptr_value) ? ptr_value : "") + 1 + 1;
     str_tags = malloc (length);
     if (str_tags)
@@ -1060,7 +1091,7 @@ trigger_callback_line_cb (const void *pointer, void *data,
     if (string_no_color)
         free (string_no_color);
 
-    if (!trigger_callback_set_tags (ctx.buffer, (const char **)tags, num_tags,
+    if (!trigger_callback_set_tags (ctx.buffer, tags, num_tags,
                                     ctx.extra_vars))
     {
         goto end;
@@ -1119,9 +1150,6 @@ trigger_callback_line_cb (const void *pointer, void *data,
     }
 
 end:
-    if (tags)
-        weechat_string_free_split (tags);
-
     TRIGGER_CALLBACK_CB_END(hashtable);
 }
 
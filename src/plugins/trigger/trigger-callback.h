@@ -48,10 +48,14 @@ struct t_trigger_context
     trigger = (struct t_trigger *)pointer;                      \
     if (!trigger || trigger->hook_running)                      \
         return __rc;                                            \
-    memset (&ctx, 0, sizeof (ctx));                             \
-    if (weechat_trigger_plugin->debug >= 1)                     \
-        gettimeofday (&(ctx.start_exec), NULL);                 \
     trigger->hook_count_cb++;                                   \
+    if (trigger->conditions_static == 0)                        \
+    {                                                           \
+        trigger_callback_post_action (trigger);                 \
+        return __rc;                                            \
+    }                                                           \
+    memset (&ctx, 0, sizeof (ctx));                             \
+    gettimeofday (&(ctx.start_exec), NULL);                     \
     trigger->hook_running = 1;                                  \
     trigger_rc = trigger_return_code[                           \
         weechat_config_integer (                                \
@@ -88,23 +92,15 @@ struct t_trigger_context
     if (ctx.vars_updated)                                       \
         weechat_list_free (ctx.vars_updated);                   \
     trigger->hook_running = 0;                                  \
-    switch (weechat_config_integer (                            \
-                trigger->options[TRIGGER_OPTION_POST_ACTION]))  \
-    {                                                           \
-        case TRIGGER_POST_ACTION_DISABLE:                       \
-            weechat_config_option_set (                         \
-                trigger->options[TRIGGER_OPTION_ENABLED],       \
-                "off", 1);                                      \
-            break;                                              \
-        case TRIGGER_POST_ACTION_DELETE:                        \
-            trigger_free (trigger);                             \
-            break;                                              \
-        default:                                                \
-            /* do nothing in the other cases */                 \
-            break;                                              \
-    }                                                           \
+    gettimeofday (&(ctx.end_exec), NULL);                       \
+    trigger->hook_time += weechat_util_timeval_diff (           \
+        &(ctx.start_exec), &(ctx.end_exec));                    \
+    trigger_callback_post_action (trigger);                     \
     return __rc;
 
+extern struct t_hashtable *trigger_callback_hashtable_options_conditions;
+
+extern void trigger_callback_post_action (struct t_trigger *trigger);
 extern int trigger_callback_signal_cb (const void *pointer, void *data,
                                        const char *signal,
                                        const char *type_data,
@@ -53,8 +53,10 @@ trigger_command_display_trigger_internal (const char *name,
                                           const char *arguments,
                                           const char *conditions,
                                           int hooks_count,
-                                          int hook_count_cb,
-                                          int hook_count_cmd,
+                                          unsigned long long hook_count_cb,
+                                          unsigned long long hook_count_cmd,
+                                          unsigned long long hook_count_match,
+                                          unsigned long long hook_time,
                                           int regex_count,
                                           struct t_trigger_regex *regex,
                                           int commands_count,
@@ -64,7 +66,7 @@ trigger_command_display_trigger_internal (const char *name,
                                           int verbose)
 {
     char str_conditions[64], str_regex[64], str_command[64], str_rc[64];
-    char str_post_action[64], spaces[256];
+    char str_post_action[64], str_stats[128], spaces[256];
     int i, length;
 
     if (verbose >= 1)
@@ -94,11 +96,18 @@ trigger_command_display_trigger_internal (const char *name,
             weechat_printf_date_tags (NULL, 0, "no_trigger",
                                       "%s hooks: %d", spaces, hooks_count);
             weechat_printf_date_tags (NULL, 0, "no_trigger",
-                                      "%s callback: %d",
+                                      "%s callback: %llu",
                                       spaces, hook_count_cb);
             weechat_printf_date_tags (NULL, 0, "no_trigger",
-                                      "%s commands: %d",
+                                      "%s executed: %llu",
+                                      spaces, hook_count_match);
+            weechat_printf_date_tags (NULL, 0, "no_trigger",
+                                      "%s commands: %llu",
                                       spaces, hook_count_cmd);
+            weechat_printf_date_tags (NULL, 0, "no_trigger",
+                                      "%s time: %.6fs",
+                                      spaces,
+                                      (double)hook_time / 1000000);
         }
         if (conditions && conditions[0])
         {
@@ -177,6 +186,7 @@ trigger_command_display_trigger_internal (const char *name,
         str_command[0] = '\0';
         str_rc[0] = '\0';
         str_post_action[0] = '\0';
+        str_stats[0] = '\0';
         if (conditions && conditions[0])
         {
             snprintf (str_conditions, sizeof (str_conditions),
@@ -214,9 +224,21 @@ trigger_command_display_trigger_internal (const char *name,
                       weechat_color (weechat_config_string (trigger_config_color_flag_post_action)),
                       weechat_color ("reset"));
         }
+        if (hook_count_cb > 0)
+        {
+            snprintf (str_stats, sizeof (str_stats),
+                      " %s(%s%llu/%llu, %.3fs%s)%s",
+                      weechat_color ("chat_delimiters"),
+                      weechat_color ("reset"),
+                      hook_count_match,
+                      hook_count_cb,
+                      (double)hook_time / 1000000,
+                      weechat_color ("chat_delimiters"),
+                      weechat_color ("reset"));
+        }
         weechat_printf_date_tags (
             NULL, 0, "no_trigger",
-            "  %s%s%s: %s%s%s%s%s%s%s%s%s%s%s%s%s",
+            "  %s%s%s: %s%s%s%s%s%s%s%s%s%s%s%s%s%s",
             (enabled) ?
             weechat_color (weechat_config_string (trigger_config_color_trigger)) :
             weechat_color (weechat_config_string (trigger_config_color_trigger_disabled)),
@@ -234,7 +256,8 @@ trigger_command_display_trigger_internal (const char *name,
             str_regex,
             str_command,
             str_rc,
-            str_post_action);
+            str_post_action,
+            str_stats);
     }
 }
 
@@ -254,6 +277,8 @@ trigger_command_display_trigger (struct t_trigger *trigger, int verbose)
         trigger->hooks_count,
         trigger->hook_count_cb,
         trigger->hook_count_cmd,
+        trigger->hook_count_match,
+        trigger->hook_time,
         trigger->regex_count,
         trigger->regex,
         trigger->commands_count,
@@ -329,6 +354,8 @@ trigger_command_list_default (int verbose)
             0,
             0,
             0,
+            0,
+            0,
             regex_count,
             regex,
             commands_count,
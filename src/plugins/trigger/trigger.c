@@ -279,6 +279,8 @@ trigger_unhook (struct t_trigger *trigger)
     }
     trigger->hook_count_cb = 0;
     trigger->hook_count_cmd = 0;
+    trigger->hook_count_match = 0;
+    trigger->hook_time = 0;
     if (trigger->hook_print_buffers)
     {
         free (trigger->hook_print_buffers);
@@ -630,6 +632,8 @@ trigger_regex_free (int *regex_count, struct t_trigger_regex **regex)
                 free ((*regex)[i].replace);
             if ((*regex)[i].replace_escaped)
                 free ((*regex)[i].replace_escaped);
+            if ((*regex)[i].options_eval)
+                weechat_hashtable_free ((*regex)[i].options_eval);
         }
         free (*regex);
         *regex = NULL;
@@ -739,6 +743,7 @@ trigger_regex_split (const char *str_regex,
         (*regex)[index].regex = NULL;
         (*regex)[index].replace = NULL;
         (*regex)[index].replace_escaped = NULL;
+        (*regex)[index].options_eval = NULL;
 
         /* set string with regex */
         (*regex)[index].str_regex = weechat_strndup (ptr_regex,
@@ -775,13 +780,28 @@ trigger_regex_split (const char *str_regex,
         if (!(*regex)[index].replace)
             goto memory_error;
 
-        /* set replace_escaped (command "s" only) */
+        /*
+         * set replace_escaped and options for evaluation (command "s" only);
+         * each regex has its own options, so that a nested evaluation (for
+         * example another trigger called by "${info:...}") can not free the
+         * replacement text while it is used
+         */
         if (command == TRIGGER_REGEX_COMMAND_REPLACE)
         {
             (*regex)[index].replace_escaped =
                 weechat_string_convert_escaped_chars ((*regex)[index].replace);
             if (!(*regex)[index].replace_escaped)
                 goto memory_error;
+            (*regex)[index].options_eval = weechat_hashtable_new (
+                32,
+                WEECHAT_HASHTABLE_STRING,
+                WEECHAT_HASHTABLE_STRING,
+                NULL, NULL);
+            if (!(*regex)[index].options_eval)
+                goto memory_error;
+            weechat_hashtable_set ((*regex)[index].options_eval,
+                                   "regex_replace",
+                                   (*regex)[index].replace_escaped);
         }
 
         if (!pos_replace_end)
@@ -871,6 +891,45 @@ trigger_split_command (const char *command,
     }
 }
 
+/*
+ * Compiles conditions of a trigger.
+ *
+ * If conditions do not contain any variable (no "$" in string), the result
+ * is always the same: conditions are evaluated only once here, so that
+ * callbacks do not evaluate them again (and skip immediately the trigger if
+ * conditions are false).
+ */
+
+void
+trigger_compile_conditions (struct t_trigger *trigger)
+{
+    const char *conditions;
+    char *value;
+
+    if (!trigger)
+        return;
+
+    trigger->conditions_static = -1;
+
+    conditions = weechat_config_string (
+        trigger->options[TRIGGER_OPTION_CONDITIONS]);
+    if (!conditions || !conditions[0])
+    {
+        trigger->conditions_static = 1;
+        return;
+    }
+
+    if (strchr (conditions, '$'))
+        return;
+
+    value = weechat_string_eval_expression (
+        conditions, NULL, NULL,
+        trigger_callback_hashtable_options_conditions);
+    trigger->conditions_static = (value && (strcmp (value, "1") == 0)) ? 1 : 0;
+    if (value)
+        free (value);
+}
+
 /*
  * Checks if a trigger name is valid:
  *   - it must not start with "-"
@@ -930,8 +989,11 @@ trigger_alloc (const char *name)
     new_trigger->hooks = NULL;
     new_trigger->hook_count_cb = 0;
     new_trigger->hook_count_cmd = 0;
+    new_trigger->hook_count_match = 0;
+    new_trigger->hook_time = 0;
     new_trigger->hook_running = 0;
     new_trigger->hook_print_buffers = NULL;
+    new_trigger->conditions_static = -1;
     new_trigger->regex_count = 0;
     new_trigger->regex = NULL;
     new_trigger->commands_count = 0;
@@ -1036,6 +1098,8 @@ trigger_new_with_options (const char *name, struct t_config_option **options)
                            &new_trigger->commands_count,
                            &new_trigger->commands);
 
+    trigger_compile_conditions (new_trigger);
+
     trigger_hook (new_trigger);
 
     return new_trigger;
@@ -1306,8 +1370,11 @@ trigger_print_log ()
         }
         weechat_log_printf ("  hook_count_cb . . . . . : %llu",  ptr_trigger->hook_count_cb);
         weechat_log_printf ("  hook_count_cmd. . . . . : %llu",  ptr_trigger->hook_count_cmd);
+        weechat_log_printf ("  hook_count_match. . . . : %llu",  ptr_trigger->hook_count_match);
+        weechat_log_printf ("  hook_time . . . . . . . : %llu",  ptr_trigger->hook_time);
         weechat_log_printf ("  hook_running. . . . . . : %d",    ptr_trigger->hook_running);
         weechat_log_printf ("  hook_print_buffers. . . : '%s'",  ptr_trigger->hook_print_buffers);
+        weechat_log_printf ("  conditions_static . . . : %d",    ptr_trigger->conditions_static);
         weechat_log_printf ("  regex_count . . . . . . : %d",    ptr_trigger->regex_count);
         weechat_log_printf ("  regex . . . . . . . . . : 0x%lx", ptr_trigger->regex);
         for (i = 0; i < ptr_trigger->regex_count; i++)
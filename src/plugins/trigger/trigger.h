@@ -95,6 +95,7 @@ struct t_trigger_regex
     regex_t *regex;                    /* compiled regex                    */
     char *replace;                     /* replacement text                  */
     char *replace_escaped;             /* repl. text (with chars escaped)   */
+    struct t_hashtable *options_eval;  /* options for eval (regex_replace)  */
 };
 
 struct t_trigger
@@ -110,9 +111,17 @@ struct t_trigger
     struct t_hook **hooks;             /* array of hooks (signal, ...)      */
     unsigned long long hook_count_cb;  /* number of calls made to callback  */
     unsigned long long hook_count_cmd; /* number of commands run in callback*/
+    unsigned long long hook_count_match; /* number of calls with conditions */
+                                       /* OK (trigger executed)             */
+    unsigned long long hook_time;      /* total time spent in callback (µs) */
     int hook_running;                  /* 1 if one hook callback is running */
     char *hook_print_buffers;          /* buffers (for hook_print only)     */
 
+    /* conditions */
+    int conditions_static;             /* -1: evaluated in each callback,   */
+                                       /* 0/1: constant conditions (without */
+                                       /* variables), evaluated only once   */
+
     /* regular expressions */
     int regex_count;                   /* number of regex                   */
     struct t_trigger_regex *regex;     /* array of regex                    */
@@ -159,6 +168,7 @@ extern int trigger_regex_split (const char *str_regex,
                                 struct t_trigger_regex **regex);
 extern void trigger_split_command (const char *command,
                                    int *commands_count, char ***commands);
+extern void trigger_compile_conditions (struct t_trigger *trigger);
 extern void trigger_unhook (struct t_trigger *trigger);
 extern void trigger_hook (struct t_trigger *trigger);
 extern int trigger_name_valid (const char *name);
@@ -54,6 +54,7 @@ struct t_upgrade_file;
 struct t_weelist;
 struct t_weelist_item;
 struct t_arraylist;
+struct t_pool;
 struct t_hashtable;
 struct t_hdata;
 struct timeval;
@@ -68,7 +69,7 @@ struct timeval;
  * please change the date with current one; for a second change at same
  * date, increment the 01, otherwise please keep 01.
  */
-#define WEECHAT_PLUGIN_API_VERSION "20221218-01"
+#define WEECHAT_PLUGIN_API_VERSION "20221218-02"
 
 /* macros for defining plugin infos */
 #define WEECHAT_PLUGIN_NAME(__name)                                     \
@@ -466,6 +467,14 @@ struct t_weechat_plugin
     int (*arraylist_clear) (struct t_arraylist *arraylist);
     void (*arraylist_free) (struct t_arraylist *arraylist);
 
+    /* pools of objects */
+    struct t_pool *(*pool_new) (struct t_weechat_plugin *plugin,
+                                const char *name, int object_size,
+                                int objects_per_slab);
+    void *(*pool_alloc) (struct t_pool *pool);
+    void (*pool_release) (struct t_pool *pool, void *object);
+    void (*pool_free) (struct t_pool *pool);
+
     /* hash tables */
     struct t_hashtable *(*hashtable_new) (int size,
                                           const char *type_keys,
@@ -1504,6 +1513,17 @@ extern int weechat_plugin_end (struct t_weechat_plugin *plugin);
 #define weechat_arraylist_free(__arraylist)                             \
     (weechat_plugin->arraylist_free)(__arraylist)
 
+/* pools of objects */
+#define weechat_pool_new(__name, __object_size, __objects_per_slab)     \
+    (weechat_plugin->pool_new)(weechat_plugin, __name, __object_size,   \
+                               __objects_per_slab)
+#define weechat_pool_alloc(__pool)                                      \
+    (weechat_plugin->pool_alloc)(__pool)
+#define weechat_pool_release(__pool, __object)                          \
+    (weechat_plugin->pool_release)(__pool, __object)
+#define weechat_pool_free(__pool)                                       \
+    (weechat_plugin->pool_free)(__pool)
+
 /* hash tables */
 #define weechat_hashtable_new(__size, __type_keys, __type_values,       \
                               __callback_hash_key, __callback_keycmp)   \
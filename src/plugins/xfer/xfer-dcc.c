@@ -19,6 +19,10 @@
  * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -26,6 +30,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 #include <poll.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -38,30 +46,147 @@
 #include "../weechat-plugin.h"
 #include "xfer.h"
 #include "xfer-config.h"
+#include "xfer-dcc.h"
 #include "xfer-file.h"
 #include "xfer-network.h"
 
 
 /*
- * Child process for sending file with DCC protocol.
+ * Refills tokens allowed for sending with a speed limit (token bucket):
+ * tokens are added according to the time elapsed since last refill, up to
+ * one second of transfer.
  */
 
 void
-xfer_dcc_send_file_child (struct t_xfer *xfer)
+xfer_dcc_send_file_refill (struct t_xfer *xfer, unsigned long long speed_limit)
+{
+    struct timeval now;
+    long long diff;
+    unsigned long long max_tokens, new_tokens;
+
+    gettimeofday (&now, NULL);
+    diff = weechat_util_timeval_diff (&xfer->send_last_refill, &now);
+    if (diff <= 0)
+        return;
+
+    max_tokens = speed_limit * 1024;
+    new_tokens = (max_tokens * (unsigned long long)diff) / 1000000;
+    if (new_tokens == 0)
+        return;
+
+    xfer->send_tokens += new_tokens;
+    if (xfer->send_tokens > max_tokens)
+        xfer->send_tokens = max_tokens;
+    xfer->send_last_refill = now;
+}
+
+/*
+ * Sends a block of file to receiver, at current position in file.
+ *
+ * If available, sendfile() is used so that data is not copied in user
+ * space, otherwise the block is read in a buffer and then sent.
+ *
+ * Returns:
+ *   > 0: number of bytes sent
+ *     0: socket not ready for write
+ *    -1: error on socket
+ *    -2: error reading local file
+ */
+
+int
+xfer_dcc_send_file_block (struct t_xfer *xfer, size_t length)
 {
-    int num_read, num_sent;
     static char buffer[XFER_BLOCKSIZE_MAX];
+    ssize_t num_read, num_sent;
+#ifdef HAVE_SYS_SENDFILE_H
+    off_t offset;
+
+    offset = (off_t)xfer->pos;
+    num_sent = sendfile (xfer->sock, xfer->file, &offset, length);
+    if (num_sent > 0)
+        return (int)num_sent;
+    if (num_sent == 0)
+        return -2;
+    if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+        return 0;
+    if ((errno != EINVAL) && (errno != ENOSYS))
+        return -1;
+    /* sendfile is not supported for this file: read and send the block */
+#endif /* HAVE_SYS_SENDFILE_H */
+
+    if (length > sizeof (buffer))
+        length = sizeof (buffer);
+    num_read = pread (xfer->file, buffer, length, (off_t)xfer->pos);
+    if (num_read < 1)
+        return -2;
+    num_sent = send (xfer->sock, buffer, num_read, 0);
+    if (num_sent < 0)
+    {
+        return ((errno == EAGAIN) || (errno == EWOULDBLOCK)
+                || (errno == EINTR)) ? 0 : -1;
+    }
+    return (int)num_sent;
+}
+
+/*
+ * Reads ACKs sent by receiver: all complete ACKs available on socket are
+ * read at once, and only the last one is kept.
+ *
+ * Returns:
+ *   1: OK (ACKs read, or nothing to read)
+ *   0: socket closed by receiver or error on socket
+ */
+
+int
+xfer_dcc_send_file_read_ack (struct t_xfer *xfer)
+{
+    unsigned char buffer[4 * 64];
     uint32_t ack;
-    time_t last_sent, new_time, last_second, sent_ok;
-    unsigned long long blocksize, speed_limit, sent_last_second;
+    int num_read;
 
-    /* empty file? just return immediately */
-    if (xfer->pos >= xfer->size)
+    while (1)
     {
-        xfer_network_write_pipe (xfer, XFER_STATUS_DONE,
-                                 XFER_NO_ERROR);
-        return;
+        num_read = recv (xfer->sock, buffer, sizeof (buffer), MSG_PEEK);
+        if (num_read == 0)
+            return 0;
+        if (num_read < 0)
+        {
+            return ((errno == EAGAIN) || (errno == EWOULDBLOCK)
+                    || (errno == EINTR)) ? 1 : 0;
+        }
+
+        /* read only complete ACKs (4 bytes each) */
+        num_read -= num_read % 4;
+        if (num_read == 0)
+            return 1;
+        num_read = recv (xfer->sock, buffer, num_read, 0);
+        if (num_read < 4)
+            return 1;
+        memcpy (&ack, buffer + num_read - 4, 4);
+        xfer->ack = ntohl (ack);
+
+        if (num_read < (int)sizeof (buffer))
+            return 1;
     }
+}
+
+/*
+ * Sends blocks of file while the socket is ready for write, the speed limit
+ * is not reached and (if fast send is off) the receiver has acknowledged
+ * all data sent.
+ *
+ * Returns:
+ *   > 0: delay (in milliseconds) before next blocks can be sent (speed limit)
+ *     0: OK
+ *    -1: error (xfer is closed)
+ */
+
+int
+xfer_dcc_send_file_blocks (struct t_xfer *xfer)
+{
+    unsigned long long blocksize, speed_limit, length;
+    int i, num_sent, delay;
+    time_t now;
 
     speed_limit = (unsigned long long)weechat_config_integer (
         xfer_config_network_speed_limit_send);
@@ -70,118 +195,225 @@ xfer_dcc_send_file_child (struct t_xfer *xfer)
     if ((speed_limit > 0) && (blocksize > speed_limit * 1024))
         blocksize = speed_limit * 1024;
 
-    last_sent = time (NULL);
-    last_second = last_sent;
-    sent_ok = 0;
-    sent_last_second = 0;
-    while (1)
+    if (speed_limit > 0)
+        xfer_dcc_send_file_refill (xfer, speed_limit);
+
+    delay = 0;
+    for (i = 0; i < XFER_DCC_SEND_MAX_BLOCKS; i++)
     {
-        /* read DCC ACK (sent by receiver) */
-        if (xfer->pos > xfer->ack)
-        {
-            /* we should receive ACK for packets sent previously */
-            while (1)
-            {
-                num_read = recv (xfer->sock, (char *) &ack, 4, MSG_PEEK);
-                if ((num_read < 1) &&
-                    ((num_read != -1) || ((errno != EAGAIN) && (errno != EWOULDBLOCK))))
-                {
-                    xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
-                                             XFER_ERROR_SEND_BLOCK);
-                    return;
-                }
-                if (num_read == 4)
-                {
-                    recv (xfer->sock, (char *) &ack, 4, 0);
-                    xfer->ack = ntohl (ack);
+        if (xfer->pos >= xfer->size)
+            break;
 
-                    /* DCC send OK? */
-                    if ((xfer->pos >= xfer->size)
-                        && (xfer->ack >= xfer->size))
-                    {
-                        xfer_network_write_pipe (xfer, XFER_STATUS_DONE,
-                                                 XFER_NO_ERROR);
-                        return;
-                    }
-                }
-                else
-                    break;
-            }
-        }
+        /* without fast send, wait for ACK of data sent */
+        if (!xfer->fast_send && (xfer->pos > xfer->ack))
+            break;
 
-        /* send a block to receiver */
-        if ((xfer->pos < xfer->size) &&
-             (xfer->fast_send || (xfer->pos <= xfer->ack)))
+        length = xfer->size - xfer->pos;
+        if (length > blocksize)
+            length = blocksize;
+
+        /* we're sending too fast (according to speed limit set by user) */
+        if ((speed_limit > 0) && (xfer->send_tokens < length))
         {
-            if ((speed_limit > 0) && (sent_last_second >= speed_limit * 1024))
-            {
-                /* we're sending too fast (according to speed limit set by user) */
-                usleep (100);
-            }
-            else
-            {
-                lseek (xfer->file, xfer->pos, SEEK_SET);
-                num_read = read (xfer->file, buffer, blocksize);
-                if (num_read < 1)
-                {
-                    xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
-                                             XFER_ERROR_READ_LOCAL);
-                    return;
-                }
-                num_sent = send (xfer->sock, buffer, num_read, 0);
-                if (num_sent < 0)
-                {
-                    /*
-                     * socket is temporarily not available (receiver can't
-                     * receive amount of data we sent ?!)
-                     */
-                    if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
-                        usleep (1000);
-                    else
-                    {
-                        xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
-                                                 XFER_ERROR_SEND_BLOCK);
-                        return;
-                    }
-                }
-                if (num_sent > 0)
-                {
-                    xfer->pos += (unsigned long long) num_sent;
-                    sent_last_second += (unsigned long long) num_sent;
-                    new_time = time (NULL);
-                    if ((last_sent != new_time)
-                        || ((sent_ok == 0) && (xfer->pos >= xfer->size)))
-                    {
-                        last_sent = new_time;
-                        xfer_network_write_pipe (xfer, XFER_STATUS_ACTIVE,
-                                                 XFER_NO_ERROR);
-                        if (xfer->pos >= xfer->size)
-                            sent_ok = new_time;
-                    }
-                }
-            }
+            delay = (int)(((length - xfer->send_tokens) * 1000)
+                          / (speed_limit * 1024)) + 1;
+            break;
         }
-        else
-            usleep (1000);
 
-        new_time = time (NULL);
-        if (new_time > last_second)
+        num_sent = xfer_dcc_send_file_block (xfer, length);
+        if (num_sent == 0)
+            break;
+        if (num_sent < 0)
         {
-            last_second = new_time;
-            sent_last_second = 0;
+            xfer_network_set_status (xfer, XFER_STATUS_FAILED,
+                                     (num_sent == -2) ?
+                                     XFER_ERROR_READ_LOCAL :
+                                     XFER_ERROR_SEND_BLOCK);
+            return -1;
         }
 
-        /*
-         * if send if OK since 2 seconds or more, and that no ACK was received,
-         * then consider it's OK
-         */
-        if ((sent_ok != 0) && (new_time > sent_ok + 2))
+        xfer->pos += (unsigned long long)num_sent;
+        if (speed_limit > 0)
+            xfer->send_tokens -= (unsigned long long)num_sent;
+
+        /* file sent: update status now */
+        if (xfer->pos >= xfer->size)
+            xfer->send_last_status = 0;
+    }
+
+    /* update status of DCC (at most once per second) */
+    now = time (NULL);
+    if (now != xfer->send_last_status)
+    {
+        xfer->send_last_status = now;
+        xfer_network_set_status (xfer, XFER_STATUS_ACTIVE, XFER_NO_ERROR);
+    }
+
+    return delay;
+}
+
+/*
+ * Sends file and updates hooks used for the transfer:
+ *   - hook on socket, waiting for ACKs and (only if blocks can be sent)
+ *     for socket ready for write
+ *   - timer when the speed limit is reached, or to end the transfer if no
+ *     ACK is received after the whole file was sent.
+ */
+
+void
+xfer_dcc_send_file_run (struct t_xfer *xfer)
+{
+    int delay, wait_write;
+
+    delay = xfer_dcc_send_file_blocks (xfer);
+    if (delay < 0)
+        return;
+
+    wait_write = ((delay == 0)
+                  && (xfer->pos < xfer->size)
+                  && (xfer->fast_send || (xfer->pos <= xfer->ack))) ? 1 : 0;
+
+    if (!xfer->hook_fd || (wait_write != xfer->send_wait_write))
+    {
+        if (xfer->hook_fd)
+            weechat_unhook (xfer->hook_fd);
+        xfer->hook_fd = weechat_hook_fd (xfer->sock,
+                                         1, wait_write, 0,
+                                         &xfer_dcc_send_file_fd_cb,
+                                         xfer, NULL);
+        xfer->send_wait_write = wait_write;
+    }
+
+    if (!xfer->hook_timer)
+    {
+        if (delay > 0)
         {
-            xfer_network_write_pipe (xfer, XFER_STATUS_DONE,
-                                     XFER_NO_ERROR);
-            return;
+            xfer->hook_timer = weechat_hook_timer (
+                delay, 0, 1,
+                &xfer_dcc_send_file_timer_cb, xfer, NULL);
         }
+        else if (xfer->pos >= xfer->size)
+        {
+            xfer->hook_timer = weechat_hook_timer (
+                XFER_DCC_SEND_ACK_TIMEOUT * 1000, 0, 1,
+                &xfer_dcc_send_file_timer_cb, xfer, NULL);
+        }
+    }
+}
+
+/*
+ * Callback called when socket is ready for write, or when ACKs are sent by
+ * receiver.
+ */
+
+int
+xfer_dcc_send_file_fd_cb (const void *pointer, void *data, int fd)
+{
+    struct t_xfer *xfer;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) fd;
+
+    xfer = (struct t_xfer *)pointer;
+
+    if (!xfer_dcc_send_file_read_ack (xfer))
+    {
+        /* socket closed by receiver: OK only if the whole file was sent */
+        if (xfer->pos >= xfer->size)
+            xfer_network_set_status (xfer, XFER_STATUS_DONE, XFER_NO_ERROR);
+        else
+            xfer_network_set_status (xfer, XFER_STATUS_FAILED,
+                                     XFER_ERROR_READ_ACK);
+        return WEECHAT_RC_OK;
+    }
+
+    /* DCC send OK? */
+    if ((xfer->pos >= xfer->size) && (xfer->ack >= xfer->size))
+    {
+        xfer_network_set_status (xfer, XFER_STATUS_DONE, XFER_NO_ERROR);
+        return WEECHAT_RC_OK;
+    }
+
+    xfer_dcc_send_file_run (xfer);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Callback for timer: resumes the transfer after a pause (speed limit), or
+ * ends it if no ACK was received after the whole file was sent.
+ */
+
+int
+xfer_dcc_send_file_timer_cb (const void *pointer, void *data,
+                             int remaining_calls)
+{
+    struct t_xfer *xfer;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) remaining_calls;
+
+    xfer = (struct t_xfer *)pointer;
+
+    /* timer is called only once, it is removed after this call */
+    xfer->hook_timer = NULL;
+
+    /*
+     * if send is OK since a while and that no ACK was received,
+     * then consider it's OK
+     */
+    if (xfer->pos >= xfer->size)
+    {
+        xfer_network_set_status (xfer, XFER_STATUS_DONE, XFER_NO_ERROR);
+        return WEECHAT_RC_OK;
     }
+
+    xfer_dcc_send_file_run (xfer);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Starts sending of file with DCC protocol (in main process, without fork).
+ */
+
+void
+xfer_dcc_send_file_start (struct t_xfer *xfer)
+{
+    if (xfer->file < 0)
+    {
+        xfer_network_set_status (xfer, XFER_STATUS_FAILED,
+                                 XFER_ERROR_READ_LOCAL);
+        return;
+    }
+
+    /* empty file? just return immediately */
+    if (xfer->pos >= xfer->size)
+    {
+        xfer_network_set_status (xfer, XFER_STATUS_DONE, XFER_NO_ERROR);
+        return;
+    }
+
+    if (xfer->hook_fd)
+    {
+        weechat_unhook (xfer->hook_fd);
+        xfer->hook_fd = NULL;
+    }
+    if (xfer->hook_timer)
+    {
+        weechat_unhook (xfer->hook_timer);
+        xfer->hook_timer = NULL;
+    }
+
+    xfer->send_tokens = (unsigned long long)weechat_config_integer (
+        xfer_config_network_speed_limit_send) * 1024;
+    gettimeofday (&xfer->send_last_refill, NULL);
+    xfer->send_last_status = time (NULL);
+    xfer->send_wait_write = 0;
+
+    xfer_dcc_send_file_run (xfer);
 }
 
 /*
@@ -229,7 +461,12 @@ xfer_dcc_recv_file_send_ack (struct t_xfer *xfer)
 }
 
 /*
- * Reads a resumed xfer from disk for hashing.
+ * Hashes a part of the file already written on disk: data received before
+ * a resume, or data received while the hash was not up to date.
+ *
+ * One block (at most "size_buffer" bytes) is read, starting at position
+ * "*pos_hashed" and up to position "pos_max" (excluded); "*pos_hashed" is
+ * updated with the number of bytes hashed.
  *
  * Returns:
  *   1: OK
@@ -237,109 +474,189 @@ xfer_dcc_recv_file_send_ack (struct t_xfer *xfer)
  */
 
 int
-xfer_dcc_resume_hash (struct t_xfer *xfer)
+xfer_dcc_resume_hash (struct t_xfer *xfer, int fd,
+                      char *buffer, size_t size_buffer,
+                      unsigned long long *pos_hashed,
+                      unsigned long long pos_max)
 {
-    char *buf;
-    unsigned long long total_read;
-    ssize_t length_buf, to_read, num_read;
-    int ret, fd;
-
-    total_read = 0;
-    ret = 1;
-    fd = 0;
-
-    length_buf = 1024 * 1024;
-    buf = malloc (length_buf);
-    if (!buf)
+    size_t to_read;
+    ssize_t num_read;
+
+    if (!xfer->hash_handle || (fd < 0) || !buffer || !pos_hashed)
         return 0;
 
-    while (fd <= 0)
+    if (*pos_hashed >= pos_max)
+        return 1;
+
+    to_read = size_buffer;
+    if (pos_max - *pos_hashed < to_read)
+        to_read = pos_max - *pos_hashed;
+
+    while (1)
     {
-        fd = open (xfer->temp_local_filename, O_RDONLY);
-        if (fd < 0)
+        num_read = pread (fd, buffer, to_read, (off_t)(*pos_hashed));
+        if (num_read > 0)
         {
-            if (errno == EINTR)
-                continue;
-            fd = 0;
-            ret = 0;
-            break;
+            gcry_md_write (*xfer->hash_handle, buffer, num_read);
+            *pos_hashed += num_read;
+            return 1;
         }
+        if ((num_read < 0) && (errno == EINTR))
+            continue;
+        /* read error or unexpected end of file */
+        return 0;
     }
+}
+
+/*
+ * Pre-allocates space on disk for the data not yet received, so that the
+ * file is less fragmented (the size of file is not changed, so that a
+ * resume is still possible if the transfer fails).
+ */
+
+void
+xfer_dcc_recv_file_allocate (struct t_xfer *xfer)
+{
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE)
+    int rc;
+
+    if ((xfer->file < 0) || (xfer->size <= xfer->pos))
+        return;
+
+    /* error is ignored: file system may not support it */
+    rc = fallocate (xfer->file, FALLOC_FL_KEEP_SIZE, (off_t)xfer->pos,
+                    (off_t)(xfer->size - xfer->pos));
+    (void) rc;
+#else
+    /* make C compiler happy */
+    (void) xfer;
+#endif /* defined(HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE) */
+}
+
+/*
+ * Writes data received in the file.
+ *
+ * Returns:
+ *   1: OK
+ *   0: write error
+ */
 
-    if (fd)
+int
+xfer_dcc_recv_file_write (struct t_xfer *xfer, const char *buffer,
+                          size_t length)
+{
+    ssize_t written;
+    size_t total_written;
+
+    total_written = 0;
+    while (total_written < length)
     {
-        while (total_read < xfer->start_resume)
+        written = write (xfer->file, buffer + total_written,
+                         length - total_written);
+        if (written < 0)
         {
-            to_read = xfer->start_resume - total_read;
-            if (to_read > length_buf)
-                num_read = read (fd, buf, length_buf);
-            else
-                num_read = read (fd, buf, to_read);
-            if (num_read > 0)
-            {
-                gcry_md_write (*xfer->hash_handle, buf, num_read);
-                total_read += num_read;
-            }
-            else if (num_read < 0)
-            {
-                if (errno == EINTR)
-                    continue;
-                ret = 0;
-                break;
-            }
+            if (errno == EINTR)
+                continue;
+            return 0;
         }
+        total_written += written;
+    }
 
-        while (close (fd) < 0)
-        {
-            if (errno != EINTR)
-                break;
-        }
+    return 1;
+}
+
+/*
+ * Writes data received (in buffer) to disk, and updates the hash if it is up
+ * to date (otherwise the data will be hashed later, read from disk).
+ *
+ * In case of error, the status "failed" is sent to parent process.
+ *
+ * Returns:
+ *   1: OK
+ *   0: write error
+ */
+
+int
+xfer_dcc_recv_file_flush (struct t_xfer *xfer, const char *buffer,
+                          size_t *buffer_used,
+                          unsigned long long *pos_written,
+                          unsigned long long *pos_hashed)
+{
+    if (*buffer_used == 0)
+        return 1;
+
+    if (!xfer_dcc_recv_file_write (xfer, buffer, *buffer_used))
+    {
+        xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
+                                 XFER_ERROR_WRITE_LOCAL);
+        return 0;
     }
 
-    free (buf);
+    if (xfer->hash_handle && (*pos_hashed == *pos_written))
+    {
+        gcry_md_write (*xfer->hash_handle, buffer, *buffer_used);
+        *pos_hashed += *buffer_used;
+    }
 
-    return ret;
+    *pos_written += *buffer_used;
+    *buffer_used = 0;
+
+    return 1;
 }
 
 /*
  * Child process for receiving file with DCC protocol.
+ *
+ * Data received is accumulated in a large buffer, which is written to disk
+ * when it is full or when there is no more data available on socket (then an
+ * ACK is sent).
+ *
+ * The CRC32 hash is computed during reception: data received is hashed
+ * directly, except if the file is resumed: then the part of the file already
+ * on disk is hashed by blocks while data is received, and the hash is
+ * computed on received data when it is up to date.
  */
 
 void
 xfer_dcc_recv_file_child (struct t_xfer *xfer)
 {
-    int flags, num_read, ready;
-    static char buffer[XFER_BLOCKSIZE_MAX];
+    int flags, ready, fd_hash;
+    char *buffer, *buffer_hash, hash[9];
+    size_t buffer_used;
+    ssize_t num_read;
     time_t last_sent, last_second, new_time;
     unsigned long long blocksize, pos_last_ack, speed_limit, recv_last_second;
+    unsigned long long pos_hashed, pos_written;
     struct pollfd poll_fd;
-    ssize_t written, total_written;
     unsigned char *bin_hash;
-    char hash[9];
 
     speed_limit = (unsigned long long)weechat_config_integer (
         xfer_config_network_speed_limit_recv);
 
-    blocksize = sizeof (buffer);
+    buffer = malloc (XFER_DCC_RECV_BUFFER_SIZE);
+    buffer_hash = (xfer->hash_handle) ?
+        malloc (XFER_DCC_RECV_HASH_BLOCKSIZE) : NULL;
+    if (!buffer || (xfer->hash_handle && !buffer_hash))
+    {
+        free (buffer);
+        free (buffer_hash);
+        xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
+                                 XFER_ERROR_WRITE_LOCAL);
+        return;
+    }
+    buffer_used = 0;
+
+    blocksize = XFER_DCC_RECV_BUFFER_SIZE;
     if ((speed_limit > 0) && (blocksize > speed_limit * 1024))
         blocksize = speed_limit * 1024;
 
-    /* if resuming, hash the portion of the file we have */
+    pos_written = xfer->pos;
+    pos_hashed = 0;
+    fd_hash = -1;
     if ((xfer->start_resume > 0) && xfer->hash_handle)
-    {
-        xfer_network_write_pipe (xfer, XFER_STATUS_HASHING,
-                                 XFER_NO_ERROR);
-        if (!xfer_dcc_resume_hash (xfer))
-        {
-            gcry_md_close (*xfer->hash_handle);
-            free (xfer->hash_handle);
-            xfer->hash_handle = NULL;
-            xfer_network_write_pipe (xfer, XFER_STATUS_HASHING,
-                                     XFER_ERROR_HASH_RESUME_ERROR);
-        }
-        xfer_network_write_pipe (xfer, XFER_STATUS_CONNECTING,
-                                 XFER_NO_ERROR);
-    }
+        fd_hash = open (xfer->temp_local_filename, O_RDONLY);
+
+    xfer_dcc_recv_file_allocate (xfer);
 
     /* first connect to sender (blocking) */
     xfer->sock = weechat_network_connect_to (xfer->proxy,
@@ -349,7 +666,7 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
     {
         xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
                                  XFER_ERROR_CONNECT_SENDER);
-        return;
+        goto end;
     }
 
     /* set TCP_NODELAY to be more aggressive with acks */
@@ -373,21 +690,38 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
 
     while (1)
     {
-        /* wait until there is something to read on socket (or error) */
+        /*
+         * wait until there is something to read on socket (or error);
+         * if the hash is late, do not wait: hash next block of file
+         */
         poll_fd.fd = xfer->sock;
         poll_fd.events = POLLIN;
         poll_fd.revents = 0;
-        ready = poll (&poll_fd, 1, -1);
-        if (ready <= 0)
+        ready = poll (&poll_fd, 1,
+                      (xfer->hash_handle && (pos_hashed < pos_written)) ?
+                      0 : -1);
+        if (ready < 0)
         {
             if ((errno == EINTR) || (errno == EAGAIN))
                 continue;
-            else
+            xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
+                                     XFER_ERROR_RECV_BLOCK);
+            goto end;
+        }
+        if (ready == 0)
+        {
+            if (xfer->hash_handle
+                && !xfer_dcc_resume_hash (xfer, fd_hash, buffer_hash,
+                                          XFER_DCC_RECV_HASH_BLOCKSIZE,
+                                          &pos_hashed, pos_written))
             {
-                xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
-                                         XFER_ERROR_RECV_BLOCK);
-                return;
+                gcry_md_close (*xfer->hash_handle);
+                free (xfer->hash_handle);
+                xfer->hash_handle = NULL;
+                xfer_network_write_pipe (xfer, XFER_STATUS_ACTIVE,
+                                         XFER_ERROR_HASH_RESUME_ERROR);
             }
+            continue;
         }
 
         /* read maximum data on socket (until nothing is available) */
@@ -403,114 +737,131 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
             }
             else
             {
-                num_read = recv (xfer->sock, buffer, blocksize, 0);
+                if (buffer_used + blocksize > XFER_DCC_RECV_BUFFER_SIZE)
+                {
+                    num_read = recv (xfer->sock, buffer + buffer_used,
+                                     XFER_DCC_RECV_BUFFER_SIZE - buffer_used,
+                                     0);
+                }
+                else
+                {
+                    num_read = recv (xfer->sock, buffer + buffer_used,
+                                     blocksize, 0);
+                }
                 if (num_read == -1)
                 {
-                    if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+                    if (errno == EINTR)
+                        continue;
+                    if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
                     {
                         xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
                                                  XFER_ERROR_RECV_BLOCK);
-                        return;
+                        goto end;
                     }
                     /*
-                     * no more data available on socket: exit loop, send ACK, and
-                     * wait for new data on socket
+                     * no more data available on socket: exit loop, write
+                     * data, send ACK, and wait for new data on socket
                      */
                     break;
                 }
-                else
+
+                if ((num_read == 0) && (xfer->pos < xfer->size))
+                {
+                    xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
+                                             XFER_ERROR_RECV_BLOCK);
+                    goto end;
+                }
+
+                buffer_used += num_read;
+                xfer->pos += (unsigned long long)num_read;
+                recv_last_second += (unsigned long long)num_read;
+
+                /* buffer full or file received: write data to disk */
+                if ((buffer_used >= XFER_DCC_RECV_BUFFER_SIZE)
+                    || (xfer->pos >= xfer->size))
                 {
-                    if ((num_read == 0) && (xfer->pos < xfer->size))
+                    if (!xfer_dcc_recv_file_flush (xfer, buffer, &buffer_used,
+                                                   &pos_written, &pos_hashed))
                     {
-                        xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
-                                                 XFER_ERROR_RECV_BLOCK);
-                        return;
+                        goto end;
                     }
+                }
 
-                    /* bytes received, write to disk */
-                    total_written = 0;
-                    while (total_written < num_read)
+                /* file received OK? */
+                if (xfer->pos >= xfer->size)
+                {
+                    /* hash the end of file (if hash is late) */
+                    if (xfer->hash_handle && (pos_hashed < pos_written))
                     {
-                        written = write (xfer->file,
-                                         buffer + total_written,
-                                         num_read - total_written);
-                        if (written < 0)
-                        {
-                            if (errno == EINTR)
-                                continue;
-                            xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
-                                                     XFER_ERROR_WRITE_LOCAL);
-                            return;
-                        }
-                        else
+                        xfer_network_write_pipe (xfer, XFER_STATUS_HASHING,
+                                                 XFER_NO_ERROR);
+                        while (xfer->hash_handle && (pos_hashed < pos_written))
                         {
-                            if (xfer->hash_handle)
+                            if (!xfer_dcc_resume_hash (
+                                    xfer, fd_hash, buffer_hash,
+                                    XFER_DCC_RECV_HASH_BLOCKSIZE,
+                                    &pos_hashed, pos_written))
                             {
-                                gcry_md_write (*xfer->hash_handle,
-                                               buffer + total_written,
-                                               written);
+                                gcry_md_close (*xfer->hash_handle);
+                                free (xfer->hash_handle);
+                                xfer->hash_handle = NULL;
+                                xfer_network_write_pipe (
+                                    xfer, XFER_STATUS_HASHING,
+                                    XFER_ERROR_HASH_RESUME_ERROR);
                             }
-                            total_written += written;
                         }
                     }
 
-                    xfer->pos += (unsigned long long) num_read;
-                    recv_last_second += (unsigned long long) num_read;
-
-                    /* file received OK? */
-                    if (xfer->pos >= xfer->size)
+                    /* check hash and report result to pipe */
+                    if (xfer->hash_handle)
                     {
-                        /* check hash and report result to pipe */
-                        if (xfer->hash_handle)
+                        gcry_md_final (*xfer->hash_handle);
+                        bin_hash = gcry_md_read (*xfer->hash_handle, 0);
+                        if (bin_hash)
                         {
-                            gcry_md_final (*xfer->hash_handle);
-                            bin_hash = gcry_md_read (*xfer->hash_handle, 0);
-                            if (bin_hash)
+                            snprintf (hash, sizeof (hash), "%.2X%.2X%.2X%.2X",
+                                      bin_hash[0], bin_hash[1], bin_hash[2],
+                                      bin_hash[3]);
+                            if (weechat_strcasecmp (hash,
+                                                    xfer->hash_target) == 0)
                             {
-                                snprintf (hash, sizeof (hash), "%.2X%.2X%.2X%.2X",
-                                          bin_hash[0], bin_hash[1], bin_hash[2],
-                                          bin_hash[3]);
-                                if (weechat_strcasecmp (hash,
-                                                        xfer->hash_target) == 0)
-                                {
-                                    xfer_network_write_pipe (xfer,
-                                                             XFER_STATUS_HASHED,
-                                                             XFER_NO_ERROR);
-                                }
-                                else
-                                {
-                                    xfer_network_write_pipe (xfer,
-                                                             XFER_STATUS_HASHED,
-                                                             XFER_ERROR_HASH_MISMATCH);
-                                }
+                                xfer_network_write_pipe (xfer,
+                                                         XFER_STATUS_HASHED,
+                                                         XFER_NO_ERROR);
+                            }
+                            else
+                            {
+                                xfer_network_write_pipe (xfer,
+                                                         XFER_STATUS_HASHED,
+                                                         XFER_ERROR_HASH_MISMATCH);
                             }
                         }
+                    }
 
-                        fsync (xfer->file);
+                    fsync (xfer->file);
 
-                        /*
-                         * extra delay before sending ACK, otherwise the send of ACK
-                         * may fail
-                         */
-                        usleep (100000);
+                    /*
+                     * extra delay before sending ACK, otherwise the send of ACK
+                     * may fail
+                     */
+                    usleep (100000);
 
-                        /* send ACK to sender without checking return code (file OK) */
-                        xfer_dcc_recv_file_send_ack (xfer);
+                    /* send ACK to sender without checking return code (file OK) */
+                    xfer_dcc_recv_file_send_ack (xfer);
 
-                        /* set status done and return */
-                        xfer_network_write_pipe (xfer, XFER_STATUS_DONE,
-                                                 XFER_NO_ERROR);
-                        return;
-                    }
+                    /* set status done and return */
+                    xfer_network_write_pipe (xfer, XFER_STATUS_DONE,
+                                             XFER_NO_ERROR);
+                    goto end;
+                }
 
-                    /* update status of DCC (parent process) */
-                    new_time = time (NULL);
-                    if (last_sent != new_time)
-                    {
-                        last_sent = new_time;
-                        xfer_network_write_pipe (xfer, XFER_STATUS_ACTIVE,
-                                                 XFER_NO_ERROR);
-                    }
+                /* update status of DCC (parent process) */
+                new_time = time (NULL);
+                if (last_sent != new_time)
+                {
+                    last_sent = new_time;
+                    xfer_network_write_pipe (xfer, XFER_STATUS_ACTIVE,
+                                             XFER_NO_ERROR);
                 }
             }
 
@@ -522,6 +873,13 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
             }
         }
 
+        /* no more data on socket: write data received to disk */
+        if (!xfer_dcc_recv_file_flush (xfer, buffer, &buffer_used,
+                                       &pos_written, &pos_hashed))
+        {
+            goto end;
+        }
+
         /* send ACK to sender (if needed) */
         if (xfer->send_ack && (xfer->pos > pos_last_ack))
         {
@@ -531,7 +889,7 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
                     /* send error, socket down? */
                     xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
                                              XFER_ERROR_SEND_ACK);
-                    return;
+                    goto end;
                 case 1:
                     /* send error, not fatal (buffer full?): disable ACKs */
                     xfer->send_ack = 0;
@@ -543,4 +901,10 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
             }
         }
     }
+
+end:
+    if (fd_hash >= 0)
+        close (fd_hash);
+    free (buffer);
+    free (buffer_hash);
 }
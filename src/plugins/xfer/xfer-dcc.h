@@ -20,7 +20,16 @@
 #ifndef WEECHAT_PLUGIN_XFER_DCC_H
 #define WEECHAT_PLUGIN_XFER_DCC_H
 
-extern void xfer_dcc_send_file_child (struct t_xfer *xfer);
+#define XFER_DCC_SEND_MAX_BLOCKS  64   /* max blocks sent in one callback   */
+#define XFER_DCC_SEND_ACK_TIMEOUT  2   /* seconds to wait for last ACK      */
+
+#define XFER_DCC_RECV_BUFFER_SIZE    (1024 * 1024) /* data written at once   */
+#define XFER_DCC_RECV_HASH_BLOCKSIZE (256 * 1024)  /* block hashed from disk */
+
+extern int xfer_dcc_send_file_fd_cb (const void *pointer, void *data, int fd);
+extern int xfer_dcc_send_file_timer_cb (const void *pointer, void *data,
+                                        int remaining_calls);
+extern void xfer_dcc_send_file_start (struct t_xfer *xfer);
 extern void xfer_dcc_recv_file_child (struct t_xfer *xfer);
 
 #endif /* WEECHAT_PLUGIN_XFER_DCC_H */
@@ -42,6 +42,7 @@
 #include "xfer-config.h"
 #include "xfer-dcc.h"
 #include "xfer-file.h"
+#include "xfer-network.h"
 
 
 /*
@@ -179,31 +180,140 @@ xfer_network_create_pipe (struct t_xfer *xfer)
 }
 
 /*
- * Writes data into pipe.
+ * Writes a status message into pipe (binary message with fixed size, written
+ * atomically in the pipe).
  */
 
 void
 xfer_network_write_pipe (struct t_xfer *xfer, int status, int error)
 {
-    char buffer[1 + 1 + 32 + 1];   /* status + error + pos + \0 */
+    struct t_xfer_network_pipe_msg msg;
     int num_written;
 
-    snprintf (buffer, sizeof (buffer), "%c%c%032llu",
-              status + '0', error + '0', xfer->pos);
-    num_written = write (xfer->child_write, buffer, sizeof (buffer));
+    memset (&msg, 0, sizeof (msg));
+    msg.status = status;
+    msg.error = error;
+    msg.pos = xfer->pos;
+    num_written = write (xfer->child_write, &msg, sizeof (msg));
     (void) num_written;
 }
 
 /*
- * Reads data from child via pipe.
+ * Updates status of a file transfer, with an optional error (sent by child
+ * process, or by the DCC sender running in main process).
+ */
+
+void
+xfer_network_set_status (struct t_xfer *xfer, int status, int error)
+{
+    xfer->last_activity = time (NULL);
+    xfer_file_calculate_speed (xfer, 0);
+
+    /* read error code */
+    switch (error)
+    {
+        /* errors for sender */
+        case XFER_ERROR_READ_LOCAL:
+            weechat_printf (NULL,
+                            _("%s%s: unable to read local file"),
+                            weechat_prefix ("error"), XFER_PLUGIN_NAME);
+            break;
+        case XFER_ERROR_SEND_BLOCK:
+            weechat_printf (NULL,
+                            _("%s%s: unable to send block to receiver"),
+                            weechat_prefix ("error"), XFER_PLUGIN_NAME);
+            break;
+        case XFER_ERROR_READ_ACK:
+            weechat_printf (NULL,
+                            _("%s%s: unable to read ACK from receiver"),
+                            weechat_prefix ("error"), XFER_PLUGIN_NAME);
+            break;
+        /* errors for receiver */
+        case XFER_ERROR_CONNECT_SENDER:
+            weechat_printf (NULL,
+                            _("%s%s: unable to connect to sender"),
+                            weechat_prefix ("error"), XFER_PLUGIN_NAME);
+            break;
+        case XFER_ERROR_RECV_BLOCK:
+            weechat_printf (NULL,
+                            _("%s%s: unable to receive block from sender"),
+                            weechat_prefix ("error"), XFER_PLUGIN_NAME);
+            break;
+        case XFER_ERROR_WRITE_LOCAL:
+            weechat_printf (NULL,
+                            _("%s%s: unable to write local file"),
+                            weechat_prefix ("error"), XFER_PLUGIN_NAME);
+            break;
+        case XFER_ERROR_SEND_ACK:
+            weechat_printf (NULL,
+                            _("%s%s: unable to send ACK to sender"),
+                            weechat_prefix ("error"), XFER_PLUGIN_NAME);
+            break;
+        case XFER_ERROR_HASH_MISMATCH:
+            weechat_printf (NULL,
+                            _("%s%s: wrong CRC32 for file %s"),
+                            weechat_prefix ("error"), XFER_PLUGIN_NAME,
+                            xfer->filename);
+            xfer->hash_status = XFER_HASH_STATUS_MISMATCH;
+            break;
+        case XFER_ERROR_HASH_RESUME_ERROR:
+            weechat_printf (NULL,
+                            _("%s%s: CRC32 error while resuming"),
+                            weechat_prefix ("error"), XFER_PLUGIN_NAME);
+            xfer->hash_status = XFER_HASH_STATUS_RESUME_ERROR;
+            break;
+    }
+
+    /* read new DCC status */
+    switch (status)
+    {
+        case XFER_STATUS_CONNECTING:
+            xfer->status = XFER_STATUS_CONNECTING;
+            xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
+            break;
+        case XFER_STATUS_ACTIVE:
+            if (xfer->status == XFER_STATUS_CONNECTING)
+            {
+                /* connection was successful, init transfer times */
+                xfer->status = XFER_STATUS_ACTIVE;
+                xfer->start_transfer = time (NULL);
+                xfer->last_check_time = time (NULL);
+                xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
+            }
+            else
+                xfer_buffer_refresh (WEECHAT_HOTLIST_LOW);
+            break;
+        case XFER_STATUS_DONE:
+            xfer_close (xfer, XFER_STATUS_DONE);
+            xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
+            break;
+        case XFER_STATUS_FAILED:
+            xfer_close (xfer, XFER_STATUS_FAILED);
+            xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
+            break;
+        case XFER_STATUS_HASHING:
+            xfer->status = XFER_STATUS_HASHING;
+            xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
+            break;
+        case XFER_STATUS_HASHED:
+            if (error == XFER_NO_ERROR)
+                xfer->hash_status = XFER_HASH_STATUS_MATCH;
+            xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
+            break;
+    }
+}
+
+/*
+ * Reads status messages from child via pipe (all messages available are read
+ * at once).
  */
 
 int
 xfer_network_child_read_cb (const void *pointer, void *data, int fd)
 {
     struct t_xfer *xfer;
-    char bufpipe[1 + 1 + 32 + 1];
-    int num_read;
+    struct t_xfer_network_pipe_msg msg[XFER_NETWORK_PIPE_MAX_MSG];
+    int i, num_read, num_msg;
 
     /* make C compiler happy */
     (void) data;
@@ -211,154 +321,35 @@ xfer_network_child_read_cb (const void *pointer, void *data, int fd)
 
     xfer = (struct t_xfer *)pointer;
 
-    num_read = read (xfer->child_read, bufpipe, sizeof (bufpipe));
-    if (num_read > 0)
-    {
-        sscanf (bufpipe + 2, "%llu", &xfer->pos);
-        xfer->last_activity = time (NULL);
-        xfer_file_calculate_speed (xfer, 0);
-
-        /* read error code */
-        switch (bufpipe[1] - '0')
-        {
-            /* errors for sender */
-            case XFER_ERROR_READ_LOCAL:
-                weechat_printf (NULL,
-                                _("%s%s: unable to read local file"),
-                                weechat_prefix ("error"), XFER_PLUGIN_NAME);
-                break;
-            case XFER_ERROR_SEND_BLOCK:
-                weechat_printf (NULL,
-                                _("%s%s: unable to send block to receiver"),
-                                weechat_prefix ("error"), XFER_PLUGIN_NAME);
-                break;
-            case XFER_ERROR_READ_ACK:
-                weechat_printf (NULL,
-                                _("%s%s: unable to read ACK from receiver"),
-                                weechat_prefix ("error"), XFER_PLUGIN_NAME);
-                break;
-            /* errors for receiver */
-            case XFER_ERROR_CONNECT_SENDER:
-                weechat_printf (NULL,
-                                _("%s%s: unable to connect to sender"),
-                                weechat_prefix ("error"), XFER_PLUGIN_NAME);
-                break;
-            case XFER_ERROR_RECV_BLOCK:
-                weechat_printf (NULL,
-                                _("%s%s: unable to receive block from sender"),
-                                weechat_prefix ("error"), XFER_PLUGIN_NAME);
-                break;
-            case XFER_ERROR_WRITE_LOCAL:
-                weechat_printf (NULL,
-                                _("%s%s: unable to write local file"),
-                                weechat_prefix ("error"), XFER_PLUGIN_NAME);
-                break;
-            case XFER_ERROR_SEND_ACK:
-                weechat_printf (NULL,
-                                _("%s%s: unable to send ACK to sender"),
-                                weechat_prefix ("error"), XFER_PLUGIN_NAME);
-                break;
-            case XFER_ERROR_HASH_MISMATCH:
-                weechat_printf (NULL,
-                                _("%s%s: wrong CRC32 for file %s"),
-                                weechat_prefix ("error"), XFER_PLUGIN_NAME,
-                                xfer->filename);
-                xfer->hash_status = XFER_HASH_STATUS_MISMATCH;
-                break;
-            case XFER_ERROR_HASH_RESUME_ERROR:
-                weechat_printf (NULL,
-                                _("%s%s: CRC32 error while resuming"),
-                                weechat_prefix ("error"), XFER_PLUGIN_NAME);
-                xfer->hash_status = XFER_HASH_STATUS_RESUME_ERROR;
-                break;
-        }
+    num_read = read (xfer->child_read, msg, sizeof (msg));
+    if (num_read <= 0)
+        return WEECHAT_RC_OK;
 
-        /* read new DCC status */
-        switch (bufpipe[0] - '0')
-        {
-            case XFER_STATUS_CONNECTING:
-                xfer->status = XFER_STATUS_CONNECTING;
-                xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
-                break;
-            case XFER_STATUS_ACTIVE:
-                if (xfer->status == XFER_STATUS_CONNECTING)
-                {
-                    /* connection was successful by child, init transfer times */
-                    xfer->status = XFER_STATUS_ACTIVE;
-                    xfer->start_transfer = time (NULL);
-                    xfer->last_check_time = time (NULL);
-                    xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
-                }
-                else
-                    xfer_buffer_refresh (WEECHAT_HOTLIST_LOW);
-                break;
-            case XFER_STATUS_DONE:
-                xfer_close (xfer, XFER_STATUS_DONE);
-                xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
-                break;
-            case XFER_STATUS_FAILED:
-                xfer_close (xfer, XFER_STATUS_FAILED);
-                xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
-                break;
-            case XFER_STATUS_HASHING:
-                xfer->status = XFER_STATUS_HASHING;
-                xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
-                break;
-            case XFER_STATUS_HASHED:
-                if (bufpipe[1] - '0' == XFER_NO_ERROR)
-                    xfer->hash_status = XFER_HASH_STATUS_MATCH;
-                xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
-                break;
-        }
+    num_msg = num_read / sizeof (msg[0]);
+    for (i = 0; i < num_msg; i++)
+    {
+        xfer->pos = msg[i].pos;
+        xfer_network_set_status (xfer, msg[i].status, msg[i].error);
+        /* xfer closed: the pipe is closed, ignore next messages */
+        if (XFER_HAS_ENDED(xfer->status))
+            break;
     }
 
     return WEECHAT_RC_OK;
 }
 
 /*
- * Forks process for sending file.
+ * Starts sending of a file.
+ *
+ * The file is sent in main process: data is sent when the socket is ready
+ * for write, and ACKs are read when data is available on socket.
  */
 
 void
-xfer_network_send_file_fork (struct t_xfer *xfer)
+xfer_network_send_file (struct t_xfer *xfer)
 {
-    pid_t pid;
-    int rc;
-
-    if (!xfer_network_create_pipe (xfer))
-        return;
-
     xfer->file = open (xfer->local_filename, O_RDONLY | O_NONBLOCK, 0644);
 
-    switch (pid = fork ())
-    {
-        case -1:  /* fork failed */
-            weechat_printf (NULL,
-                            _("%s%s: unable to fork (%s)"),
-                            weechat_prefix ("error"),
-                            XFER_PLUGIN_NAME,
-                            strerror (errno));
-            xfer_close (xfer, XFER_STATUS_FAILED);
-            xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
-            return;
-        case 0:  /* child process */
-            rc = setuid (getuid ());
-            (void) rc;
-            close (xfer->child_read);
-            switch (xfer->protocol)
-            {
-                case XFER_NO_PROTOCOL:
-                    _exit (EXIT_SUCCESS);
-                    break;
-                case XFER_PROTOCOL_DCC:
-                    xfer_dcc_send_file_child (xfer);
-                    break;
-                case XFER_NUM_PROTOCOLS:
-                    break;
-            }
-            _exit (EXIT_SUCCESS);
-    }
-
     weechat_printf (NULL,
                     _("%s: sending file to %s (%s, %s.%s), "
                       "name: %s (local filename: %s), %llu bytes (protocol: %s)"),
@@ -372,14 +363,16 @@ xfer_network_send_file_fork (struct t_xfer *xfer)
                     xfer->size,
                     xfer_protocol_string[xfer->protocol]);
 
-    /* parent process */
-    xfer->child_pid = pid;
-    close (xfer->child_write);
-    xfer->child_write = -1;
-    xfer->hook_fd = weechat_hook_fd (xfer->child_read,
-                                     1, 0, 0,
-                                     &xfer_network_child_read_cb,
-                                     xfer, NULL);
+    switch (xfer->protocol)
+    {
+        case XFER_NO_PROTOCOL:
+            break;
+        case XFER_PROTOCOL_DCC:
+            xfer_dcc_send_file_start (xfer);
+            break;
+        case XFER_NUM_PROTOCOLS:
+            break;
+    }
 }
 
 /*
@@ -545,7 +538,7 @@ xfer_network_fd_cb (const void *pointer, void *data, int fd)
             xfer->status = XFER_STATUS_ACTIVE;
             xfer->start_transfer = time (NULL);
             xfer_buffer_refresh (WEECHAT_HOTLIST_MESSAGE);
-            xfer_network_send_file_fork (xfer);
+            xfer_network_send_file (xfer);
         }
     }
 
@@ -22,11 +22,24 @@
 
 #include <sys/socket.h>
 
+#define XFER_NETWORK_PIPE_MAX_MSG 64   /* max messages read from child      */
+
+/* message sent by child process to parent (binary, fixed size) */
+
+struct t_xfer_network_pipe_msg
+{
+    int status;                        /* new status of xfer                */
+    int error;                         /* error (XFER_NO_ERROR if no error) */
+    unsigned long long pos;            /* position in file                  */
+};
+
 extern int xfer_network_resolve_addr (const char *str_address,
                                       const char *str_port,
                                       struct sockaddr *addr,
                                       socklen_t *addr_len,
                                       int ai_flags);
+extern void xfer_network_set_status (struct t_xfer *xfer, int status,
+                                     int error);
 extern void xfer_network_write_pipe (struct t_xfer *xfer, int status,
                                      int error);
 extern void xfer_network_connect_init (struct t_xfer *xfer);
@@ -538,6 +538,11 @@ xfer_alloc ()
     new_xfer->filename_suffix = -1;
     new_xfer->pos = 0;
     new_xfer->ack = 0;
+    new_xfer->send_tokens = 0;
+    new_xfer->send_last_refill.tv_sec = 0;
+    new_xfer->send_last_refill.tv_usec = 0;
+    new_xfer->send_last_status = 0;
+    new_xfer->send_wait_write = 0;
     new_xfer->start_resume = 0;
     new_xfer->last_check_time = time_now;
     new_xfer->last_check_pos = time_now;
@@ -1723,6 +1728,12 @@ xfer_print_log ()
         weechat_log_printf ("  filename_suffix . . . . : %d",    ptr_xfer->filename_suffix);
         weechat_log_printf ("  pos . . . . . . . . . . : %llu",  ptr_xfer->pos);
         weechat_log_printf ("  ack . . . . . . . . . . : %llu",  ptr_xfer->ack);
+        weechat_log_printf ("  send_tokens . . . . . . : %llu",  ptr_xfer->send_tokens);
+        weechat_log_printf ("  send_last_refill. . . . : %lld.%06ld",
+                            (long long)ptr_xfer->send_last_refill.tv_sec,
+                            (long)ptr_xfer->send_last_refill.tv_usec);
+        weechat_log_printf ("  send_last_status. . . . : %lld",  (long long)ptr_xfer->send_last_status);
+        weechat_log_printf ("  send_wait_write . . . . : %d",    ptr_xfer->send_wait_write);
         weechat_log_printf ("  start_resume. . . . . . : %llu",  ptr_xfer->start_resume);
         weechat_log_printf ("  last_check_time . . . . : %lld",  (long long)ptr_xfer->last_check_time);
         weechat_log_printf ("  last_check_pos. . . . . : %llu",  ptr_xfer->last_check_pos);
@@ -22,6 +22,7 @@
 
 #include <unistd.h>
 #include <time.h>
+#include <sys/time.h>
 #include <gcrypt.h>
 #include <sys/socket.h>
 
@@ -176,6 +177,11 @@ struct t_xfer
     int filename_suffix;               /* suffix (like .1) if renaming file */
     unsigned long long pos;            /* number of bytes received/sent     */
     unsigned long long ack;            /* number of bytes received OK       */
+    unsigned long long send_tokens;    /* bytes allowed by speed limit      */
+    struct timeval send_last_refill;   /* last refill of send_tokens        */
+    time_t send_last_status;           /* last update of status (send)      */
+    int send_wait_write;               /* 1 if hook_fd waits for socket     */
+                                       /* ready for write (send file)       */
     unsigned long long start_resume;   /* start of resume (in bytes)        */
     time_t last_check_time;            /* last time we checked bytes snt/rcv*/
     unsigned long long last_check_pos; /* bytes sent/recv at last check     */
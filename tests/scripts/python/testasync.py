@@ -0,0 +1,48 @@
+#
+# Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+#
+# This file is part of WeeChat, the extensible chat client.
+#
+# WeeChat is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# WeeChat is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+#
+
+"""
+This script tests async callbacks of python scripts (callbacks running in
+the thread of script, with name starting with "async:").
+
+It is loaded by WeeChat tests (test-scripts.cpp), then the signal
+"testasync_signal" is sent and the messages printed by the callback are
+checked; the callback runs in the script thread, so prnt and command are
+executed later in main thread and other functions are not allowed.
+"""
+
+# pylint: disable=wrong-import-position,unused-argument
+
+import weechat  # noqa: E402
+
+weechat.register('testasync', 'Sébastien Helleu', '1.0', 'GPL3',
+                 'Test of async callbacks', '', '')
+
+
+def async_signal_cb(data, signal, signal_data):
+    """Callback of signal, running in the script thread."""
+    weechat.prnt('', 'TESTASYNC signal: %s, %s, %s'
+                 % (data, signal, signal_data))
+    weechat.command('', '/print TESTASYNC command')
+    weechat.buffer_search_main()
+    weechat.prnt('', 'TESTASYNC end')
+    return weechat.WEECHAT_RC_OK
+
+
+weechat.hook_signal('testasync_signal', 'async:async_signal_cb', 'data')
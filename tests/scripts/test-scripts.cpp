@@ -45,6 +45,10 @@ int api_tests_errors = 0;
 int api_tests_count = 0;
 int api_tests_end = 0;
 int api_tests_other = 0;
+int async_tests_signal = 0;
+int async_tests_command = 0;
+int async_tests_not_allowed = 0;
+int async_tests_end = 0;
 
 
 TEST_GROUP(Scripts)
@@ -99,6 +103,53 @@ TEST_GROUP(Scripts)
         return WEECHAT_RC_OK;
     }
 
+    /*
+     * Callback for messages displayed by async callbacks of test script.
+     */
+
+    static int
+    test_print_async_cb (const void *pointer, void *data,
+                         struct t_gui_buffer *buffer,
+                         time_t date, int tags_count, const char **tags,
+                         int displayed, int highlight, const char *prefix,
+                         const char *message)
+    {
+        /* make C++ compiler happy */
+        (void) pointer;
+        (void) data;
+        (void) buffer;
+        (void) date;
+        (void) tags_count;
+        (void) tags;
+        (void) displayed;
+        (void) highlight;
+        (void) prefix;
+
+        if (!message)
+            return WEECHAT_RC_OK;
+
+        if (strcmp (message,
+                    "TESTASYNC signal: data, testasync_signal, value") == 0)
+        {
+            async_tests_signal++;
+        }
+        else if (strcmp (message, "TESTASYNC command") == 0)
+        {
+            async_tests_command++;
+        }
+        else if (strstr (message, "function \"buffer_search_main\" can not "
+                         "be called in an async callback (script: testasync)"))
+        {
+            async_tests_not_allowed++;
+        }
+        else if (strcmp (message, "TESTASYNC end") == 0)
+        {
+            async_tests_end++;
+        }
+
+        return WEECHAT_RC_OK;
+    }
+
     void setup()
     {
         api_hook_print = hook_print (NULL,  /* plugin */
@@ -285,3 +336,68 @@ TEST(Scripts, API)
 
     printf ("TEST(Scripts, API)");
 }
+
+/*
+ * Tests async callbacks of python scripts.
+ */
+
+TEST(Scripts, AsyncPython)
+{
+    char str_command[PATH_MAX + 128];
+    const char *ptr_test_scripts_dir;
+    struct t_hook *hook_print_async;
+    struct t_hdata *hdata;
+    void *plugins;
+    int i;
+
+    /* test if the python plugin is loaded; if not, tests are skipped */
+    hdata = hook_hdata_get (NULL, "plugin");
+    plugins = hdata_get_list (hdata, "weechat_plugins");
+    if (!hdata_search (hdata, plugins, "${plugin.name} == python",
+                       NULL, NULL, NULL, 1))
+    {
+        return;
+    }
+
+    ptr_test_scripts_dir = getenv ("WEECHAT_TESTS_SCRIPTS_DIR");
+
+    async_tests_signal = 0;
+    async_tests_command = 0;
+    async_tests_not_allowed = 0;
+    async_tests_end = 0;
+
+    hook_print_async = hook_print (NULL, NULL, NULL, NULL, 1,
+                                   &test_print_async_cb, NULL, NULL);
+    CHECK(hook_print_async);
+
+    /* load script (the signal is hooked with an async callback) */
+    snprintf (str_command, sizeof (str_command),
+              "/script load -q %s/testasync.py",
+              (ptr_test_scripts_dir) ?
+              ptr_test_scripts_dir : "../tests/scripts/python");
+    run_cmd (str_command);
+
+    /* the callback runs in the script thread: nothing is printed yet */
+    hook_signal_send ("testasync_signal", WEECHAT_HOOK_SIGNAL_STRING,
+                      (void *)"value");
+    LONGS_EQUAL(0, async_tests_end);
+
+    /* run fd hooks (actions of script thread) until the end of callback */
+    hook_fd_timeout_max = 100;
+    for (i = 0; (i < 50) && !async_tests_end; i++)
+    {
+        hook_fd_exec ();
+    }
+    hook_fd_timeout_max = -1;
+
+    /* unload script */
+    run_cmd ("/script unload -q testasync.py");
+
+    unhook (hook_print_async);
+
+    /* prnt and command are executed in main thread, in order */
+    LONGS_EQUAL(1, async_tests_signal);
+    LONGS_EQUAL(1, async_tests_command);
+    LONGS_EQUAL(1, async_tests_not_allowed);
+    LONGS_EQUAL(1, async_tests_end);
+}
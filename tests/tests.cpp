@@ -73,9 +73,11 @@ IMPORT_TEST_GROUP(CoreHook);
 IMPORT_TEST_GROUP(CoreInfolist);
 IMPORT_TEST_GROUP(CoreList);
 IMPORT_TEST_GROUP(CoreNetwork);
+IMPORT_TEST_GROUP(CorePool);
 IMPORT_TEST_GROUP(CoreSecure);
 IMPORT_TEST_GROUP(CoreSignal);
 IMPORT_TEST_GROUP(CoreString);
+IMPORT_TEST_GROUP(CoreThreadPool);
 IMPORT_TEST_GROUP(CoreUrl);
 IMPORT_TEST_GROUP(CoreUtf8);
 IMPORT_TEST_GROUP(CoreUtil);
@@ -87,6 +89,7 @@ IMPORT_TEST_GROUP(GuiBuffer);
 IMPORT_TEST_GROUP(GuiChat);
 IMPORT_TEST_GROUP(GuiColor);
 IMPORT_TEST_GROUP(GuiFilter);
+IMPORT_TEST_GROUP(GuiHistory);
 IMPORT_TEST_GROUP(GuiInput);
 IMPORT_TEST_GROUP(GuiLine);
 IMPORT_TEST_GROUP(GuiNick);
@@ -26,6 +26,9 @@
 extern "C"
 {
 #include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "src/core/weechat.h"
 #include "src/core/wee-config-file.h"
 #include "src/core/wee-config.h"
 #include "src/core/wee-secure-config.h"
@@ -35,6 +38,28 @@ extern "C"
 extern char *config_file_option_full_name (struct t_config_option *option);
 extern int config_file_string_boolean_is_valid (const char *text);
 extern const char *config_file_option_escape (const char *name);
+extern int config_file_same_content (const char *filename1,
+                                     const char *filename2);
+extern char *config_file_read_line (const char *content, size_t size,
+                                    size_t *pos, char *line, int size_line);
+
+int
+test_config_file_create_option_cb (const void *pointer, void *data,
+                                   struct t_config_file *config_file,
+                                   struct t_config_section *section,
+                                   const char *option_name, const char *value)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+
+    return (config_file_new_option (
+                config_file, section, option_name, "string", "test option",
+                NULL, 0, 0, "", value, 0,
+                NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL)) ?
+        WEECHAT_CONFIG_OPTION_SET_OK_SAME_VALUE :
+        WEECHAT_CONFIG_OPTION_SET_ERROR;
+}
 }
 
 TEST_GROUP(CoreConfigFile)
@@ -940,11 +965,115 @@ TEST(CoreConfigFile, WriteInternal)
 /*
  * Tests functions:
  *   config_file_write
+ *   config_file_set_modified
+ *   config_file_same_content
  */
 
 TEST(CoreConfigFile, Write)
 {
-    /* TODO: write tests */
+    struct t_config_file *config;
+    struct t_config_section *section;
+    struct t_config_option *option;
+    char filename[PATH_MAX], filename2[PATH_MAX];
+    struct stat st;
+    ino_t inode;
+    FILE *file;
+
+    config = config_file_new (NULL, "test_write", NULL, NULL, NULL);
+    CHECK(config);
+    LONGS_EQUAL(1, config->modified);
+    section = config_file_new_section (config, "sect", 0, 0,
+                                       NULL, NULL, NULL, NULL, NULL, NULL,
+                                       NULL, NULL, NULL, NULL, NULL, NULL,
+                                       NULL, NULL, NULL);
+    CHECK(section);
+    option = config_file_new_option (config, section, "opt", "string",
+                                     "test option", NULL, 0, 0, "abc", NULL,
+                                     0, NULL, NULL, NULL, NULL, NULL, NULL,
+                                     NULL, NULL, NULL);
+    CHECK(option);
+
+    snprintf (filename, sizeof (filename), "%s/test_write.conf",
+              weechat_config_dir);
+    snprintf (filename2, sizeof (filename2), "%s/test_write2.conf",
+              weechat_config_dir);
+
+    /* first write: file is created */
+    LONGS_EQUAL(WEECHAT_CONFIG_WRITE_OK, config_file_write (config));
+    LONGS_EQUAL(0, config->modified);
+    LONGS_EQUAL(0, stat (filename, &st));
+    inode = st.st_ino;
+
+    /* not modified: file is not written again */
+    LONGS_EQUAL(WEECHAT_CONFIG_WRITE_OK, config_file_write (config));
+    LONGS_EQUAL(0, stat (filename, &st));
+    LONGS_EQUAL(inode, st.st_ino);
+
+    /* modified with same content: file is kept */
+    config_file_set_modified (config);
+    LONGS_EQUAL(1, config->modified);
+    LONGS_EQUAL(WEECHAT_CONFIG_WRITE_OK, config_file_write (config));
+    LONGS_EQUAL(0, config->modified);
+    LONGS_EQUAL(0, stat (filename, &st));
+    LONGS_EQUAL(inode, st.st_ino);
+
+    /* option changed: file is replaced */
+    LONGS_EQUAL(WEECHAT_CONFIG_OPTION_SET_OK_CHANGED,
+                config_file_option_set (option, "def", 1));
+    LONGS_EQUAL(1, config->modified);
+    LONGS_EQUAL(WEECHAT_CONFIG_WRITE_OK, config_file_write (config));
+    LONGS_EQUAL(0, config->modified);
+
+    /* compare files */
+    LONGS_EQUAL(0, config_file_same_content (filename, filename2));
+    file = fopen (filename2, "w");
+    CHECK(file);
+    fputs ("test", file);
+    fclose (file);
+    LONGS_EQUAL(0, config_file_same_content (filename, filename2));
+    LONGS_EQUAL(1, config_file_same_content (filename2, filename2));
+    LONGS_EQUAL(1, config_file_same_content (filename, filename));
+
+    /* file changed on disk: it is written again */
+    LONGS_EQUAL(0, rename (filename2, filename));
+    LONGS_EQUAL(WEECHAT_CONFIG_WRITE_OK, config_file_write (config));
+    LONGS_EQUAL(0, stat (filename, &st));
+    CHECK(st.st_size > 4);
+
+    config_file_free (config);
+    unlink (filename);
+}
+
+/*
+ * Tests functions:
+ *   config_file_read_line
+ */
+
+TEST(CoreConfigFile, ReadLine)
+{
+    const char *content = "line 1\nline 2\n\nlong line";
+    char line[8];
+    size_t pos;
+
+    pos = 0;
+    STRCMP_EQUAL("line 1\n",
+                 config_file_read_line (content, strlen (content), &pos,
+                                        line, sizeof (line)));
+    STRCMP_EQUAL("line 2\n",
+                 config_file_read_line (content, strlen (content), &pos,
+                                        line, sizeof (line)));
+    STRCMP_EQUAL("\n",
+                 config_file_read_line (content, strlen (content), &pos,
+                                        line, sizeof (line)));
+    STRCMP_EQUAL("long li",
+                 config_file_read_line (content, strlen (content), &pos,
+                                        line, sizeof (line)));
+    STRCMP_EQUAL("ne",
+                 config_file_read_line (content, strlen (content), &pos,
+                                        line, sizeof (line)));
+    POINTERS_EQUAL(NULL,
+                   config_file_read_line (content, strlen (content), &pos,
+                                          line, sizeof (line)));
 }
 
 /*
@@ -954,7 +1083,80 @@ TEST(CoreConfigFile, Write)
 
 TEST(CoreConfigFile, Read)
 {
-    /* TODO: write tests */
+    struct t_config_file *config;
+    struct t_config_section *section;
+    struct t_config_option *ptr_option, *ptr_prev_option;
+    const char *names[] = { "a", "B", "c", "d", "e", NULL };
+    char filename[PATH_MAX];
+    FILE *file;
+    int i;
+
+    config = config_file_new (NULL, "test_read", NULL, NULL, NULL);
+    CHECK(config);
+    section = config_file_new_section (
+        config, "sect", 1, 1,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+        &test_config_file_create_option_cb, NULL, NULL,
+        NULL, NULL, NULL);
+    CHECK(section);
+
+    snprintf (filename, sizeof (filename), "%s/test_read.conf",
+              weechat_config_dir);
+
+    /* options are not sorted in file */
+    file = fopen (filename, "w");
+    CHECK(file);
+    fputs ("# test\n"
+           "\n"
+           "[sect]\n"
+           "e = \"5\"\n"
+           "c = \"3\"\n"
+           "B = \"2\"\n"
+           "a = \"1\"\n"
+           "b = \"22\"\n"
+           "d = \"4\"\n",
+           file);
+    fclose (file);
+
+    LONGS_EQUAL(WEECHAT_CONFIG_READ_OK, config_file_read (config));
+    LONGS_EQUAL(0, config->reading);
+    LONGS_EQUAL(9, config->read_lines);
+    CHECK(config->read_time >= 0);
+
+    /* options are sorted after read */
+    LONGS_EQUAL(0, section->options_unsorted);
+    POINTERS_EQUAL(NULL, section->options_index);
+    ptr_prev_option = NULL;
+    ptr_option = section->options;
+    for (i = 0; names[i]; i++)
+    {
+        CHECK(ptr_option);
+        STRCMP_EQUAL(names[i], ptr_option->name);
+        POINTERS_EQUAL(ptr_prev_option, ptr_option->prev_option);
+        ptr_prev_option = ptr_option;
+        ptr_option = ptr_option->next_option;
+    }
+    POINTERS_EQUAL(NULL, ptr_option);
+    STRCMP_EQUAL("e", section->last_option->name);
+
+    /* option "b" was found (case is ignored) and updated */
+    ptr_option = config_file_search_option (config, section, "b");
+    CHECK(ptr_option);
+    STRCMP_EQUAL("B", ptr_option->name);
+    STRCMP_EQUAL("22", CONFIG_STRING(ptr_option));
+    ptr_option = config_file_search_option (config, section, "d");
+    CHECK(ptr_option);
+    STRCMP_EQUAL("4", CONFIG_STRING(ptr_option));
+
+    /* empty file */
+    file = fopen (filename, "w");
+    CHECK(file);
+    fclose (file);
+    LONGS_EQUAL(WEECHAT_CONFIG_READ_OK, config_file_read (config));
+    LONGS_EQUAL(0, config->read_lines);
+
+    config_file_free (config);
+    unlink (filename);
 }
 
 /*
@@ -29,6 +29,8 @@ extern "C"
 #include "src/core/wee-infolist.h"
 #include "src/core/wee-list.h"
 #include "src/plugins/plugin.h"
+
+extern int hashtable_pool_count;
 }
 
 #define HASHTABLE_TEST_KEY           "test"
@@ -76,6 +78,65 @@ TEST(CoreHashtable, HashDbj2)
     CHECK(hash == HASHTABLE_TEST_KEY_LONG_HASH);
 }
 
+/*
+ * Tests functions:
+ *   hashtable_hash_key_wyhash
+ *   hashtable_hash_key_string
+ */
+
+TEST(CoreHashtable, HashWyhash)
+{
+    const char *str_long = "12345678901234567890123456789012345678901234567890"
+        "123456789012345678901234567890";
+
+    /* test vectors of wyhash (final version 4) */
+    CHECK(0x0409638ee2bde459ULL == hashtable_hash_key_wyhash ("", 0, 0));
+    CHECK(0xa8412d091b5fe0a9ULL == hashtable_hash_key_wyhash ("a", 1, 1));
+    CHECK(0x32dd92e4b2915153ULL == hashtable_hash_key_wyhash ("abc", 3, 2));
+    CHECK(0x8619124089a3a16bULL
+          == hashtable_hash_key_wyhash ("message digest", 14, 3));
+    CHECK(0x7a43afb61d7f5f40ULL
+          == hashtable_hash_key_wyhash ("abcdefghijklmnopqrstuvwxyz", 26, 4));
+    CHECK(0xc39cab13b115aad3ULL
+          == hashtable_hash_key_wyhash (str_long, strlen (str_long), 6));
+
+    CHECK(hashtable_hash_key_string (HASHTABLE_TEST_KEY, 0)
+          == hashtable_hash_key_wyhash (HASHTABLE_TEST_KEY,
+                                        strlen (HASHTABLE_TEST_KEY), 0));
+
+    /* hash depends on the seed */
+    CHECK(hashtable_hash_key_string (HASHTABLE_TEST_KEY, 0)
+          != hashtable_hash_key_string (HASHTABLE_TEST_KEY, 1));
+    CHECK(hashtable_hash_key_string (HASHTABLE_TEST_KEY_LONG, 0)
+          != hashtable_hash_key_string (HASHTABLE_TEST_KEY_LONG, 1));
+}
+
+/*
+ * Tests functions:
+ *   hashtable_init_seed
+ */
+
+TEST(CoreHashtable, InitSeed)
+{
+    struct t_hashtable *hashtable;
+    unsigned long long seed;
+
+    seed = hashtable_hash_seed;
+
+    hashtable_init_seed ();
+    CHECK(hashtable_hash_seed != 0);
+
+    hashtable = hashtable_new (8,
+                               WEECHAT_HASHTABLE_STRING,
+                               WEECHAT_HASHTABLE_STRING,
+                               NULL,
+                               NULL);
+    CHECK(hashtable->hash_seed == hashtable_hash_seed);
+    hashtable_free (hashtable);
+
+    hashtable_hash_seed = seed;
+}
+
 /*
  * Test callback hashing a key.
  *
@@ -140,8 +201,8 @@ TEST(CoreHashtable, New)
                                &test_hashtable_hash_key_cb,
                                &test_hashtable_keycmp_cb);
     CHECK(hashtable);
-    LONGS_EQUAL(32, hashtable->size);
-    CHECK(hashtable->htable);
+    LONGS_EQUAL(HASHTABLE_SMALL_SIZE, hashtable->size);
+    POINTERS_EQUAL(hashtable->htable_small, hashtable->htable);
     LONGS_EQUAL(0, hashtable->items_count);
     POINTERS_EQUAL(NULL, hashtable->oldest_item);
     POINTERS_EQUAL(NULL, hashtable->newest_item);
@@ -152,6 +213,62 @@ TEST(CoreHashtable, New)
     POINTERS_EQUAL(NULL, hashtable->callback_free_key);
     POINTERS_EQUAL(NULL, hashtable->callback_free_value);
     hashtable_free (hashtable);
+
+    /* large hashtable: slots are allocated */
+    hashtable = hashtable_new (256,
+                               WEECHAT_HASHTABLE_STRING,
+                               WEECHAT_HASHTABLE_STRING,
+                               NULL, NULL);
+    CHECK(hashtable);
+    LONGS_EQUAL(256, hashtable->size);
+    CHECK(hashtable->htable);
+    CHECK(hashtable->htable != hashtable->htable_small);
+    hashtable_free (hashtable);
+}
+
+/*
+ * Tests functions:
+ *   hashtable_new
+ *   hashtable_free
+ *   hashtable_end
+ */
+
+TEST(CoreHashtable, Pool)
+{
+    struct t_hashtable *hashtable, *hashtable2;
+
+    /* empty the pool */
+    hashtable_end ();
+    LONGS_EQUAL(0, hashtable_pool_count);
+
+    hashtable = hashtable_new (32,
+                               WEECHAT_HASHTABLE_STRING,
+                               WEECHAT_HASHTABLE_STRING,
+                               NULL, NULL);
+    CHECK(hashtable);
+    hashtable_set (hashtable, "key", "value");
+    hashtable_free (hashtable);
+    LONGS_EQUAL(1, hashtable_pool_count);
+
+    /* the hashtable freed is reused */
+    hashtable2 = hashtable_new (8,
+                                WEECHAT_HASHTABLE_INTEGER,
+                                WEECHAT_HASHTABLE_POINTER,
+                                NULL, NULL);
+    POINTERS_EQUAL(hashtable, hashtable2);
+    LONGS_EQUAL(8, hashtable2->size);
+    LONGS_EQUAL(0, hashtable2->items_count);
+    POINTERS_EQUAL(NULL, hashtable2->oldest_item);
+    POINTERS_EQUAL(NULL, hashtable2->newest_item);
+    LONGS_EQUAL(HASHTABLE_INTEGER, hashtable2->type_keys);
+    LONGS_EQUAL(HASHTABLE_POINTER, hashtable2->type_values);
+    POINTERS_EQUAL(NULL, hashtable2->keys_values);
+    POINTERS_EQUAL(NULL, hashtable2->callback_free_key);
+    POINTERS_EQUAL(NULL, hashtable2->callback_free_value);
+    hashtable_free (hashtable2);
+
+    hashtable_end ();
+    LONGS_EQUAL(0, hashtable_pool_count);
 }
 
 /*
@@ -182,7 +299,7 @@ TEST(CoreHashtable, SetGetRemove)
                                WEECHAT_HASHTABLE_STRING,
                                &test_hashtable_hash_key_cb,
                                &test_hashtable_keycmp_cb);
-    LONGS_EQUAL(32, hashtable->size);
+    LONGS_EQUAL(HASHTABLE_SMALL_SIZE, hashtable->size);
     LONGS_EQUAL(0, hashtable->items_count);
 
     /* invalid set of items */
@@ -197,10 +314,10 @@ TEST(CoreHashtable, SetGetRemove)
     CHECK(hashtable->newest_item);
     STRCMP_EQUAL(str_key, (const char *)item->key);
     LONGS_EQUAL(strlen (str_key) + 1, item->key_size);
+    CHECK(HASHTABLE_ITEM_KEY_INLINE(item));
     POINTERS_EQUAL(NULL, item->value);
     LONGS_EQUAL(0, item->value_size);
-    POINTERS_EQUAL(NULL, item->prev_item);
-    POINTERS_EQUAL(NULL, item->next_item);
+    LONGS_EQUAL(0, item->value_inline);
     POINTERS_EQUAL(NULL, item->prev_created_item);
     POINTERS_EQUAL(NULL, item->next_created_item);
 
@@ -214,8 +331,7 @@ TEST(CoreHashtable, SetGetRemove)
     LONGS_EQUAL(strlen (str_key) + 1, item->key_size);
     STRCMP_EQUAL(str_value, (const char *)item->value);
     LONGS_EQUAL(strlen (str_value) + 1, item->value_size);
-    POINTERS_EQUAL(NULL, item->prev_item);
-    POINTERS_EQUAL(NULL, item->next_item);
+    LONGS_EQUAL(0, item->value_inline);
     POINTERS_EQUAL(NULL, item->prev_created_item);
     POINTERS_EQUAL(NULL, item->next_created_item);
 
@@ -224,7 +340,7 @@ TEST(CoreHashtable, SetGetRemove)
     CHECK(item);
     STRCMP_EQUAL(str_key, (const char *)item->key);
     STRCMP_EQUAL(str_value, (const char *)item->value);
-    LONGS_EQUAL(2, hash);
+    CHECK(hash == item->hash);
 
     /* get value */
     ptr_value = (const char *)hashtable_get (hashtable, str_key);
@@ -255,6 +371,7 @@ TEST(CoreHashtable, SetGetRemove)
     LONGS_EQUAL(strlen (str_key) + 1, item->key_size);
     STRCMP_EQUAL(str_value, (const char *)item->value);
     LONGS_EQUAL(strlen (str_value) + 1, item->value_size);
+    LONGS_EQUAL(1, item->value_inline);
 
     /* add another item */
     hashtable_set (hashtable, "xxx", "zzz");
@@ -279,53 +396,39 @@ TEST(CoreHashtable, SetGetRemove)
     LONGS_EQUAL(hashtable->items_count, hashtable2->items_count);
     for (i = 0; i < hashtable->size; i++)
     {
-        if (hashtable->htable[i])
+        ptr_item = hashtable->htable[i].item;
+        ptr_item2 = hashtable2->htable[i].item;
+        if (ptr_item)
         {
-            ptr_item = hashtable->htable[i];
-            ptr_item2 = hashtable2->htable[i];
-            while (ptr_item && ptr_item2)
+            CHECK(ptr_item2);
+            CHECK(ptr_item != ptr_item2);
+            CHECK(hashtable->htable[i].hash == hashtable2->htable[i].hash);
+            LONGS_EQUAL(ptr_item->key_size, ptr_item2->key_size);
+            LONGS_EQUAL(ptr_item->value_size, ptr_item2->value_size);
+            STRCMP_EQUAL((const char *)ptr_item->key,
+                         (const char *)ptr_item2->key);
+            if (ptr_item->value)
             {
-                LONGS_EQUAL(ptr_item->key_size, ptr_item2->key_size);
-                LONGS_EQUAL(ptr_item->value_size, ptr_item2->value_size);
-                if (ptr_item->key)
-                {
-                    STRCMP_EQUAL((const char *)ptr_item->key,
-                                 (const char *)ptr_item2->key);
-                }
-                else
-                {
-                    POINTERS_EQUAL(ptr_item->key, ptr_item2->key);
-                }
-                if (ptr_item->value)
-                {
-                    STRCMP_EQUAL((const char *)ptr_item->value,
-                                 (const char *)ptr_item2->value);
-                }
-                else
-                {
-                    POINTERS_EQUAL(ptr_item->value, ptr_item2->value);
-                }
-                ptr_item = ptr_item->next_item;
-                ptr_item2 = ptr_item2->next_item;
-                CHECK((ptr_item && ptr_item2) || (!ptr_item && !ptr_item2));
+                STRCMP_EQUAL((const char *)ptr_item->value,
+                             (const char *)ptr_item2->value);
+            }
+            else
+            {
+                POINTERS_EQUAL(ptr_item->value, ptr_item2->value);
             }
         }
         else
         {
-            POINTERS_EQUAL(hashtable->htable[i], hashtable2->htable[i]);
+            POINTERS_EQUAL(NULL, ptr_item2);
         }
     }
 
     /* remove all items */
     hashtable_remove_all (hashtable);
-    POINTERS_EQUAL(NULL, hashtable->htable[0]);
-    POINTERS_EQUAL(NULL, hashtable->htable[1]);
-    POINTERS_EQUAL(NULL, hashtable->htable[2]);
-    POINTERS_EQUAL(NULL, hashtable->htable[3]);
-    POINTERS_EQUAL(NULL, hashtable->htable[4]);
-    POINTERS_EQUAL(NULL, hashtable->htable[5]);
-    POINTERS_EQUAL(NULL, hashtable->htable[6]);
-    POINTERS_EQUAL(NULL, hashtable->htable[7]);
+    for (i = 0; i < hashtable->size; i++)
+    {
+        POINTERS_EQUAL(NULL, hashtable->htable[i].item);
+    }
     LONGS_EQUAL(0, hashtable->items_count);
     POINTERS_EQUAL(NULL, hashtable->oldest_item);
     POINTERS_EQUAL(NULL, hashtable->newest_item);
@@ -335,25 +438,25 @@ TEST(CoreHashtable, SetGetRemove)
     hashtable_free (hashtable2);
 
     /*
-     * create a hashtable with size 8, and add 6 items,
-     * to check if many items with same hashed key work fine,
+     * create a hashtable with size 8 and seed 0, and add 6 items,
+     * to check if many items with same slot work fine,
      * the expected htable inside hashtable is:
      *   +-----+
-     *   |   0 |
+     *   |   0 | --> "chat"
      *   +-----+
-     *   |   1 |
+     *   |   1 | --> "weechat"
      *   +-----+
-     *   |   2 | --> "extensible"
+     *   |   2 | --> "client"
      *   +-----+
-     *   |   3 | --> "fast" --> "light"
+     *   |   3 | --> "extensible"
      *   +-----+
      *   |   4 |
      *   +-----+
-     *   |   5 | --> "chat"
+     *   |   5 |
      *   +-----+
-     *   |   6 | --> "client"
+     *   |   6 | --> "light"
      *   +-----+
-     *   |   7 | --> "weechat"
+     *   |   7 | --> "fast"
      *   +-----+
      */
     hashtable = hashtable_new (8,
@@ -361,32 +464,36 @@ TEST(CoreHashtable, SetGetRemove)
                                WEECHAT_HASHTABLE_STRING,
                                NULL,
                                NULL);
+    hashtable->hash_seed = 0;
     LONGS_EQUAL(8, hashtable->size);
     LONGS_EQUAL(0, hashtable->items_count);
 
     item = hashtable_set (hashtable, "weechat", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[7]);
+    POINTERS_EQUAL(item, hashtable->htable[1].item);
 
     item = hashtable_set (hashtable, "light", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[3]);
+    POINTERS_EQUAL(item, hashtable->htable[6].item);
 
     item = hashtable_set (hashtable, "fast", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[3]);
+    POINTERS_EQUAL(item, hashtable->htable[7].item);
 
     item = hashtable_set (hashtable, "extensible", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[2]);
+    POINTERS_EQUAL(item, hashtable->htable[3].item);
 
     item = hashtable_set (hashtable, "chat", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[5]);
+    POINTERS_EQUAL(item, hashtable->htable[0].item);
 
     item = hashtable_set (hashtable, "client", NULL);
     CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[6]);
+    POINTERS_EQUAL(item, hashtable->htable[2].item);
+
+    /* hashtable is filled at 75%: no resize yet */
+    LONGS_EQUAL(8, hashtable->size);
 
     /* check items by order of creation */
     ptr_item = hashtable->oldest_item;
@@ -458,15 +565,18 @@ TEST(CoreHashtable, SetGetRemove)
     ptr_item = ptr_item->next_created_item;
     POINTERS_EQUAL(NULL, ptr_item);
 
-    /* check current content of hashtable */
-    POINTERS_EQUAL(NULL, hashtable->htable[0]);
-    POINTERS_EQUAL(NULL, hashtable->htable[1]);
-    STRCMP_EQUAL("extensible", (const char *)hashtable->htable[2]->key);
-    POINTERS_EQUAL(NULL, hashtable->htable[3]);
-    POINTERS_EQUAL(NULL, hashtable->htable[4]);
-    STRCMP_EQUAL("chat", (const char *)hashtable->htable[5]->key);
-    POINTERS_EQUAL(NULL, hashtable->htable[6]);
-    POINTERS_EQUAL(NULL, hashtable->htable[7]);
+    /*
+     * check current content of hashtable: "chat" has been moved back to its
+     * slot (7) when "fast" was removed
+     */
+    POINTERS_EQUAL(NULL, hashtable->htable[0].item);
+    POINTERS_EQUAL(NULL, hashtable->htable[1].item);
+    POINTERS_EQUAL(NULL, hashtable->htable[2].item);
+    STRCMP_EQUAL("extensible", (const char *)hashtable->htable[3].item->key);
+    POINTERS_EQUAL(NULL, hashtable->htable[4].item);
+    POINTERS_EQUAL(NULL, hashtable->htable[5].item);
+    POINTERS_EQUAL(NULL, hashtable->htable[6].item);
+    STRCMP_EQUAL("chat", (const char *)hashtable->htable[7].item->key);
 
     /* free hashtable */
     hashtable_free (hashtable);
@@ -759,6 +869,186 @@ TEST(CoreHashtable, Infolist)
     STRCMP_EQUAL("last item", infolist_string (infolist, "test_value_00005"));
 }
 
+/*
+ * Tests functions:
+ *   hashtable_set
+ *   hashtable_get
+ *   hashtable_remove
+ *   hashtable_resize
+ */
+
+TEST(CoreHashtable, Resize)
+{
+    struct t_hashtable *hashtable;
+    struct t_hashtable_item *item;
+    int i, *ptr_value;
+
+    hashtable = hashtable_new (8,
+                               WEECHAT_HASHTABLE_INTEGER,
+                               WEECHAT_HASHTABLE_INTEGER,
+                               NULL,
+                               NULL);
+    LONGS_EQUAL(8, hashtable->size);
+
+    /* size is rounded to a power of 2 */
+    hashtable_free (hashtable);
+    hashtable = hashtable_new (5,
+                               WEECHAT_HASHTABLE_INTEGER,
+                               WEECHAT_HASHTABLE_INTEGER,
+                               NULL,
+                               NULL);
+    LONGS_EQUAL(8, hashtable->size);
+
+    i = 0;
+    item = hashtable_set (hashtable, &i, &i);
+    CHECK(item);
+    for (i = 1; i < 1000; i++)
+    {
+        CHECK(hashtable_set (hashtable, &i, &i));
+    }
+    LONGS_EQUAL(1000, hashtable->items_count);
+    LONGS_EQUAL(2048, hashtable->size);
+
+    /* items are never moved */
+    i = 0;
+    POINTERS_EQUAL(item, hashtable_get_item (hashtable, &i, NULL));
+    POINTERS_EQUAL(item, hashtable->oldest_item);
+
+    for (i = 0; i < 1000; i++)
+    {
+        ptr_value = (int *)hashtable_get (hashtable, &i);
+        CHECK(ptr_value);
+        LONGS_EQUAL(i, *ptr_value);
+    }
+
+    for (i = 0; i < 1000; i += 2)
+    {
+        hashtable_remove (hashtable, &i);
+    }
+    LONGS_EQUAL(500, hashtable->items_count);
+    for (i = 0; i < 1000; i++)
+    {
+        ptr_value = (int *)hashtable_get (hashtable, &i);
+        if (i % 2 == 0)
+        {
+            POINTERS_EQUAL(NULL, ptr_value);
+        }
+        else
+        {
+            CHECK(ptr_value);
+            LONGS_EQUAL(i, *ptr_value);
+        }
+    }
+
+    hashtable_free (hashtable);
+}
+
+/*
+ * Test callback hashing a key: it returns the same hash for all keys.
+ */
+
+unsigned long long
+test_hashtable_hash_key_same_cb (struct t_hashtable *hashtable,
+                                 const void *key)
+{
+    /* make C++ compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    return 0;
+}
+
+/*
+ * Tests functions:
+ *   hashtable_find_slot
+ *   hashtable_remove_item
+ */
+
+TEST(CoreHashtable, Collisions)
+{
+    struct t_hashtable *hashtable;
+
+    hashtable = hashtable_new (8,
+                               WEECHAT_HASHTABLE_STRING,
+                               WEECHAT_HASHTABLE_STRING,
+                               &test_hashtable_hash_key_same_cb,
+                               &test_hashtable_keycmp_cb);
+    hashtable->hash_seed = 0;
+
+    /* all keys have the slot 0, the next free slots are used */
+    hashtable_set (hashtable, "a", "1");
+    hashtable_set (hashtable, "b", "2");
+    hashtable_set (hashtable, "c", "3");
+    STRCMP_EQUAL("a", (const char *)hashtable->htable[0].item->key);
+    STRCMP_EQUAL("b", (const char *)hashtable->htable[1].item->key);
+    STRCMP_EQUAL("c", (const char *)hashtable->htable[2].item->key);
+    POINTERS_EQUAL(NULL, hashtable->htable[3].item);
+
+    /* remove first key: next keys are moved back */
+    hashtable_remove (hashtable, "a");
+    LONGS_EQUAL(2, hashtable->items_count);
+    STRCMP_EQUAL("b", (const char *)hashtable->htable[0].item->key);
+    STRCMP_EQUAL("c", (const char *)hashtable->htable[1].item->key);
+    POINTERS_EQUAL(NULL, hashtable->htable[2].item);
+    POINTERS_EQUAL(NULL, hashtable_get (hashtable, "a"));
+    STRCMP_EQUAL("2", (const char *)hashtable_get (hashtable, "b"));
+    STRCMP_EQUAL("3", (const char *)hashtable_get (hashtable, "c"));
+
+    /* remove last key */
+    hashtable_remove (hashtable, "c");
+    LONGS_EQUAL(1, hashtable->items_count);
+    STRCMP_EQUAL("b", (const char *)hashtable->htable[0].item->key);
+    POINTERS_EQUAL(NULL, hashtable->htable[1].item);
+    STRCMP_EQUAL("2", (const char *)hashtable_get (hashtable, "b"));
+
+    hashtable_free (hashtable);
+}
+
+/*
+ * Tests functions (with many items, hashtable is resized many times):
+ *   hashtable_set
+ *   hashtable_get
+ *   hashtable_remove
+ */
+
+TEST(CoreHashtable, ManyItems)
+{
+    struct t_hashtable *hashtable;
+    char key[64];
+    int i, j, count[3] = { 10, 10000, 100000 };
+
+    for (i = 0; i < 3; i++)
+    {
+        hashtable = hashtable_new (32,
+                                   WEECHAT_HASHTABLE_STRING,
+                                   WEECHAT_HASHTABLE_INTEGER,
+                                   NULL,
+                                   NULL);
+
+        for (j = 0; j < count[i]; j++)
+        {
+            snprintf (key, sizeof (key), "key_%d", j);
+            hashtable_set (hashtable, key, &j);
+        }
+        LONGS_EQUAL(count[i], hashtable->items_count);
+
+        for (j = 0; j < count[i]; j++)
+        {
+            snprintf (key, sizeof (key), "key_%d", j);
+            LONGS_EQUAL(j, *((int *)hashtable_get (hashtable, key)));
+        }
+
+        for (j = 0; j < count[i]; j++)
+        {
+            snprintf (key, sizeof (key), "key_%d", j);
+            hashtable_remove (hashtable, key);
+        }
+        LONGS_EQUAL(0, hashtable->items_count);
+
+        hashtable_free (hashtable);
+    }
+}
+
 /*
  * Tests functions:
  *   hashtable_print_log
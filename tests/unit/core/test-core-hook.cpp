@@ -23,13 +23,26 @@
 
 extern "C"
 {
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include "src/core/wee-hashtable.h"
 #include "src/core/wee-hook.h"
 #include "src/core/wee-string.h"
 #include "src/gui/gui-buffer.h"
 #include "src/gui/gui-chat.h"
+#include "src/gui/gui-color.h"
 #include "src/gui/gui-line.h"
 #include "src/plugins/plugin.h"
+
+extern void hook_process_send_buffers (struct t_hook *hook_process,
+                                       int callback_rc);
+extern void hook_process_child_read (struct t_hook *hook_process, int fd,
+                                     int index_buffer,
+                                     struct t_hook **hook_fd);
 }
 
 #define TEST_BUFFER_NAME "test"
@@ -163,9 +176,171 @@ TEST(CoreHook, Infolist)
  *   hook_line
  */
 
+struct t_test_hook_line_result
+{
+    int count;                         /* number of calls to callback       */
+    char message[256];                 /* message received                  */
+    char tags[256];                    /* tags received (string)            */
+    int tags_count;                    /* number of tags received           */
+    int tags_array_ok;                 /* 1 if tags_array matches the tags  */
+    struct t_hashtable *update;        /* data returned to update the line  */
+};
+
+struct t_hashtable *
+test_hook_line_cb (const void *pointer, void *data, struct t_hashtable *line)
+{
+    struct t_test_hook_line_result *result;
+    const char *ptr_value;
+    char **tags_array, *str_tags;
+    unsigned long value;
+    int rc, count;
+
+    /* make C++ compiler happy */
+    (void) data;
+
+    result = (struct t_test_hook_line_result *)pointer;
+
+    result->count++;
+    ptr_value = (const char *)hashtable_get (line, "message");
+    snprintf (result->message, sizeof (result->message),
+              "%s", (ptr_value) ? ptr_value : "(null)");
+    ptr_value = (const char *)hashtable_get (line, "tags");
+    snprintf (result->tags, sizeof (result->tags),
+              "%s", (ptr_value) ? ptr_value : "(null)");
+    ptr_value = (const char *)hashtable_get (line, "tags_count");
+    result->tags_count = (ptr_value) ? atoi (ptr_value) : -1;
+
+    /* tags_array must have tags_count tags, the same as in "tags" */
+    result->tags_array_ok = 0;
+    tags_array = NULL;
+    ptr_value = (const char *)hashtable_get (line, "tags_array");
+    if (ptr_value)
+    {
+        rc = sscanf (ptr_value, "0x%lx", &value);
+        if ((rc != EOF) && (rc != 0))
+            tags_array = (char **)value;
+    }
+    if (tags_array)
+    {
+        for (count = 0; tags_array[count]; count++)
+        {
+        }
+        str_tags = string_rebuild_split_string ((const char **)tags_array,
+                                                ",", 0, -1);
+        result->tags_array_ok = ((count == result->tags_count)
+                                 && str_tags
+                                 && (strcmp (str_tags, result->tags) == 0)) ?
+            1 : 0;
+        if (str_tags)
+            free (str_tags);
+    }
+    else
+    {
+        result->tags_array_ok = (result->tags_count == 0) ? 1 : 0;
+    }
+
+    return (result->update) ? hashtable_dup (result->update) : NULL;
+}
+
+/*
+ * Tests functions:
+ *   hook_line
+ *   hook_line_exec
+ */
+
 TEST(CoreHook, Line)
 {
-    /* TODO: write tests */
+    struct t_gui_buffer *test_buffer;
+    struct t_hook *hook1, *hook2, *hook3;
+    struct t_test_hook_line_result result1, result2, result3;
+    struct t_gui_line *ptr_line;
+
+    POINTERS_EQUAL(NULL, hook_line (NULL, NULL, NULL, NULL,
+                                    NULL, NULL, NULL));
+
+    /* create/open a test buffer */
+    test_buffer = gui_buffer_new (NULL, TEST_BUFFER_NAME,
+                                  NULL, NULL, NULL,
+                                  NULL, NULL, NULL);
+    CHECK(test_buffer);
+
+    memset (&result1, 0, sizeof (result1));
+    memset (&result2, 0, sizeof (result2));
+    memset (&result3, 0, sizeof (result3));
+
+    /* hooks called in this order: hook1, hook2, hook3 */
+    hook1 = hook_line (NULL, "3000|formatted", "core." TEST_BUFFER_NAME, NULL,
+                       &test_hook_line_cb, &result1, NULL);
+    CHECK(hook1);
+    hook2 = hook_line (NULL, "2000|formatted", "core." TEST_BUFFER_NAME, NULL,
+                       &test_hook_line_cb, &result2, NULL);
+    CHECK(hook2);
+    hook3 = hook_line (NULL, "1000|formatted", "core." TEST_BUFFER_NAME,
+                       "tag2", &test_hook_line_cb, &result3, NULL);
+    CHECK(hook3);
+
+    /* line not updated: tags_array and tags_count match the line */
+    gui_chat_printf_date_tags (test_buffer, 0, "tag1,tag2,tag3",
+                               "prefix\tmessage");
+    ptr_line = test_buffer->own_lines->last_line;
+    LONGS_EQUAL(1, result1.count);
+    STRCMP_EQUAL("message", result1.message);
+    STRCMP_EQUAL("tag1,tag2,tag3", result1.tags);
+    LONGS_EQUAL(3, result1.tags_count);
+    LONGS_EQUAL(1, result1.tags_array_ok);
+    LONGS_EQUAL(1, result2.count);
+    STRCMP_EQUAL("message", result2.message);
+    STRCMP_EQUAL("tag1,tag2,tag3", result2.tags);
+    LONGS_EQUAL(3, result2.tags_count);
+    LONGS_EQUAL(1, result2.tags_array_ok);
+    LONGS_EQUAL(1, result3.count);
+    LONGS_EQUAL(3, ptr_line->data->tags_count);
+
+    /* line without tags */
+    gui_chat_printf_date_tags (test_buffer, 0, NULL, "prefix\tmessage");
+    LONGS_EQUAL(2, result1.count);
+    STRCMP_EQUAL("", result1.tags);
+    LONGS_EQUAL(0, result1.tags_count);
+    LONGS_EQUAL(1, result1.tags_array_ok);
+    LONGS_EQUAL(2, result2.count);
+    LONGS_EQUAL(1, result3.count);
+
+    /* line updated by hook1: hashtable is filled again for hook2 */
+    result1.update = hashtable_new (32,
+                                    WEECHAT_HASHTABLE_STRING,
+                                    WEECHAT_HASHTABLE_STRING,
+                                    NULL, NULL);
+    CHECK(result1.update);
+    hashtable_set (result1.update, "message", "updated");
+    hashtable_set (result1.update, "tags", "tag1,new_tag");
+    gui_chat_printf_date_tags (test_buffer, 0, "tag1,tag2,tag3",
+                               "prefix\tmessage");
+    ptr_line = test_buffer->own_lines->last_line;
+    LONGS_EQUAL(3, result1.count);
+    STRCMP_EQUAL("message", result1.message);
+    STRCMP_EQUAL("tag1,tag2,tag3", result1.tags);
+    LONGS_EQUAL(3, result1.tags_count);
+    LONGS_EQUAL(1, result1.tags_array_ok);
+    LONGS_EQUAL(3, result2.count);
+    STRCMP_EQUAL("updated", result2.message);
+    STRCMP_EQUAL("tag1,new_tag", result2.tags);
+    LONGS_EQUAL(2, result2.tags_count);
+    LONGS_EQUAL(1, result2.tags_array_ok);
+    /* hook3 (tag "tag2") is not called any more: the tag was removed */
+    LONGS_EQUAL(1, result3.count);
+    STRCMP_EQUAL("updated", ptr_line->data->message);
+    LONGS_EQUAL(2, ptr_line->data->tags_count);
+    STRCMP_EQUAL("tag1", ptr_line->data->tags_array[0]);
+    STRCMP_EQUAL("new_tag", ptr_line->data->tags_array[1]);
+    hashtable_free (result1.update);
+    result1.update = NULL;
+
+    unhook (hook1);
+    unhook (hook2);
+    unhook (hook3);
+
+    /* close the test buffer */
+    gui_buffer_close (test_buffer);
 }
 
 char *
@@ -366,6 +541,8 @@ TEST(CoreHook, Modifier)
     POINTERS_EQUAL(NULL, ptr_line->data->prefix);
     STRCMP_EQUAL("message (modified)", ptr_line->data->message);
 
+    unhook (hook);
+
     /* close the test buffer */
     gui_buffer_close (test_buffer);
 }
@@ -375,9 +552,177 @@ TEST(CoreHook, Modifier)
  *   hook_print
  */
 
+int
+test_hook_print_cb (const void *pointer, void *data,
+                    struct t_gui_buffer *buffer,
+                    time_t date, int tags_count, const char **tags,
+                    int displayed, int highlight,
+                    const char *prefix, const char *message)
+{
+    /* make C++ compiler happy */
+    (void) data;
+    (void) date;
+    (void) tags_count;
+    (void) tags;
+    (void) displayed;
+    (void) highlight;
+
+    /* free strings without colors cached in line, like an update of line */
+    gui_line_free_no_color (buffer->own_lines->last_line->data);
+
+    snprintf ((char *)pointer, 256, "%s|%s",
+              (prefix) ? prefix : "(null)",
+              (message) ? message : "(null)");
+
+    return WEECHAT_RC_OK;
+}
+
 TEST(CoreHook, Print)
 {
-    /* TODO: write tests */
+    struct t_gui_buffer *test_buffer;
+    struct t_hook *hook1, *hook2;
+    char result1[256], result2[256];
+
+    /* create/open a test buffer */
+    test_buffer = gui_buffer_new (NULL, TEST_BUFFER_NAME,
+                                  NULL, NULL, NULL,
+                                  NULL, NULL, NULL);
+    CHECK(test_buffer);
+
+    hook1 = hook_print (NULL, test_buffer, NULL, "message", 1,
+                        &test_hook_print_cb, result1, NULL);
+    CHECK(hook1);
+    hook2 = hook_print (NULL, test_buffer, NULL, NULL, 0,
+                        &test_hook_print_cb, result2, NULL);
+    CHECK(hook2);
+
+    /* strings without colors are still valid if the line is updated */
+    result1[0] = '\0';
+    result2[0] = '\0';
+    gui_chat_printf_date_tags (test_buffer, 0, NULL,
+                               "%sprefix\t%smessage",
+                               gui_color_get_custom ("red"),
+                               gui_color_get_custom ("blue"));
+    STRCMP_EQUAL("prefix|message", result1);
+    CHECK(strncmp (result2, "prefix|", 7) != 0);
+
+    /* message not matching */
+    result1[0] = '\0';
+    result2[0] = '\0';
+    gui_chat_printf_date_tags (test_buffer, 0, NULL, "prefix\ttest");
+    STRCMP_EQUAL("", result1);
+    STRCMP_EQUAL("prefix|test", result2);
+
+    /* long message (copied in allocated memory) */
+    result1[0] = '\0';
+    gui_chat_printf_date_tags (test_buffer, 0, NULL,
+                               "prefix\tmessage %08192d", 0);
+    LONGS_EQUAL(255, strlen (result1));
+    CHECK(strncmp (result1, "prefix|message 0000", 19) == 0);
+
+    unhook (hook1);
+    unhook (hook2);
+
+    /* close the test buffer */
+    gui_buffer_close (test_buffer);
+}
+
+/*
+ * Tests functions:
+ *   hook_process
+ *   hook_process_hashtable
+ */
+
+struct t_test_hook_process_result
+{
+    int count;                         /* number of calls to callback       */
+    int return_code;                   /* last return code received         */
+    char out[256];                     /* stdout received (concatenated)    */
+    char err[256];                     /* stderr received (concatenated)    */
+    int fd;                            /* pipe to check (-1 = none)         */
+    int pipe_pending;                  /* bytes in pipe during last call    */
+};
+
+int
+test_hook_process_cb (const void *pointer, void *data,
+                      const char *command, int return_code,
+                      const char *out, const char *err)
+{
+    struct t_test_hook_process_result *result;
+
+    /* make C++ compiler happy */
+    (void) data;
+    (void) command;
+
+    result = (struct t_test_hook_process_result *)pointer;
+
+    result->count++;
+    result->return_code = return_code;
+    if (out)
+    {
+        strncat (result->out, out,
+                 sizeof (result->out) - strlen (result->out) - 1);
+    }
+    if (err)
+    {
+        strncat (result->err, err,
+                 sizeof (result->err) - strlen (result->err) - 1);
+    }
+    if (result->fd >= 0)
+    {
+        if (ioctl (result->fd, FIONREAD, &result->pipe_pending) != 0)
+            result->pipe_pending = -1;
+    }
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Creates a process hook which is not run (command "func:" is run only by
+ * hook_process_exec), so that its buffers can be tested without a child
+ * process.
+ */
+
+struct t_hook *
+test_hook_process_new (const char *buffer_size, const char *line_mode,
+                       const char *backpressure,
+                       struct t_test_hook_process_result *result)
+{
+    struct t_hashtable *options;
+    struct t_hook *hook;
+
+    memset (result, 0, sizeof (*result));
+    result->fd = -1;
+
+    options = hashtable_new (32,
+                             WEECHAT_HASHTABLE_STRING,
+                             WEECHAT_HASHTABLE_STRING,
+                             NULL, NULL);
+    if (buffer_size)
+        hashtable_set (options, "buffer_size", buffer_size);
+    if (line_mode)
+        hashtable_set (options, "line_mode", line_mode);
+    if (backpressure)
+        hashtable_set (options, "backpressure", backpressure);
+    hook = hook_process_hashtable (NULL, "func:test", options, 0,
+                                   &test_hook_process_cb, result, NULL);
+    hashtable_free (options);
+
+    return hook;
+}
+
+/*
+ * Adds data in stdout/stderr buffer of a process hook.
+ */
+
+void
+test_hook_process_add_data (struct t_hook *hook, int index_buffer,
+                            const char *data)
+{
+    memcpy (HOOK_PROCESS(hook, buffer[index_buffer])
+            + HOOK_PROCESS(hook, buffer_size[index_buffer]),
+            data, strlen (data));
+    HOOK_PROCESS(hook, buffer_size[index_buffer]) += strlen (data);
 }
 
 /*
@@ -388,7 +733,221 @@ TEST(CoreHook, Print)
 
 TEST(CoreHook, Process)
 {
-    /* TODO: write tests */
+    struct t_test_hook_process_result result;
+    struct t_hook *hook;
+
+    /* invalid arguments */
+    POINTERS_EQUAL(NULL, hook_process (NULL, NULL, 0,
+                                       &test_hook_process_cb, NULL, NULL));
+    POINTERS_EQUAL(NULL, hook_process (NULL, "", 0,
+                                       &test_hook_process_cb, NULL, NULL));
+    POINTERS_EQUAL(NULL, hook_process (NULL, "func:test", 0,
+                                       NULL, NULL, NULL));
+
+    /* default options */
+    hook = test_hook_process_new (NULL, NULL, NULL, &result);
+    CHECK(hook);
+    LONGS_EQUAL(HOOK_PROCESS_BUFFER_SIZE, HOOK_PROCESS(hook, buffer_max));
+    LONGS_EQUAL(HOOK_PROCESS_BUFFER_SIZE, HOOK_PROCESS(hook, buffer_flush));
+    LONGS_EQUAL(0, HOOK_PROCESS(hook, line_mode));
+    LONGS_EQUAL(0, HOOK_PROCESS(hook, backpressure));
+    unhook (hook);
+
+    /* custom options */
+    hook = test_hook_process_new ("1024", "1", "1", &result);
+    CHECK(hook);
+    LONGS_EQUAL(1024, HOOK_PROCESS(hook, buffer_max));
+    LONGS_EQUAL(1024, HOOK_PROCESS(hook, buffer_flush));
+    LONGS_EQUAL(1, HOOK_PROCESS(hook, line_mode));
+    LONGS_EQUAL(1, HOOK_PROCESS(hook, backpressure));
+    unhook (hook);
+
+    /* invalid buffer size: default size is used */
+    hook = test_hook_process_new ("0", "0", "0", &result);
+    CHECK(hook);
+    LONGS_EQUAL(HOOK_PROCESS_BUFFER_SIZE, HOOK_PROCESS(hook, buffer_max));
+    LONGS_EQUAL(0, HOOK_PROCESS(hook, line_mode));
+    LONGS_EQUAL(0, HOOK_PROCESS(hook, backpressure));
+    unhook (hook);
+    hook = test_hook_process_new ("abc", NULL, NULL, &result);
+    CHECK(hook);
+    LONGS_EQUAL(HOOK_PROCESS_BUFFER_SIZE, HOOK_PROCESS(hook, buffer_max));
+    unhook (hook);
+}
+
+/*
+ * Tests functions:
+ *   hook_process_send_buffers
+ */
+
+TEST(CoreHook, ProcessSendBuffers)
+{
+    struct t_test_hook_process_result result;
+    struct t_hook *hook;
+
+    /* without line mode: all data is sent */
+    hook = test_hook_process_new ("16", NULL, NULL, &result);
+    CHECK(hook);
+    hook_process_send_buffers (hook, WEECHAT_HOOK_PROCESS_RUNNING);
+    LONGS_EQUAL(0, result.count);
+    test_hook_process_add_data (hook, HOOK_PROCESS_STDOUT, "line1\npart");
+    test_hook_process_add_data (hook, HOOK_PROCESS_STDERR, "error");
+    hook_process_send_buffers (hook, WEECHAT_HOOK_PROCESS_RUNNING);
+    LONGS_EQUAL(1, result.count);
+    LONGS_EQUAL(WEECHAT_HOOK_PROCESS_RUNNING, result.return_code);
+    STRCMP_EQUAL("line1\npart", result.out);
+    STRCMP_EQUAL("error", result.err);
+    LONGS_EQUAL(0, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+    LONGS_EQUAL(0, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDERR]));
+    unhook (hook);
+
+    /* line mode: partial line is kept in buffer for next call */
+    hook = test_hook_process_new ("16", "1", NULL, &result);
+    CHECK(hook);
+    test_hook_process_add_data (hook, HOOK_PROCESS_STDOUT, "line1\nline2\npa");
+    hook_process_send_buffers (hook, WEECHAT_HOOK_PROCESS_RUNNING);
+    LONGS_EQUAL(1, result.count);
+    STRCMP_EQUAL("line1\nline2\n", result.out);
+    STRCMP_EQUAL("", result.err);
+    LONGS_EQUAL(2, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+    CHECK(strncmp (HOOK_PROCESS(hook, buffer[HOOK_PROCESS_STDOUT]),
+                   "pa", 2) == 0);
+
+    /* line mode: no complete line, nothing is sent */
+    test_hook_process_add_data (hook, HOOK_PROCESS_STDOUT, "rt");
+    hook_process_send_buffers (hook, WEECHAT_HOOK_PROCESS_RUNNING);
+    LONGS_EQUAL(1, result.count);
+    LONGS_EQUAL(4, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+
+    /* line mode: partial line completed */
+    test_hook_process_add_data (hook, HOOK_PROCESS_STDOUT, "ial\nnext");
+    hook_process_send_buffers (hook, WEECHAT_HOOK_PROCESS_RUNNING);
+    LONGS_EQUAL(2, result.count);
+    STRCMP_EQUAL("line1\nline2\npartial\n", result.out);
+    LONGS_EQUAL(4, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+
+    /* line mode: final flush at end of process sends the partial line */
+    hook_process_send_buffers (hook, 0);
+    LONGS_EQUAL(3, result.count);
+    LONGS_EQUAL(0, result.return_code);
+    STRCMP_EQUAL("line1\nline2\npartial\nnext", result.out);
+    LONGS_EQUAL(0, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+
+    /* final flush with empty buffers: callback is called (end of process) */
+    hook_process_send_buffers (hook, 0);
+    LONGS_EQUAL(4, result.count);
+    unhook (hook);
+
+    /* line mode: buffer full without new line, all data is sent */
+    hook = test_hook_process_new ("8", "1", NULL, &result);
+    CHECK(hook);
+    test_hook_process_add_data (hook, HOOK_PROCESS_STDOUT, "abcdefgh");
+    hook_process_send_buffers (hook, WEECHAT_HOOK_PROCESS_RUNNING);
+    LONGS_EQUAL(1, result.count);
+    STRCMP_EQUAL("abcdefgh", result.out);
+    LONGS_EQUAL(0, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+    unhook (hook);
+}
+
+/*
+ * Tests functions:
+ *   hook_process_child_read
+ */
+
+TEST(CoreHook, ProcessChildRead)
+{
+    struct t_test_hook_process_result result;
+    struct t_hook *hook, *hook_fd;
+    int fd[2], pending;
+
+    /* line mode: partial line carried over across reads */
+    hook = test_hook_process_new ("16", "1", NULL, &result);
+    CHECK(hook);
+    LONGS_EQUAL(0, pipe (fd));
+    fcntl (fd[0], F_SETFL, fcntl (fd[0], F_GETFL) | O_NONBLOCK);
+    hook_fd = NULL;
+    LONGS_EQUAL(9, write (fd[1], "abc\ndef\ng", 9));
+    hook_process_child_read (hook, fd[0], HOOK_PROCESS_STDOUT, &hook_fd);
+    LONGS_EQUAL(0, result.count);
+    LONGS_EQUAL(9, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+    hook_process_send_buffers (hook, WEECHAT_HOOK_PROCESS_RUNNING);
+    LONGS_EQUAL(1, result.count);
+    STRCMP_EQUAL("abc\ndef\n", result.out);
+    LONGS_EQUAL(1, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+    LONGS_EQUAL(6, write (fd[1], "hi\njkl", 6));
+    hook_process_child_read (hook, fd[0], HOOK_PROCESS_STDOUT, &hook_fd);
+    LONGS_EQUAL(1, result.count);
+    LONGS_EQUAL(7, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+    hook_process_send_buffers (hook, WEECHAT_HOOK_PROCESS_RUNNING);
+    LONGS_EQUAL(2, result.count);
+    STRCMP_EQUAL("abc\ndef\nghi\n", result.out);
+    LONGS_EQUAL(3, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+
+    /* line mode: buffer filled without new line, all data is sent */
+    LONGS_EQUAL(13, write (fd[1], "mnopqrstuvwxy", 13));
+    hook_process_child_read (hook, fd[0], HOOK_PROCESS_STDOUT, &hook_fd);
+    LONGS_EQUAL(3, result.count);
+    STRCMP_EQUAL("abc\ndef\nghi\njklmnopqrstuvwxy", result.out);
+    LONGS_EQUAL(0, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+    close (fd[0]);
+    close (fd[1]);
+    unhook (hook);
+
+    /* backpressure: pipe is not read while the callback is busy */
+    hook = test_hook_process_new ("4", NULL, "1", &result);
+    CHECK(hook);
+    LONGS_EQUAL(0, pipe (fd));
+    fcntl (fd[0], F_SETFL, fcntl (fd[0], F_GETFL) | O_NONBLOCK);
+    result.fd = fd[0];
+    hook_fd = NULL;
+    LONGS_EQUAL(2, write (fd[1], "01", 2));
+    hook_process_child_read (hook, fd[0], HOOK_PROCESS_STDOUT, &hook_fd);
+    LONGS_EQUAL(0, result.count);
+    LONGS_EQUAL(8, write (fd[1], "23456789", 8));
+    hook_process_child_read (hook, fd[0], HOOK_PROCESS_STDOUT, &hook_fd);
+    LONGS_EQUAL(1, result.count);
+    STRCMP_EQUAL("0123", result.out);
+    LONGS_EQUAL(6, result.pipe_pending);
+    LONGS_EQUAL(0, ioctl (fd[0], FIONREAD, &pending));
+    LONGS_EQUAL(6, pending);
+    hook_process_child_read (hook, fd[0], HOOK_PROCESS_STDOUT, &hook_fd);
+    LONGS_EQUAL(2, result.count);
+    STRCMP_EQUAL("01234567", result.out);
+    LONGS_EQUAL(2, result.pipe_pending);
+    hook_process_child_read (hook, fd[0], HOOK_PROCESS_STDOUT, &hook_fd);
+    LONGS_EQUAL(2, result.count);
+    LONGS_EQUAL(2, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+    LONGS_EQUAL(0, ioctl (fd[0], FIONREAD, &pending));
+    LONGS_EQUAL(0, pending);
+
+    /* end of process: EOF on pipe, then final flush */
+    close (fd[1]);
+    hook_process_child_read (hook, fd[0], HOOK_PROCESS_STDOUT, &hook_fd);
+    LONGS_EQUAL(2, result.count);
+    hook_process_send_buffers (hook, 0);
+    LONGS_EQUAL(3, result.count);
+    LONGS_EQUAL(0, result.return_code);
+    STRCMP_EQUAL("0123456789", result.out);
+    close (fd[0]);
+    unhook (hook);
+
+    /* without backpressure: pipe is read again after the callback */
+    hook = test_hook_process_new ("4", NULL, NULL, &result);
+    CHECK(hook);
+    LONGS_EQUAL(0, pipe (fd));
+    fcntl (fd[0], F_SETFL, fcntl (fd[0], F_GETFL) | O_NONBLOCK);
+    hook_fd = NULL;
+    test_hook_process_add_data (hook, HOOK_PROCESS_STDOUT, "ab");
+    LONGS_EQUAL(5, write (fd[1], "cdefg", 5));
+    hook_process_child_read (hook, fd[0], HOOK_PROCESS_STDOUT, &hook_fd);
+    LONGS_EQUAL(1, result.count);
+    STRCMP_EQUAL("abcd", result.out);
+    LONGS_EQUAL(3, HOOK_PROCESS(hook, buffer_size[HOOK_PROCESS_STDOUT]));
+    LONGS_EQUAL(0, ioctl (fd[0], FIONREAD, &pending));
+    LONGS_EQUAL(0, pending);
+    close (fd[0]);
+    close (fd[1]);
+    unhook (hook);
 }
 
 /*
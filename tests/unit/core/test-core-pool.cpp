@@ -0,0 +1,234 @@
+/*
+ * test-core-pool.cpp - test pool functions
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <string.h>
+#include "src/core/weechat.h"
+#include "src/core/wee-pool.h"
+}
+
+TEST_GROUP(CorePool)
+{
+};
+
+/*
+ * Tests functions:
+ *   pool_new
+ *   pool_objects_total
+ *   pool_free
+ */
+
+TEST(CorePool, New)
+{
+    struct t_pool *pool;
+
+    POINTERS_EQUAL(NULL, pool_new (NULL, NULL, 16, 8));
+    POINTERS_EQUAL(NULL, pool_new (NULL, "test", 0, 8));
+    POINTERS_EQUAL(NULL, pool_new (NULL, "test", -1, 8));
+
+    /* object size is aligned, and big enough for a pointer */
+    pool = pool_new (NULL, "test", 1, 8);
+    CHECK(pool);
+    POINTERS_EQUAL(NULL, pool->plugin);
+    STRCMP_EQUAL("test", pool->name);
+    LONGS_EQUAL(POOL_ALIGN_SIZE, pool->object_size);
+    LONGS_EQUAL(8, pool->objects_per_slab);
+    POINTERS_EQUAL(NULL, pool->slabs);
+    LONGS_EQUAL(0, pool->slabs_count);
+    POINTERS_EQUAL(NULL, pool->free_objects);
+    LONGS_EQUAL(0, pool->objects_used);
+    LONGS_EQUAL(0, pool->objects_used_max);
+    LONGS_EQUAL(0, pool_objects_total (pool));
+    CHECK(pool == last_weechat_pool);
+    pool_free (pool);
+
+    pool = pool_new (NULL, "test", 21, 0);
+    CHECK(pool);
+    LONGS_EQUAL(24, pool->object_size);
+    LONGS_EQUAL(POOL_DEFAULT_PER_SLAB, pool->objects_per_slab);
+    pool_free (pool);
+
+    /* slab size is limited */
+    pool = pool_new (NULL, "test", 1024, 1024 * 1024);
+    CHECK(pool);
+    LONGS_EQUAL(POOL_MAX_SLAB_SIZE / 1024, pool->objects_per_slab);
+    pool_free (pool);
+
+    LONGS_EQUAL(0, pool_objects_total (NULL));
+
+    /* test free of NULL pool */
+    pool_free (NULL);
+}
+
+/*
+ * Tests functions:
+ *   pool_alloc
+ *   pool_release
+ */
+
+TEST(CorePool, AllocRelease)
+{
+    struct t_pool *pool;
+    char *objects[10], *object;
+    int i, j;
+
+    POINTERS_EQUAL(NULL, pool_alloc (NULL));
+    pool_release (NULL, NULL);
+
+    pool = pool_new (NULL, "test", 32, 4);
+    CHECK(pool);
+
+    /* allocate 10 objects: 3 slabs are needed */
+    for (i = 0; i < 10; i++)
+    {
+        objects[i] = (char *)pool_alloc (pool);
+        CHECK(objects[i]);
+        memset (objects[i], 'a' + i, 32);
+        for (j = 0; j < i; j++)
+        {
+            CHECK(objects[i] != objects[j]);
+        }
+    }
+    LONGS_EQUAL(3, pool->slabs_count);
+    LONGS_EQUAL(12, pool_objects_total (pool));
+    LONGS_EQUAL(10, pool->objects_used);
+    LONGS_EQUAL(10, pool->objects_used_max);
+
+    /* check that objects do not overlap */
+    for (i = 0; i < 10; i++)
+    {
+        for (j = 0; j < 32; j++)
+        {
+            LONGS_EQUAL('a' + i, objects[i][j]);
+        }
+    }
+
+    /* release objects: they are reused (last released first) */
+    pool_release (pool, objects[3]);
+    pool_release (pool, objects[7]);
+    pool_release (pool, NULL);
+    LONGS_EQUAL(8, pool->objects_used);
+    object = (char *)pool_alloc (pool);
+    POINTERS_EQUAL(objects[7], object);
+    object = (char *)pool_alloc (pool);
+    POINTERS_EQUAL(objects[3], object);
+    LONGS_EQUAL(3, pool->slabs_count);
+    LONGS_EQUAL(10, pool->objects_used);
+
+    /* release all objects: slabs are kept */
+    for (i = 0; i < 10; i++)
+    {
+        pool_release (pool, objects[i]);
+    }
+    LONGS_EQUAL(0, pool->objects_used);
+    LONGS_EQUAL(10, pool->objects_used_max);
+    LONGS_EQUAL(3, pool->slabs_count);
+    LONGS_EQUAL(12, pool->count_alloc);
+
+    pool_free (pool);
+}
+
+/*
+ * Tests functions:
+ *   pool_alloc
+ *   pool_release
+ *
+ * (with debug poisoning enabled)
+ */
+
+TEST(CorePool, Poison)
+{
+    struct t_pool *pool, *pool2;
+    unsigned char *object, *object2;
+    int i, old_debug_core;
+
+    old_debug_core = weechat_debug_core;
+    weechat_debug_core = 1;
+
+    pool = pool_new (NULL, "test", 16, 4);
+    CHECK(pool);
+    pool2 = pool_new (NULL, "test2", 16, 4);
+    CHECK(pool2);
+
+    object = (unsigned char *)pool_alloc (pool);
+    CHECK(object);
+    for (i = 0; i < 16; i++)
+    {
+        LONGS_EQUAL(POOL_POISON_ALLOC, object[i]);
+    }
+
+    pool_release (pool, object);
+    LONGS_EQUAL(0, pool->objects_used);
+    for (i = sizeof (void *); i < 16; i++)
+    {
+        LONGS_EQUAL(POOL_POISON_RELEASE, object[i]);
+    }
+
+    /* release of an object in the wrong pool is ignored */
+    object2 = (unsigned char *)pool_alloc (pool2);
+    CHECK(object2);
+    object = (unsigned char *)pool_alloc (pool);
+    pool_release (pool, object2);
+    LONGS_EQUAL(1, pool->objects_used);
+    pool_release (pool, object + 1);
+    LONGS_EQUAL(1, pool->objects_used);
+    pool_release (pool2, object2);
+    pool_release (pool, object);
+    LONGS_EQUAL(0, pool->objects_used);
+    LONGS_EQUAL(0, pool2->objects_used);
+
+    pool_free (pool);
+    pool_free (pool2);
+
+    weechat_debug_core = old_debug_core;
+}
+
+/*
+ * Tests functions:
+ *   pool_free_all_plugin
+ */
+
+TEST(CorePool, FreeAllPlugin)
+{
+    struct t_pool *pool1, *pool2, *pool3, *old_last_pool;
+
+    old_last_pool = last_weechat_pool;
+
+    pool1 = pool_new ((struct t_weechat_plugin *)0x1, "test1", 16, 4);
+    pool2 = pool_new ((struct t_weechat_plugin *)0x2, "test2", 16, 4);
+    pool3 = pool_new ((struct t_weechat_plugin *)0x1, "test3", 16, 4);
+    CHECK(pool1);
+    CHECK(pool2);
+    CHECK(pool3);
+    CHECK(pool_alloc (pool1));
+    CHECK(pool_alloc (pool3));
+
+    pool_free_all_plugin ((struct t_weechat_plugin *)0x1);
+    POINTERS_EQUAL(pool2, last_weechat_pool);
+    POINTERS_EQUAL(old_last_pool, pool2->prev_pool);
+    POINTERS_EQUAL(NULL, pool2->next_pool);
+
+    pool_free_all_plugin ((struct t_weechat_plugin *)0x2);
+    POINTERS_EQUAL(old_last_pool, last_weechat_pool);
+}
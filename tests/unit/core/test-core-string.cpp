@@ -1884,6 +1884,7 @@ TEST(CoreString, RebuildSplitString)
 
 /*
  * Tests functions:
+ *    string_iconv_cache_free
  *    string_iconv
  *    string_iconv_to_internal
  *    string_iconv_from_internal
@@ -1894,8 +1895,13 @@ TEST(CoreString, Iconv)
 {
     const char *noel_utf8 = "no\xc3\xabl";  /* noël */
     const char *noel_iso = "no\xebl";
+    const char *charsets[] = { "ISO-8859-1", "ISO-8859-2", "ISO-8859-3",
+                               "ISO-8859-4", "ISO-8859-5", "ISO-8859-6",
+                               "ISO-8859-7", "ISO-8859-8", "ISO-8859-9",
+                               "ISO-8859-15", NULL };
     char *str;
     FILE *f;
+    int i;
 
     /* string_iconv */
     WEE_TEST_STR(NULL, string_iconv (0, NULL, NULL, NULL));
@@ -1905,6 +1911,21 @@ TEST(CoreString, Iconv)
     WEE_TEST_STR(noel_iso, string_iconv (1, "UTF-8", "ISO-8859-15", noel_utf8));
     WEE_TEST_STR(noel_utf8, string_iconv (0, "ISO-8859-15", "UTF-8", noel_iso));
 
+    /* ASCII chars are converted for some charsets */
+    WEE_TEST_STR("a+-b", string_iconv (1, "UTF-8", "UTF-7", "a+b"));
+    WEE_TEST_STR("a+b", string_iconv (0, "UTF-7", "UTF-8", "a+-b"));
+    WEE_TEST_STR("\xe3\x80\x80",
+                 string_iconv (0, "ISO-2022-JP", "UTF-8", "\x1b$B!!\x1b(B"));
+
+    /* more charsets than descriptors kept in cache */
+    for (i = 0; charsets[i]; i++)
+    {
+        WEE_TEST_STR("abc", string_iconv (1, "UTF-8", charsets[i], "abc"));
+    }
+    WEE_TEST_STR(noel_iso, string_iconv (1, "UTF-8", "ISO-8859-15", noel_utf8));
+    string_iconv_cache_free ();
+    WEE_TEST_STR(noel_iso, string_iconv (1, "UTF-8", "ISO-8859-15", noel_utf8));
+
     /* string_iconv_to_internal */
     WEE_TEST_STR(NULL, string_iconv_to_internal (NULL, NULL));
     WEE_TEST_STR("", string_iconv_to_internal (NULL, ""));
@@ -0,0 +1,172 @@
+/*
+ * test-core-thread-pool.cpp - test pool of threads functions
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <stdlib.h>
+#include <unistd.h>
+#include "src/core/wee-thread-pool.h"
+
+int test_thread_pool_freed = 0;
+
+int
+test_thread_pool_square_cb (void *arg)
+{
+    int value;
+
+    value = *((int *)arg);
+
+    return value * value;
+}
+
+int
+test_thread_pool_sleep_cb (void *arg)
+{
+    usleep (*((int *)arg));
+
+    return 0;
+}
+
+void
+test_thread_pool_free_cb (void *arg)
+{
+    free (arg);
+    test_thread_pool_freed++;
+}
+}
+
+#define TEST_THREAD_POOL_NUM_JOBS 32
+
+TEST_GROUP(CoreThreadPool)
+{
+};
+
+/*
+ * Tests functions:
+ *   thread_pool_job_add
+ *   thread_pool_job_done
+ *   thread_pool_job_cancel
+ *   thread_pool_job_wait
+ *   thread_pool_job_free
+ *   thread_pool_get_stats
+ */
+
+TEST(CoreThreadPool, Jobs)
+{
+    struct t_thread_pool_job *jobs[TEST_THREAD_POOL_NUM_JOBS];
+    struct t_thread_pool_stats stats;
+    int values[TEST_THREAD_POOL_NUM_JOBS], i;
+
+    POINTERS_EQUAL(NULL, thread_pool_job_add (NULL, NULL, NULL, 1));
+    POINTERS_EQUAL(NULL, thread_pool_job_add (&test_thread_pool_square_cb,
+                                              NULL, NULL, 0));
+
+    LONGS_EQUAL(0, thread_pool_job_done (NULL));
+    LONGS_EQUAL(0, thread_pool_job_cancel (NULL));
+    thread_pool_job_wait (NULL);
+    LONGS_EQUAL(1, thread_pool_job_free (NULL));
+    thread_pool_get_stats (NULL);
+
+    for (i = 0; i < TEST_THREAD_POOL_NUM_JOBS; i++)
+    {
+        values[i] = i;
+        jobs[i] = thread_pool_job_add (&test_thread_pool_square_cb,
+                                       &values[i], NULL, 2);
+        CHECK(jobs[i]);
+    }
+
+    /* no more than 2 threads are started */
+    thread_pool_get_stats (&stats);
+    CHECK(stats.threads <= 2);
+
+    for (i = 0; i < TEST_THREAD_POOL_NUM_JOBS; i++)
+    {
+        thread_pool_job_wait (jobs[i]);
+        LONGS_EQUAL(1, thread_pool_job_done (jobs[i]));
+        LONGS_EQUAL(i * i, jobs[i]->rc);
+        LONGS_EQUAL(1, thread_pool_job_free (jobs[i]));
+    }
+
+    thread_pool_get_stats (&stats);
+    CHECK(stats.threads <= 2);
+    LONGS_EQUAL(0, stats.jobs_queued);
+    LONGS_EQUAL(0, stats.jobs_running);
+    CHECK(stats.jobs_done >= TEST_THREAD_POOL_NUM_JOBS);
+}
+
+/*
+ * Tests functions:
+ *   thread_pool_job_add
+ *   thread_pool_job_cancel
+ *   thread_pool_job_wait
+ *   thread_pool_job_free
+ *   thread_pool_end
+ */
+
+TEST(CoreThreadPool, Cancel)
+{
+    struct t_thread_pool_job *job_running, *job_queued, *job_detached;
+    int delay, *ptr_delay;
+
+    /* one thread: the second job is queued until the end of first job */
+    delay = 200 * 1000;
+    job_running = thread_pool_job_add (&test_thread_pool_sleep_cb,
+                                       &delay, NULL, 1);
+    CHECK(job_running);
+    job_queued = thread_pool_job_add (&test_thread_pool_square_cb,
+                                      &delay, NULL, 1);
+    CHECK(job_queued);
+
+    /* a queued job can be cancelled */
+    LONGS_EQUAL(1, thread_pool_job_cancel (job_queued));
+    LONGS_EQUAL(0, thread_pool_job_cancel (job_queued));
+    LONGS_EQUAL(1, thread_pool_job_done (job_queued));
+    LONGS_EQUAL(-1, job_queued->rc);
+    LONGS_EQUAL(1, thread_pool_job_free (job_queued));
+
+    /* a running job is detached, and freed by its thread */
+    usleep (50 * 1000);
+    test_thread_pool_freed = 0;
+    ptr_delay = (int *)malloc (sizeof (*ptr_delay));
+    CHECK(ptr_delay);
+    *ptr_delay = 1000;
+    job_detached = thread_pool_job_add (&test_thread_pool_sleep_cb,
+                                        ptr_delay, &test_thread_pool_free_cb,
+                                        2);
+    CHECK(job_detached);
+    while (!thread_pool_job_done (job_running)
+           && (job_detached->status == THREAD_POOL_JOB_QUEUED))
+    {
+        usleep (1000);
+    }
+    if (thread_pool_job_free (job_detached))
+        test_thread_pool_free_cb (ptr_delay);
+
+    thread_pool_job_wait (job_running);
+    LONGS_EQUAL(0, thread_pool_job_cancel (job_running));
+    LONGS_EQUAL(0, job_running->rc);
+    LONGS_EQUAL(1, thread_pool_job_free (job_running));
+
+    thread_pool_end ();
+    LONGS_EQUAL(1, test_thread_pool_freed);
+}
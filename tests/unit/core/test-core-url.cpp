@@ -23,9 +23,18 @@
 
 extern "C"
 {
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "src/core/wee-hashtable.h"
 #include "src/core/wee-url.h"
+#include "src/plugins/plugin.h"
 }
 
+#define TEST_URL_FILE_IN "./tmp_weechat_test/url_in.txt"
+#define TEST_URL_FILE_OUT "./tmp_weechat_test/url_out.txt"
+
 TEST_GROUP(CoreUrl)
 {
 };
@@ -33,11 +42,66 @@ TEST_GROUP(CoreUrl)
 /*
  * Tests functions:
  *   weeurl_download
+ *   weeurl_transfer_init
+ *   weeurl_transfer_perform
+ *   weeurl_transfer_end
  */
 
 TEST(CoreUrl, Download)
 {
-    /* TODO: write tests */
+    struct t_url_transfer transfer;
+    struct t_hashtable *options;
+    char url[PATH_MAX + 64], cwd[PATH_MAX], buffer[256];
+    FILE *file;
+
+    LONGS_EQUAL(1, weeurl_download (NULL, NULL));
+    LONGS_EQUAL(1, weeurl_download ("", NULL));
+
+    options = hashtable_new (32,
+                             WEECHAT_HASHTABLE_STRING,
+                             WEECHAT_HASHTABLE_STRING,
+                             NULL, NULL);
+    CHECK(options);
+
+    /* input file not found */
+    hashtable_set (options, "file_in", "/path/not/found");
+    LONGS_EQUAL(4, weeurl_transfer_init (&transfer, "file:///dev/null",
+                                         options, NULL, NULL));
+    weeurl_transfer_end (&transfer);
+    POINTERS_EQUAL(NULL, transfer.curl);
+    hashtable_remove_all (options);
+
+    /* copy a local file */
+    file = fopen (TEST_URL_FILE_IN, "w");
+    CHECK(file);
+    fputs ("test URL", file);
+    fclose (file);
+    CHECK(getcwd (cwd, sizeof (cwd)));
+    snprintf (url, sizeof (url), "file://%s/%s", cwd, TEST_URL_FILE_IN + 2);
+    hashtable_set (options, "file_out", TEST_URL_FILE_OUT);
+    LONGS_EQUAL(0, weeurl_transfer_init (&transfer, url, options, NULL, NULL));
+    CHECK(transfer.curl);
+    LONGS_EQUAL(0, weeurl_transfer_perform (&transfer));
+    weeurl_transfer_end (&transfer);
+    file = fopen (TEST_URL_FILE_OUT, "r");
+    CHECK(file);
+    CHECK(fgets (buffer, sizeof (buffer), file));
+    fclose (file);
+    STRCMP_EQUAL("test URL", buffer);
+
+    /* cancelled transfer */
+    LONGS_EQUAL(0, weeurl_transfer_init (&transfer, url, options, NULL,
+                                         NULL));
+    transfer.cancel = 1;
+    transfer.error = fopen ("/dev/null", "w");
+    CHECK(transfer.error);
+    LONGS_EQUAL(2, weeurl_transfer_perform (&transfer));
+    fclose (transfer.error);
+    weeurl_transfer_end (&transfer);
+
+    unlink (TEST_URL_FILE_IN);
+    unlink (TEST_URL_FILE_OUT);
+    hashtable_free (options);
 }
 
 /*
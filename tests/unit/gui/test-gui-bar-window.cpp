@@ -23,8 +23,13 @@
 
 extern "C"
 {
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include "src/gui/gui-bar.h"
+#include "src/gui/gui-bar-item.h"
 #include "src/gui/gui-bar-window.h"
+#include "src/gui/gui-chat.h"
 #include "src/gui/gui-color.h"
 #include "src/gui/gui-window.h"
 
@@ -193,9 +198,150 @@ TEST(GuiBarWindow, ItemIsSpacer)
  *   gui_bar_window_content_get_with_filling
  */
 
+char *
+test_bar_item_cb (const void *pointer, void *data,
+                  struct t_gui_bar_item *item,
+                  struct t_gui_window *window,
+                  struct t_gui_buffer *buffer,
+                  struct t_hashtable *extra_info)
+{
+    /* make C++ compiler happy */
+    (void) data;
+    (void) item;
+    (void) window;
+    (void) buffer;
+    (void) extra_info;
+
+    return strdup ((const char *)pointer);
+}
+
 TEST(GuiBarWindow, ContentGetWithFilling)
 {
-    /* TODO: write tests */
+    struct t_gui_bar_item *item1, *item2;
+    struct t_gui_bar *bar;
+    struct t_gui_bar_window *bar_window;
+    char value1[64], value2[64], str_expected[256], *content, *content2;
+    int num_spacers, length_on_screen;
+
+    num_spacers = -1;
+    length_on_screen = -1;
+    POINTERS_EQUAL(NULL,
+                   gui_bar_window_content_get_with_filling (
+                       NULL, NULL, &num_spacers, &length_on_screen));
+    LONGS_EQUAL(0, num_spacers);
+    LONGS_EQUAL(0, length_on_screen);
+
+    snprintf (value1, sizeof (value1), "abc");
+    snprintf (value2, sizeof (value2), "defgh");
+    item1 = gui_bar_item_new (NULL, "test_item1",
+                              &test_bar_item_cb, value1, NULL);
+    CHECK(item1);
+    item2 = gui_bar_item_new (NULL, "test_item2",
+                              &test_bar_item_cb, value2, NULL);
+    CHECK(item2);
+    bar = gui_bar_new ("test", "off", "0", "window", "", "top",
+                       "horizontal", "vertical", "1", "0",
+                       "default", "default", "default", "default",
+                       "off", "test_item1,test_item2");
+    CHECK(bar);
+    bar_window = gui_bar_window_search_bar (gui_windows, bar);
+    CHECK(bar_window);
+    bar_window->width = 24;
+    bar_window->height = 1;
+
+    /* horizontal filling */
+    content = gui_bar_window_content_get_with_filling (
+        bar_window, gui_windows, &num_spacers, &length_on_screen);
+    snprintf (str_expected, sizeof (str_expected),
+              "%c%c%c%cabc%c %c%c%cdefgh%c%c%c",
+              GUI_COLOR_RESET_CHAR,
+              GUI_COLOR_COLOR_CHAR, GUI_COLOR_BAR_CHAR,
+              GUI_COLOR_BAR_START_ITEM,
+              GUI_COLOR_RESET_CHAR,
+              GUI_COLOR_COLOR_CHAR, GUI_COLOR_BAR_CHAR,
+              GUI_COLOR_BAR_START_ITEM,
+              GUI_COLOR_COLOR_CHAR, GUI_COLOR_BAR_CHAR,
+              GUI_COLOR_BAR_START_ITEM);
+    STRCMP_EQUAL(str_expected, content);
+    LONGS_EQUAL(0, num_spacers);
+    LONGS_EQUAL(9, length_on_screen);
+    LONGS_EQUAL(gui_chat_strlen_screen (content), length_on_screen);
+    LONGS_EQUAL(GUI_BAR_FILLING_HORIZONTAL, bar_window->content_filling_type);
+
+    /* cache hit: same content even if item value changed without update */
+    snprintf (value1, sizeof (value1), "xyz");
+    content2 = gui_bar_window_content_get_with_filling (
+        bar_window, gui_windows, &num_spacers, &length_on_screen);
+    STRCMP_EQUAL(content, content2);
+    CHECK(content != content2);
+    LONGS_EQUAL(0, num_spacers);
+    LONGS_EQUAL(9, length_on_screen);
+    free (content2);
+    free (content);
+
+    /* cache invalidated after an update of item */
+    snprintf (value1, sizeof (value1), "abcd");
+    gui_bar_item_update ("test_item1");
+    LONGS_EQUAL(1, bar_window->items_refresh_needed[0][0]);
+    content = gui_bar_window_content_get_with_filling (
+        bar_window, gui_windows, &num_spacers, &length_on_screen);
+    CHECK(strstr (content, "abcd"));
+    CHECK(strstr (content, "defgh"));
+    LONGS_EQUAL(0, bar_window->items_refresh_needed[0][0]);
+    LONGS_EQUAL(10, length_on_screen);
+    LONGS_EQUAL(gui_chat_strlen_screen (content), length_on_screen);
+    free (content);
+
+    /* cache invalidated after a change of filling */
+    snprintf (value1, sizeof (value1), "a\nbb\nccc");
+    gui_bar_item_update ("test_item1");
+    content = gui_bar_window_content_get_with_filling (
+        bar_window, gui_windows, &num_spacers, &length_on_screen);
+    free (content);
+    gui_bar_set (bar, "filling_top_bottom", "columns_horizontal");
+    content = gui_bar_window_content_get_with_filling (
+        bar_window, gui_windows, &num_spacers, &length_on_screen);
+    snprintf (str_expected, sizeof (str_expected),
+              "a    %c bb   %c ccc  %c defgh\n",
+              GUI_COLOR_RESET_CHAR,
+              GUI_COLOR_RESET_CHAR,
+              GUI_COLOR_RESET_CHAR);
+    STRCMP_EQUAL(str_expected, content);
+    LONGS_EQUAL(0, num_spacers);
+    LONGS_EQUAL(24, length_on_screen);
+    LONGS_EQUAL(GUI_BAR_FILLING_COLUMNS_HORIZONTAL,
+                bar_window->content_filling_type);
+    LONGS_EQUAL(6, bar_window->screen_col_size);
+    LONGS_EQUAL(1, bar_window->screen_lines);
+    LONGS_EQUAL(24, bar_window->content_filling_width);
+    LONGS_EQUAL(1, bar_window->content_filling_height);
+    free (content);
+
+    /* columns built again if width of bar window changes */
+    bar_window->width = 12;
+    content = gui_bar_window_content_get_with_filling (
+        bar_window, gui_windows, &num_spacers, &length_on_screen);
+    snprintf (str_expected, sizeof (str_expected),
+              "a    %c bb   \nccc  %c defgh\n",
+              GUI_COLOR_RESET_CHAR,
+              GUI_COLOR_RESET_CHAR);
+    STRCMP_EQUAL(str_expected, content);
+    LONGS_EQUAL(24, length_on_screen);
+    LONGS_EQUAL(2, bar_window->screen_lines);
+    LONGS_EQUAL(12, bar_window->content_filling_width);
+    free (content);
+
+    /* columns built again if height of bar window changes */
+    bar_window->height = 2;
+    content = gui_bar_window_content_get_with_filling (
+        bar_window, gui_windows, &num_spacers, &length_on_screen);
+    STRCMP_EQUAL(str_expected, content);
+    LONGS_EQUAL(2, bar_window->content_filling_height);
+    free (content);
+
+    gui_bar_free (bar);
+    gui_bar_item_free (item1);
+    gui_bar_item_free (item2);
 }
 
 /*
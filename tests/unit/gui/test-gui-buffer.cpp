@@ -24,10 +24,12 @@
 extern "C"
 {
 #include <string.h>
+#include "src/core/wee-arraylist.h"
 #include "src/core/wee-hashtable.h"
 #include "src/core/wee-hook.h"
 #include "src/core/wee-input.h"
 #include "src/gui/gui-buffer.h"
+#include "src/gui/gui-input.h"
 #include "src/gui/gui-key.h"
 #include "src/gui/gui-line.h"
 #include "src/gui/gui-nicklist.h"
@@ -700,11 +702,58 @@ TEST(GuiBuffer, GetPointer)
 /*
  * Tests functions:
  *   gui_buffer_ask_chat_refresh
+ *   gui_buffer_refresh_queue_add
+ *   gui_buffer_refresh_queue_update
  */
 
 TEST(GuiBuffer, AskChatRefresh)
 {
-    /* TODO: write tests */
+    struct t_gui_buffer *buffer;
+    int i, size;
+
+    buffer = gui_buffer_new (NULL, TEST_BUFFER_NAME,
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    /* new buffer is in refresh queue */
+    LONGS_EQUAL(2, buffer->chat_refresh_needed);
+    LONGS_EQUAL(1, buffer->refresh_queued);
+
+    /* buffer refreshed: removed from queue */
+    buffer->chat_refresh_needed = 0;
+    buffer->own_lines->buffer_max_length_refresh = 0;
+    buffer->own_lines->prefix_max_length_refresh = 0;
+    gui_buffer_refresh_queue_update ();
+    LONGS_EQUAL(0, buffer->refresh_queued);
+
+    gui_buffer_ask_chat_refresh (NULL, 1);
+    gui_buffer_ask_chat_refresh (buffer, 0);
+    LONGS_EQUAL(0, buffer->chat_refresh_needed);
+    LONGS_EQUAL(0, buffer->refresh_queued);
+
+    gui_buffer_ask_chat_refresh (buffer, 1);
+    LONGS_EQUAL(1, buffer->chat_refresh_needed);
+    LONGS_EQUAL(1, buffer->refresh_queued);
+    gui_buffer_ask_chat_refresh (buffer, 2);
+    LONGS_EQUAL(2, buffer->chat_refresh_needed);
+    gui_buffer_ask_chat_refresh (buffer, 1);
+    LONGS_EQUAL(2, buffer->chat_refresh_needed);
+
+    /* buffer is added only once in queue */
+    size = arraylist_size (gui_buffers_refresh);
+    gui_buffer_refresh_queue_add (buffer);
+    LONGS_EQUAL(size, arraylist_size (gui_buffers_refresh));
+
+    /* refresh still needed: buffer is kept in queue */
+    gui_buffer_refresh_queue_update ();
+    LONGS_EQUAL(1, buffer->refresh_queued);
+
+    /* closed buffer is removed from queue */
+    gui_buffer_close (buffer);
+    for (i = 0; i < arraylist_size (gui_buffers_refresh); i++)
+    {
+        CHECK(arraylist_get (gui_buffers_refresh, i) != buffer);
+    }
 }
 
 /*
@@ -1277,14 +1326,125 @@ TEST(GuiBuffer, UndoSnapFree)
     /* TODO: write tests */
 }
 
+/*
+ * Tests functions:
+ *   gui_buffer_undo_set_diff
+ *   gui_buffer_undo_apply_diff
+ */
+
+TEST(GuiBuffer, UndoDiff)
+{
+    struct t_gui_input_undo undo;
+    char *data;
+
+    memset (&undo, 0, sizeof (undo));
+
+    gui_buffer_undo_set_diff (&undo, strdup ("abc"), "abc");
+    LONGS_EQUAL(3, undo.diff_offset);
+    LONGS_EQUAL(0, undo.diff_size_next);
+    POINTERS_EQUAL(NULL, undo.diff_text);
+    data = gui_buffer_undo_apply_diff (&undo, strdup ("abc"));
+    STRCMP_EQUAL("abc", data);
+    free (data);
+
+    gui_buffer_undo_set_diff (&undo, strdup ("hello world"), "hello big world");
+    LONGS_EQUAL(6, undo.diff_offset);
+    LONGS_EQUAL(4, undo.diff_size_next);
+    POINTERS_EQUAL(NULL, undo.diff_text);
+    data = gui_buffer_undo_apply_diff (&undo, strdup ("hello big world"));
+    STRCMP_EQUAL("hello world", data);
+    free (data);
+
+    gui_buffer_undo_set_diff (&undo, strdup ("hello big world"), "hello world");
+    LONGS_EQUAL(6, undo.diff_offset);
+    LONGS_EQUAL(0, undo.diff_size_next);
+    STRCMP_EQUAL("big ", undo.diff_text);
+    data = gui_buffer_undo_apply_diff (&undo, strdup ("hello world"));
+    STRCMP_EQUAL("hello big world", data);
+    free (data);
+    free (undo.diff_text);
+
+    gui_buffer_undo_set_diff (&undo, strdup ("aaa"), "aa");
+    LONGS_EQUAL(2, undo.diff_offset);
+    LONGS_EQUAL(0, undo.diff_size_next);
+    STRCMP_EQUAL("a", undo.diff_text);
+    data = gui_buffer_undo_apply_diff (&undo, strdup ("aa"));
+    STRCMP_EQUAL("aaa", data);
+    free (data);
+    free (undo.diff_text);
+
+    gui_buffer_undo_set_diff (&undo, strdup ("xyz"), "");
+    LONGS_EQUAL(0, undo.diff_offset);
+    LONGS_EQUAL(0, undo.diff_size_next);
+    STRCMP_EQUAL("xyz", undo.diff_text);
+    data = gui_buffer_undo_apply_diff (&undo, strdup (""));
+    STRCMP_EQUAL("xyz", data);
+    free (data);
+    free (undo.diff_text);
+}
+
 /*
  * Tests functions:
  *   gui_buffer_undo_add
+ *   gui_buffer_undo_get_data
  */
 
 TEST(GuiBuffer, UndoAdd)
 {
-    /* TODO: write tests */
+    struct t_gui_buffer *buffer;
+    struct t_gui_input_undo *ptr_undo;
+    char *data;
+
+    buffer = gui_buffer_new (NULL, TEST_BUFFER_NAME,
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    POINTERS_EQUAL(NULL, gui_buffer_undo_get_data (NULL, NULL));
+    POINTERS_EQUAL(NULL, gui_buffer_undo_get_data (buffer, NULL));
+
+    gui_buffer_undo_add (NULL);
+
+    gui_buffer_undo_add (buffer);
+    gui_input_replace_input (buffer, "test");
+    gui_buffer_undo_add (buffer);
+    gui_input_replace_input (buffer, "test undo");
+    gui_buffer_undo_add (buffer);
+    LONGS_EQUAL(3, buffer->input_undo_count);
+
+    /* only the last undo has the full content */
+    ptr_undo = buffer->input_undo;
+    POINTERS_EQUAL(NULL, ptr_undo->data);
+    POINTERS_EQUAL(NULL, ptr_undo->next_undo->data);
+    STRCMP_EQUAL("test undo", buffer->last_input_undo->data);
+    POINTERS_EQUAL(buffer->last_input_undo, buffer->ptr_input_undo);
+
+    data = gui_buffer_undo_get_data (buffer, ptr_undo);
+    STRCMP_EQUAL("", data);
+    free (data);
+    data = gui_buffer_undo_get_data (buffer, ptr_undo->next_undo);
+    STRCMP_EQUAL("test", data);
+    free (data);
+    data = gui_buffer_undo_get_data (buffer, buffer->last_input_undo);
+    STRCMP_EQUAL("test undo", data);
+    free (data);
+
+    /* add with a snapshot: same content as snapshot is ignored */
+    gui_buffer_undo_snap (buffer);
+    gui_buffer_undo_add (buffer);
+    LONGS_EQUAL(3, buffer->input_undo_count);
+    POINTERS_EQUAL(NULL, buffer->input_undo_snap->data);
+
+    /* add after an undo: the next undos are removed */
+    buffer->ptr_input_undo = buffer->input_undo->next_undo;
+    gui_input_replace_input (buffer, "other");
+    gui_buffer_undo_add (buffer);
+    LONGS_EQUAL(3, buffer->input_undo_count);
+    data = gui_buffer_undo_get_data (buffer, buffer->input_undo->next_undo);
+    STRCMP_EQUAL("test", data);
+    free (data);
+    STRCMP_EQUAL("other", buffer->last_input_undo->data);
+
+    gui_buffer_close (buffer);
 }
 
 /*
@@ -1294,7 +1454,52 @@ TEST(GuiBuffer, UndoAdd)
 
 TEST(GuiBuffer, UndoFree)
 {
-    /* TODO: write tests */
+    struct t_gui_buffer *buffer;
+    const char *inputs[] = { "a", "ab", "abc", "xabc", NULL };
+    char *data;
+    int i;
+
+    buffer = gui_buffer_new (NULL, TEST_BUFFER_NAME,
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    for (i = 0; inputs[i]; i++)
+    {
+        gui_input_replace_input (buffer, inputs[i]);
+        gui_buffer_undo_add (buffer);
+    }
+    LONGS_EQUAL(4, buffer->input_undo_count);
+
+    gui_buffer_undo_free (NULL, NULL);
+    gui_buffer_undo_free (buffer, NULL);
+
+    /* free undo in the middle of list ("ab") */
+    gui_buffer_undo_free (buffer, buffer->input_undo->next_undo);
+    LONGS_EQUAL(3, buffer->input_undo_count);
+    data = gui_buffer_undo_get_data (buffer, buffer->input_undo);
+    STRCMP_EQUAL("a", data);
+    free (data);
+    data = gui_buffer_undo_get_data (buffer, buffer->input_undo->next_undo);
+    STRCMP_EQUAL("abc", data);
+    free (data);
+
+    /* free last undo ("xabc") */
+    gui_buffer_undo_free (buffer, buffer->last_input_undo);
+    LONGS_EQUAL(2, buffer->input_undo_count);
+    STRCMP_EQUAL("abc", buffer->last_input_undo->data);
+    POINTERS_EQUAL(NULL, buffer->last_input_undo->diff_text);
+    POINTERS_EQUAL(buffer->last_input_undo, buffer->ptr_input_undo);
+    data = gui_buffer_undo_get_data (buffer, buffer->input_undo);
+    STRCMP_EQUAL("a", data);
+    free (data);
+
+    /* free first undo ("a") */
+    gui_buffer_undo_free (buffer, buffer->input_undo);
+    LONGS_EQUAL(1, buffer->input_undo_count);
+    POINTERS_EQUAL(buffer->input_undo, buffer->last_input_undo);
+    STRCMP_EQUAL("abc", buffer->input_undo->data);
+
+    gui_buffer_close (buffer);
 }
 
 /*
@@ -23,6 +23,8 @@
 
 extern "C"
 {
+#include <stdio.h>
+#include <string.h>
 #include "src/core/wee-config.h"
 #include "src/core/wee-string.h"
 #include "src/gui/gui-color.h"
@@ -547,6 +549,82 @@ TEST(GuiColor, Decode)
     WEE_CHECK_DECODE("test_?option_weechat.color.chat_host", string, "?");
 }
 
+/*
+ * Tests functions:
+ *   gui_color_decode_into
+ */
+
+TEST(GuiColor, DecodeInto)
+{
+    char string[256], output[256];
+
+    snprintf (string, sizeof (string),
+              "%stest%s_é_%send",
+              gui_color_get_custom ("blue"),
+              gui_color_get_custom ("bold"),
+              gui_color_get_custom ("reset"));
+
+    /* invalid arguments */
+    LONGS_EQUAL(0, gui_color_decode_into (string, NULL, NULL, 0));
+    LONGS_EQUAL(0, gui_color_decode_into (string, NULL, output, 0));
+    strcpy (output, "x");
+    LONGS_EQUAL(0, gui_color_decode_into (NULL, NULL, output, sizeof (output)));
+    STRCMP_EQUAL("", output);
+
+    LONGS_EQUAL(11, gui_color_decode_into (string, NULL,
+                                           output, sizeof (output)));
+    STRCMP_EQUAL("test_é_end", output);
+    LONGS_EQUAL(14, gui_color_decode_into (string, "?",
+                                           output, sizeof (output)));
+    STRCMP_EQUAL("?test?_é_?end", output);
+
+    /* output too small: string is truncated, UTF-8 char is not cut */
+    LONGS_EQUAL(4, gui_color_decode_into (string, NULL, output, 5));
+    STRCMP_EQUAL("test", output);
+    LONGS_EQUAL(5, gui_color_decode_into (string, NULL, output, 7));
+    STRCMP_EQUAL("test_", output);
+    LONGS_EQUAL(7, gui_color_decode_into (string, NULL, output, 8));
+    STRCMP_EQUAL("test_é", output);
+    LONGS_EQUAL(0, gui_color_decode_into (string, NULL, output, 1));
+    STRCMP_EQUAL("", output);
+}
+
+/*
+ * Tests functions (long string):
+ *   gui_color_decode
+ *   gui_color_decode_into
+ */
+
+TEST(GuiColor, DecodeLongString)
+{
+    char **string, *decoded, *output;
+    int i, length;
+
+    string = string_dyn_alloc (1024 * 1024);
+    CHECK(string);
+    for (i = 0; i < 8192; i++)
+    {
+        if (i % 8 == 0)
+            string_dyn_concat (string, gui_color_get_custom ("blue"), -1);
+        string_dyn_concat (string, "lorem ipsum dolor sit amet, ", -1);
+        if (i % 16 == 0)
+            string_dyn_concat (string, gui_color_get_custom ("reset"), -1);
+    }
+    length = strlen (*string);
+    output = (char *)malloc (length + 1);
+    CHECK(output);
+
+    decoded = gui_color_decode (*string, NULL);
+    LONGS_EQUAL(8192 * 28, strlen (decoded));
+    LONGS_EQUAL(8192 * 28,
+                gui_color_decode_into (*string, NULL, output, length + 1));
+    STRCMP_EQUAL(decoded, output);
+    free (decoded);
+
+    free (output);
+    string_dyn_free (string, 1);
+}
+
 /*
  * Tests functions:
  *   gui_color_decode_ansi
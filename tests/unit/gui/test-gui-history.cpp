@@ -0,0 +1,243 @@
+/*
+ * test-gui-history.cpp - test history functions
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "src/core/wee-config.h"
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-history.h"
+}
+
+#define TEST_BUFFER_NAME "test"
+
+TEST_GROUP(GuiHistory)
+{
+};
+
+/*
+ * Tests functions:
+ *   gui_history_text_mask
+ */
+
+TEST(GuiHistory, TextMask)
+{
+    LONGS_EQUAL(0, gui_history_text_mask (NULL));
+    LONGS_EQUAL(0, gui_history_text_mask (""));
+
+    CHECK(gui_history_text_mask ("a") != 0);
+
+    /* mask of a string contains mask of all its substrings */
+    CHECK((gui_history_text_mask ("hello world")
+           & gui_history_text_mask ("lo wo"))
+          == gui_history_text_mask ("lo wo"));
+    CHECK((gui_history_text_mask ("/msg nickserv")
+           & gui_history_text_mask ("msg"))
+          == gui_history_text_mask ("msg"));
+}
+
+/*
+ * Tests functions:
+ *   gui_history_buffer_add
+ *   gui_history_set_text
+ *   gui_history_search
+ *   gui_history_buffer_free
+ */
+
+TEST(GuiHistory, BufferAdd)
+{
+    struct t_gui_buffer *buffer;
+    char str_command[64];
+    int i;
+
+    buffer = gui_buffer_new (NULL, TEST_BUFFER_NAME,
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    gui_history_buffer_add (NULL, "test");
+    gui_history_buffer_add (buffer, NULL);
+    POINTERS_EQUAL(NULL, buffer->history);
+
+    gui_history_buffer_add (buffer, "test");
+    gui_history_buffer_add (buffer, "test");
+    gui_history_buffer_add (buffer, "/help");
+    LONGS_EQUAL(2, buffer->num_history);
+    LONGS_EQUAL(9, buffer->history_size);
+    STRCMP_EQUAL("/help", buffer->history->text);
+    STRCMP_EQUAL("test", buffer->last_history->text);
+
+    /* text is shared with global history */
+    gui_history_global_add ("/help");
+    POINTERS_EQUAL(gui_history->text, buffer->history->text);
+
+    /* search */
+    POINTERS_EQUAL(NULL, gui_history_search (buffer->last_history, NULL));
+    POINTERS_EQUAL(NULL, gui_history_search (buffer->last_history, "xyz"));
+    POINTERS_EQUAL(buffer->last_history,
+                   gui_history_search (buffer->last_history, "es"));
+    POINTERS_EQUAL(buffer->history,
+                   gui_history_search (buffer->last_history, "/h"));
+    POINTERS_EQUAL(NULL,
+                   gui_history_search (buffer->last_history, "HELP"));
+
+    /* update text */
+    gui_history_set_text (buffer, buffer->last_history, "test2");
+    STRCMP_EQUAL("test2", buffer->last_history->text);
+    LONGS_EQUAL(10, buffer->history_size);
+    POINTERS_EQUAL(buffer->last_history,
+                   gui_history_search (buffer->last_history, "st2"));
+
+    /* max number of commands */
+    for (i = 0; i < 200; i++)
+    {
+        snprintf (str_command, sizeof (str_command), "/command %d", i);
+        gui_history_buffer_add (buffer, str_command);
+    }
+    LONGS_EQUAL(CONFIG_INTEGER(config_history_max_commands),
+                buffer->num_history);
+    STRCMP_EQUAL("/command 199", buffer->history->text);
+
+    /* max size of commands */
+    config_file_option_set (config_history_max_commands_size, "30", 1);
+    gui_history_buffer_add (buffer, "/last");
+    LONGS_EQUAL(3, buffer->num_history);
+    LONGS_EQUAL(29, buffer->history_size);
+    STRCMP_EQUAL("/last", buffer->history->text);
+    STRCMP_EQUAL("/command 198", buffer->last_history->text);
+
+    /* the most recent command is always kept */
+    gui_history_buffer_add (buffer,
+                            "/a very long command, longer than 30 bytes");
+    LONGS_EQUAL(1, buffer->num_history);
+    config_file_option_reset (config_history_max_commands_size, 1);
+
+    gui_history_buffer_free (buffer);
+    POINTERS_EQUAL(NULL, buffer->history);
+    POINTERS_EQUAL(NULL, buffer->last_history);
+    LONGS_EQUAL(0, buffer->num_history);
+    LONGS_EQUAL(0, buffer->history_size);
+
+    gui_history_global_free ();
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Tests functions:
+ *   gui_history_global_file_escape
+ *   gui_history_global_file_read
+ */
+
+TEST(GuiHistory, GlobalFile)
+{
+    const char *entries[] = { "/print test", "a\\b", "line 1\nline 2",
+                              "\\n", "end\\", "", NULL };
+    char *str, filename[] = "./tmp_weechat_test/history_test.txt";
+    FILE *file;
+    int i;
+
+    str = gui_history_global_file_escape ("test");
+    STRCMP_EQUAL("test\n", str);
+    free (str);
+    str = gui_history_global_file_escape ("a\\b\nc");
+    STRCMP_EQUAL("a\\\\b\\nc\n", str);
+    free (str);
+
+    file = fopen (filename, "w");
+    CHECK(file);
+    for (i = 0; entries[i]; i++)
+    {
+        str = gui_history_global_file_escape (entries[i]);
+        fputs (str, file);
+        free (str);
+    }
+    fclose (file);
+
+    file = fopen (filename, "r");
+    CHECK(file);
+    for (i = 0; entries[i]; i++)
+    {
+        str = gui_history_global_file_read (file);
+        STRCMP_EQUAL(entries[i], str);
+        free (str);
+    }
+    POINTERS_EQUAL(NULL, gui_history_global_file_read (file));
+    fclose (file);
+
+    unlink (filename);
+}
+
+/*
+ * Tests functions:
+ *   gui_history_global_load
+ */
+
+TEST(GuiHistory, GlobalLoad)
+{
+    char filename1[] = "./tmp_weechat_test/history_test1.txt";
+    char filename2[] = "./tmp_weechat_test/history_test2.txt";
+    FILE *file;
+
+    file = fopen (filename1, "w");
+    CHECK(file);
+    fputs ("/test1\n", file);
+    fclose (file);
+
+    file = fopen (filename2, "w");
+    CHECK(file);
+    fputs ("/test2\n", file);
+    fclose (file);
+
+    gui_history_global_free ();
+    gui_history_global_loaded = 0;
+
+    /* option set before first use: file is not loaded immediately */
+    config_file_option_set (config_history_global_file, filename1, 1);
+    POINTERS_EQUAL(NULL, gui_history);
+
+    /* first use: file is loaded */
+    gui_history_global_load ();
+    LONGS_EQUAL(1, gui_history_global_loaded);
+    CHECK(gui_history);
+    STRCMP_EQUAL("/test1", gui_history->text);
+    LONGS_EQUAL(1, num_gui_history);
+
+    /* file loaded only once */
+    gui_history_global_load ();
+    LONGS_EQUAL(1, num_gui_history);
+
+    /* option changed after first use: new file is loaded */
+    config_file_option_set (config_history_global_file, filename2, 1);
+    LONGS_EQUAL(1, gui_history_global_loaded);
+    LONGS_EQUAL(2, num_gui_history);
+    STRCMP_EQUAL("/test1", gui_history->text);
+    STRCMP_EQUAL("/test2", last_gui_history->text);
+
+    config_file_option_reset (config_history_global_file, 1);
+    LONGS_EQUAL(2, num_gui_history);
+
+    gui_history_global_free ();
+    unlink (filename1);
+    unlink (filename2);
+}
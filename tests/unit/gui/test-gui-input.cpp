@@ -24,9 +24,17 @@
 extern "C"
 {
 #include <string.h>
+#include "src/core/wee-config.h"
+#include "src/core/wee-config-file.h"
+#include "src/core/wee-utf8.h"
 #include "src/gui/gui-buffer.h"
 #include "src/gui/gui-input.h"
 
+extern int gui_input_optimize_size (struct t_gui_buffer *buffer,
+                                    int new_size, int new_length);
+extern char *gui_input_pos_to_ptr (struct t_gui_buffer *buffer, int pos);
+extern int gui_input_ptr_to_pos (struct t_gui_buffer *buffer,
+                                 const char *ptr);
 extern void gui_input_delete_range (struct t_gui_buffer *buffer,
                                     char *start, char *end);
 }
@@ -42,7 +50,89 @@ TEST_GROUP(GuiInput)
 
 TEST(GuiInput, OptimizeSize)
 {
-    /* TODO: write tests */
+    int old_alloc;
+
+    gui_input_replace_input (gui_buffers, "");
+    LONGS_EQUAL(GUI_BUFFER_INPUT_BLOCK_SIZE, gui_buffers->input_buffer_alloc);
+
+    /* size is at least doubled when input grows */
+    LONGS_EQUAL(1, gui_input_optimize_size (gui_buffers, 300, 300));
+    LONGS_EQUAL(2 * GUI_BUFFER_INPUT_BLOCK_SIZE,
+                gui_buffers->input_buffer_alloc);
+    LONGS_EQUAL(300, gui_buffers->input_buffer_size);
+    LONGS_EQUAL(300, gui_buffers->input_buffer_length);
+    LONGS_EQUAL(1, gui_input_optimize_size (gui_buffers, 5000, 5000));
+    LONGS_EQUAL(5120, gui_buffers->input_buffer_alloc);
+
+    /* size is kept if input is not much smaller */
+    old_alloc = gui_buffers->input_buffer_alloc;
+    LONGS_EQUAL(1, gui_input_optimize_size (gui_buffers, 2000, 2000));
+    LONGS_EQUAL(old_alloc, gui_buffers->input_buffer_alloc);
+
+    /* size is reduced if input uses less than a quarter */
+    LONGS_EQUAL(1, gui_input_optimize_size (gui_buffers, 10, 10));
+    LONGS_EQUAL(GUI_BUFFER_INPUT_BLOCK_SIZE, gui_buffers->input_buffer_alloc);
+
+    gui_input_replace_input (gui_buffers, "");
+}
+
+/*
+ * Tests functions:
+ *   gui_input_pos_to_ptr
+ *   gui_input_ptr_to_pos
+ */
+
+TEST(GuiInput, PosToPtr)
+{
+    const char *input = "noël, été, hâte";
+    char other_buffer[16];
+    int i, pos;
+
+    gui_input_replace_input (gui_buffers, input);
+    LONGS_EQUAL(0, gui_buffers->input_buffer_cache_pos);
+    LONGS_EQUAL(0, gui_buffers->input_buffer_cache_offset);
+
+    POINTERS_EQUAL(gui_buffers->input_buffer,
+                   gui_input_pos_to_ptr (gui_buffers, -1));
+    POINTERS_EQUAL(gui_buffers->input_buffer + gui_buffers->input_buffer_size,
+                   gui_input_pos_to_ptr (gui_buffers, 100));
+    LONGS_EQUAL(0, gui_input_ptr_to_pos (gui_buffers,
+                                         gui_buffers->input_buffer));
+    LONGS_EQUAL(gui_buffers->input_buffer_length,
+                gui_input_ptr_to_pos (gui_buffers,
+                                      gui_buffers->input_buffer
+                                      + gui_buffers->input_buffer_size));
+
+    /* pointer out of input buffer: start or end of input is returned */
+    pos = gui_input_ptr_to_pos (gui_buffers, other_buffer);
+    CHECK((pos == 0) || (pos == gui_buffers->input_buffer_length));
+
+    /* forward, then backward (cached position is used) */
+    for (i = 0; i <= gui_buffers->input_buffer_length; i++)
+    {
+        POINTERS_EQUAL(utf8_add_offset (input, i) - input
+                       + gui_buffers->input_buffer,
+                       gui_input_pos_to_ptr (gui_buffers, i));
+        LONGS_EQUAL(i, gui_input_ptr_to_pos (gui_buffers,
+                                             gui_input_pos_to_ptr (gui_buffers, i)));
+    }
+    for (i = gui_buffers->input_buffer_length; i >= 0; i--)
+    {
+        POINTERS_EQUAL(utf8_add_offset (input, i) - input
+                       + gui_buffers->input_buffer,
+                       gui_input_pos_to_ptr (gui_buffers, i));
+    }
+
+    /* cached position is kept when inserting at cursor */
+    gui_input_set_pos (gui_buffers, 3);
+    gui_input_insert_string (gui_buffers, "ï");
+    STRCMP_EQUAL("noëïl, été, hâte", gui_buffers->input_buffer);
+    LONGS_EQUAL(4, gui_buffers->input_buffer_cache_pos);
+    LONGS_EQUAL(6, gui_buffers->input_buffer_cache_offset);
+    LONGS_EQUAL(4, gui_input_ptr_to_pos (gui_buffers,
+                                         gui_buffers->input_buffer + 6));
+
+    gui_input_replace_input (gui_buffers, "");
 }
 
 /*
@@ -162,7 +252,37 @@ TEST(GuiInput, InsertString)
 
 TEST(GuiInput, MoveToBuffer)
 {
-    /* TODO: write tests */
+    struct t_gui_buffer *buffer;
+
+    buffer = gui_buffer_new (NULL, "test", NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    config_file_option_set (config_look_input_share, "all", 1);
+    config_file_option_set (config_look_input_share_overwrite, "on", 1);
+
+    /* cached position in target buffer, in a different input */
+    gui_input_replace_input (buffer, "ééééé");
+    gui_input_pos_to_ptr (buffer, 2);
+    LONGS_EQUAL(2, buffer->input_buffer_cache_pos);
+    LONGS_EQUAL(4, buffer->input_buffer_cache_offset);
+
+    gui_input_replace_input (gui_buffers, "abcdef");
+    gui_input_pos_to_ptr (gui_buffers, 1);
+    gui_input_move_to_buffer (gui_buffers, buffer);
+    STRCMP_EQUAL("", gui_buffers->input_buffer);
+    LONGS_EQUAL(0, gui_buffers->input_buffer_cache_pos);
+    LONGS_EQUAL(0, gui_buffers->input_buffer_cache_offset);
+    STRCMP_EQUAL("abcdef", buffer->input_buffer);
+    LONGS_EQUAL(6, buffer->input_buffer_size);
+    LONGS_EQUAL(6, buffer->input_buffer_length);
+    LONGS_EQUAL(1, buffer->input_buffer_cache_pos);
+    LONGS_EQUAL(1, buffer->input_buffer_cache_offset);
+    POINTERS_EQUAL(buffer->input_buffer + 3, gui_input_pos_to_ptr (buffer, 3));
+
+    config_file_option_reset (config_look_input_share, 1);
+    config_file_option_reset (config_look_input_share_overwrite, 1);
+
+    gui_buffer_close (buffer);
 }
 
 /*
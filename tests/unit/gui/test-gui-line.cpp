@@ -42,7 +42,7 @@ extern "C"
     STRCMP_EQUAL(__result, str);                                        \
     free (str);                                                         \
     gui_line_free_data (line);                                          \
-    free (line);
+    gui_line_release (line);
 
 #define WEE_BUILD_STR_MSG_TAGS(__tags, __message, __colors)             \
     line = gui_line_new (gui_buffers, -1, 0, 0, __tags,                 \
@@ -54,7 +54,7 @@ extern "C"
     STRCMP_EQUAL(str_result, str);                                      \
     free (str);                                                         \
     gui_line_free_data (line);                                          \
-    free (line);
+    gui_line_release (line);
 
 #define WEE_LINE_MATCH_TAGS(__result, __line_tags, __tags)              \
     gui_line_tags_alloc (&line_data, __line_tags);                      \
@@ -230,7 +230,7 @@ TEST(GuiLine, BuildStringMessageTags)
                                                        NULL,
                                                        1));
     gui_line_free_data (line);
-    free (line);
+    gui_line_release (line);
 
     snprintf (str_result, sizeof (str_result),
               "message%s [%s%s]",
@@ -279,6 +279,69 @@ TEST(GuiLine, BuildStringMessageTags)
     WEE_BUILD_STR_MSG_TAGS("tag1,tag2,tag3", str_message, 0);
 }
 
+/*
+ * Tests functions:
+ *   gui_line_get_prefix_no_color
+ *   gui_line_get_message_no_color
+ *   gui_line_free_no_color
+ *   gui_line_uncache_no_color
+ */
+
+TEST(GuiLine, NoColor)
+{
+    struct t_gui_line *line;
+    const char *ptr_prefix, *ptr_message;
+    char str_prefix[256], str_message[256];
+
+    POINTERS_EQUAL(NULL, gui_line_get_prefix_no_color (NULL));
+    POINTERS_EQUAL(NULL, gui_line_get_message_no_color (NULL));
+    gui_line_free_no_color (NULL);
+    gui_line_uncache_no_color (NULL);
+
+    snprintf (str_prefix, sizeof (str_prefix),
+              "%sblue prefix",
+              gui_color_get_custom ("blue"));
+    snprintf (str_message, sizeof (str_message),
+              "%sred message",
+              gui_color_get_custom ("red"));
+    line = gui_line_new (gui_buffers, -1, 0, 0, "tag1", str_prefix,
+                         str_message);
+    CHECK(line);
+    gui_line_free_no_color (line->data);
+    POINTERS_EQUAL(NULL, line->data->prefix_no_color);
+    POINTERS_EQUAL(NULL, line->data->message_no_color);
+
+    /* strings are computed once and kept in line */
+    ptr_prefix = gui_line_get_prefix_no_color (line->data);
+    ptr_message = gui_line_get_message_no_color (line->data);
+    STRCMP_EQUAL("blue prefix", ptr_prefix);
+    STRCMP_EQUAL("red message", ptr_message);
+    POINTERS_EQUAL(ptr_prefix, gui_line_get_prefix_no_color (line->data));
+    POINTERS_EQUAL(ptr_message, gui_line_get_message_no_color (line->data));
+
+    /* cache is kept only if option is enabled */
+    config_file_option_set (config_look_line_cache_no_color, "on", 1);
+    gui_line_uncache_no_color (line->data);
+    POINTERS_EQUAL(ptr_prefix, line->data->prefix_no_color);
+    POINTERS_EQUAL(ptr_message, line->data->message_no_color);
+    config_file_option_reset (config_look_line_cache_no_color, 1);
+    POINTERS_EQUAL(ptr_message, line->data->message_no_color);
+    gui_line_uncache_no_color (line->data);
+    POINTERS_EQUAL(NULL, line->data->prefix_no_color);
+    POINTERS_EQUAL(NULL, line->data->message_no_color);
+
+    gui_line_free_data (line);
+    gui_line_release (line);
+
+    /* line without prefix */
+    line = gui_line_new (gui_buffers, -1, 0, 0, NULL, NULL, "message");
+    CHECK(line);
+    POINTERS_EQUAL(NULL, gui_line_get_prefix_no_color (line->data));
+    STRCMP_EQUAL("message", gui_line_get_message_no_color (line->data));
+    gui_line_free_data (line);
+    gui_line_release (line);
+}
+
 /*
  * Tests functions:
  *   gui_line_is_displayed
@@ -355,6 +418,48 @@ TEST(GuiLine, GetNextDisplayed)
     /* TODO: write tests */
 }
 
+/*
+ * Tests functions:
+ *   gui_line_search_by_y
+ */
+
+TEST(GuiLine, SearchByY)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_line *ptr_line;
+    int y;
+
+    POINTERS_EQUAL(NULL, gui_line_search_by_y (NULL, 0));
+
+    buffer = gui_buffer_new_user ("test", GUI_BUFFER_TYPE_FREE);
+    CHECK(buffer);
+
+    POINTERS_EQUAL(NULL, gui_line_search_by_y (buffer->own_lines, 0));
+
+    /* lines 0 to 19 (empty lines are added before line 20) */
+    gui_chat_printf_y_date_tags (buffer, 20, 0, NULL, "line 20");
+    LONGS_EQUAL(21, buffer->own_lines->lines_count);
+    for (y = 0; y < 21; y++)
+    {
+        ptr_line = gui_line_search_by_y (buffer->own_lines, y);
+        CHECK(ptr_line);
+        LONGS_EQUAL(y, ptr_line->data->y);
+    }
+    POINTERS_EQUAL(NULL, gui_line_search_by_y (buffer->own_lines, 21));
+    POINTERS_EQUAL(buffer->own_lines->first_line,
+                   gui_line_search_by_y (buffer->own_lines, -1));
+
+    /* update a line in the middle and delete the last line */
+    gui_chat_printf_y_date_tags (buffer, 15, 0, NULL, "line 15");
+    STRCMP_EQUAL("line 15",
+                 gui_line_search_by_y (buffer->own_lines, 15)->data->message);
+    gui_chat_printf_y_date_tags (buffer, 20, 0, NULL, "");
+    LONGS_EQUAL(20, buffer->own_lines->lines_count);
+    POINTERS_EQUAL(NULL, gui_line_search_by_y (buffer->own_lines, 20));
+
+    gui_buffer_close (buffer);
+}
+
 /*
  * Tests functions:
  *   gui_line_search_text
@@ -0,0 +1,149 @@
+/*
+ * test-exec.cpp - test exec functions
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+#include "tests/tests.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include <string.h>
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-line.h"
+#include "src/plugins/exec/exec.h"
+
+extern void exec_display_lines (struct t_exec_cmd *exec_cmd,
+                                struct t_gui_buffer *buffer,
+                                int out, const char *lines, int length);
+extern void exec_concat_output (struct t_exec_cmd *exec_cmd,
+                                struct t_gui_buffer *buffer,
+                                int out, const char *text);
+}
+
+#define WEE_CHECK_EXEC_LINE(__line, __prefix, __message, __tag)        \
+    STRCMP_EQUAL(__prefix, __line->data->prefix);                       \
+    STRCMP_EQUAL(__message, __line->data->message);                     \
+    LONGS_EQUAL(2, __line->data->tags_count);                           \
+    STRCMP_EQUAL(__tag, __line->data->tags_array[0]);                   \
+    STRCMP_EQUAL("exec_cmd_test", __line->data->tags_array[1]);
+
+TEST_GROUP(Exec)
+{
+};
+
+/*
+ * Tests functions:
+ *   exec_display_lines
+ */
+
+TEST(Exec, DisplayLines)
+{
+    struct t_exec_cmd *exec_cmd;
+    struct t_gui_line *ptr_line;
+    int lines_count;
+
+    exec_cmd = exec_add ();
+    CHECK(exec_cmd);
+    exec_cmd->name = strdup ("test");
+    exec_cmd->color = EXEC_COLOR_STRIP;
+
+    /* invalid arguments */
+    lines_count = gui_buffers->own_lines->lines_count;
+    exec_display_lines (NULL, gui_buffers, EXEC_STDOUT, "test", 4);
+    exec_display_lines (exec_cmd, gui_buffers, EXEC_STDOUT, NULL, 4);
+    exec_display_lines (exec_cmd, gui_buffers, EXEC_STDOUT, "test", -1);
+    LONGS_EQUAL(lines_count, gui_buffers->own_lines->lines_count);
+
+    /* block of lines displayed with a single printf, "length" bytes used */
+    exec_display_lines (exec_cmd, gui_buffers, EXEC_STDOUT,
+                        "line1\nline2\nline3", 11);
+    LONGS_EQUAL(lines_count + 2, gui_buffers->own_lines->lines_count);
+    LONGS_EQUAL(2, exec_cmd->output_line_nb);
+    ptr_line = gui_buffers->own_lines->last_line;
+    WEE_CHECK_EXEC_LINE(ptr_line, "", "line2", "exec_stdout");
+    ptr_line = ptr_line->prev_line;
+    WEE_CHECK_EXEC_LINE(ptr_line, "", "line1", "exec_stdout");
+
+    /* stderr, with line numbers */
+    exec_cmd->line_numbers = 1;
+    exec_display_lines (exec_cmd, gui_buffers, EXEC_STDERR, "err1\nerr2", 9);
+    LONGS_EQUAL(lines_count + 4, gui_buffers->own_lines->lines_count);
+    LONGS_EQUAL(4, exec_cmd->output_line_nb);
+    ptr_line = gui_buffers->own_lines->last_line;
+    WEE_CHECK_EXEC_LINE(ptr_line, "4", "err2", "exec_stderr");
+    ptr_line = ptr_line->prev_line;
+    WEE_CHECK_EXEC_LINE(ptr_line, "3", "err1", "exec_stderr");
+
+    exec_free (exec_cmd);
+}
+
+/*
+ * Tests functions:
+ *   exec_concat_output
+ */
+
+TEST(Exec, ConcatOutput)
+{
+    struct t_exec_cmd *exec_cmd;
+    struct t_gui_line *ptr_line;
+    int lines_count;
+
+    exec_cmd = exec_add ();
+    CHECK(exec_cmd);
+    exec_cmd->name = strdup ("test");
+    exec_cmd->color = EXEC_COLOR_STRIP;
+
+    lines_count = gui_buffers->own_lines->lines_count;
+
+    /* complete lines are displayed, incomplete line is kept */
+    exec_concat_output (exec_cmd, gui_buffers, EXEC_STDOUT,
+                        "line1\nline2\npart");
+    LONGS_EQUAL(lines_count + 2, gui_buffers->own_lines->lines_count);
+    ptr_line = gui_buffers->own_lines->last_line;
+    WEE_CHECK_EXEC_LINE(ptr_line, "", "line2", "exec_stdout");
+    ptr_line = ptr_line->prev_line;
+    WEE_CHECK_EXEC_LINE(ptr_line, "", "line1", "exec_stdout");
+    LONGS_EQUAL(4, exec_cmd->output_size[EXEC_STDOUT]);
+    STRCMP_EQUAL("part", exec_cmd->output[EXEC_STDOUT]);
+
+    /* no new line: text is added to the incomplete line */
+    exec_concat_output (exec_cmd, gui_buffers, EXEC_STDOUT, "ia");
+    LONGS_EQUAL(lines_count + 2, gui_buffers->own_lines->lines_count);
+    LONGS_EQUAL(6, exec_cmd->output_size[EXEC_STDOUT]);
+    STRCMP_EQUAL("partia", exec_cmd->output[EXEC_STDOUT]);
+
+    /* incomplete line is completed */
+    exec_concat_output (exec_cmd, gui_buffers, EXEC_STDOUT,
+                        "l\nline3\nline4\n");
+    LONGS_EQUAL(lines_count + 5, gui_buffers->own_lines->lines_count);
+    ptr_line = gui_buffers->own_lines->last_line;
+    WEE_CHECK_EXEC_LINE(ptr_line, "", "line4", "exec_stdout");
+    ptr_line = ptr_line->prev_line;
+    WEE_CHECK_EXEC_LINE(ptr_line, "", "line3", "exec_stdout");
+    ptr_line = ptr_line->prev_line;
+    WEE_CHECK_EXEC_LINE(ptr_line, "", "partial", "exec_stdout");
+    LONGS_EQUAL(0, exec_cmd->output_size[EXEC_STDOUT]);
+    POINTERS_EQUAL(NULL, exec_cmd->output[EXEC_STDOUT]);
+    LONGS_EQUAL(5, exec_cmd->output_line_nb);
+
+    exec_free (exec_cmd);
+}
@@ -0,0 +1,268 @@
+/*
+ * test-script-repo.cpp - test script repository functions
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+#include "tests/tests.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+#include "src/plugins/script/script.h"
+#include "src/plugins/script/script-repo.h"
+
+extern struct t_script_repo *script_repo_alloc ();
+extern void script_repo_add (struct t_script_repo *script);
+extern struct t_script_repo_read *script_repo_read_new (int quiet);
+extern void script_repo_read_free_scripts (struct t_script_repo_read *repo_read);
+extern void script_repo_read_free (struct t_script_repo_read *repo_read);
+extern int script_repo_read_add (struct t_script_repo_read *repo_read,
+                                 struct t_script_repo *script);
+extern int script_repo_set_name_with_extension (struct t_script_repo *script);
+extern int script_repo_cache_key (struct t_script_repo_read *repo_read,
+                                  char *key, int size);
+extern int script_repo_cache_write (struct t_script_repo_read *repo_read,
+                                    const char *key);
+extern int script_repo_cache_read (struct t_script_repo_read *repo_read,
+                                   const char *key);
+}
+
+#define TEST_SCRIPT_REPO_FILE "./tmp_weechat_test/test_plugins.xml.gz"
+#define TEST_SCRIPT_REPO_CACHE "./tmp_weechat_test/test_plugins.cache"
+
+TEST_GROUP(ScriptRepo)
+{
+    /*
+     * Creates a script with a name and an extension (the script is not
+     * added in list).
+     */
+
+    static struct t_script_repo *new_script (const char *name,
+                                             const char *extension)
+    {
+        struct t_script_repo *script;
+
+        script = script_repo_alloc ();
+        CHECK(script);
+        script->name = strdup (name);
+        script->language = script_language_search_by_extension (extension);
+        CHECK(script->language >= 0);
+        CHECK(script_repo_set_name_with_extension (script));
+
+        return script;
+    }
+
+    /*
+     * Writes the (fake) repository file, with a given content and
+     * modification time.
+     */
+
+    static void write_repo_file (const char *content, time_t mtime)
+    {
+        FILE *file;
+        struct utimbuf times;
+
+        file = fopen (TEST_SCRIPT_REPO_FILE, "w");
+        CHECK(file);
+        fputs (content, file);
+        fclose (file);
+        times.actime = mtime;
+        times.modtime = mtime;
+        LONGS_EQUAL(0, utime (TEST_SCRIPT_REPO_FILE, &times));
+    }
+};
+
+/*
+ * Tests functions:
+ *   script_repo_cache_key
+ *   script_repo_cache_write
+ *   script_repo_cache_read
+ */
+
+TEST(ScriptRepo, Cache)
+{
+    struct t_script_repo_read *repo_read;
+    struct t_script_repo *script;
+    char key[4096], key2[4096];
+
+    repo_read = script_repo_read_new (1);
+    CHECK(repo_read);
+    free (repo_read->filename);
+    repo_read->filename = strdup (TEST_SCRIPT_REPO_FILE);
+    free (repo_read->cache_filename);
+    repo_read->cache_filename = strdup (TEST_SCRIPT_REPO_CACHE);
+
+    /* repository file not found */
+    unlink (TEST_SCRIPT_REPO_FILE);
+    LONGS_EQUAL(0, script_repo_cache_key (repo_read, key, sizeof (key)));
+
+    write_repo_file ("abc", 1000000);
+    LONGS_EQUAL(1, script_repo_cache_key (repo_read, key, sizeof (key)));
+
+    /* cache not found */
+    unlink (TEST_SCRIPT_REPO_CACHE);
+    LONGS_EQUAL(0, script_repo_cache_read (repo_read, key));
+    LONGS_EQUAL(0, repo_read->num_scripts);
+
+    /* write scripts in cache, with chars escaped in fields */
+    script = new_script ("test", "py");
+    script->author = strdup ("Author");
+    script->version = strdup ("1.0");
+    script->license = strdup ("GPL3");
+    script->description = strdup ("desc\twith tab,\nnew line and \\ (\\t)");
+    script->tags = strdup ("tag1,tag2");
+    script->min_weechat = strdup ("3.0");
+    script->sha512sum = strdup ("abcdef");
+    script->url = strdup ("https://example.com/test.py");
+    script->popularity = 3;
+    script->date_added = 1000;
+    script->date_updated = 2000;
+    LONGS_EQUAL(1, script_repo_read_add (repo_read, script));
+    script = new_script ("other", "lua");
+    script->description = strdup ("other script");
+    LONGS_EQUAL(1, script_repo_read_add (repo_read, script));
+    LONGS_EQUAL(1, script_repo_cache_write (repo_read, key));
+    script_repo_read_free_scripts (repo_read);
+    LONGS_EQUAL(0, repo_read->num_scripts);
+
+    /* read scripts in cache */
+    LONGS_EQUAL(1, script_repo_cache_read (repo_read, key));
+    LONGS_EQUAL(2, repo_read->num_scripts);
+    script = repo_read->scripts[0];
+    STRCMP_EQUAL("test", script->name);
+    STRCMP_EQUAL("test.py", script->name_with_extension);
+    LONGS_EQUAL(script_language_search_by_extension ("py"), script->language);
+    STRCMP_EQUAL("Author", script->author);
+    POINTERS_EQUAL(NULL, script->mail);
+    STRCMP_EQUAL("1.0", script->version);
+    STRCMP_EQUAL("GPL3", script->license);
+    STRCMP_EQUAL("desc\twith tab,\nnew line and \\ (\\t)", script->description);
+    STRCMP_EQUAL("tag1,tag2", script->tags);
+    POINTERS_EQUAL(NULL, script->requirements);
+    STRCMP_EQUAL("3.0", script->min_weechat);
+    POINTERS_EQUAL(NULL, script->max_weechat);
+    STRCMP_EQUAL("abcdef", script->sha512sum);
+    STRCMP_EQUAL("https://example.com/test.py", script->url);
+    LONGS_EQUAL(3, script->popularity);
+    LONGS_EQUAL(1000, script->date_added);
+    LONGS_EQUAL(2000, script->date_updated);
+    script = repo_read->scripts[1];
+    STRCMP_EQUAL("other", script->name);
+    STRCMP_EQUAL("other.lua", script->name_with_extension);
+    STRCMP_EQUAL("other script", script->description);
+    POINTERS_EQUAL(NULL, script->author);
+    LONGS_EQUAL(0, script->popularity);
+    script_repo_read_free_scripts (repo_read);
+
+    /* cache outdated: modification time of repository file has changed */
+    write_repo_file ("abc", 2000000);
+    LONGS_EQUAL(1, script_repo_cache_key (repo_read, key2, sizeof (key2)));
+    CHECK(strcmp (key, key2) != 0);
+    LONGS_EQUAL(0, script_repo_cache_read (repo_read, key2));
+    LONGS_EQUAL(0, repo_read->num_scripts);
+
+    /* cache outdated: size of repository file has changed */
+    write_repo_file ("abcd", 1000000);
+    LONGS_EQUAL(1, script_repo_cache_key (repo_read, key2, sizeof (key2)));
+    CHECK(strcmp (key, key2) != 0);
+    LONGS_EQUAL(0, script_repo_cache_read (repo_read, key2));
+    LONGS_EQUAL(0, repo_read->num_scripts);
+
+    /* same repository file: cache is valid again */
+    write_repo_file ("abc", 1000000);
+    LONGS_EQUAL(1, script_repo_cache_key (repo_read, key2, sizeof (key2)));
+    STRCMP_EQUAL(key, key2);
+    LONGS_EQUAL(1, script_repo_cache_read (repo_read, key2));
+    LONGS_EQUAL(2, repo_read->num_scripts);
+
+    script_repo_read_free (repo_read);
+    unlink (TEST_SCRIPT_REPO_FILE);
+    unlink (TEST_SCRIPT_REPO_CACHE);
+}
+
+/*
+ * Tests functions:
+ *   script_repo_search_by_name
+ *   script_repo_search_by_name_ext
+ */
+
+TEST(ScriptRepo, SearchByName)
+{
+    struct t_script_repo *script_abc_py, *script_abc_pl, *script_abc_def;
+    struct t_script_repo *script_ab, *script_zzz, *script_new;
+
+    script_repo_remove_all ();
+
+    POINTERS_EQUAL(NULL, script_repo_search_by_name ("abc"));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name_ext ("abc.py"));
+
+    /* scripts are added in any order */
+    script_zzz = new_script ("zzz", "py");
+    script_repo_add (script_zzz);
+    script_abc_py = new_script ("abc", "py");
+    script_repo_add (script_abc_py);
+    script_abc_def = new_script ("abc_def", "py");
+    script_repo_add (script_abc_def);
+    script_ab = new_script ("ab", "lua");
+    script_repo_add (script_ab);
+    script_abc_pl = new_script ("abc", "pl");
+    script_repo_add (script_abc_pl);
+
+    /* search by name */
+    POINTERS_EQUAL(NULL, script_repo_search_by_name (NULL));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name (""));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name ("a"));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name ("abcd"));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name ("zzzz"));
+    POINTERS_EQUAL(script_ab, script_repo_search_by_name ("ab"));
+    POINTERS_EQUAL(script_abc_pl, script_repo_search_by_name ("abc"));
+    POINTERS_EQUAL(script_abc_def, script_repo_search_by_name ("abc_def"));
+    POINTERS_EQUAL(script_zzz, script_repo_search_by_name ("zzz"));
+
+    /* search by name with extension */
+    POINTERS_EQUAL(NULL, script_repo_search_by_name_ext (NULL));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name_ext (""));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name_ext ("abc"));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name_ext ("abc.lua"));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name_ext ("ab.py"));
+    POINTERS_EQUAL(NULL, script_repo_search_by_name_ext ("zzzz.py"));
+    POINTERS_EQUAL(script_ab, script_repo_search_by_name_ext ("ab.lua"));
+    POINTERS_EQUAL(script_abc_py, script_repo_search_by_name_ext ("abc.py"));
+    POINTERS_EQUAL(script_abc_pl, script_repo_search_by_name_ext ("abc.pl"));
+    POINTERS_EQUAL(script_abc_def,
+                   script_repo_search_by_name_ext ("abc_def.py"));
+    POINTERS_EQUAL(script_zzz, script_repo_search_by_name_ext ("zzz.py"));
+
+    /* array sorted by name is built again after add of a script */
+    script_new = new_script ("new", "rb");
+    script_repo_add (script_new);
+    POINTERS_EQUAL(script_new, script_repo_search_by_name ("new"));
+    POINTERS_EQUAL(script_new, script_repo_search_by_name_ext ("new.rb"));
+    POINTERS_EQUAL(script_ab, script_repo_search_by_name_ext ("ab.lua"));
+
+    script_repo_remove_all ();
+
+    POINTERS_EQUAL(NULL, script_repo_search_by_name ("abc"));
+}
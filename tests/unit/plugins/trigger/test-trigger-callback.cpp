@@ -0,0 +1,119 @@
+/*
+ * test-trigger-callback.cpp - test trigger callback functions
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+#include "tests/tests.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include "src/core/wee-hook.h"
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-chat.h"
+#include "src/gui/gui-line.h"
+#include "src/plugins/trigger/trigger.h"
+}
+
+TEST_GROUP(TriggerCallback)
+{
+};
+
+/*
+ * Tests functions:
+ *   trigger_callback_regex_replace
+ */
+
+TEST(TriggerCallback, RegexReplace)
+{
+    struct t_trigger *trigger_outer, *trigger_inner;
+    char *str;
+
+    trigger_inner = trigger_new ("test_inner", "on", "modifier",
+                                 "test_inner", "", "/b/c/", "", "", "");
+    CHECK(trigger_inner);
+    trigger_outer = trigger_new ("test_outer", "on", "modifier",
+                                 "test_outer", "",
+                                 "/a/${modifier:test_inner,,b}/",
+                                 "", "", "");
+    CHECK(trigger_outer);
+
+    WEE_TEST_STR("c", hook_modifier_exec (NULL, "test_inner", NULL, "b"));
+
+    /*
+     * the replacement text of outer trigger is used for each match, after
+     * the evaluation of inner trigger (which has its own replacement text)
+     */
+    WEE_TEST_STR("xcxcxcx",
+                 hook_modifier_exec (NULL, "test_outer", NULL, "xaxaxax"));
+
+    trigger_free (trigger_outer);
+    trigger_free (trigger_inner);
+}
+
+/*
+ * Tests functions:
+ *   trigger_callback_line_cb
+ */
+
+TEST(TriggerCallback, Line)
+{
+    struct t_trigger *trigger;
+    struct t_gui_buffer *test_buffer;
+    struct t_gui_line *ptr_line;
+
+    test_buffer = gui_buffer_new (NULL, "test",
+                                  NULL, NULL, NULL,
+                                  NULL, NULL, NULL);
+    CHECK(test_buffer);
+
+    trigger = trigger_new ("test_line", "on", "line",
+                           "formatted;core.test;tag2",
+                           "${tg_tag_nick} == alice",
+                           "/.*/${tags}|${tg_tag_nick}|${tg_tag_notify}/",
+                           "", "", "");
+    CHECK(trigger);
+
+    /* tag "tag2" not in line: trigger not executed */
+    gui_chat_printf_date_tags (test_buffer, 0, "tag1,nick_alice",
+                               "prefix\tmessage");
+    ptr_line = test_buffer->own_lines->last_line;
+    STRCMP_EQUAL("message", ptr_line->data->message);
+
+    /* tags matching, but condition is false */
+    gui_chat_printf_date_tags (test_buffer, 0, "tag1,tag2,nick_bob",
+                               "prefix\tmessage");
+    ptr_line = test_buffer->own_lines->last_line;
+    STRCMP_EQUAL("message", ptr_line->data->message);
+
+    /* tags matching and condition is true: tags are sent to trigger */
+    gui_chat_printf_date_tags (test_buffer, 0,
+                               "tag1,tag2,nick_alice,notify_message",
+                               "prefix\tmessage");
+    ptr_line = test_buffer->own_lines->last_line;
+    STRCMP_EQUAL(",tag1,tag2,nick_alice,notify_message,|alice|message",
+                 ptr_line->data->message);
+    LONGS_EQUAL(4, ptr_line->data->tags_count);
+
+    trigger_free (trigger);
+
+    gui_buffer_close (test_buffer);
+}
@@ -26,6 +26,7 @@
 extern "C"
 {
 #include <stdio.h>
+#include "src/core/wee-config-file.h"
 #include "src/core/wee-hook.h"
 #include "src/plugins/trigger/trigger.h"
 }
@@ -391,6 +392,43 @@ TEST(TriggerConfig, ChangeTriggerArguments)
     /* TODO: write tests */
 }
 
+/*
+ * Tests functions:
+ *   trigger_config_change_trigger_conditions
+ */
+
+TEST(TriggerConfig, ChangeTriggerConditions)
+{
+    struct t_trigger *trigger;
+    struct t_config_option *ptr_option;
+
+    trigger = trigger_new ("test", "on", "signal", "test_signal", "1 == 2",
+                           "", "", "", "");
+    CHECK(trigger);
+    LONGS_EQUAL(0, trigger->conditions_static);
+    ptr_option = trigger->options[TRIGGER_OPTION_CONDITIONS];
+
+    /* no conditions: always true */
+    config_file_option_set (ptr_option, "", 1);
+    LONGS_EQUAL(1, trigger->conditions_static);
+
+    /* static conditions: evaluated only once */
+    config_file_option_set (ptr_option, "abc == abc", 1);
+    LONGS_EQUAL(1, trigger->conditions_static);
+    config_file_option_set (ptr_option, "abc == def", 1);
+    LONGS_EQUAL(0, trigger->conditions_static);
+
+    /* conditions with variables: evaluated in each callback */
+    config_file_option_set (ptr_option, "${tg_signal_data} == abc", 1);
+    LONGS_EQUAL(-1, trigger->conditions_static);
+
+    /* static conditions again: compiled again */
+    config_file_option_set (ptr_option, "1", 1);
+    LONGS_EQUAL(1, trigger->conditions_static);
+
+    trigger_free (trigger);
+}
+
 /*
  * Tests functions:
  *   trigger_config_change_trigger_regex
@@ -28,6 +28,7 @@ extern "C"
 #include <stdio.h>
 #include "src/core/wee-config.h"
 #include "src/core/wee-config-file.h"
+#include "src/core/wee-hashtable.h"
 #include "src/plugins/plugin.h"
 #include "src/plugins/trigger/trigger.h"
 }
@@ -235,6 +236,8 @@ TEST(Trigger, RegexSplit)
     CHECK(regex[0].regex);
     STRCMP_EQUAL("b", regex[0].replace);
     STRCMP_EQUAL("b", regex[0].replace_escaped);
+    STRCMP_EQUAL("b", (const char *)hashtable_get (regex[0].options_eval,
+                                                   "regex_replace"));
 
     /* simple regex replace (command "s") */
     WEE_CHECK_REGEX_SPLIT(0, 1, "s/a/b");
@@ -251,6 +254,7 @@ TEST(Trigger, RegexSplit)
     POINTERS_EQUAL(NULL, regex[0].regex);
     STRCMP_EQUAL("${chars:A-H}", regex[0].replace);
     POINTERS_EQUAL(NULL, regex[0].replace_escaped);
+    POINTERS_EQUAL(NULL, regex[0].options_eval);
 
     /* simple regex replace with variable (implicit command "s") */
     WEE_CHECK_REGEX_SPLIT(0, 1, "/a/b/var");
@@ -441,6 +445,40 @@ TEST(Trigger, SplitCommand)
     STRCMP_EQUAL("/test2", commands[1]);
 }
 
+/*
+ * Tests functions:
+ *   trigger_compile_conditions
+ */
+
+TEST(Trigger, CompileConditions)
+{
+    struct t_trigger *trigger;
+
+    trigger_compile_conditions (NULL);
+
+    trigger = trigger_new ("test", "on", "signal", "test", "", "", "",
+                           "ok", "none");
+    CHECK(trigger);
+
+    /* no conditions: always true */
+    LONGS_EQUAL(1, trigger->conditions_static);
+
+    /* constant conditions: evaluated only once */
+    config_file_option_set (trigger->options[TRIGGER_OPTION_CONDITIONS],
+                            "1 == 1", 1);
+    LONGS_EQUAL(1, trigger->conditions_static);
+    config_file_option_set (trigger->options[TRIGGER_OPTION_CONDITIONS],
+                            "abc == def", 1);
+    LONGS_EQUAL(0, trigger->conditions_static);
+
+    /* conditions with variables: evaluated in callback */
+    config_file_option_set (trigger->options[TRIGGER_OPTION_CONDITIONS],
+                            "${tg_signal} == test", 1);
+    LONGS_EQUAL(-1, trigger->conditions_static);
+
+    trigger_free (trigger);
+}
+
 /*
  * Tests functions:
  *   trigger_name_valid
@@ -560,7 +598,10 @@ TEST(Trigger, New)
             }
             LONGS_EQUAL(0, trigger->hook_count_cb);
             LONGS_EQUAL(0, trigger->hook_count_cmd);
+            LONGS_EQUAL(0, trigger->hook_count_match);
+            LONGS_EQUAL(0, trigger->hook_time);
             LONGS_EQUAL(0, trigger->hook_running);
+            LONGS_EQUAL(1, trigger->conditions_static);
             if (enabled && (hook_type == TRIGGER_HOOK_PRINT))
             {
                 STRCMP_EQUAL("args", trigger->hook_print_buffers);
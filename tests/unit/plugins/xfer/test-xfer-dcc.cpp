@@ -0,0 +1,258 @@
+/*
+ * test-xfer-dcc.cpp - test DCC functions
+ *
+ * Copyright (C) 2022 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <gcrypt.h>
+#include "src/plugins/xfer/xfer.h"
+
+extern int xfer_dcc_send_file_block (struct t_xfer *xfer, size_t length);
+extern int xfer_dcc_send_file_read_ack (struct t_xfer *xfer);
+extern int xfer_dcc_resume_hash (struct t_xfer *xfer, int fd,
+                                 char *buffer, size_t size_buffer,
+                                 unsigned long long *pos_hashed,
+                                 unsigned long long pos_max);
+extern int xfer_dcc_recv_file_write (struct t_xfer *xfer, const char *buffer,
+                                     size_t length);
+}
+
+#define TEST_XFER_FILENAME "./tmp_weechat_test/xfer_dcc_test.bin"
+#define TEST_XFER_SIZE     ((4 * XFER_BLOCKSIZE_MAX) + 1234)
+
+TEST_GROUP(XferDcc)
+{
+};
+
+/*
+ * Tests functions:
+ *   xfer_dcc_send_file_block
+ *
+ * (file sent on a local socket, in many blocks)
+ */
+
+TEST(XferDcc, SendFileBlock)
+{
+    struct t_xfer xfer;
+    int fd[2], i, rc, num_read, flags;
+    char *data, *received;
+    unsigned long long total_received;
+    FILE *file;
+
+    data = (char *)malloc (TEST_XFER_SIZE);
+    CHECK(data);
+    received = (char *)malloc (TEST_XFER_SIZE);
+    CHECK(received);
+    for (i = 0; i < TEST_XFER_SIZE; i++)
+    {
+        data[i] = (char)((i * 7) & 0xFF);
+    }
+    file = fopen (TEST_XFER_FILENAME, "wb");
+    CHECK(file);
+    LONGS_EQUAL(TEST_XFER_SIZE, fwrite (data, 1, TEST_XFER_SIZE, file));
+    fclose (file);
+
+    LONGS_EQUAL(0, socketpair (AF_UNIX, SOCK_STREAM, 0, fd));
+    flags = fcntl (fd[0], F_GETFL);
+    fcntl (fd[0], F_SETFL, flags | O_NONBLOCK);
+    flags = fcntl (fd[1], F_GETFL);
+    fcntl (fd[1], F_SETFL, flags | O_NONBLOCK);
+
+    memset (&xfer, 0, sizeof (xfer));
+    xfer.sock = fd[0];
+    xfer.file = open (TEST_XFER_FILENAME, O_RDONLY);
+    CHECK(xfer.file >= 0);
+    xfer.size = TEST_XFER_SIZE;
+
+    total_received = 0;
+    while (total_received < TEST_XFER_SIZE)
+    {
+        if (xfer.pos < xfer.size)
+        {
+            rc = xfer_dcc_send_file_block (
+                &xfer,
+                (xfer.size - xfer.pos > XFER_BLOCKSIZE_MAX) ?
+                XFER_BLOCKSIZE_MAX : xfer.size - xfer.pos);
+            CHECK(rc >= 0);
+            xfer.pos += rc;
+        }
+        num_read = recv (fd[1], received + total_received,
+                         TEST_XFER_SIZE - total_received, 0);
+        if (num_read > 0)
+            total_received += num_read;
+    }
+
+    LONGS_EQUAL(TEST_XFER_SIZE, xfer.pos);
+    MEMCMP_EQUAL(data, received, TEST_XFER_SIZE);
+
+    /* end of file reached: error reading local file */
+    LONGS_EQUAL(-2, xfer_dcc_send_file_block (&xfer, 1024));
+
+    close (xfer.file);
+    close (fd[0]);
+    close (fd[1]);
+    unlink (TEST_XFER_FILENAME);
+    free (data);
+    free (received);
+}
+
+/*
+ * Tests functions:
+ *   xfer_dcc_send_file_read_ack
+ */
+
+TEST(XferDcc, SendFileReadAck)
+{
+    struct t_xfer xfer;
+    int fd[2], flags;
+    uint32_t acks[3];
+
+    LONGS_EQUAL(0, socketpair (AF_UNIX, SOCK_STREAM, 0, fd));
+    flags = fcntl (fd[0], F_GETFL);
+    fcntl (fd[0], F_SETFL, flags | O_NONBLOCK);
+
+    memset (&xfer, 0, sizeof (xfer));
+    xfer.sock = fd[0];
+
+    /* nothing to read */
+    LONGS_EQUAL(1, xfer_dcc_send_file_read_ack (&xfer));
+    LONGS_EQUAL(0, xfer.ack);
+
+    /* 3 ACKs sent: only the last one is kept */
+    acks[0] = htonl (1024);
+    acks[1] = htonl (2048);
+    acks[2] = htonl (3072);
+    LONGS_EQUAL(sizeof (acks), send (fd[1], acks, sizeof (acks), 0));
+    LONGS_EQUAL(1, xfer_dcc_send_file_read_ack (&xfer));
+    LONGS_EQUAL(3072, xfer.ack);
+
+    /* incomplete ACK: not read */
+    acks[0] = htonl (4096);
+    LONGS_EQUAL(2, send (fd[1], acks, 2, 0));
+    LONGS_EQUAL(1, xfer_dcc_send_file_read_ack (&xfer));
+    LONGS_EQUAL(3072, xfer.ack);
+    LONGS_EQUAL(2, send (fd[1], ((char *)acks) + 2, 2, 0));
+    LONGS_EQUAL(1, xfer_dcc_send_file_read_ack (&xfer));
+    LONGS_EQUAL(4096, xfer.ack);
+
+    /* socket closed by receiver */
+    close (fd[1]);
+    LONGS_EQUAL(0, xfer_dcc_send_file_read_ack (&xfer));
+
+    close (fd[0]);
+}
+
+/*
+ * Tests functions:
+ *   xfer_dcc_recv_file_write
+ *   xfer_dcc_resume_hash
+ *
+ * (hash of a file computed by blocks read on disk must be the same as the
+ * hash computed on the whole content in memory)
+ */
+
+TEST(XferDcc, ResumeHash)
+{
+    struct t_xfer xfer;
+    gcry_md_hd_t hd_file, hd_memory;
+    char data[10000], buffer[1024], hash_file[9], hash_memory[9];
+    unsigned char *bin_hash;
+    unsigned long long pos_hashed;
+    int i, fd;
+
+    for (i = 0; i < (int)sizeof (data); i++)
+    {
+        data[i] = (char)((i * 13) & 0xFF);
+    }
+
+    memset (&xfer, 0, sizeof (xfer));
+    xfer.file = open (TEST_XFER_FILENAME, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    CHECK(xfer.file >= 0);
+    LONGS_EQUAL(1, xfer_dcc_recv_file_write (&xfer, data, sizeof (data)));
+    close (xfer.file);
+
+    fd = open (TEST_XFER_FILENAME, O_RDONLY);
+    CHECK(fd >= 0);
+
+    /* no hash handle */
+    pos_hashed = 0;
+    LONGS_EQUAL(0, xfer_dcc_resume_hash (&xfer, fd, buffer, sizeof (buffer),
+                                         &pos_hashed, sizeof (data)));
+
+    LONGS_EQUAL(0, gcry_md_open (&hd_file, GCRY_MD_CRC32, 0));
+    LONGS_EQUAL(0, gcry_md_open (&hd_memory, GCRY_MD_CRC32, 0));
+    xfer.hash_handle = &hd_file;
+
+    /* invalid file descriptor */
+    LONGS_EQUAL(0, xfer_dcc_resume_hash (&xfer, -1, buffer, sizeof (buffer),
+                                         &pos_hashed, sizeof (data)));
+
+    /* hash first 2500 bytes (3 blocks) */
+    LONGS_EQUAL(1, xfer_dcc_resume_hash (&xfer, fd, buffer, sizeof (buffer),
+                                         &pos_hashed, 2500));
+    LONGS_EQUAL(1024, pos_hashed);
+    LONGS_EQUAL(1, xfer_dcc_resume_hash (&xfer, fd, buffer, sizeof (buffer),
+                                         &pos_hashed, 2500));
+    LONGS_EQUAL(1, xfer_dcc_resume_hash (&xfer, fd, buffer, sizeof (buffer),
+                                         &pos_hashed, 2500));
+    LONGS_EQUAL(2500, pos_hashed);
+    LONGS_EQUAL(1, xfer_dcc_resume_hash (&xfer, fd, buffer, sizeof (buffer),
+                                         &pos_hashed, 2500));
+    LONGS_EQUAL(2500, pos_hashed);
+
+    /* hash end of file */
+    while (pos_hashed < sizeof (data))
+    {
+        LONGS_EQUAL(1, xfer_dcc_resume_hash (&xfer, fd, buffer,
+                                             sizeof (buffer), &pos_hashed,
+                                             sizeof (data)));
+    }
+    LONGS_EQUAL(sizeof (data), pos_hashed);
+
+    /* beyond end of file: error */
+    LONGS_EQUAL(0, xfer_dcc_resume_hash (&xfer, fd, buffer, sizeof (buffer),
+                                         &pos_hashed, sizeof (data) + 10));
+
+    gcry_md_final (hd_file);
+    bin_hash = gcry_md_read (hd_file, 0);
+    snprintf (hash_file, sizeof (hash_file), "%.2X%.2X%.2X%.2X",
+              bin_hash[0], bin_hash[1], bin_hash[2], bin_hash[3]);
+
+    gcry_md_write (hd_memory, data, sizeof (data));
+    gcry_md_final (hd_memory);
+    bin_hash = gcry_md_read (hd_memory, 0);
+    snprintf (hash_memory, sizeof (hash_memory), "%.2X%.2X%.2X%.2X",
+              bin_hash[0], bin_hash[1], bin_hash[2], bin_hash[3]);
+
+    STRCMP_EQUAL(hash_memory, hash_file);
+
+    gcry_md_close (hd_file);
+    gcry_md_close (hd_memory);
+    close (fd);
+    unlink (TEST_XFER_FILENAME);
+}